@@ -5,7 +5,13 @@
 
 #include <microui.h>
 
+#include <gpu/texture_array.h>
+#include <gpu/upload.h>
+#include <math/bounds.h>
 #include <math/matrix.h>
+#include <scene/gpu_cull.h>
+#include <scene/light_grid.h>
+#include <scene/occlusion.h>
 
 typedef enum {
     SIDE_FRONT,
@@ -21,22 +27,81 @@ typedef struct {
     vec3 scale;
 } TransformComponent;
 
+#define PAL_MAX_MESH_LODS 6
+
+// Generated meshes live in the geometry arena (see g_common.h): their
+// buffers are shared blocks and the draw starts at first_index, with
+// vertex_offset added to every index.
+typedef struct {
+    SDL_GPUBuffer* vertex_buffer;
+    Uint32 num_vertices;
+    SDL_GPUBuffer* index_buffer;
+    Uint32 num_indices;
+    Uint32 first_index;
+    Sint32 vertex_offset;
+    bool arena;  // buffers are arena blocks, not owned by the mesh
+    float error; // max distance from the true surface, in local units
+} PAL_MeshLOD;
+
 typedef struct {
     SDL_GPUBuffer* vertex_buffer;
     Uint32 num_vertices;
     SDL_GPUBuffer* index_buffer;
     Uint32 num_indices;
+    Uint32 first_index;
+    Sint32 vertex_offset;
+    bool arena;
     SDL_GPUIndexElementSize index_size;
+    aabb bounds;       // local space, used for culling
+    bool box_occluder; // geometry fills its bounds (boxes, planes)
+
+    // lods[0] mirrors the geometry above; coarser levels follow and are owned
+    // by the mesh. num_lods is 1 (or 0 for hand-built meshes) without a chain.
+    PAL_MeshLOD lods[PAL_MAX_MESH_LODS];
+    Uint32 num_lods;
+
+    // entities (and PAL_RetainMesh holders) using the mesh; see g_common.h
+    Uint32 refs;
+    bool owned;  // allocated by PAL_CreateMesh, freed with the last reference
+    bool shared; // registered under key by PAL_AcquireSharedMesh
+    Uint64 key;
 } PAL_MeshComponent;
 
+// what materials of one kind share: the pipelines and so the shaders and
+// their resource layout. Templates are reference counted like meshes, each
+// instance holding one reference; see m_common.h.
+typedef struct PAL_MaterialTemplate {
+    // shared with similar templates; see PAL_AcquireGraphicsPipeline
+    SDL_GPUGraphicsPipeline* pipeline;
+    // position-only variant for the depth pre-pass, NULL when it is off
+    SDL_GPUGraphicsPipeline* depth_pipeline;
+    // variant drawn while there are no point lights, NULL if there is none
+    SDL_GPUGraphicsPipeline* ambient_pipeline;
+    bool textured; // instances must come with a texture and sampler
+    Uint32 refs;
+    // PAL_TemplateState; the pipelines are only read once it is ready
+    SDL_AtomicInt state;
+    // drawn in place of a pending template, may be NULL
+    struct PAL_MaterialTemplate* fallback;
+} PAL_MaterialTemplate;
+
+// per-instance parameters, an element of the material SSBO (std430)
 typedef struct {
     SDL_FColor color;
     SDL_FColor emissive;
-    SDL_GPUTexture* texture;
+    Uint32 layer; // of the instance's texture array, set by the instance
+    Uint32 pad[3];
+} PAL_GPUMaterial;
+
+#define PAL_MATERIAL_NULL SDL_MAX_UINT32
+
+// a material instance: a template plus an index into the parameter table
+// (see PAL_AddMaterialParams) and the textures it samples
+typedef struct {
+    PAL_MaterialTemplate* tmpl;
+    Uint32 params;
+    PAL_TextureLayer texture; // the instance's own layer
     SDL_GPUSampler* sampler;
-    SDL_GPUShader* vertex_shader;
-    SDL_GPUShader* fragment_shader;
-    SDL_GPUGraphicsPipeline* pipeline;
 } PAL_MaterialComponent;
 
 typedef struct {
@@ -54,6 +119,8 @@ typedef struct {
     SDL_FRect rect;
     SDL_FColor color;
     SDL_GPUTexture* texture;
+    SDL_Surface* pixels; // text not yet uploaded to texture
+    SDL_Rect clip;       // zero size when unclipped
 } UIRect;
 
 typedef struct {
@@ -63,6 +130,7 @@ typedef struct {
     Uint32 max_rects;
     SDL_GPUTexture* white_texture;
     SDL_GPUSampler* sampler;
+    SDL_Rect clip; // applied to rects as they are queued
 
     // text
     TTF_Font* font;
@@ -72,6 +140,7 @@ typedef struct {
     Uint32 vbo_size;
     SDL_GPUBuffer* ibo;
     Uint32 ibo_size;
+    PAL_UploadRing* upload; // the renderer's
 
     // uh
     SDL_GPUShader* vertex;
@@ -83,12 +152,29 @@ typedef struct {
 
 // Billboard is a flag (no data)
 
+// CPU-side triangles rasterized into the occlusion buffer; without positions
+// the entity's mesh bounds are used as a solid box
+typedef struct {
+    vec3* positions;
+    Uint32 num_positions;
+    Uint32* indices;
+    Uint32 num_indices;
+    aabb bounds;
+} OccluderComponent;
+
 typedef SDL_FColor AmbientLightComponent;
 typedef SDL_FColor GPUAmbientLight;
 
-typedef SDL_FColor PointLightComponent; // position is another component
+// reach of a point light created with radius 0
+#define PAL_POINT_LIGHT_RADIUS 10.0f
+
+// position is another component
+typedef struct {
+    SDL_FColor color; // rgb, a is intensity
+    float radius;     // the light fades out smoothly to zero here
+} PointLightComponent;
 typedef struct {
-    vec4 position;
+    vec4 position; // w is the radius
     SDL_FColor color;
 } GPUPointLight;
 
@@ -107,9 +193,18 @@ void add_transform (Entity e, const PAL_TransformCreateInfo* info);
 TransformComponent* get_transform (Entity e);
 bool has_transform (Entity e);
 void remove_transform (Entity e);
+// call after writing through get_transform or get_point_light so the scene
+// index is refit and the light restaged, and with GPU culling after changing
+// an attached material or mesh in place
+void mark_transform_dirty (Entity e);
 
 // Meshes
-void PAL_AddMeshComponent (Entity e, PAL_MeshComponent* mesh);
+// replaces (and releases) a mesh the entity already has
+void PAL_AddMeshComponent (
+    SDL_GPUDevice* device,
+    Entity e,
+    PAL_MeshComponent* mesh
+);
 PAL_MeshComponent* PAL_GetMeshComponent (Entity e);
 bool has_mesh (Entity e);
 void remove_mesh (SDL_GPUDevice* device, Entity e); // state for device release
@@ -123,6 +218,18 @@ void remove_material (
     Entity e
 ); // state for device release
 
+// Material parameters live in one table that the renderer mirrors into a
+// storage buffer; draws carry the index of their parameters. Adding,
+// setting or removing parameters only touches the table, the GPU copy
+// follows with the next frame. PAL_AddMaterialParams returns
+// PAL_MATERIAL_NULL if memory runs out; PAL_SetMaterialParams keeps the
+// texture layer already there. Removed indices are ignored by the rest until
+// handed out again, and removing one twice is logged and does nothing.
+Uint32 PAL_AddMaterialParams (const PAL_GPUMaterial* params);
+const PAL_GPUMaterial* PAL_GetMaterialParams (Uint32 index);
+void PAL_SetMaterialParams (Uint32 index, const PAL_GPUMaterial* params);
+void PAL_RemoveMaterialParams (Uint32 index);
+
 // Cameras
 typedef struct {
     float fov;
@@ -151,41 +258,172 @@ void add_billboard (Entity e);
 bool has_billboard (Entity e);
 void remove_billboard (Entity e);
 
+// Occluders
+typedef struct {
+    const vec3* positions;
+    Uint32 num_positions;
+    const Uint32* indices;
+    Uint32 num_indices;
+} PAL_OccluderCreateInfo;
+
+// info may be NULL to occlude with the mesh bounds
+void add_occluder (Entity e, const PAL_OccluderCreateInfo* info);
+OccluderComponent* get_occluder (Entity e);
+bool has_occluder (Entity e);
+void remove_occluder (Entity e);
+
 // UI
 void add_ui (Entity e, UIComponent* ui);
 bool has_ui (Entity e);
 UIComponent* get_ui (Entity e);
 void remove_ui (Entity e);
 
+#define PAL_MAX_FRAMES_IN_FLIGHT 3
+
 // renderer
 typedef struct {
     SDL_GPUDevice* device;
     SDL_Window* window;
     Uint32 width;
     Uint32 height;
+    bool occlusion_culling; // CPU occlusion pass before drawing
+    bool gpu_culling;       // cull and select LODs in a compute pass
+    bool deferred;          // G-buffer pass, then one lighting pass per pixel
+    bool depth_prepass;     // lay down depth first, then shade on EQUAL
+    Uint32 upload_size;     // staging bytes per frame, 0 for the default
+    // dynamic resolution: the scene is rendered at a fraction of the window
+    // between the bounds (0 means 1) and upscaled. The fraction is steered
+    // toward target_frame_ms by the smoothed frame time; with no target it
+    // stays at max_render_scale. Under vsync frames can't beat the refresh
+    // interval, so the scale only climbs back when the target is above it.
+    float min_render_scale;
+    float max_render_scale;
+    float target_frame_ms;
+    // frames the CPU may run ahead of the GPU, 1 to PAL_MAX_FRAMES_IN_FLIGHT
+    // (0 for 2). One gives the lowest latency, three the most overlap.
+    Uint32 frames_in_flight;
+    // VSYNC (the default), MAILBOX or IMMEDIATE; falls back to VSYNC where
+    // the window doesn't support it
+    SDL_GPUPresentMode present_mode;
+    // record and submit on a render thread while the caller simulates the
+    // next frame (see render_system)
+    bool render_thread;
 } PAL_RendererCreateInfo;
 
+// with GPU culling only renderables, draw_calls and upload_bytes are counted
+typedef struct {
+    Uint32 renderables; // entities in the scene index
+    Uint32 visible;     // survived frustum culling
+    Uint32 occluders;   // rasterized into the occlusion buffer
+    Uint32 occluded;    // culled by the occlusion buffer
+    Uint32 objects;     // meshes drawn
+    Uint32 draw_calls;  // an indirect batch counts once
+    Uint32 prepass_draw_calls; // depth pre-pass, 0 when it is off
+    Uint64 triangles;
+    Uint32 upload_bytes; // staged and copied at the start of the frame
+    Uint32 render_width; // scene resolution before upscaling
+    Uint32 render_height;
+} PAL_FrameStats;
+
+// snapshot of what a frame draws; see render_system
+typedef struct PAL_RenderFrame PAL_RenderFrame;
+
 typedef struct {
     SDL_GPUDevice* device;
     SDL_Window* window;
     Uint32 width;
     Uint32 height;
-    Uint32 dwidth;
+    Uint32 dwidth; // size of the depth and other render targets
     Uint32 dheight;
     SDL_GPUTexture* depth_texture;
     SDL_GPUTextureFormat format;
+    // dynamic resolution; when scaled the scene renders into the top-left
+    // render_width x render_height of color_target, which is blitted to the
+    // swapchain before the UI is drawn
+    bool scaled;
+    SDL_GPUTexture* color_target;
+    float min_render_scale;
+    float max_render_scale;
+    float render_scale;
+    float target_frame_ms;
+    float frame_ms; // smoothed frame interval
+    Uint64 last_frame_ns;
+    Uint32 render_width;
+    Uint32 render_height;
+    // frame pacing; render_system waits on the fence of the frame that last
+    // used its slot, and skips the frame if no swapchain image is free
+    SDL_GPUFence* frame_fences[PAL_MAX_FRAMES_IN_FLIGHT];
+    // texture array growths the frame behind each fence had seen, so the
+    // textures growth retires outlive the frames that may bind them
+    Uint32 fence_growths[PAL_MAX_FRAMES_IN_FLIGHT];
+    Uint32 frames_in_flight;
+    Uint32 frame_index;
+    Uint64 skipped_frames;
+    // one frame is extracted while the other is recorded
+    PAL_RenderFrame* frames[2];
+    Uint32 extract_slot;
+    PAL_RenderFrame* recording; // handed to the render thread, not yet done
+    SDL_Thread* render_thread;  // NULL when frames are recorded inline
+    SDL_Semaphore* frame_ready;
+    SDL_Semaphore* frame_done;
+    bool restage_lights; // the light SSBOs missed changes; restage them whole
+    // the material parameter table (see PAL_AddMaterialParams)
+    SDL_GPUBuffer* material_ssbo;
+    Uint32 material_size;
+    // deferred shading; materials draw into the G-buffer instead of the
+    // swapchain when it is on (see PAL_GetMaterialTargets)
+    bool deferred;
+    SDL_GPUTexture* gbuffer_albedo; // rgb albedo, a = 1 for lit surfaces
+    SDL_GPUTexture* gbuffer_normal; // octahedral-encoded world normal
+    SDL_GPUSampler* gbuffer_sampler;
+    SDL_GPUGraphicsPipeline* lighting_pipeline;
+    SDL_GPUColorTargetDescription material_targets[2];
+    Uint32 num_material_targets;
+    // materials carry a depth-only pipeline variant and shade on EQUAL
+    bool depth_prepass;
     SDL_GPUBuffer* ambient_ssbo;
     Uint32 ambient_size;
     SDL_GPUBuffer* point_ssbo;
     Uint32 point_size;
+    // clustered point lights, rebuilt for the camera every frame; the SSBO
+    // holds a PAL_LightCluster per cluster followed by the light index list
+    PAL_LightGrid* light_grid;
+    vec4* light_spheres; // world-space position and radius per point light
+    Uint32 light_sphere_capacity;
+    SDL_GPUBuffer* cluster_ssbo;
+    Uint32 cluster_size;
+    PAL_UploadRing* upload;
+    Entity* draw_list;
+    Uint32 draw_list_capacity;
+    // per-draw object constants, indirect commands and the instance stream
+    // that carries each draw's object index (see render_system)
+    SDL_GPUBuffer* object_buffer;
+    SDL_GPUBuffer* indirect_buffer;
+    SDL_GPUBuffer* instance_buffer;
+    Uint32 draw_capacity;
+    PAL_OcclusionBuffer* occlusion; // NULL when occlusion culling is off
+    PAL_GPUCuller* culler;          // NULL when GPU culling is off
+    PAL_FrameStats stats;
 } PAL_GPURenderer;
 
 PAL_GPURenderer* renderer_init (const PAL_RendererCreateInfo* info);
+// waits until the frame on the render thread is recorded. Meshes, materials
+// and UI components a frame may still draw must only be removed or released
+// after this, and UI components only created after it (they stage into the
+// renderer's upload ring); without a render thread it returns at once.
+// Loading textures needn't wait: a texture array that grows keeps its old
+// texture until the frames that may bind it are done on the GPU.
+void renderer_wait (PAL_GPURenderer* renderer);
+// stops the render thread and the material loader and waits for the GPU;
+// call before releasing the renderer's resources
+void renderer_quit (PAL_GPURenderer* renderer);
+// targets of the pass materials draw in; pipelines must be built for these
+SDL_GPUGraphicsPipelineTargetInfo
+PAL_GetMaterialTargets (const PAL_GPURenderer* renderer);
 
 // Ambient Lights
 typedef struct {
     SDL_FColor color;
-    PAL_GPURenderer* renderer;
 } PAL_AmbientLightCreateInfo;
 
 void add_ambient_light (Entity e, const PAL_AmbientLightCreateInfo* info);
@@ -196,7 +434,7 @@ void remove_ambient_light (Entity e);
 // Point Lights
 typedef struct {
     SDL_FColor color;
-    PAL_GPURenderer* renderer;
+    float radius; // 0 for PAL_POINT_LIGHT_RADIUS
 } PAL_PointLightCreateInfo;
 
 void add_point_light (Entity e, const PAL_PointLightCreateInfo* info);
@@ -207,6 +445,10 @@ void remove_point_light (Entity e);
 // Systems
 void fps_controller_event_system (SDL_Event* event);
 void fps_controller_update_system (float dt);
+// snapshots the frame seen by cam from the components, then records and
+// submits it. With a render thread the recording runs while the caller
+// simulates the next frame, so the result, timings and stats returned are
+// those of the previous frame.
 SDL_AppResult render_system (
     PAL_GPURenderer* renderer,
     Entity cam,
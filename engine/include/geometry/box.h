@@ -7,6 +7,7 @@ typedef struct {
     float w;
     float h;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_BoxMeshCreateInfo;
 
 PAL_MeshComponent* PAL_CreateBoxMesh (const PAL_BoxMeshCreateInfo* info);
\ No newline at end of file
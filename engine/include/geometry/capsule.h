@@ -8,6 +8,7 @@ typedef struct {
     Uint32 cap_segments;
     Uint32 radial_segments;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_CapsuleMeshCreateInfo;
 
 PAL_MeshComponent*
@@ -6,6 +6,7 @@ typedef struct {
     float radius;
     Uint32 segments;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_CircleMeshCreateInfo;
 
 PAL_MeshComponent* PAL_CreateCircleMesh (const PAL_CircleMeshCreateInfo* info);
\ No newline at end of file
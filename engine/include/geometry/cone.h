@@ -11,6 +11,7 @@ typedef struct {
     float theta_start;
     float theta_length;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_ConeMeshCreateInfo;
 
 PAL_MeshComponent* PAL_CreateConeMesh (const PAL_ConeMeshCreateInfo* info);
\ No newline at end of file
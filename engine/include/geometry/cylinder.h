@@ -12,6 +12,7 @@ typedef struct {
     float theta_start;
     float theta_length;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_CylinderMeshCreateInfo;
 
 PAL_MeshComponent*
@@ -1,17 +1,25 @@
 #pragma once
 
+#include <stddef.h>
+
 #include <SDL3/SDL_gpu.h>
 
-// Returns 0 on success, 1 on failure
+#include <ecs/ecs.h>
+#include <gpu/geometry.h>
+#include <math/bounds.h>
+
+// Creates a buffer holding the data; returns NULL on failure. With a batch
+// the copy happens when the batch is submitted, otherwise right away.
 SDL_GPUBuffer* PAL_UploadVertices (
     SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
     const void* vertices,
     Uint64 vertices_size
 );
 
-// Returns 0 on success, 1 on failure
 SDL_GPUBuffer* PAL_UploadIndices (
     SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
     const void* indices,
     Uint64 indices_size
 );
@@ -26,7 +34,89 @@ void PAL_ComputeNormals (
     Uint32 norm_offset
 );
 
+aabb PAL_ComputeBounds (
+    const float* vertices,
+    Uint32 num_vertices,
+    Uint32 stride,
+    Uint32 pos_offset
+);
+
+// Generated meshes are sub-allocated from one geometry arena, created on the
+// first PAL_CreateMesh and destroyed by PAL_DestroyMeshArena (free_pools
+// calls it once every entity is gone).
+PAL_GeometryArena* PAL_GetMeshArena (SDL_GPUDevice* device);
+void PAL_DestroyMeshArena (void);
+
+// Copies interleaved pos3/norm3/uv2 vertices with 32-bit indices into one
+// range of the mesh arena and wraps it in a heap-allocated mesh component.
+// Returns NULL on failure. batch is optional, as above.
+PAL_MeshComponent* PAL_CreateMesh (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const float* vertices,
+    Uint32 num_vertices,
+    const Uint32* indices,
+    Uint32 num_indices
+);
+
+// Moves level's geometry into mesh as its next (coarser) LOD and frees the
+// level struct. On failure (chain full) the level is released instead.
+bool PAL_AppendMeshLOD (
+    SDL_GPUDevice* device,
+    PAL_MeshComponent* mesh,
+    PAL_MeshComponent* level,
+    float error
+);
+
+// Picks the coarsest level whose error stays under one pixel.
+// pixels_per_unit is how many pixels one local-space unit covers at the
+// mesh's distance; current is last frame's level, used for hysteresis.
+Uint32 PAL_SelectMeshLOD (
+    const PAL_MeshComponent* mesh,
+    float pixels_per_unit,
+    Uint32 current
+);
+
+// Meshes are reference counted: PAL_AddMeshComponent takes a reference and
+// remove_mesh, or replacing the entity's mesh, drops it. A new mesh starts
+// with none, so the first entity to take it owns it; PAL_RetainMesh keeps a
+// mesh alive while it's detached.
+void PAL_RetainMesh (PAL_MeshComponent* mesh);
+
+// Drops a reference. The last one releases the geometry (every LOD),
+// unregisters a shared mesh and frees meshes made by PAL_CreateMesh. Returns
+// true if the mesh was released.
+bool PAL_ReleaseMesh (SDL_GPUDevice* device, PAL_MeshComponent* mesh);
+
+typedef PAL_MeshComponent* (*PAL_MeshGenerator) (const void* info);
+
+// Content-addressed mesh registry. The key is the generator name, the
+// device and the first params_size bytes of info, compared in full; an
+// identical live mesh is returned instead of generating a new one. Like a
+// generator's, the result carries no reference of its own.
+PAL_MeshComponent* PAL_AcquireSharedMesh (
+    const char* generator,
+    PAL_MeshGenerator create,
+    const void* info,
+    Uint64 params_size,
+    SDL_GPUDevice* device
+);
+
+// e.g. PAL_CreateSharedMesh (Icosahedron, &info). Parameters are everything
+// before `device`, padding included, so create infos must be
+// zero-initialized: designated initializers or `= {}` zero the padding too,
+// while a struct filled in member by member can hold stack garbage there and
+// then never matches (it is generated afresh, not confused with another).
+// Pointer parameters (the lathe path) are keyed by address. LOD chains are
+// built on a private base and aren't shared.
+#define PAL_CreateSharedMesh(kind, info)                                       \
+    PAL_AcquireSharedMesh (                                                    \
+        #kind, (PAL_MeshGenerator) PAL_Create##kind##Mesh, (info),             \
+        offsetof (typeof (*(info)), device), (info)->device                    \
+    )
+
 typedef struct {
     float radius;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_PlatonicMeshCreateInfo;
\ No newline at end of file
@@ -10,6 +10,14 @@ typedef struct {
     float phi_start;
     float phi_length;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_LatheMeshCreateInfo;
 
-PAL_MeshComponent* PAL_CreateLatheMesh (const PAL_LatheMeshCreateInfo* info);
\ No newline at end of file
+PAL_MeshComponent* PAL_CreateLatheMesh (const PAL_LatheMeshCreateInfo* info);
+
+// Builds up to num_levels LODs into one mesh, halving the segment count per
+// level (down to 6). The path itself is kept at full detail.
+PAL_MeshComponent* PAL_CreateLatheMeshLODs (
+    const PAL_LatheMeshCreateInfo* info,
+    Uint32 num_levels
+);
\ No newline at end of file
@@ -8,6 +8,7 @@ typedef struct {
     Uint32 width_segments;
     Uint32 height_segments;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_PlaneMeshCreateInfo;
 
 PAL_MeshComponent* PAL_CreatePlaneMesh (const PAL_PlaneMeshCreateInfo* info);
\ No newline at end of file
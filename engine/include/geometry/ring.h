@@ -10,6 +10,7 @@ typedef struct {
     float theta_start;
     float theta_length;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_RingMeshCreateInfo;
 
 PAL_MeshComponent* PAL_CreateRingMesh (const PAL_RingMeshCreateInfo* info);
\ No newline at end of file
@@ -11,6 +11,21 @@ typedef struct {
     float theta_start;
     float theta_length;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_SphereMeshCreateInfo;
 
-PAL_MeshComponent* PAL_CreateSphereMesh (const PAL_SphereMeshCreateInfo* info);
\ No newline at end of file
+PAL_MeshComponent* PAL_CreateSphereMesh (const PAL_SphereMeshCreateInfo* info);
+
+// Builds up to num_levels LODs into one mesh, halving both segment counts per
+// level (down to 6x4). Level 0 uses info as given.
+PAL_MeshComponent* PAL_CreateSphereMeshLODs (
+    const PAL_SphereMeshCreateInfo* info,
+    Uint32 num_levels
+);
+
+// create info used for a level of PAL_CreateSphereMeshLODs
+PAL_SphereMeshCreateInfo
+PAL_SphereMeshLODInfo (const PAL_SphereMeshCreateInfo* info, Uint32 level);
+
+// max distance between the tessellation and the true sphere
+float PAL_SphereMeshError (const PAL_SphereMeshCreateInfo* info);
\ No newline at end of file
@@ -9,6 +9,14 @@ typedef struct {
     Uint32 tubular_segments;
     float arc;
     SDL_GPUDevice* device;
+    PAL_UploadBatch* batch; // optional, defers the upload to the batch
 } PAL_TorusMeshCreateInfo;
 
-PAL_MeshComponent* PAL_CreateTorusMesh (const PAL_TorusMeshCreateInfo* info);
\ No newline at end of file
+PAL_MeshComponent* PAL_CreateTorusMesh (const PAL_TorusMeshCreateInfo* info);
+
+// Builds up to num_levels LODs into one mesh, halving both segment counts per
+// level (down to 4 radial, 6 tubular). Level 0 uses info as given.
+PAL_MeshComponent* PAL_CreateTorusMeshLODs (
+    const PAL_TorusMeshCreateInfo* info,
+    Uint32 num_levels
+);
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_stdinc.h>
+
+// levels a DDS file can carry (a 32768 texel edge has 16)
+#define PAL_DDS_MAX_LEVELS 16
+
+#define PAL_DDS_MAGIC 0x20534444u // "DDS "
+#define PAL_DDS_FOURCC(a, b, c, d)                                            \
+    ((Uint32) (a) | ((Uint32) (b) << 8) | ((Uint32) (c) << 16) |              \
+     ((Uint32) (d) << 24))
+
+// header flags the converter writes and the loader checks
+#define PAL_DDSD_CAPS 0x1u
+#define PAL_DDSD_HEIGHT 0x2u
+#define PAL_DDSD_WIDTH 0x4u
+#define PAL_DDSD_PIXELFORMAT 0x1000u
+#define PAL_DDSD_MIPMAPCOUNT 0x20000u
+#define PAL_DDSD_LINEARSIZE 0x80000u
+#define PAL_DDPF_FOURCC 0x4u
+#define PAL_DDSCAPS_COMPLEX 0x8u
+#define PAL_DDSCAPS_TEXTURE 0x1000u
+#define PAL_DDSCAPS_MIPMAP 0x400000u
+#define PAL_DDSCAPS2_CUBEMAP 0x200u
+#define PAL_DDSCAPS2_VOLUME 0x200000u
+
+// the DXGI formats the loader accepts in a DX10 header
+#define PAL_DXGI_BC1_UNORM 71u
+#define PAL_DXGI_BC1_UNORM_SRGB 72u
+#define PAL_DXGI_BC3_UNORM 77u
+#define PAL_DXGI_BC3_UNORM_SRGB 78u
+#define PAL_DXGI_BC5_UNORM 83u
+#define PAL_DXGI_BC7_UNORM 98u
+#define PAL_DXGI_BC7_UNORM_SRGB 99u
+#define PAL_DX10_TEXTURE2D 3u
+
+// the file layout after the magic, little endian
+typedef struct {
+    Uint32 size; // 32
+    Uint32 flags;
+    Uint32 fourcc;
+    Uint32 rgb_bit_count;
+    Uint32 masks[4];
+} PAL_DDSPixelFormat;
+
+typedef struct {
+    Uint32 size; // 124
+    Uint32 flags;
+    Uint32 height;
+    Uint32 width;
+    Uint32 pitch_or_linear_size;
+    Uint32 depth;
+    Uint32 mip_map_count;
+    Uint32 reserved1[11];
+    PAL_DDSPixelFormat format;
+    Uint32 caps;
+    Uint32 caps2;
+    Uint32 caps3;
+    Uint32 caps4;
+    Uint32 reserved2;
+} PAL_DDSHeader;
+
+// follows the header when format.fourcc is "DX10"
+typedef struct {
+    Uint32 dxgi_format;
+    Uint32 resource_dimension;
+    Uint32 misc_flag;
+    Uint32 array_size;
+    Uint32 misc_flags2;
+} PAL_DDSHeaderDX10;
+
+// bytes of the magic and both headers; reading this much of a file is enough
+// for PAL_ParseDDS
+#define PAL_DDS_HEADER_SIZE                                                   \
+    (sizeof (Uint32) + sizeof (PAL_DDSHeader) + sizeof (PAL_DDSHeaderDX10))
+
+// a block-compressed 2D texture inside a DDS file; the levels follow each
+// other, largest first, at the given offsets from the start of the file
+typedef struct {
+    SDL_GPUTextureFormat format;
+    Uint32 width;
+    Uint32 height;
+    Uint32 block_size; // bytes per 4x4 block
+    Uint32 num_levels;
+    Uint64 level_offsets[PAL_DDS_MAX_LEVELS];
+    Uint32 level_sizes[PAL_DDS_MAX_LEVELS];
+} PAL_DDSImage;
+
+// bytes of one level of a block-compressed texture
+Uint32 PAL_DDSLevelSize (Uint32 width, Uint32 height, Uint32 block_size);
+
+// true if data starts with the DDS magic
+bool PAL_IsDDS (const void* data, size_t size);
+
+// reads the headers of a 2D DDS file holding BC1, BC3, BC5 or BC7 blocks
+// (legacy DXT1, DXT5 and ATI2 FourCCs or a DX10 header) from the first size
+// bytes of a file of file_size bytes, so the levels can be read straight to
+// their destination. Cube maps, arrays, volumes and uncompressed formats are
+// rejected with a log, as are sizes that aren't a multiple of the 4x4 block
+// and files too short for their levels.
+bool PAL_ParseDDS (
+    const void* data,
+    size_t size,
+    Uint64 file_size,
+    PAL_DDSImage* image
+);
\ No newline at end of file
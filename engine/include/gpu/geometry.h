@@ -0,0 +1,36 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_stdinc.h>
+
+// Shared vertex/index memory for generated meshes. The arena is a list of
+// large GPU buffers (blocks) created with both vertex and index usage; each
+// allocation is a first-fit range from a block's free list, so meshes in the
+// same block draw without rebinding and can be batched into indirect draws.
+// Oversized requests get a block of their own.
+typedef struct PAL_GeometryArena PAL_GeometryArena;
+
+// block_size is the size of a regular block in bytes
+PAL_GeometryArena*
+PAL_CreateGeometryArena (SDL_GPUDevice* device, Uint32 block_size);
+// releases every block; outstanding allocations become invalid
+void PAL_DestroyGeometryArena (PAL_GeometryArena* arena);
+
+// returns the block holding size bytes at *offset (a multiple of alignment,
+// which must be a power of two), or NULL on failure
+SDL_GPUBuffer* PAL_GeometryArenaAlloc (
+    PAL_GeometryArena* arena,
+    Uint32 size,
+    Uint32 alignment,
+    Uint32* offset
+);
+void PAL_GeometryArenaFree (
+    PAL_GeometryArena* arena,
+    SDL_GPUBuffer* block,
+    Uint32 offset,
+    Uint32 size
+);
+
+// bytes handed out and bytes reserved in blocks
+Uint64 PAL_GeometryArenaUsed (const PAL_GeometryArena* arena);
+Uint64 PAL_GeometryArenaCapacity (const PAL_GeometryArena* arena);
\ No newline at end of file
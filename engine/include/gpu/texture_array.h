@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_stdinc.h>
+
+#include <gpu/upload.h>
+
+// Texture arrays: textures of one format, size and mip count share the
+// layers of a 2D array texture, so materials sampling different textures
+// still bind the same texture and their draws batch together. Arrays are
+// found by the textures' create info; each hands out layers from a free
+// list and doubles when it runs out, up to PAL_TEXTURE_ARRAY_MAX_LAYERS,
+// after which another array of the same kind is started. Growing creates a
+// bigger texture, queues a GPU copy of the layers in use and retires the
+// old texture until no frame can bind it. The array object stays put, so
+// holders of a layer keep (array, layer) and look up the texture when they
+// bind it; an array goes with its last layer. Main thread only.
+typedef struct PAL_TextureArray PAL_TextureArray;
+
+// layers a new array starts with, and the most an array grows to (the
+// least Vulkan guarantees is 256)
+#define PAL_TEXTURE_ARRAY_MIN_LAYERS 4
+#define PAL_TEXTURE_ARRAY_MAX_LAYERS 256
+
+typedef struct {
+    PAL_TextureArray* array; // NULL for no texture
+    Uint32 layer;
+} PAL_TextureLayer;
+
+// a free layer in an array of textures like info (type and layer count are
+// ignored), creating or growing an array as needed. The copies a growth
+// needs are queued into batch, or submitted right away without one, so
+// layers of the same kind are best staged through the one batch: a growth
+// can't see uploads still waiting in another. Returns a NULL array on
+// failure.
+PAL_TextureLayer PAL_AcquireTextureLayer (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const SDL_GPUTextureCreateInfo* info
+);
+// frees the layer; the last one releases the array and its texture, so a
+// batch still uploading into it must have been submitted
+void PAL_ReleaseTextureLayer (PAL_TextureLayer layer);
+
+// the array's texture at present; it changes when the array grows
+SDL_GPUTexture* PAL_GetTextureArrayTexture (const PAL_TextureArray* array);
+const SDL_GPUTextureCreateInfo*
+PAL_GetTextureArrayInfo (const PAL_TextureArray* array);
+
+// counts the textures replaced by growth across all arrays; whoever holds
+// an array's texture (draw states, the GPU culler) refreshes it when this
+// changes
+Uint32 PAL_GetTextureArrayGrowths (void);
+// releases the textures retired by the first `unbound` growths whose copies
+// have been submitted. The renderer calls it with the growths every frame
+// still on the GPU had seen; without one, pass SDL_MAX_UINT32 once the
+// batches are submitted.
+void PAL_ReleaseRetiredTextures (Uint32 unbound);
\ No newline at end of file
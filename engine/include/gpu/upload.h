@@ -0,0 +1,121 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_stdinc.h>
+
+// Per-frame staging arena for dynamic uploads. Data is sub-allocated
+// linearly from one large transfer buffer that is mapped with cycle = true,
+// so SDL hands out a fresh backing store while the previous frames are
+// still in flight. Queued copies are recorded into a single copy pass by
+// PAL_UploadRingFlush at the start of the frame. If a frame outgrows the
+// arena a bigger transfer buffer replaces it, after which the steady state
+// creates none.
+typedef struct PAL_UploadRing PAL_UploadRing;
+
+// size is the initial per-frame capacity in bytes
+PAL_UploadRing* PAL_CreateUploadRing (SDL_GPUDevice* device, Uint32 size);
+void PAL_DestroyUploadRing (PAL_UploadRing* ring);
+
+// reserves size bytes and queues a copy of them into dst at offset; returns
+// the staging memory to write the data to (valid until the next reservation
+// or flush), or NULL on failure
+void* PAL_UploadRingBuffer (
+    PAL_UploadRing* ring,
+    SDL_GPUBuffer* dst,
+    Uint32 offset,
+    Uint32 size
+);
+
+// same for a texture region; pixels_per_row is the row pitch of the staged
+// data in texels (0 for tightly packed)
+void* PAL_UploadRingTexture (
+    PAL_UploadRing* ring,
+    const SDL_GPUTextureRegion* dst,
+    Uint32 pixels_per_row,
+    Uint32 size
+);
+
+// queues a GPU-side copy of src into dst, ordered with the uploads; it
+// stages nothing
+bool PAL_UploadRingCopyTexture (
+    PAL_UploadRing* ring,
+    const SDL_GPUTextureLocation* src,
+    const SDL_GPUTextureRegion* dst
+);
+
+// records every queued copy into one copy pass on cmd and resets the arena;
+// returns the number of bytes uploaded
+Uint32 PAL_UploadRingFlush (PAL_UploadRing* ring, SDL_GPUCommandBuffer* cmd);
+
+// One-shot staging for load-time uploads (meshes, textures). Everything
+// added to a batch shares one growing staging allocation and is copied in a
+// single copy pass and command buffer on submit, instead of one submit per
+// resource.
+typedef struct PAL_UploadBatch PAL_UploadBatch;
+
+// size is a hint for the total bytes staged; the batch grows past it
+PAL_UploadBatch* PAL_BeginUploadBatch (SDL_GPUDevice* device, Uint32 size);
+
+// same contract as PAL_UploadRingBuffer, PAL_UploadRingTexture and
+// PAL_UploadRingCopyTexture
+void* PAL_UploadBatchBuffer (
+    PAL_UploadBatch* batch,
+    SDL_GPUBuffer* dst,
+    Uint32 offset,
+    Uint32 size
+);
+void* PAL_UploadBatchTexture (
+    PAL_UploadBatch* batch,
+    const SDL_GPUTextureRegion* dst,
+    Uint32 pixels_per_row,
+    Uint32 size
+);
+bool PAL_UploadBatchCopyTexture (
+    PAL_UploadBatch* batch,
+    const SDL_GPUTextureLocation* src,
+    const SDL_GPUTextureRegion* dst
+);
+
+// fills the rest of texture's mip chain from its first level once the
+// batch's copies have landed; texture needs SDL_GPU_TEXTUREUSAGE_COLOR_TARGET
+// next to its sampler usage. Each texture is queued once, so every layer
+// staged into an array shares one pass.
+bool PAL_UploadBatchGenerateMipmaps (
+    PAL_UploadBatch* batch,
+    SDL_GPUTexture* texture
+);
+
+// releases texture after the batch's copies are submitted, for textures the
+// queued copies still read
+bool PAL_UploadBatchReleaseTexture (
+    PAL_UploadBatch* batch,
+    SDL_GPUTexture* texture
+);
+
+typedef void (*PAL_UploadCallback) (void* data);
+
+// calls callback (data) once the batch is submitted, after the releases,
+// for owners that must know when the copies can no longer be missed. It is
+// called even if the submission failed.
+bool PAL_UploadBatchOnSubmit (
+    PAL_UploadBatch* batch,
+    PAL_UploadCallback callback,
+    void* data
+);
+
+#define PAL_UPLOAD_ALL_LAYERS SDL_MAX_UINT32
+
+// forgets the copies queued into (and out of) one layer of texture, or all
+// of them, so the layer can be reused or the texture released before the
+// batch is submitted. Mip generation is dropped with the texture's last
+// copy. The staged bytes stay reserved.
+void PAL_UploadBatchDiscard (
+    PAL_UploadBatch* batch,
+    SDL_GPUTexture* texture,
+    Uint32 layer
+);
+
+// submits the copies and frees the batch. If fence is not NULL it receives a
+// fence that signals once the uploads have landed (NULL if nothing was
+// staged); release it with SDL_ReleaseGPUFence.
+bool PAL_SubmitUploadBatch (PAL_UploadBatch* batch, SDL_GPUFence** fence);
\ No newline at end of file
@@ -5,8 +5,16 @@
 
 typedef struct {
     SDL_FColor color;
-    SDL_GPUCullMode cullmode;
+    SDL_GPUCullMode cullmode; // of a template made here
+    bool async; // build a template made here on the loader thread
     PAL_GPURenderer* renderer;
+    // shared with other instances; NULL makes one for this material
+    PAL_MaterialTemplate* tmpl;
 } PAL_BasicMaterialCreateInfo;
 
+// pipelines for basic materials with the given culling; see m_common.h
+PAL_MaterialTemplate* PAL_CreateBasicTemplate (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode);
+// the same, built on the material loader thread; pending until then
+PAL_MaterialTemplate* PAL_LoadBasicTemplate (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode, PAL_MaterialTemplate* fallback);
+// an instance; with info->tmpl set it makes no GPU calls
 PAL_MaterialComponent* PAL_CreateBasicMaterial (const PAL_BasicMaterialCreateInfo* info);
\ No newline at end of file
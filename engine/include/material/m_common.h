@@ -14,8 +14,188 @@ typedef struct {
     Uint32 storage_texture_count;
 } PAL_ShaderCreateInfo;
 
+// Shaders are cached by file, stage and resource counts: loading one that
+// is alive returns it with another reference, which PAL_ReleaseShader
+// drops. Each file is read and checked once; its code is kept for later
+// loads until PAL_FreeShaderCode.
 SDL_GPUShader* PAL_LoadShader (const PAL_ShaderCreateInfo* info);
+void PAL_ReleaseShader (SDL_GPUDevice* device, SDL_GPUShader* shader);
+void PAL_FreeShaderCode (void);
 
-SDL_GPUTexture* PAL_LoadTexture (SDL_GPUDevice* device, const char* bmp_file_path);
+typedef struct {
+    SDL_GPUDevice* device;
+    char* filename;
+    Uint32 readonly_storage_buffer_count;
+    Uint32 readwrite_storage_buffer_count;
+    Uint32 uniform_buffer_count;
+    Uint32 threadcount_x; // must match the shader's local_size_x
+} PAL_ComputePipelineCreateInfo;
+
+SDL_GPUComputePipeline*
+PAL_LoadComputePipeline (const PAL_ComputePipelineCreateInfo* info);
+
+// Graphics pipeline cache. Pipelines built from the same shaders (file,
+// stage and resource counts), vertex layout, rasterizer, blend and depth
+// state and targets are created once and shared. Each acquire takes a
+// reference that PAL_ReleaseGraphicsPipeline drops; the last one releases
+// the pipeline. The shaders of info are ignored, they are loaded from vertex
+// and fragment on a miss.
+SDL_GPUGraphicsPipeline* PAL_AcquireGraphicsPipeline (
+    SDL_GPUDevice* device,
+    const PAL_ShaderCreateInfo* vertex,
+    const PAL_ShaderCreateInfo* fragment,
+    const SDL_GPUGraphicsPipelineCreateInfo* info
+);
+// pipelines the cache didn't create are released directly
+void PAL_ReleaseGraphicsPipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUGraphicsPipeline* pipeline
+);
+
+// Sampler cache. Samplers are created once per distinct create info and
+// shared, so materials sampling alike bind the same object. Each acquire or
+// retain takes a reference that PAL_ReleaseSampler drops; the last one
+// releases the sampler.
+typedef enum {
+    PAL_SAMPLER_LINEAR_REPEAT, // trilinear, for tiling material textures
+    PAL_SAMPLER_LINEAR_CLAMP,
+    PAL_SAMPLER_NEAREST_REPEAT,
+    PAL_SAMPLER_NEAREST_CLAMP, // exact texel fetches, e.g. the G-buffer
+} PAL_SamplerPreset;
+
+SDL_GPUSampler* PAL_AcquireSampler (
+    SDL_GPUDevice* device,
+    const SDL_GPUSamplerCreateInfo* info
+);
+SDL_GPUSampler*
+PAL_AcquirePresetSampler (SDL_GPUDevice* device, PAL_SamplerPreset preset);
+// false if sampler isn't one of the cache's
+bool PAL_RetainSampler (SDL_GPUSampler* sampler);
+// samplers the cache didn't create are released directly
+void PAL_ReleaseSampler (SDL_GPUDevice* device, SDL_GPUSampler* sampler);
+
+// position-only variant of a material pipeline for the depth pre-pass; it
+// takes the material vertex layout, so the same geometry binds to both.
+// Cached like any other pipeline.
+SDL_GPUGraphicsPipeline* PAL_CreateDepthPipeline (
+    const PAL_GPURenderer* renderer,
+    SDL_GPUCullMode cullmode
+);
+
+// Material templates hold what instances of a material kind share: the
+// pipeline, built from vertex, fragment and info through the pipeline cache,
+// and its depth pre-pass variant when the renderer has one. A fragment
+// shader with a sampler makes a textured template. Templates are reference
+// counted like meshes. A new template has no references; each instance
+// takes one and remove_material drops it, so the last instance releases the
+// pipelines and frees the template. PAL_RetainMaterialTemplate keeps a
+// template alive without instances. Returns NULL on failure.
+PAL_MaterialTemplate* PAL_CreateMaterialTemplate (
+    const PAL_GPURenderer* renderer,
+    const PAL_ShaderCreateInfo* vertex,
+    const PAL_ShaderCreateInfo* fragment,
+    const SDL_GPUGraphicsPipelineCreateInfo* info
+);
+// sets the pipeline and depth pipeline of tmpl as PAL_CreateMaterialTemplate
+// does; for builders (see below)
+bool PAL_CreateTemplatePipelines (
+    PAL_MaterialTemplate* tmpl,
+    const PAL_GPURenderer* renderer,
+    const PAL_ShaderCreateInfo* vertex,
+    const PAL_ShaderCreateInfo* fragment,
+    const SDL_GPUGraphicsPipelineCreateInfo* info
+);
+void PAL_RetainMaterialTemplate (PAL_MaterialTemplate* tmpl);
+// returns true if the template was released
+bool PAL_ReleaseMaterialTemplate (
+    SDL_GPUDevice* device,
+    PAL_MaterialTemplate* tmpl
+);
+
+// Asynchronous templates
+// Reading shaders and compiling pipelines can stall a frame, so a template
+// may be built on the material loader thread instead (SDL GPU devices can
+// create objects from any thread). It is returned at once, pending, and
+// used like any other: instances can be made and released. render_system
+// skips instances of a pending template, or draws them with its fallback,
+// until the loader marks it ready; a failed template is never drawn.
+typedef enum {
+    PAL_TEMPLATE_READY,
+    PAL_TEMPLATE_PENDING,
+    PAL_TEMPLATE_FAILED,
+} PAL_TemplateState;
+
+// sets the pipelines of tmpl from args; what it made before failing is
+// released by the caller. Runs on the loader thread for async templates, so
+// it must only read renderer.
+typedef bool (*PAL_TemplateBuilder) (
+    PAL_MaterialTemplate* tmpl,
+    const PAL_GPURenderer* renderer,
+    const void* args
+);
+
+typedef struct {
+    const PAL_GPURenderer* renderer;
+    PAL_TemplateBuilder build;
+    const void* args; // copied for the loader
+    Uint32 args_size;
+    bool textured;
+    // build on the loader thread; otherwise on this one, NULL on failure
+    bool async;
+    // ready template with the same vertex layout and texturing, drawn while
+    // this one is pending; kept until this one is released. May be NULL.
+    PAL_MaterialTemplate* fallback;
+} PAL_TemplateBuildInfo;
+
+// call from the thread that creates materials
+PAL_MaterialTemplate*
+PAL_BuildMaterialTemplate (const PAL_TemplateBuildInfo* info);
+PAL_TemplateState
+PAL_GetMaterialTemplateState (const PAL_MaterialTemplate* tmpl);
+// the template to draw tmpl's instances with: tmpl once ready, its fallback
+// while pending, else NULL
+const PAL_MaterialTemplate*
+PAL_ResolveMaterialTemplate (const PAL_MaterialTemplate* tmpl);
+// templates that left PAL_TEMPLATE_PENDING so far, ready or failed; the
+// renderer re-adds instances to the GPU culler when it changes, dropping
+// those of failed templates as PAL_ResolveMaterialTemplate does
+Uint32 PAL_GetMaterialTemplateSettles (void);
+// builds what is still queued and stops the loader; renderer_quit calls it
+void PAL_QuitMaterialLoader (void);
+
+// an instance of tmpl with its own parameters; makes no GPU calls. The
+// instance takes over the texture layer, whose index goes into its
+// parameters, and holds its own reference to sampler, which must come from
+// the sampler cache; textured templates need both. Returns NULL if they are
+// missing or memory runs out.
+PAL_MaterialComponent* PAL_CreateMaterialInstance (
+    PAL_MaterialTemplate* tmpl,
+    const PAL_GPUMaterial* params,
+    PAL_TextureLayer texture,
+    SDL_GPUSampler* sampler
+);
+
+// batch is optional; with one the pixels are copied when it is submitted.
+// DDS files (see tools/texconv) go up as they are, block-compressed and with
+// their prebuilt mip levels; anything else is decoded with SDL_image and gets
+// its mip chain generated on the GPU after the copy. Either way the texels
+// are read or converted straight into the staging memory.
+SDL_GPUTexture* PAL_LoadTexture (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const char* file_path
+);
+// same, into a layer of a texture array shared with textures of the same
+// format, size and mip count, which is what materials sample; see
+// gpu/texture_array.h. Returns a NULL array on failure.
+PAL_TextureLayer PAL_LoadTextureLayer (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const char* file_path
+);
 
-SDL_GPUTexture* create_white_texture (SDL_GPUDevice* device);
\ No newline at end of file
+SDL_GPUTexture*
+create_white_texture (SDL_GPUDevice* device, PAL_UploadBatch* batch);
+// a 1x1 white layer, for untinted materials on textured templates
+PAL_TextureLayer
+PAL_CreateWhiteTextureLayer (SDL_GPUDevice* device, PAL_UploadBatch* batch);
\ No newline at end of file
@@ -4,11 +4,22 @@
 
 typedef struct {
     PAL_GPURenderer* renderer;
+    // shared with other instances; NULL makes one for this material
+    PAL_MaterialTemplate* tmpl;
     SDL_FColor color;
     SDL_FColor emissive;
-    SDL_GPUCullMode cullmode;
-    SDL_GPUTexture* texture;
-    SDL_GPUSampler* sampler;
+    SDL_GPUCullMode cullmode; // of a template made here
+    bool async; // build a template made here on the loader thread
+    // a NULL array for an untextured material, which skips the texture
+    // fetch; see PAL_LoadTextureLayer
+    PAL_TextureLayer texture;
+    SDL_GPUSampler* sampler; // cached; the material takes a reference
 } PAL_PhongMaterialCreateInfo;
 
+// pipelines for Phong materials with the given culling, sampling a texture
+// or not; see m_common.h
+PAL_MaterialTemplate* PAL_CreatePhongTemplate (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode, bool textured);
+// the same, built on the material loader thread; pending until then
+PAL_MaterialTemplate* PAL_LoadPhongTemplate (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode, bool textured, PAL_MaterialTemplate* fallback);
+// an instance; with info->tmpl set it makes no GPU calls
 PAL_MaterialComponent* PAL_CreatePhongMaterial (const PAL_PhongMaterialCreateInfo* info);
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <math/matrix.h>
+
+typedef struct {
+    vec3 min;
+    vec3 max;
+} aabb;
+
+// planes are (nx, ny, nz, d); a point p is inside when dot(n, p) + d >= 0
+typedef struct {
+    vec4 planes[6];
+} frustum;
+
+typedef enum {
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECT,
+    FRUSTUM_INSIDE,
+} FrustumResult;
+
+aabb aabb_empty (void);
+aabb aabb_union (aabb a, aabb b);
+aabb aabb_expand (aabb a, float margin);
+bool aabb_contains (aabb outer, aabb inner);
+float aabb_surface_area (aabb a);
+vec3 aabb_center (aabb a);
+aabb aabb_transform (aabb a, mat4 m); // world-space box around a transformed box
+
+// extracts the clip planes of a (projection * view) matrix built with
+// mat4_perspective (depth range [0, 1])
+void frustum_from_matrix (frustum* f, mat4 view_proj);
+FrustumResult frustum_classify_aabb (const frustum* f, aabb a);
+bool frustum_test_aabb (const frustum* f, aabb a);
\ No newline at end of file
@@ -4,6 +4,8 @@
 
 // Helper macro for mat4 indexing (column-major: m[col*4 + row])
 #define MAT4_IDX(row, col) ((col) * 4 + (row))
+// same for mat3 (m[col*3 + row])
+#define MAT3_IDX(row, col) ((col) * 3 + (row))
 
 typedef struct {
     float x, y;
@@ -17,6 +19,7 @@ typedef struct {
     float x, y, z, w;
 } vec4;
 
+typedef float mat3[9];
 typedef float mat4[16];
 
 vec2 vec2_add (vec2 a, vec2 b);
@@ -64,6 +67,11 @@ void mat4_perspective (
     float far
 );
 void mat4_look_at (mat4 m, vec3 eye, vec3 center, vec3 up);
+// returns false and leaves out untouched if m is singular
+bool mat4_inverse (mat4 out, mat4 m);
+// inverse-transpose of m's upper 3x3, for transforming normals; falls back
+// to the upper 3x3 itself if it is singular
+void mat3_normal (mat3 out, mat4 m);
 
 // TODO: move these to a separate file
 void random_seed (Uint32 seed);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <ecs/ecs.h>
+#include <math/bounds.h>
+
+#define PAL_BVH_NULL (~0u)
+
+// Dynamic AABB tree over renderable entities. Leaves store a "fat" box
+// (tight box + margin) so small motions don't touch the tree; larger ones
+// remove and reinsert the leaf with a surface-area cost heuristic and AVL
+// rotations. When enough leaves have been reinserted the tree is rebuilt
+// top-down with binned SAH on a worker thread and swapped in by
+// PAL_BVHMaintain.
+typedef struct PAL_BVH PAL_BVH;
+
+PAL_BVH* PAL_CreateBVH (float margin);
+void PAL_DestroyBVH (PAL_BVH* bvh);
+
+// returns a proxy handle, or PAL_BVH_NULL on allocation failure
+Uint32 PAL_BVHInsert (PAL_BVH* bvh, Entity e, aabb box);
+void PAL_BVHRemove (PAL_BVH* bvh, Uint32 proxy);
+// refits the proxy; returns true if the leaf had to be reinserted
+bool PAL_BVHMove (PAL_BVH* bvh, Uint32 proxy, aabb box);
+Uint32 PAL_BVHCount (const PAL_BVH* bvh);
+
+// call once per frame: swaps in a finished background rebuild and starts a
+// new one once the tree has degraded
+void PAL_BVHMaintain (PAL_BVH* bvh);
+// blocking SAH rebuild (e.g. after loading a level)
+void PAL_BVHRebuild (PAL_BVH* bvh);
+
+// appends every entity whose leaf touches the frustum to out, which must
+// hold PAL_BVHCount entries; returns the number written. Subtrees fully
+// inside the frustum are emitted without further plane tests.
+Uint32 PAL_BVHQueryFrustum (PAL_BVH* bvh, const frustum* f, Entity* out);
\ No newline at end of file
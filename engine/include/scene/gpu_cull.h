@@ -0,0 +1,121 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_stdinc.h>
+
+#include <gpu/upload.h>
+#include <math/bounds.h>
+
+// levels a culling batch can select between (the shader's table holds 8)
+#define PAL_CULL_MAX_LODS 8
+
+// pipeline and bindings shared by a run of draws
+typedef struct {
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUGraphicsPipeline* depth_pipeline; // NULL without a depth pre-pass
+    // variant for frames without point lights, NULL if there is none
+    SDL_GPUGraphicsPipeline* ambient_pipeline;
+    SDL_GPUTexture* texture; // NULL for untextured pipelines
+    SDL_GPUSampler* sampler;
+    SDL_GPUBuffer* vertex_buffer;
+    SDL_GPUBuffer* index_buffer; // NULL for non-indexed meshes
+    SDL_GPUIndexElementSize index_size;
+} PAL_DrawState;
+
+// orders by every field, so equal states sort next to each other
+int PAL_CompareDrawState (const PAL_DrawState* a, const PAL_DrawState* b);
+
+// per-object constants read by the material vertex shaders (std430)
+typedef struct {
+    mat4 model;
+    vec4 normal[3]; // normal matrix columns, padded like a std430 mat3
+    Uint32 material; // index into the material SSBO
+    Uint32 pad[3];
+} PAL_GPUObject;
+
+typedef struct {
+    SDL_GPUBuffer* vertex_buffer;
+    SDL_GPUBuffer* index_buffer;
+    Uint32 num_indices;
+    Uint32 first_index;
+    Sint32 vertex_offset;
+    float error; // object-space error, as in PAL_MeshLOD
+} PAL_CullLOD;
+
+// what an instance draws: material state and the mesh's LOD chain. Instances
+// with identical batches share one indirect command per level.
+typedef struct {
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUGraphicsPipeline* depth_pipeline;
+    SDL_GPUGraphicsPipeline* ambient_pipeline;
+    SDL_GPUTexture* texture;
+    SDL_GPUSampler* sampler;
+    SDL_GPUIndexElementSize index_size;
+    PAL_CullLOD lods[PAL_CULL_MAX_LODS];
+    Uint32 num_lods;
+} PAL_CullBatchInfo;
+
+typedef struct {
+    PAL_GPUObject object;
+    aabb bounds;    // object-space mesh bounds
+    bool billboard; // the model's rotation is replaced to face the camera
+} PAL_CullInstance;
+
+typedef struct {
+    frustum frustum;
+    vec3 cam_pos;
+    vec4 cam_rot;
+    float pixels_per_radian; // pixels per world unit at distance one
+} PAL_CullView;
+
+// draws sharing a state; one multi-draw indirect call each
+typedef struct {
+    PAL_DrawState state;
+    Uint32 first_command;
+    Uint32 num_commands;
+} PAL_CullRun;
+
+typedef struct {
+    SDL_GPUBuffer* objects;   // PAL_GPUObject per instance slot
+    SDL_GPUBuffer* commands;  // SDL_GPUIndexedIndirectDrawCommand
+    SDL_GPUBuffer* instances; // compacted slots, one Uint32 per instance
+    const PAL_CullRun* runs;
+    Uint32 num_runs;
+} PAL_CullOutput;
+
+// GPU-driven frustum culling and LOD selection. Instance transforms and
+// bounds stay resident in storage buffers and only changed instances are
+// re-uploaded. Every frame a compute pass tests each instance and appends
+// the visible ones to the instance stream of their batch's indirect command
+// for the selected level, so drawing costs one multi-draw indirect call per
+// run of commands sharing a state, whatever the instance count. Only indexed
+// geometry is supported.
+typedef struct PAL_GPUCuller PAL_GPUCuller;
+
+// pipeline is cull.comp; the culler takes ownership of it
+PAL_GPUCuller*
+PAL_CreateGPUCuller (SDL_GPUDevice* device, SDL_GPUComputePipeline* pipeline);
+void PAL_DestroyGPUCuller (PAL_GPUCuller* culler);
+
+// adds or updates the instance with the given id (e.g. an entity); returns
+// false if the batch can't be culled on the GPU or memory runs out
+bool PAL_GPUCullerSet (
+    PAL_GPUCuller* culler,
+    Uint32 id,
+    const PAL_CullBatchInfo* batch,
+    const PAL_CullInstance* instance
+);
+void PAL_GPUCullerRemove (PAL_GPUCuller* culler, Uint32 id);
+Uint32 PAL_GPUCullerCount (const PAL_GPUCuller* culler);
+
+// stages changed instances and this frame's indirect commands into ring;
+// call before the ring is flushed
+bool PAL_GPUCullerPrepare (PAL_GPUCuller* culler, PAL_UploadRing* ring);
+// records the culling compute pass; must follow the flush and precede the
+// render pass that draws the output
+void PAL_GPUCullerDispatch (
+    PAL_GPUCuller* culler,
+    SDL_GPUCommandBuffer* cmd,
+    const PAL_CullView* view
+);
+PAL_CullOutput PAL_GPUCullerOutput (const PAL_GPUCuller* culler);
\ No newline at end of file
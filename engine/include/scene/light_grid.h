@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <math/matrix.h>
+
+// cluster grid dimensions; phong_material.frag must use the same
+#define PAL_LIGHT_GRID_X 16
+#define PAL_LIGHT_GRID_Y 9
+#define PAL_LIGHT_GRID_Z 24
+#define PAL_LIGHT_GRID_CLUSTERS \
+    (PAL_LIGHT_GRID_X * PAL_LIGHT_GRID_Y * PAL_LIGHT_GRID_Z)
+
+// Clustered light assignment, after Olsson et al., "Clustered Deferred and
+// Forward Shading". The view frustum is split into 16x9 screen tiles and 24
+// depth slices spaced exponentially between the near and far planes, and
+// each point light is listed in every cluster its bounding sphere overlaps.
+// A fragment then only shades the lights of its own cluster. Nothing here
+// touches the GPU.
+typedef struct PAL_LightGrid PAL_LightGrid;
+
+// a run of the index list; std430 uvec2 in the shader
+typedef struct {
+    Uint32 offset;
+    Uint32 count;
+} PAL_LightCluster;
+
+typedef struct {
+    mat4 view;       // world to view space, depth along +z
+    float proj_x;    // projection[0][0], built with mat4_perspective
+    float proj_y;    // projection[1][1]
+    float near_clip;
+    float far_clip;
+} PAL_LightGridView;
+
+typedef struct {
+    // PAL_LIGHT_GRID_CLUSTERS entries, x fastest, tile row 0 at the top of
+    // the screen and slice 0 at the near plane
+    const PAL_LightCluster* clusters;
+    const Uint32* indices; // light indices, a run per cluster
+    Uint32 num_indices;
+    // slice of a fragment at view depth d: log (d) * scale + bias
+    float slice_scale;
+    float slice_bias;
+} PAL_LightGridOutput;
+
+PAL_LightGrid* PAL_CreateLightGrid (void);
+void PAL_DestroyLightGrid (PAL_LightGrid* grid);
+
+// assigns count world-space lights (xyz center, w radius) to the clusters
+// of view; returns false if memory runs out, leaving the grid empty
+bool PAL_LightGridBuild (
+    PAL_LightGrid* grid,
+    const PAL_LightGridView* view,
+    const vec4* lights,
+    Uint32 count
+);
+PAL_LightGridOutput PAL_LightGridGetOutput (const PAL_LightGrid* grid);
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+#include <math/bounds.h>
+#include <math/matrix.h>
+
+// Low-resolution CPU depth buffer for occlusion culling, after Andersson et
+// al., "Masked Software Occlusion Culling". The screen is split into 8x4
+// pixel tiles; each tile keeps a conservative far depth (zmax0) plus a
+// working layer (zmax1 and a 32-bit coverage mask) that is merged into
+// zmax0 once fully covered. Coverage is rasterized four pixels at a time
+// with SSE2 where available. Nothing here touches the GPU.
+typedef struct PAL_OcclusionBuffer PAL_OcclusionBuffer;
+
+// width must be a multiple of 8 and height a multiple of 4
+PAL_OcclusionBuffer* PAL_CreateOcclusionBuffer (Uint32 width, Uint32 height);
+void PAL_DestroyOcclusionBuffer (PAL_OcclusionBuffer* ob);
+
+// resets every tile to the far plane; view_proj is built with
+// mat4_perspective (depth range [0, 1])
+void PAL_OcclusionClear (PAL_OcclusionBuffer* ob, mat4 view_proj);
+
+// rasterizes an indexed triangle list (either winding) transformed by model
+void PAL_OcclusionRasterize (
+    PAL_OcclusionBuffer* ob,
+    const vec3* positions,
+    const Uint32* indices,
+    Uint32 num_indices,
+    mat4 model
+);
+
+// rasterizes the faces of a solid box; flat boxes (planes) work too
+void PAL_OcclusionRasterizeBox (PAL_OcclusionBuffer* ob, aabb box, mat4 model);
+
+// returns false only if the world-space box is hidden behind what has been
+// rasterized so far
+bool PAL_OcclusionTestAABB (const PAL_OcclusionBuffer* ob, aabb box);
\ No newline at end of file
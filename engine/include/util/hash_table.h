@@ -0,0 +1,73 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+
+// Open-addressing table with linear probing, keyed by byte strings under
+// 64-bit FNV-1a hashes. Entries keep a copy of their key and lookups compare
+// it in full, so a hash collision only lengthens a probe. Removal shifts
+// later entries back rather than leaving tombstones, and an emptied table
+// frees its slots. Nothing is locked; callers that share a table across
+// threads hold their own lock. The mesh registry and the material caches
+// are built on it.
+#define PAL_HASH_SEED 0xcbf29ce484222325ull // FNV-1a offset basis
+
+typedef struct {
+    Uint64 hash;
+    Uint8* key; // owned copy
+    Uint64 key_size;
+    void* value; // NULL for an empty slot
+    Uint64 data; // the owner's, e.g. a reference count or a size
+} PAL_HashSlot;
+
+typedef struct {
+    PAL_HashSlot* slots;
+    Uint32 capacity; // power of two
+    Uint32 count;
+} PAL_HashTable;
+
+// A key assembled from several fields. Short keys stay in place; longer
+// ones move to the heap, and if that fails the key is marked failed and
+// finds nothing. Free it with PAL_FreeHashKey.
+#define PAL_HASH_KEY_INLINE 256
+
+typedef struct {
+    Uint8 inline_bytes[PAL_HASH_KEY_INLINE];
+    Uint8* bytes;
+    Uint64 size;
+    Uint64 capacity;
+    bool failed;
+} PAL_HashKey;
+
+Uint64 PAL_HashBytes (Uint64 hash, const void* data, Uint64 size);
+
+void PAL_InitHashKey (PAL_HashKey* key);
+void PAL_HashKeyAppend (PAL_HashKey* key, const void* data, Uint64 size);
+// appends the string with its terminator, so neighbouring fields can't run
+// into it
+void PAL_HashKeyAppendString (PAL_HashKey* key, const char* string);
+void PAL_FreeHashKey (PAL_HashKey* key);
+
+// the entry under key, or NULL
+PAL_HashSlot*
+PAL_HashTableFind (const PAL_HashTable* table, const void* key, Uint64 size);
+// adds value under a copy of key, which must not be in the table yet;
+// returns its entry, or NULL if memory runs out. Entries move when the table
+// grows or loses an entry.
+PAL_HashSlot* PAL_HashTableInsert (
+    PAL_HashTable* table,
+    const void* key,
+    Uint64 size,
+    void* value
+);
+// the entry holding value: scanning the table, or probing from hash when
+// the caller kept it
+PAL_HashSlot*
+PAL_HashTableFindValue (const PAL_HashTable* table, const void* value);
+PAL_HashSlot* PAL_HashTableFindValueFrom (
+    const PAL_HashTable* table,
+    Uint64 hash,
+    const void* value
+);
+void PAL_HashTableRemove (PAL_HashTable* table, PAL_HashSlot* slot);
+// frees the slots and key copies; the values are the caller's
+void PAL_FreeHashTable (PAL_HashTable* table);
\ No newline at end of file
@@ -0,0 +1,24 @@
+#version 450
+
+// Geometry pass of the deferred renderer for unlit materials; an albedo
+// alpha of 0 tells the lighting pass to pass the colour through.
+// UNTEXTURED leaves out the texture fetch.
+layout(location = 0) in vec3 fragColor;
+layout (location = 1) in vec2 TexCoord;
+
+#ifndef UNTEXTURED
+layout (location = 2) flat in uint fragLayer;
+layout (set = 2, binding = 0) uniform sampler2DArray texture1;
+#endif
+
+layout (location = 0) out vec4 outAlbedo;
+layout (location = 1) out vec2 outNormal;
+
+void main() {
+#ifdef UNTEXTURED
+    outAlbedo = vec4(fragColor, 0.0);
+#else
+    outAlbedo = vec4(texture(texture1, vec3(TexCoord, fragLayer)).rgb * fragColor, 0.0);
+#endif
+    outNormal = vec2(0.0);
+}
\ No newline at end of file
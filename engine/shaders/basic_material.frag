@@ -1,12 +1,20 @@
 #version 450
 
+// UNTEXTURED leaves out the texture fetch
 layout(location = 0) in vec3 fragColor;
 layout (location = 1) in vec2 TexCoord;
 
-layout (set = 2, binding = 0) uniform sampler2D texture1;
+#ifndef UNTEXTURED
+layout (location = 2) flat in uint fragLayer;
+layout (set = 2, binding = 0) uniform sampler2DArray texture1;
+#endif
 
 layout (location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texture1, TexCoord) * vec4(fragColor, 1.0);
+#ifdef UNTEXTURED
+    outColor = vec4(fragColor, 1.0);
+#else
+    outColor = texture(texture1, vec3(TexCoord, fragLayer)) * vec4(fragColor, 1.0);
+#endif
 } 
\ No newline at end of file
@@ -3,19 +3,46 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in uint aObject; // per-instance index into objects
 
 layout (location = 0) out vec3 fragColor;
 layout (location = 1) out vec2 TexCoord;
+layout (location = 2) flat out uint fragLayer;
 
-layout(std140, set = 1, binding = 0) uniform UBO {
-    vec4 color;
-    mat4 model;
+// matches depth_only.vert bit for bit, for the pre-pass EQUAL test
+invariant gl_Position;
+
+layout(std140, set = 1, binding = 0) uniform FrameUBO {
     mat4 view;
     mat4 projection;
-} ubo;
+    mat4 view_projection;
+} frame_ubo;
+
+struct Object {
+    mat4 model;
+    mat3 normal; // inverse-transpose of the model's upper 3x3
+    uvec4 material; // x: index into the material buffer
+};
+layout(std430, set = 0, binding = 0) readonly buffer ObjectBuffer {
+    Object objects[];
+};
+
+// per-instance parameters (PAL_GPUMaterial)
+struct Material {
+    vec4 color;
+    vec4 emissive;
+    uvec4 texture; // x: layer of the texture array
+};
+layout(std430, set = 0, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+};
 
 void main() {
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(aPos, 1.0);
-    fragColor = ubo.color.rgb;  // Reuse colors across quad vertices (or update to per-vertex if needed)
+    Object obj = objects[aObject];
+    vec4 world = obj.model * vec4(aPos, 1.0);
+    gl_Position = frame_ubo.view_projection * world;
+    Material mat = materials[obj.material.x];
+    fragColor = mat.color.rgb;  // Reuse colors across quad vertices (or update to per-vertex if needed)
     TexCoord = aTexCoord;
+    fragLayer = mat.texture.x;
 }
\ No newline at end of file
@@ -0,0 +1,115 @@
+#version 450
+
+// Lighting pass of the deferred renderer: shades every pixel of the
+// G-buffer once, with the same model as phong_material.frag.
+struct AmbientLight {
+    vec4 color; // rgb, a is intensity
+};
+struct PointLight {
+    vec4 position;  // xyz + radius
+    vec4 color;     // rgb + intensity
+};
+
+// cluster grid; must match PAL_LIGHT_GRID_* in scene/light_grid.h
+#define GRID_X 16u
+#define GRID_Y 9u
+#define GRID_Z 24u
+
+// Set 2: samplers, SSBOs
+layout (set = 2, binding = 0) uniform sampler2D gbuffer_albedo;
+layout (set = 2, binding = 1) uniform sampler2D gbuffer_normal;
+layout (set = 2, binding = 2) uniform sampler2D gbuffer_depth;
+layout (std430, set = 2, binding = 3) readonly buffer AmbientBuffer {
+    AmbientLight ambients[];
+};
+layout (std430, set = 2, binding = 4) readonly buffer PointBuffer {
+    PointLight points[];
+};
+layout (std430, set = 2, binding = 5) readonly buffer ClusterBuffer {
+    uvec2 clusters[GRID_X * GRID_Y * GRID_Z];
+    uint light_indices[];
+};
+
+// the forward FrameUBO behind the constants that unproject depth
+layout (std140, set = 3, binding = 0) uniform LightingUBO {
+    mat4 inverse_view_projection;
+    vec4 pixel_size;    // xy: one pixel of the viewport in uv
+    vec4 cam_pos;
+    vec4 cam_rot;
+    vec4 view_z;        // view depth = dot(view_z.xyz, p) + view_z.w
+    vec4 cluster_scale; // tiles per pixel, then slice = log(depth) * z + w
+    int ambient_count;
+    int point_count;
+    int pad0; int pad1; // std140 padding
+} ubo;
+
+layout (location = 0) out vec4 outColor;
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        vec2 s = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * s;
+    }
+    return normalize(n);
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float frag_depth = texelFetch(gbuffer_depth, pixel, 0).r;
+    if (frag_depth >= 1.0) {
+        outColor = vec4(0.0, 0.0, 0.0, 1.0); // nothing drawn here
+        return;
+    }
+    vec4 albedo = texelFetch(gbuffer_albedo, pixel, 0);
+    if (albedo.a == 0.0) {
+        outColor = vec4(albedo.rgb, 1.0); // unlit
+        return;
+    }
+    vec3 objectColor = albedo.rgb;
+    vec3 norm = oct_decode(texelFetch(gbuffer_normal, pixel, 0).rg);
+
+    // position from depth; NDC y points up, pixel rows go down
+    vec2 uv = gl_FragCoord.xy * ubo.pixel_size.xy;
+    vec4 ndc = vec4(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0, frag_depth, 1.0);
+    vec4 world = ubo.inverse_view_projection * ndc;
+    vec3 FragPos = world.xyz / world.w;
+    vec3 view_xyz = ubo.cam_pos.xyz;
+
+    vec3 ambient_sum = vec3(0.0);
+    for (int i = 0; i < ubo.ambient_count; i++) {
+        ambient_sum += ambients[i].color.a * ambients[i].color.rgb * objectColor;
+    }
+
+    // point lights of this pixel's cluster
+    float depth = dot(ubo.view_z.xyz, FragPos) + ubo.view_z.w;
+    uvec2 tile = min(uvec2(gl_FragCoord.xy * ubo.cluster_scale.xy), uvec2(GRID_X - 1u, GRID_Y - 1u));
+    float slice = log(max(depth, 1e-6)) * ubo.cluster_scale.z + ubo.cluster_scale.w;
+    uint z = uint(clamp(slice, 0.0, float(GRID_Z - 1u)));
+    uvec2 cluster = clusters[(z * GRID_Y + tile.y) * GRID_X + tile.x];
+
+    vec3 diffuse_sum = vec3(0.0);
+    vec3 specular_sum = vec3(0.0);
+    vec3 view_dir = normalize(view_xyz - FragPos);
+    for (uint n = 0u; n < cluster.y; n++) {
+        PointLight point = points[light_indices[cluster.x + n]];
+        float intensity = point.color.a;
+        vec3 to_light = point.position.xyz - FragPos;
+        float light_dist = length(to_light);
+        vec3 light_dir = to_light / max(light_dist, 1e-6);
+        vec3 point_rgb = point.color.rgb;
+
+        // smooth falloff to zero at the radius
+        float falloff = clamp(1.0 - light_dist * light_dist / (point.position.w * point.position.w), 0.0, 1.0);
+        falloff *= falloff;
+
+        float diff = max(dot(norm, light_dir), 0.0);
+        diffuse_sum += falloff * intensity * point_rgb * diff * objectColor;
+
+        vec3 reflection_dir = reflect(-light_dir, norm);
+        float spec = pow(max(dot(view_dir, reflection_dir), 0.0), 256);
+        specular_sum += falloff * 0.5 * spec * point_rgb;
+    }
+
+    outColor = vec4(ambient_sum + diffuse_sum + specular_sum, 1.0);
+}
\ No newline at end of file
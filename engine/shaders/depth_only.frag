@@ -0,0 +1,5 @@
+#version 450
+
+// depth pre-pass: no colour is written
+void main() {
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 450
+
+// Depth pre-pass: position only. gl_Position must be computed exactly as in
+// the material vertex shaders, so the main pass can test depth for EQUAL.
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in uint aObject;  // per-instance index into objects
+
+invariant gl_Position;
+
+layout(std140, set = 1, binding = 0) uniform FrameUBO {
+    mat4 view;
+    mat4 projection;
+    mat4 view_projection;
+} frame_ubo;
+
+struct Object {
+    mat4 model;
+    mat3 normal;
+    uvec4 material; // x: index into the material buffer
+};
+layout(std430, set = 0, binding = 0) readonly buffer ObjectBuffer {
+    Object objects[];
+};
+
+void main() {
+    vec4 world = objects[aObject].model * vec4(aPos, 1.0);
+    gl_Position = frame_ubo.view_projection * world;
+}
\ No newline at end of file
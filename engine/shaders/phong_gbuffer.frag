@@ -0,0 +1,35 @@
+#version 450
+
+// Geometry pass of the deferred renderer: writes the G-buffer instead of
+// shading. Lighting happens once per pixel in deferred_lighting.frag.
+// UNTEXTURED leaves out the texture fetch.
+layout(location = 0) in vec3 fragColor;
+layout (location = 1) in vec2 TexCoord;
+layout (location = 2) in vec3 Normal;
+layout (location = 3) in vec3 FragPos;
+
+#ifndef UNTEXTURED
+layout (location = 5) flat in uint fragLayer;
+layout (set = 2, binding = 0) uniform sampler2DArray texture1;
+#endif
+
+layout (location = 0) out vec4 outAlbedo; // rgb albedo, a = 1 for lit
+layout (location = 1) out vec2 outNormal; // octahedral
+
+vec2 oct_encode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0) {
+        vec2 s = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * s;
+    }
+    return n.xy;
+}
+
+void main() {
+#ifdef UNTEXTURED
+    outAlbedo = vec4(fragColor, 1.0);
+#else
+    outAlbedo = vec4(texture(texture1, vec3(TexCoord, fragLayer)).rgb * fragColor, 1.0);
+#endif
+    outNormal = oct_encode(normalize(Normal));
+}
\ No newline at end of file
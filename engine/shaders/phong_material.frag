@@ -1,31 +1,56 @@
 #version 450
 
+// Permutations (see SHADER_VARIANTS in engine/CMakeLists.txt):
+//   UNTEXTURED       no texture fetch; the sampler is left out
+//   NO_POINT_LIGHTS  ambient lighting only; the point light and cluster
+//                    buffers are left out
 layout(location = 0) in vec3 fragColor;
 layout (location = 1) in vec2 TexCoord;
 layout (location = 2) in vec3 Normal;
 layout (location = 3) in vec3 FragPos;
+layout (location = 4) in vec3 fragEmissive;
 
 struct AmbientLight {
     vec4 color; // rgb, a is intensity
 };
 struct PointLight {
-    vec4 position;  // xyz + padding
+    vec4 position;  // xyz + radius
     vec4 color;     // rgb + intensity
 };
 
-// Set 2: samplers, SSBOs
-layout (set = 2, binding = 0) uniform sampler2D texture1;
-layout (std430, set = 2, binding = 1) buffer AmbientBuffer {
+// cluster grid; must match PAL_LIGHT_GRID_* in scene/light_grid.h
+#define GRID_X 16u
+#define GRID_Y 9u
+#define GRID_Z 24u
+
+// Set 2: samplers, then SSBOs
+#ifdef UNTEXTURED
+#define FIRST_BUFFER 0
+#else
+#define FIRST_BUFFER 1
+layout (location = 5) flat in uint fragLayer;
+layout (set = 2, binding = 0) uniform sampler2DArray texture1;
+#endif
+layout (std430, set = 2, binding = FIRST_BUFFER) buffer AmbientBuffer {
     AmbientLight ambients[];
 };
-layout (std430, set = 2, binding = 2) buffer PointBuffer {
+#ifndef NO_POINT_LIGHTS
+layout (std430, set = 2, binding = FIRST_BUFFER + 1) buffer PointBuffer {
     PointLight points[];
 };
+// per cluster the offset and count of its run in light_indices
+layout (std430, set = 2, binding = FIRST_BUFFER + 2) readonly buffer ClusterBuffer {
+    uvec2 clusters[GRID_X * GRID_Y * GRID_Z];
+    uint light_indices[];
+};
+#endif
 
 // Frame UBO(s)
 layout (std140, set = 3, binding = 0) uniform FrameUBO {
     vec4 cam_pos;
     vec4 cam_rot;
+    vec4 view_z;        // view depth = dot(view_z.xyz, p) + view_z.w
+    vec4 cluster_scale; // tiles per pixel, then slice = log(depth) * z + w
     int ambient_count;
     int point_count;
     int pad0; int pad1; // std140 padding
@@ -35,9 +60,12 @@ layout (std140, set = 3, binding = 0) uniform FrameUBO {
 layout (location = 0) out vec4 outColor;
 
 void main() {
-    vec4 texColor = texture(texture1, TexCoord);
+#ifdef UNTEXTURED
+    vec4 texColor = vec4(1.0);
+#else
+    vec4 texColor = texture(texture1, vec3(TexCoord, fragLayer));
+#endif
     vec3 objectColor = texColor.rgb * fragColor;
-    vec3 view_xyz = ubo.cam_pos.xyz;
     vec3 norm = normalize(Normal);
 
     vec3 ambient_sum = vec3(0.0);
@@ -50,28 +78,41 @@ void main() {
         ambient_sum += intensity * rgb * objectColor;
     }
 
-    // point lights
     vec3 diffuse_sum = vec3(0.0);
     vec3 specular_sum = vec3(0.0);
-    for (int i = 0; i < ubo.point_count; i++) {
-        float intensity = points[i].color.a;
-        vec3 point_xyz = points[i].position.xyz;
-        vec3 light_dir = normalize(point_xyz - FragPos);
-        float light_dist = length(point_xyz - FragPos); // TODO: distance attenuation
-        vec3 point_rgb = points[i].color.rgb;
+#ifndef NO_POINT_LIGHTS
+    // point lights of this fragment's cluster
+    float depth = dot(ubo.view_z.xyz, FragPos) + ubo.view_z.w;
+    uvec2 tile = min(uvec2(gl_FragCoord.xy * ubo.cluster_scale.xy), uvec2(GRID_X - 1u, GRID_Y - 1u));
+    float slice = log(max(depth, 1e-6)) * ubo.cluster_scale.z + ubo.cluster_scale.w;
+    uint z = uint(clamp(slice, 0.0, float(GRID_Z - 1u)));
+    uvec2 cluster = clusters[(z * GRID_Y + tile.y) * GRID_X + tile.x];
+
+    vec3 view_dir = normalize(ubo.cam_pos.xyz - FragPos);
+    for (uint n = 0u; n < cluster.y; n++) {
+        PointLight point = points[light_indices[cluster.x + n]];
+        float intensity = point.color.a;
+        vec3 to_light = point.position.xyz - FragPos;
+        float light_dist = length(to_light);
+        vec3 light_dir = to_light / max(light_dist, 1e-6);
+        vec3 point_rgb = point.color.rgb;
+
+        // smooth falloff to zero at the radius
+        float falloff = clamp(1.0 - light_dist * light_dist / (point.position.w * point.position.w), 0.0, 1.0);
+        falloff *= falloff;
 
         // diffuse
         float diff = max(dot(norm, light_dir), 0.0);
-        diffuse_sum += intensity * point_rgb * diff * objectColor;
+        diffuse_sum += falloff * intensity * point_rgb * diff * objectColor;
 
         // specular
-        vec3 view_dir = normalize(view_xyz - FragPos);
         vec3 reflection_dir = reflect(-light_dir, norm);
         float spec = pow(max(dot(view_dir, reflection_dir), 0.0), 256);
-        specular_sum += 0.5 * spec * point_rgb;
+        specular_sum += falloff * 0.5 * spec * point_rgb;
     }
+#endif
 
     // Combine
-    vec3 result = ambient_sum + diffuse_sum + specular_sum;
+    vec3 result = ambient_sum + diffuse_sum + specular_sum + fragEmissive;
     outColor = vec4(result, texColor.a);
 }
\ No newline at end of file
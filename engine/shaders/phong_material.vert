@@ -3,28 +3,54 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
+layout(location = 3) in uint aObject;  // per-instance index into objects
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 TexCoord;
 layout(location = 2) out vec3 Normal;  // Pass transformed normal
 layout(location = 3) out vec3 FragPos;  // Pass world-space position for light calc
+layout(location = 4) out vec3 fragEmissive;
+layout(location = 5) flat out uint fragLayer;
+
+// matches depth_only.vert bit for bit, for the pre-pass EQUAL test
+invariant gl_Position;
 
 // Frame UBO
 layout(std140, set = 1, binding = 0) uniform FrameUBO {
     mat4 view;
     mat4 projection;
+    mat4 view_projection;
 } frame_ubo;
 
-// object ubo
-layout(std140, set = 1, binding = 1) uniform ObjectUBO {
+// per-draw objects
+struct Object {
     mat4 model;
+    mat3 normal; // inverse-transpose of the model's upper 3x3
+    uvec4 material; // x: index into the material buffer
+};
+layout(std430, set = 0, binding = 0) readonly buffer ObjectBuffer {
+    Object objects[];
+};
+
+// per-instance parameters (PAL_GPUMaterial)
+struct Material {
     vec4 color;
-} object_ubo;
+    vec4 emissive;
+    uvec4 texture; // x: layer of the texture array
+};
+layout(std430, set = 0, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+};
 
 void main() {
-    gl_Position = frame_ubo.projection * frame_ubo.view * object_ubo.model * vec4(aPos, 1.0);
-    fragColor = object_ubo.color.rgb;
+    Object obj = objects[aObject];
+    vec4 world = obj.model * vec4(aPos, 1.0);
+    gl_Position = frame_ubo.view_projection * world;
+    Material mat = materials[obj.material.x];
+    fragColor = mat.color.rgb;
+    fragEmissive = mat.emissive.rgb;
+    fragLayer = mat.texture.x;
     TexCoord = aTexCoord;
-    FragPos = vec3(object_ubo.model * vec4(aPos, 1.0));  // World pos
-    Normal = mat3(transpose(inverse(object_ubo.model))) * aNormal;  // Transform normal (normal matrix)
+    FragPos = world.xyz;  // World pos
+    Normal = obj.normal * aNormal;  // normal matrix is precomputed per object
 }
\ No newline at end of file
@@ -2,6 +2,9 @@
 #include <stdlib.h>
 
 #include <ecs/ecs.h>
+#include <geometry/g_common.h>
+#include <material/m_common.h>
+#include <scene/bvh.h>
 #include <ui/ui.h>
 
 static Uint32 next_entity_id = 0;
@@ -21,6 +24,7 @@ static GenericPool material_pool = {0};
 static GenericPool camera_pool = {0};
 static GenericPool fps_controller_pool = {0};
 static GenericPool billboard_pool = {0}; // no data, just presence
+static GenericPool occluder_pool = {0};
 static GenericPool ambient_light_pool = {0};
 static GenericPool point_light_pool = {0};
 static GenericPool ui_pool = {0};
@@ -45,15 +49,19 @@ static void grow_entity_map (GenericPool* pool, Uint32 min_entity) {
 // Helper to grow data and index_to_entity (dense)
 static void grow_data (GenericPool* pool, Uint64 component_size) {
     Uint32 new_cap = pool->data_capacity ? pool->data_capacity * 2 : 64;
-    void* new_data = realloc (pool->data, new_cap * component_size);
+    // flag pools have no data; realloc to zero bytes would free it
+    void* new_data = NULL;
+    if (component_size > 0) {
+        new_data = realloc (pool->data, new_cap * component_size);
+        if (new_data) pool->data = new_data;
+    }
     Uint32* new_idx_ent =
         (Uint32*) realloc (pool->index_to_entity, new_cap * sizeof (Uint32));
-    if (!new_data || !new_idx_ent) {
+    if (new_idx_ent) pool->index_to_entity = new_idx_ent;
+    if ((component_size > 0 && !new_data) || !new_idx_ent) {
         SDL_Log ("Failed to realloc data pool");
         return;
     }
-    pool->data = new_data;
-    pool->index_to_entity = new_idx_ent;
     pool->data_capacity = new_cap;
 }
 
@@ -124,6 +132,501 @@ pool_get (const GenericPool* pool, Entity e, Uint64 component_size) {
     return (char*) pool->data + idx * component_size;
 }
 
+// Light sync
+// point_ssbo mirrors the point light pool slot for slot, and light_mirror
+// holds the same GPUPointLights on the CPU. Adding, removing, moving or
+// editing a light marks its slot; extraction rewrites only the marked slots
+// of the mirror from the components, and recording stages only those,
+// merged into runs, in the frame's copy pass. The clusters are built from
+// the mirror, so they always agree with what the SSBO shades with, and a
+// light moved without being marked stays where it was in both. Ambient
+// lights are a handful of colours and are restaged whole when one changes.
+static GPUPointLight* light_mirror = NULL; // indexed by slot
+static Uint32 light_mirror_capacity = 0;
+static Uint32* light_dirty_slots = NULL;
+static Uint32 light_dirty_count = 0;
+static Uint32 light_dirty_capacity = 0;
+static bool* light_slot_dirty = NULL; // indexed by slot
+static Uint32 light_slot_capacity = 0;
+static bool light_resync = true; // restage every slot
+static bool ambient_dirty = true;
+
+static void mark_light_slot (Uint32 slot) {
+    if (light_resync) return;
+    if (slot >= light_slot_capacity) {
+        Uint32 new_cap = light_slot_capacity ? light_slot_capacity * 2 : 64;
+        if (new_cap <= slot) new_cap = slot + 1;
+        bool* new_flags =
+            (bool*) realloc (light_slot_dirty, new_cap * sizeof (bool));
+        if (!new_flags) {
+            light_resync = true;
+            return;
+        }
+        memset (
+            new_flags + light_slot_capacity, 0,
+            (new_cap - light_slot_capacity) * sizeof (bool)
+        );
+        light_slot_dirty = new_flags;
+        light_slot_capacity = new_cap;
+    }
+    if (light_slot_dirty[slot]) return;
+
+    if (light_dirty_count == light_dirty_capacity) {
+        Uint32 new_cap = light_dirty_capacity ? light_dirty_capacity * 2 : 64;
+        Uint32* new_slots =
+            (Uint32*) realloc (light_dirty_slots, new_cap * sizeof (Uint32));
+        if (!new_slots) {
+            // a full restage covers whatever can't be tracked
+            light_resync = true;
+            return;
+        }
+        light_dirty_slots = new_slots;
+        light_dirty_capacity = new_cap;
+    }
+    light_dirty_slots[light_dirty_count++] = slot;
+    light_slot_dirty[slot] = true;
+}
+
+// Render frames
+// render_system works in two steps. Extraction runs on the caller's thread
+// and snapshots everything the GPU work needs from the components: the
+// camera, sorted draws with their object constants, changes for the GPU
+// culler, lights and UI rects. Recording then builds and submits the command
+// buffer from that snapshot alone, either straight away or on the render
+// thread while the caller simulates the next frame. Two frames alternate so
+// one can be extracted while the other is recorded. The upload ring, the
+// culler, the light grid and the GPU buffers belong to the recording side.
+
+// a visible mesh; entity and trans are only read during extraction
+typedef struct {
+    PAL_DrawState state;
+    Uint32 num_elements; // indices, or vertices without an index buffer
+    Uint32 first_index;
+    Sint32 vertex_offset;
+    Entity entity;
+    const TransformComponent* trans;
+    Uint32 material; // parameter index
+} DrawItem;
+
+typedef struct {
+    Uint32 id;
+    bool remove;
+    PAL_CullBatchInfo batch;
+    PAL_CullInstance instance;
+} CullUpdate;
+
+// a UI component's rects and what it draws them with
+typedef struct {
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUBuffer* vbo;
+    SDL_GPUBuffer* ibo;
+    SDL_GPUSampler* sampler;
+    SDL_GPUTexture* white_texture;
+    Uint32 first_rect;
+    Uint32 num_rects;
+    bool staged; // vertices made it into the upload ring
+} UIBatch;
+
+struct PAL_RenderFrame {
+    // camera; a frame without one is submitted empty
+    bool has_camera;
+    mat4 view;
+    mat4 proj;
+    mat4 view_proj;
+    frustum frustum;
+    vec3 cam_pos;
+    vec4 cam_rot;
+    float near_clip;
+    float far_clip;
+    // CPU culling: draws sorted by state, with their object constants
+    DrawItem* draws;
+    PAL_GPUObject* objects;
+    Uint32 num_draws;
+    Uint32 draw_capacity;
+    Uint32 object_capacity;
+    // GPU culling: scene changes since the last frame
+    CullUpdate* cull_updates;
+    Uint32 num_cull_updates;
+    Uint32 cull_update_capacity;
+    // every light, as in light_mirror, and the point light slots changed
+    // since the last frame
+    GPUAmbientLight* ambient_lights;
+    Uint32 num_ambient_lights;
+    Uint32 ambient_light_capacity;
+    bool ambient_dirty;
+    GPUPointLight* point_lights;
+    Uint32 num_point_lights;
+    Uint32 point_light_capacity;
+    Uint32* dirty_slots; // ascending
+    Uint32 num_dirty_slots;
+    Uint32 dirty_slot_capacity;
+    bool light_resync;
+    // the material parameter table when it changed; recording clears the
+    // flag once it is staged, else finish_frame has it extracted again
+    PAL_GPUMaterial* materials;
+    Uint32 num_materials;
+    Uint32 material_capacity;
+    bool materials_dirty;
+    // UI; text textures and pixels belong to the frame until it is recorded
+    UIBatch* ui;
+    Uint32 num_ui;
+    Uint32 ui_capacity;
+    UIRect* rects;
+    Uint32 num_rects;
+    Uint32 rect_capacity;
+    // texture array growths the frame's textures are current for; textures
+    // retired by later growths may still be bound
+    Uint32 texture_growths;
+    // results, read on the caller's thread once the frame is recorded
+    SDL_AppResult result;
+    // textures retired by this many growths are bound by no frame the GPU
+    // may still run (see PAL_ReleaseRetiredTextures)
+    Uint32 unbound_growths;
+    bool skipped;
+    Uint32 width; // swapchain size, 0 if none was acquired
+    Uint32 height;
+    PAL_FrameStats stats;
+    Uint64 prerender;
+    Uint64 preui;
+    Uint64 postrender;
+};
+
+// grows an array to hold count elements of size bytes
+static bool
+grow_array (void** data, Uint32* capacity, Uint32 count, Uint64 size) {
+    if (count <= *capacity) return true;
+    Uint32 new_cap = *capacity ? *capacity : 64;
+    while (new_cap < count) new_cap *= 2;
+    void* new_data = realloc (*data, new_cap * size);
+    if (new_data == NULL) return false;
+    *data = new_data;
+    *capacity = new_cap;
+    return true;
+}
+
+static int SDLCALL render_thread_main (void* data);
+
+static void free_frame (PAL_RenderFrame* frame) {
+    if (frame == NULL) return;
+    free (frame->draws);
+    free (frame->objects);
+    free (frame->cull_updates);
+    free (frame->ambient_lights);
+    free (frame->point_lights);
+    free (frame->dirty_slots);
+    free (frame->materials);
+    free (frame->ui);
+    free (frame->rects);
+    free (frame);
+}
+
+// Scene index
+// Renderables (mesh + transform) live in a dynamic BVH, or in the GPU culler
+// when GPU culling is on. Component changes only mark the entity dirty; the
+// index is updated once per frame in render_system.
+#define SCENE_BVH_MARGIN 0.1f
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 128
+#define OCCLUDER_MIN_SIZE 2.0f // world-space diagonal for automatic occluders
+#define MAX_OCCLUDERS 64
+#define UPLOAD_RING_SIZE (1u << 20)
+#define MIN_DRAW_CAPACITY 256
+#define CULL_THREADS 64 // local_size_x in cull.comp
+#define GBUFFER_ALBEDO_FORMAT SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM
+#define GBUFFER_NORMAL_FORMAT SDL_GPU_TEXTUREFORMAT_R16G16_FLOAT
+#define FRAME_TIME_SMOOTHING 0.1f  // weight of the newest frame interval
+#define RENDER_SCALE_DEADBAND 0.05f // frame time error left alone
+#define RENDER_SCALE_DROP 0.9f      // largest per-frame steps; drop fast,
+#define RENDER_SCALE_RAISE 1.02f    // recover slowly so it doesn't oscillate
+
+typedef struct {
+    Uint32 proxy;
+    bool dirty;
+    bool occluder; // rasterized into the occlusion buffer this frame
+    Uint8 lod;     // last selected level, for hysteresis
+} SceneEntry;
+
+static PAL_BVH* scene_bvh = NULL;
+static SceneEntry* scene_entries = NULL;
+static Uint32 scene_capacity = 0;
+static Entity* scene_dirty = NULL;
+static Uint32 scene_dirty_count = 0;
+static Uint32 scene_dirty_capacity = 0;
+// PAL_GetMaterialTemplateSettles last seen
+static Uint32 template_settles = 0;
+// PAL_GetTextureArrayGrowths the culler's instances were last refreshed for
+static Uint32 texture_growths = 0;
+
+static SceneEntry* scene_entry (Entity e) {
+    if (e >= scene_capacity) {
+        Uint32 new_cap = scene_capacity ? scene_capacity * 2 : 1024;
+        if (new_cap <= e) new_cap = e + 1;
+        SceneEntry* new_entries = (SceneEntry*) realloc (
+            scene_entries, new_cap * sizeof (SceneEntry)
+        );
+        if (!new_entries) {
+            SDL_Log ("Failed to realloc scene entries");
+            return NULL;
+        }
+        for (Uint32 i = scene_capacity; i < new_cap; i++) {
+            new_entries[i] = (SceneEntry) {.proxy = PAL_BVH_NULL};
+        }
+        scene_entries = new_entries;
+        scene_capacity = new_cap;
+    }
+    return &scene_entries[e];
+}
+
+void mark_transform_dirty (Entity e) {
+    if (pool_has (&point_light_pool, e)) {
+        mark_light_slot (point_light_pool.entity_to_index[e]);
+    }
+
+    SceneEntry* entry = scene_entry (e);
+    if (entry == NULL || entry->dirty) return;
+
+    if (scene_dirty_count == scene_dirty_capacity) {
+        Uint32 new_cap = scene_dirty_capacity ? scene_dirty_capacity * 2 : 256;
+        Entity* new_dirty =
+            (Entity*) realloc (scene_dirty, new_cap * sizeof (Entity));
+        if (!new_dirty) {
+            SDL_Log ("Failed to realloc scene dirty list");
+            return;
+        }
+        scene_dirty = new_dirty;
+        scene_dirty_capacity = new_cap;
+    }
+    scene_dirty[scene_dirty_count++] = e;
+    entry->dirty = true;
+}
+
+static void scene_remove (Entity e) {
+    if (e >= scene_capacity || scene_entries[e].proxy == PAL_BVH_NULL) return;
+    PAL_BVHRemove (scene_bvh, scene_entries[e].proxy);
+    scene_entries[e].proxy = PAL_BVH_NULL;
+}
+
+static void
+model_matrix (Entity e, const TransformComponent* trans, vec4 cam_rot, mat4 m) {
+    mat4_identity (m);
+    if (has_billboard (e)) {
+        mat4_translate (m, trans->position);
+        mat4_rotate_quat (m, cam_rot);
+        mat4_rotate_y (m, (float) M_PI);
+        mat4_scale (m, trans->scale);
+    } else {
+        mat4_translate (m, trans->position);
+        mat4_rotate_quat (m, trans->rotation);
+        mat4_scale (m, trans->scale);
+    }
+}
+
+// fills the model and normal matrices of an object
+static void object_transform (
+    PAL_GPUObject* object,
+    Entity e,
+    const TransformComponent* trans,
+    vec4 cam_rot
+) {
+    model_matrix (e, trans, cam_rot, object->model);
+    vec3 s = trans->scale;
+    mat3 normal;
+    if (s.x == s.y && s.y == s.z && s.x != 0.0f) {
+        // rotation times a uniform scale s: the inverse-transpose is the
+        // same matrix divided by s^2, no inverse needed
+        float k = 1.0f / (s.x * s.x);
+        for (Uint32 col = 0; col < 3; col++) {
+            for (Uint32 row = 0; row < 3; row++) {
+                normal[MAT3_IDX (row, col)] =
+                    object->model[MAT4_IDX (row, col)] * k;
+            }
+        }
+    } else {
+        mat3_normal (normal, object->model);
+    }
+    for (Uint32 col = 0; col < 3; col++) {
+        object->normal[col] = (vec4) {
+            normal[MAT3_IDX (0, col)], normal[MAT3_IDX (1, col)],
+            normal[MAT3_IDX (2, col)], 0.0f
+        };
+    }
+}
+
+static aabb world_bounds (
+    Entity e,
+    const TransformComponent* trans,
+    const PAL_MeshComponent* mesh
+) {
+    if (has_billboard (e)) {
+        // billboards follow the camera, so bound every orientation
+        vec3 lo = mesh->bounds.min;
+        vec3 hi = mesh->bounds.max;
+        vec3 far = {
+            fmaxf (fabsf (lo.x), fabsf (hi.x)),
+            fmaxf (fabsf (lo.y), fabsf (hi.y)),
+            fmaxf (fabsf (lo.z), fabsf (hi.z)),
+        };
+        float scale = fmaxf (
+            fabsf (trans->scale.x),
+            fmaxf (fabsf (trans->scale.y), fabsf (trans->scale.z))
+        );
+        float r = sqrtf (vec3_dot (far, far)) * scale;
+        vec3 ext = {r, r, r};
+        return (aabb) {
+            .min = vec3_sub (trans->position, ext),
+            .max = vec3_add (trans->position, ext),
+        };
+    }
+    mat4 model;
+    model_matrix (e, trans, (vec4) {0.0f, 0.0f, 0.0f, 1.0f}, model);
+    return aabb_transform (mesh->bounds, model);
+}
+
+static Uint32 select_lod (
+    Entity e,
+    const TransformComponent* trans,
+    const PAL_MeshComponent* mesh,
+    vec3 cam_pos,
+    float pixels_per_radian
+) {
+    vec3 s = trans->scale;
+    float scale = fmaxf (fabsf (s.x), fmaxf (fabsf (s.y), fabsf (s.z)));
+    vec3 c = aabb_center (mesh->bounds);
+    c = (vec3) {c.x * s.x, c.y * s.y, c.z * s.z};
+    vec3 center = vec3_add (trans->position, vec3_rotate (trans->rotation, c));
+    vec3 half = vec3_sub (mesh->bounds.max, aabb_center (mesh->bounds));
+
+    // distance to the nearest point of the bounding sphere
+    vec3 to_center = vec3_sub (center, cam_pos);
+    float dist = sqrtf (vec3_dot (to_center, to_center)) -
+                 sqrtf (vec3_dot (half, half)) * scale;
+    dist = fmaxf (dist, 1e-3f);
+
+    SceneEntry* entry = &scene_entries[e];
+    entry->lod = (Uint8) PAL_SelectMeshLOD (
+        mesh, pixels_per_radian * scale / dist, entry->lod
+    );
+    return entry->lod;
+}
+
+// queues a dirty entity for the GPU culler, or its removal if it can't be
+// drawn; scene_update has made room for it
+static void cull_update (PAL_RenderFrame* frame, Entity e) {
+    CullUpdate* update = &frame->cull_updates[frame->num_cull_updates++];
+    *update = (CullUpdate) {.id = e};
+    TransformComponent* trans = get_transform (e);
+    PAL_MeshComponent* mesh = has_mesh (e) ? PAL_GetMeshComponent (e) : NULL;
+    PAL_MaterialComponent* mat =
+        has_material (e) ? PAL_GetMaterialComponent (e) : NULL;
+    const PAL_MaterialTemplate* tmpl =
+        mat ? PAL_ResolveMaterialTemplate (mat->tmpl) : NULL;
+    if (!trans || !mesh || !tmpl) {
+        update->remove = true;
+        return;
+    }
+
+    PAL_CullBatchInfo* batch = &update->batch;
+    *batch = (PAL_CullBatchInfo) {
+        .pipeline = tmpl->pipeline,
+        .depth_pipeline = tmpl->depth_pipeline,
+        .ambient_pipeline = tmpl->ambient_pipeline,
+        .texture = PAL_GetTextureArrayTexture (mat->texture.array),
+        .sampler = mat->sampler,
+        .index_size = mesh->index_size,
+        .num_lods = mesh->num_lods ? mesh->num_lods : 1,
+    };
+    if (mesh->num_lods == 0) {
+        batch->lods[0] = (PAL_CullLOD) {
+            .vertex_buffer = mesh->vertex_buffer,
+            .index_buffer = mesh->index_buffer,
+            .num_indices = mesh->num_indices,
+            .first_index = mesh->first_index,
+            .vertex_offset = mesh->vertex_offset,
+        };
+    }
+    for (Uint32 l = 0; l < mesh->num_lods; l++) {
+        const PAL_MeshLOD* lod = &mesh->lods[l];
+        batch->lods[l] = (PAL_CullLOD) {
+            .vertex_buffer = lod->vertex_buffer,
+            .index_buffer = lod->index_buffer,
+            .num_indices = lod->num_indices,
+            .first_index = lod->first_index,
+            .vertex_offset = lod->vertex_offset,
+            .error = lod->error,
+        };
+    }
+
+    // billboards are turned towards the camera by the culling pass
+    update->instance = (PAL_CullInstance) {
+        .object.material = mat->params,
+        .bounds = mesh->bounds,
+        .billboard = has_billboard (e),
+    };
+    object_transform (
+        &update->instance.object, e, trans, (vec4) {0.0f, 0.0f, 0.0f, 1.0f}
+    );
+}
+
+static void scene_update (PAL_GPURenderer* renderer, PAL_RenderFrame* frame) {
+    if (renderer->culler) {
+        // the culler holds the pipelines and texture an instance was added
+        // with, so a template that finished loading or failed, or a texture
+        // array that grew, re-adds every material's instance
+        Uint32 settles = PAL_GetMaterialTemplateSettles ();
+        Uint32 growths = PAL_GetTextureArrayGrowths ();
+        if (settles != template_settles || growths != texture_growths) {
+            template_settles = settles;
+            for (Uint32 i = 0; i < material_pool.count; i++) {
+                mark_transform_dirty (material_pool.index_to_entity[i]);
+            }
+        }
+        // without room the entities stay dirty until the next frame
+        if (!grow_array (
+                (void**) &frame->cull_updates, &frame->cull_update_capacity,
+                scene_dirty_count, sizeof (CullUpdate)
+            )) {
+            SDL_Log ("Failed to grow culler updates");
+            return;
+        }
+        for (Uint32 i = 0; i < scene_dirty_count; i++) {
+            scene_entries[scene_dirty[i]].dirty = false;
+            cull_update (frame, scene_dirty[i]);
+        }
+        scene_dirty_count = 0;
+        texture_growths = growths;
+        return;
+    }
+
+    if (scene_bvh == NULL) {
+        scene_bvh = PAL_CreateBVH (SCENE_BVH_MARGIN);
+        if (scene_bvh == NULL) return;
+    }
+
+    for (Uint32 i = 0; i < scene_dirty_count; i++) {
+        Entity e = scene_dirty[i];
+        SceneEntry* entry = &scene_entries[e];
+        entry->dirty = false;
+
+        TransformComponent* trans = get_transform (e);
+        PAL_MeshComponent* mesh =
+            has_mesh (e) ? PAL_GetMeshComponent (e) : NULL;
+        if (trans == NULL || mesh == NULL) {
+            scene_remove (e);
+            continue;
+        }
+
+        aabb box = world_bounds (e, trans, mesh);
+        if (entry->proxy == PAL_BVH_NULL) {
+            entry->proxy = PAL_BVHInsert (scene_bvh, e, box);
+        } else {
+            PAL_BVHMove (scene_bvh, entry->proxy, box);
+        }
+    }
+    scene_dirty_count = 0;
+
+    PAL_BVHMaintain (scene_bvh);
+}
+
 Entity create_entity (void) {
     return next_entity_id++;
 }
@@ -135,6 +638,7 @@ void destroy_entity (SDL_GPUDevice* device, Entity e) {
     remove_camera (e);
     remove_fps_controller (e);
     remove_billboard (e);
+    remove_occluder (e);
     remove_ambient_light (e);
     remove_point_light (e);
     remove_ui (e);
@@ -148,6 +652,7 @@ void add_transform (Entity e, const PAL_TransformCreateInfo* info) {
         .scale = info->scale
     };
     pool_add (&transform_pool, e, &comp, sizeof (TransformComponent));
+    mark_transform_dirty (e);
 }
 TransformComponent* get_transform (Entity e) {
     return (TransformComponent*) pool_get (
@@ -159,11 +664,22 @@ bool has_transform (Entity e) {
 }
 void remove_transform (Entity e) {
     pool_remove (&transform_pool, e, sizeof (TransformComponent));
+    scene_remove (e);
+    mark_transform_dirty (e);
 }
 
 // Meshes
-void PAL_AddMeshComponent (Entity e, PAL_MeshComponent* mesh) {
+void PAL_AddMeshComponent (
+    SDL_GPUDevice* device,
+    Entity e,
+    PAL_MeshComponent* mesh
+) {
+    // retained first, so re-adding the same mesh can't release it
+    PAL_RetainMesh (mesh);
+    // a replaced mesh loses this entity's reference like in remove_mesh
+    if (has_mesh (e)) PAL_ReleaseMesh (device, PAL_GetMeshComponent (e));
     pool_add (&mesh_pool, e, &mesh, sizeof (PAL_MeshComponent*));
+    mark_transform_dirty (e);
 }
 PAL_MeshComponent* PAL_GetMeshComponent (Entity e) {
     PAL_MeshComponent** mesh = (PAL_MeshComponent**) pool_get (
@@ -175,19 +691,18 @@ bool has_mesh (Entity e) {
     return pool_has (&mesh_pool, e);
 }
 void remove_mesh (SDL_GPUDevice* device, Entity e) {
-    PAL_MeshComponent* mesh = PAL_GetMeshComponent (e);
-    if (mesh) {
-        if (mesh->vertex_buffer)
-            SDL_ReleaseGPUBuffer (device, mesh->vertex_buffer);
-        if (mesh->index_buffer)
-            SDL_ReleaseGPUBuffer (device, mesh->index_buffer);
-    }
+    if (!has_mesh (e)) return;
+    // shared meshes keep their buffers until the last entity lets go
+    PAL_ReleaseMesh (device, PAL_GetMeshComponent (e));
     pool_remove (&mesh_pool, e, sizeof (PAL_MeshComponent*));
+    scene_remove (e);
+    mark_transform_dirty (e);
 }
 
 // Materials
 void PAL_AddMaterialComponent (Entity e, PAL_MaterialComponent* material) {
     pool_add (&material_pool, e, &material, sizeof (PAL_MaterialComponent*));
+    mark_transform_dirty (e);
 }
 PAL_MaterialComponent* PAL_GetMaterialComponent (Entity e) {
     PAL_MaterialComponent** mat = (PAL_MaterialComponent**) pool_get (
@@ -199,18 +714,93 @@ bool has_material (Entity e) {
     return pool_has (&material_pool, e);
 }
 void remove_material (SDL_GPUDevice* device, Entity e) {
+    if (!has_material (e)) return;
     PAL_MaterialComponent* mat = PAL_GetMaterialComponent (e);
     if (mat) {
-        if (mat->texture) SDL_ReleaseGPUTexture (device, mat->texture);
-        if (mat->pipeline)
-            SDL_ReleaseGPUGraphicsPipeline (device, mat->pipeline);
-        if (mat->vertex_shader)
-            SDL_ReleaseGPUShader (device, mat->vertex_shader);
-        if (mat->fragment_shader)
-            SDL_ReleaseGPUShader (device, mat->fragment_shader);
-        if (mat->sampler) SDL_ReleaseGPUSampler (device, mat->sampler);
+        PAL_ReleaseTextureLayer (mat->texture);
+        PAL_ReleaseSampler (device, mat->sampler);
+        // the template and its pipelines go with their last instance
+        PAL_ReleaseMaterialTemplate (device, mat->tmpl);
+        PAL_RemoveMaterialParams (mat->params);
+        free (mat);
+    }
+    pool_remove (&material_pool, e, sizeof (PAL_MaterialComponent*));
+    mark_transform_dirty (e);
+}
+
+// Material parameters
+// Instances index one table of parameters, mirrored by the renderer's
+// material_ssbo; removed indices are reused. It is a few bytes per material
+// and rarely changes, so like the ambient lights it is restaged whole when
+// anything in it does. The free list is kept as large as the table, so
+// removing never fails, and each index records whether it is live so one
+// can't be removed (and later handed out) twice.
+static PAL_GPUMaterial* material_params = NULL;
+static Uint32 material_param_count = 0; // removed entries included
+static Uint32 material_param_capacity = 0;
+static bool* param_live = NULL; // indexed like material_params
+static Uint32 param_live_capacity = 0;
+static Uint32* free_params = NULL;
+static Uint32 free_param_count = 0;
+static Uint32 free_param_capacity = 0;
+static bool materials_dirty = true;
+
+Uint32 PAL_AddMaterialParams (const PAL_GPUMaterial* params) {
+    Uint32 index;
+    if (free_param_count > 0) {
+        index = free_params[--free_param_count];
+    } else {
+        Uint32 count = material_param_count + 1;
+        if (count == PAL_MATERIAL_NULL ||
+            !grow_array (
+                (void**) &material_params, &material_param_capacity, count,
+                sizeof (PAL_GPUMaterial)
+            ) ||
+            !grow_array (
+                (void**) &free_params, &free_param_capacity, count,
+                sizeof (Uint32)
+            ) ||
+            !grow_array (
+                (void**) &param_live, &param_live_capacity, count,
+                sizeof (bool)
+            )) {
+            SDL_Log ("Failed to grow material parameters");
+            return PAL_MATERIAL_NULL;
+        }
+        index = material_param_count++;
+    }
+    material_params[index] = *params;
+    param_live[index] = true;
+    materials_dirty = true;
+    return index;
+}
+
+static bool params_live (Uint32 index) {
+    return index < material_param_count && param_live[index];
+}
+
+// valid until parameters are next added
+const PAL_GPUMaterial* PAL_GetMaterialParams (Uint32 index) {
+    if (!params_live (index)) return NULL;
+    return &material_params[index];
+}
+
+void PAL_SetMaterialParams (Uint32 index, const PAL_GPUMaterial* params) {
+    if (!params_live (index)) return;
+    Uint32 layer = material_params[index].layer;
+    material_params[index] = *params;
+    material_params[index].layer = layer;
+    materials_dirty = true;
+}
+
+void PAL_RemoveMaterialParams (Uint32 index) {
+    if (index == PAL_MATERIAL_NULL) return;
+    if (!params_live (index)) {
+        SDL_Log ("Material parameters %u aren't in use", index);
+        return;
     }
-    pool_remove (&material_pool, e, sizeof (PAL_MaterialComponent));
+    param_live[index] = false;
+    free_params[free_param_count++] = index;
 }
 
 // Cameras
@@ -261,12 +851,61 @@ void remove_fps_controller (Entity e) {
 // Billboards (flag, no data)
 void add_billboard (Entity e) {
     pool_add (&billboard_pool, e, NULL, 0); // no data copy
+    mark_transform_dirty (e);
 }
 bool has_billboard (Entity e) {
     return pool_has (&billboard_pool, e);
 }
 void remove_billboard (Entity e) {
     pool_remove (&billboard_pool, e, 0);
+    mark_transform_dirty (e);
+}
+
+// Occluders
+void add_occluder (Entity e, const PAL_OccluderCreateInfo* info) {
+    remove_occluder (e);
+    OccluderComponent comp = {0};
+    if (info && info->positions && info->num_indices > 0) {
+        comp.positions = malloc (info->num_positions * sizeof (vec3));
+        comp.indices = malloc (info->num_indices * sizeof (Uint32));
+        if (!comp.positions || !comp.indices) {
+            SDL_Log ("Failed to allocate occluder geometry");
+            free (comp.positions);
+            free (comp.indices);
+            return;
+        }
+        memcpy (
+            comp.positions, info->positions,
+            info->num_positions * sizeof (vec3)
+        );
+        memcpy (
+            comp.indices, info->indices, info->num_indices * sizeof (Uint32)
+        );
+        comp.num_positions = info->num_positions;
+        comp.num_indices = info->num_indices;
+        comp.bounds = aabb_empty ();
+        for (Uint32 i = 0; i < comp.num_positions; i++) {
+            vec3 p = comp.positions[i];
+            comp.bounds = aabb_union (comp.bounds, (aabb) {p, p});
+        }
+    }
+    pool_add (&occluder_pool, e, &comp, sizeof (OccluderComponent));
+}
+OccluderComponent* get_occluder (Entity e) {
+    return (OccluderComponent*) pool_get (
+        &occluder_pool, e, sizeof (OccluderComponent)
+    );
+}
+bool has_occluder (Entity e) {
+    return pool_has (&occluder_pool, e);
+}
+void remove_occluder (Entity e) {
+    OccluderComponent* occ = get_occluder (e);
+    if (occ) {
+        free (occ->positions);
+        free (occ->indices);
+    }
+    pool_remove (&occluder_pool, e, sizeof (OccluderComponent));
 }
 
 void add_ui (Entity e, UIComponent* ui) {
@@ -286,73 +925,7 @@ void remove_ui (Entity e) {
 void add_ambient_light (Entity e, const PAL_AmbientLightCreateInfo* info) {
     AmbientLightComponent comp = info->color;
     pool_add (&ambient_light_pool, e, &comp, sizeof (AmbientLightComponent));
-
-    GPUAmbientLight all_lights[ambient_light_pool.count];
-    for (Uint32 i = 0; i < ambient_light_pool.count; i++) {
-        Entity light_entity = ambient_light_pool.index_to_entity[i];
-        GPUAmbientLight gpu_light = {0};
-
-        AmbientLightComponent* light = get_ambient_light (light_entity);
-        gpu_light = light ? *light : (SDL_FColor) {1.0f, 1.0f, 1.0f, 1.0f};
-
-        all_lights[i] = gpu_light;
-    }
-
-    Uint32 ssbo_size = ambient_light_pool.count * sizeof (GPUAmbientLight);
-    ssbo_size = ssbo_size > 1024 ? ssbo_size : 1024;
-    if (info->renderer->ambient_ssbo &&
-        info->renderer->ambient_size < ssbo_size) {
-        SDL_ReleaseGPUBuffer (
-            info->renderer->device, info->renderer->ambient_ssbo
-        );
-        info->renderer->ambient_ssbo = NULL;
-        info->renderer->ambient_size = 0;
-    }
-
-    if (info->renderer->ambient_ssbo == NULL) {
-        SDL_GPUBufferCreateInfo ssbo_info = {
-            .size = ssbo_size,
-            .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
-        };
-        info->renderer->ambient_ssbo =
-            SDL_CreateGPUBuffer (info->renderer->device, &ssbo_info);
-        if (info->renderer->ambient_ssbo == NULL) {
-            return;
-        }
-    }
-
-    SDL_GPUTransferBufferCreateInfo tbuf_info = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = ssbo_size,
-    };
-    SDL_GPUTransferBuffer* tbuf =
-        SDL_CreateGPUTransferBuffer (info->renderer->device, &tbuf_info);
-    void* map = SDL_MapGPUTransferBuffer (info->renderer->device, tbuf, false);
-    if (map == NULL) {
-        SDL_ReleaseGPUTransferBuffer (info->renderer->device, tbuf);
-        return;
-    }
-    memcpy (map, all_lights, sizeof (all_lights));
-    GPUAmbientLight* mapped_light = (GPUAmbientLight*) map;
-    SDL_UnmapGPUTransferBuffer (info->renderer->device, tbuf);
-
-    // upload data
-    SDL_GPUCommandBuffer* cmd =
-        SDL_AcquireGPUCommandBuffer (info->renderer->device);
-    SDL_GPUCopyPass* pass = SDL_BeginGPUCopyPass (cmd);
-    SDL_GPUTransferBufferLocation tbuf_loc = {
-        .transfer_buffer = tbuf,
-        .offset = 0,
-    };
-    SDL_GPUBufferRegion tbuf_region = {
-        .buffer = info->renderer->ambient_ssbo,
-        .offset = 0,
-        .size = sizeof (all_lights),
-    };
-    SDL_UploadToGPUBuffer (pass, &tbuf_loc, &tbuf_region, false);
-    SDL_EndGPUCopyPass (pass);
-    SDL_SubmitGPUCommandBuffer (cmd);
-    SDL_ReleaseGPUTransferBuffer (info->renderer->device, tbuf);
+    ambient_dirty = true;
 }
 AmbientLightComponent* get_ambient_light (Entity e) {
     return (AmbientLightComponent*) pool_get (
@@ -363,105 +936,21 @@ bool has_ambient_light (Entity e) {
     return pool_has (&ambient_light_pool, e);
 }
 void remove_ambient_light (Entity e) {
+    if (!pool_has (&ambient_light_pool, e)) return;
     pool_remove (&ambient_light_pool, e, sizeof (AmbientLightComponent));
+    ambient_dirty = true;
 }
 
 // Point Lights
-// TODO: bulk initialize point lights
-// TODO: communicate failure to caller
-// TODO: what if the transform is added after the point light?
+// Changes only mark the light's slot (see Light sync); positions are read
+// from the transform when the slot is next extracted.
 void add_point_light (Entity e, const PAL_PointLightCreateInfo* info) {
-    PointLightComponent comp = info->color;
-    pool_add (&point_light_pool, e, &comp, sizeof (PointLightComponent));
-
-    // reconstruct point light buffer
-    GPUPointLight all_lights[point_light_pool.count];
-    for (Uint32 i = 0; i < point_light_pool.count; i++) {
-        // create gpu light
-        Entity light_entity = point_light_pool.index_to_entity[i];
-        GPUPointLight gpu_light = {0};
-
-        // copy in the color
-        PointLightComponent* light = get_point_light (light_entity);
-        // light = NULL;
-        gpu_light.color =
-            light ? *light : (SDL_FColor) {1.0f, 1.0f, 1.0f, 1.0f};
-
-        // copy in the position
-        TransformComponent* transform = get_transform (light_entity);
-        vec4 position;
-        if (transform) {
-            position.x = transform->position.x;
-            position.y = transform->position.y;
-            position.z = transform->position.z;
-            position.w = 0.0f;
-        } else {
-            position = (vec4) {0};
-        }
-        gpu_light.position = position;
-
-        all_lights[i] = gpu_light;
-    }
-
-    // release existing ssbo if it's too small
-    Uint32 ssbo_size = point_light_pool.count * sizeof (GPUPointLight);
-    ssbo_size = ssbo_size > 1024 ? ssbo_size : 1024;
-    if (info->renderer->point_ssbo && info->renderer->point_size < ssbo_size) {
-        SDL_ReleaseGPUBuffer (
-            info->renderer->device, info->renderer->point_ssbo
-        );
-        info->renderer->point_ssbo = NULL;
-        info->renderer->point_size = 0;
-    }
-
-    // if ssbo is uninitialized (or if it was released because too small),
-    // create one
-    if (info->renderer->point_ssbo == NULL) {
-        SDL_GPUBufferCreateInfo ssbo_info = {
-            .size = ssbo_size,
-            .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
-        };
-        info->renderer->point_ssbo =
-            SDL_CreateGPUBuffer (info->renderer->device, &ssbo_info);
-        if (info->renderer->point_ssbo == NULL) {
-            return;
-        }
-        info->renderer->point_size = ssbo_size;
-    }
-
-    // create transfer buffer
-    SDL_GPUTransferBufferCreateInfo tbuf_info = {
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = ssbo_size
-    };
-    SDL_GPUTransferBuffer* tbuf =
-        SDL_CreateGPUTransferBuffer (info->renderer->device, &tbuf_info);
-    void* map = SDL_MapGPUTransferBuffer (info->renderer->device, tbuf, false);
-    if (map == NULL) {
-        SDL_ReleaseGPUTransferBuffer (info->renderer->device, tbuf);
-        return;
-    }
-    memcpy (map, all_lights, sizeof (all_lights));
-    GPUPointLight* mapped_light = (GPUPointLight*) map;
-    SDL_UnmapGPUTransferBuffer (info->renderer->device, tbuf);
-
-    // upload data
-    SDL_GPUCommandBuffer* cmd =
-        SDL_AcquireGPUCommandBuffer (info->renderer->device);
-    SDL_GPUCopyPass* pass = SDL_BeginGPUCopyPass (cmd);
-    SDL_GPUTransferBufferLocation tbuf_loc = {
-        .transfer_buffer = tbuf,
-        .offset = 0,
-    };
-    SDL_GPUBufferRegion tbuf_region = {
-        .buffer = info->renderer->point_ssbo,
-        .offset = 0,
-        .size = sizeof (all_lights),
+    PointLightComponent comp = {
+        .color = info->color,
+        .radius = info->radius > 0.0f ? info->radius : PAL_POINT_LIGHT_RADIUS,
     };
-    SDL_UploadToGPUBuffer (pass, &tbuf_loc, &tbuf_region, false);
-    SDL_EndGPUCopyPass (pass);
-    SDL_SubmitGPUCommandBuffer (cmd);
-    SDL_ReleaseGPUTransferBuffer (info->renderer->device, tbuf);
+    pool_add (&point_light_pool, e, &comp, sizeof (PointLightComponent));
+    mark_light_slot (point_light_pool.entity_to_index[e]);
 }
 PointLightComponent* get_point_light (Entity e) {
     return (PointLightComponent*) pool_get (
@@ -472,7 +961,182 @@ bool has_point_light (Entity e) {
     return pool_has (&point_light_pool, e);
 }
 void remove_point_light (Entity e) {
+    if (!pool_has (&point_light_pool, e)) return;
+    // the last light moves into the freed slot
+    Uint32 slot = point_light_pool.entity_to_index[e];
     pool_remove (&point_light_pool, e, sizeof (PointLightComponent));
+    if (slot < point_light_pool.count) mark_light_slot (slot);
+}
+
+// texels covering a window extent at a render scale
+static Uint32 target_extent (Uint32 extent, float scale) {
+    return SDL_max ((Uint32) ceilf ((float) extent * scale), 1u);
+}
+
+// smooths the frame interval and steers render_scale toward the target
+// frame time. SDL's GPU API has no timestamp queries, so the wall-clock
+// interval stands in for GPU time; it follows the GPU whenever the GPU is
+// the bottleneck. Shading cost goes with area, hence the square root.
+static void update_render_scale (PAL_GPURenderer* renderer) {
+    Uint64 now = SDL_GetTicksNS ();
+    if (renderer->last_frame_ns != 0) {
+        float ms = (float) (now - renderer->last_frame_ns) / 1e6f;
+        renderer->frame_ms =
+            renderer->frame_ms > 0.0f
+                ? renderer->frame_ms +
+                      FRAME_TIME_SMOOTHING * (ms - renderer->frame_ms)
+                : ms;
+    }
+    renderer->last_frame_ns = now;
+    if (!renderer->scaled || renderer->target_frame_ms <= 0.0f ||
+        renderer->frame_ms <= 0.0f) {
+        return;
+    }
+
+    float ratio = renderer->target_frame_ms / renderer->frame_ms;
+    if (fabsf (ratio - 1.0f) < RENDER_SCALE_DEADBAND) return;
+    float step =
+        SDL_clamp (sqrtf (ratio), RENDER_SCALE_DROP, RENDER_SCALE_RAISE);
+    renderer->render_scale = SDL_clamp (
+        renderer->render_scale * step, renderer->min_render_scale,
+        renderer->max_render_scale
+    );
+}
+
+// releases the textures sized with the window
+static void release_targets (PAL_GPURenderer* renderer) {
+    SDL_ReleaseGPUTexture (renderer->device, renderer->depth_texture);
+    SDL_ReleaseGPUTexture (renderer->device, renderer->color_target);
+    SDL_ReleaseGPUTexture (renderer->device, renderer->gbuffer_albedo);
+    SDL_ReleaseGPUTexture (renderer->device, renderer->gbuffer_normal);
+    renderer->depth_texture = NULL;
+    renderer->color_target = NULL;
+    renderer->gbuffer_albedo = NULL;
+    renderer->gbuffer_normal = NULL;
+}
+
+// (re)creates the textures sized with the window: depth, the scaled colour
+// target and the G-buffer; on failure the previous ones are kept
+static bool
+create_targets (PAL_GPURenderer* renderer, Uint32 width, Uint32 height) {
+    SDL_GPUTextureCreateInfo texture_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_D24_UNORM,
+        .width = width,
+        .height = height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET
+    };
+    // the deferred lighting pass reads depth back
+    if (renderer->deferred) texture_info.usage |= SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    SDL_GPUTexture* depth =
+        SDL_CreateGPUTexture (renderer->device, &texture_info);
+
+    SDL_GPUTexture* color = NULL;
+    SDL_GPUTexture* albedo = NULL;
+    SDL_GPUTexture* normal = NULL;
+    texture_info.usage =
+        SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    if (renderer->scaled) {
+        texture_info.format = renderer->format;
+        color = SDL_CreateGPUTexture (renderer->device, &texture_info);
+    }
+    if (renderer->deferred) {
+        texture_info.format = GBUFFER_ALBEDO_FORMAT;
+        albedo = SDL_CreateGPUTexture (renderer->device, &texture_info);
+        texture_info.format = GBUFFER_NORMAL_FORMAT;
+        normal = SDL_CreateGPUTexture (renderer->device, &texture_info);
+    }
+
+    if (depth == NULL || (renderer->scaled && color == NULL) ||
+        (renderer->deferred && (albedo == NULL || normal == NULL))) {
+        SDL_Log (
+            "Failed to create %ux%u render targets: %s", width, height,
+            SDL_GetError ()
+        );
+        SDL_ReleaseGPUTexture (renderer->device, depth);
+        SDL_ReleaseGPUTexture (renderer->device, color);
+        SDL_ReleaseGPUTexture (renderer->device, albedo);
+        SDL_ReleaseGPUTexture (renderer->device, normal);
+        return false;
+    }
+    release_targets (renderer);
+    renderer->depth_texture = depth;
+    renderer->color_target = color;
+    renderer->gbuffer_albedo = albedo;
+    renderer->gbuffer_normal = normal;
+    renderer->dwidth = width;
+    renderer->dheight = height;
+    return true;
+}
+
+// G-buffer sampler and the lighting pipeline; on failure nothing is kept
+static bool create_deferred (PAL_GPURenderer* renderer) {
+    // every pixel is fetched exactly, so the filter never applies
+    renderer->gbuffer_sampler = PAL_AcquirePresetSampler (
+        renderer->device, PAL_SAMPLER_NEAREST_CLAMP
+    );
+
+    PAL_ShaderCreateInfo vertex_info = {
+        .device = renderer->device,
+        .filename = "shaders/deferred_lighting.vert.spv",
+        .stage = SDL_GPU_SHADERSTAGE_VERTEX,
+    };
+    PAL_ShaderCreateInfo fragment_info = {
+        .device = renderer->device,
+        .filename = "shaders/deferred_lighting.frag.spv",
+        .stage = SDL_GPU_SHADERSTAGE_FRAGMENT,
+        .sampler_count = 3,
+        .uniform_buffer_count = 1,
+        .storage_buffer_count = 3,
+    };
+    SDL_GPUShader* vertex_shader = PAL_LoadShader (&vertex_info);
+    SDL_GPUShader* fragment_shader = PAL_LoadShader (&fragment_info);
+    if (vertex_shader && fragment_shader) {
+        SDL_GPUGraphicsPipelineCreateInfo pipe_info = {
+            .target_info =
+                {.num_color_targets = 1,
+                 .color_target_descriptions =
+                     (SDL_GPUColorTargetDescription[]) {
+                         {.format = renderer->format}
+                     },
+                 .has_depth_stencil_target = false},
+            .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+            .vertex_shader = vertex_shader,
+            .fragment_shader = fragment_shader,
+            .rasterizer_state =
+                {.fill_mode = SDL_GPU_FILLMODE_FILL,
+                 .cull_mode = SDL_GPU_CULLMODE_NONE},
+        };
+        renderer->lighting_pipeline =
+            SDL_CreateGPUGraphicsPipeline (renderer->device, &pipe_info);
+    }
+    PAL_ReleaseShader (renderer->device, vertex_shader);
+    PAL_ReleaseShader (renderer->device, fragment_shader);
+
+    if (renderer->gbuffer_sampler == NULL ||
+        renderer->lighting_pipeline == NULL) {
+        SDL_Log ("Failed to create lighting pass: %s", SDL_GetError ());
+        PAL_ReleaseSampler (renderer->device, renderer->gbuffer_sampler);
+        SDL_ReleaseGPUGraphicsPipeline (
+            renderer->device, renderer->lighting_pipeline
+        );
+        renderer->gbuffer_sampler = NULL;
+        renderer->lighting_pipeline = NULL;
+        return false;
+    }
+    return true;
+}
+
+SDL_GPUGraphicsPipelineTargetInfo
+PAL_GetMaterialTargets (const PAL_GPURenderer* renderer) {
+    return (SDL_GPUGraphicsPipelineTargetInfo) {
+        .color_target_descriptions = renderer->material_targets,
+        .num_color_targets = renderer->num_material_targets,
+        .has_depth_stencil_target = true,
+        .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM,
+    };
 }
 
 PAL_GPURenderer* renderer_init (const PAL_RendererCreateInfo* info) {
@@ -485,39 +1149,75 @@ PAL_GPURenderer* renderer_init (const PAL_RendererCreateInfo* info) {
     renderer->device = info->device;
     renderer->window = info->window;
     renderer->width = info->width;
-    renderer->dwidth = info->width;
     renderer->height = info->height;
-    renderer->dheight = info->height;
 
-    // depth texture
-    SDL_GPUTextureCreateInfo depth_info = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GPU_TEXTUREFORMAT_D24_UNORM,
-        .width = info->width,
-        .height = info->height,
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET
-    };
-    renderer->depth_texture = SDL_CreateGPUTexture (info->device, &depth_info);
-    if (renderer->depth_texture == NULL) {
-        free (renderer);
-        SDL_Log (
-            "Failed to create renderer depth texture: %s", SDL_GetError ()
-        );
-        return NULL;
+    // dynamic resolution; 0 means 1 for either bound
+    float max_scale = info->max_render_scale > 0.0f ? info->max_render_scale
+                                                    : 1.0f;
+    float min_scale = info->min_render_scale > 0.0f ? info->min_render_scale
+                                                    : 1.0f;
+    renderer->max_render_scale = max_scale;
+    renderer->min_render_scale = SDL_min (min_scale, max_scale);
+    renderer->render_scale = max_scale;
+    renderer->target_frame_ms = info->target_frame_ms;
+    renderer->scaled = renderer->min_render_scale != 1.0f || max_scale != 1.0f;
+
+    // deferred shading samples the depth buffer
+    renderer->deferred = info->deferred;
+    if (renderer->deferred &&
+        !SDL_GPUTextureSupportsFormat (
+            info->device, SDL_GPU_TEXTUREFORMAT_D24_UNORM,
+            SDL_GPU_TEXTURETYPE_2D,
+            SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET |
+                SDL_GPU_TEXTUREUSAGE_SAMPLER
+        )) {
+        SDL_Log ("Deferred shading disabled: depth can't be sampled");
+        renderer->deferred = false;
+    }
+
+    // frame pacing
+    renderer->frames_in_flight =
+        info->frames_in_flight ? info->frames_in_flight : 2;
+    renderer->frames_in_flight =
+        SDL_min (renderer->frames_in_flight, PAL_MAX_FRAMES_IN_FLIGHT);
+    if (!SDL_SetGPUAllowedFramesInFlight (
+            info->device, renderer->frames_in_flight
+        )) {
+        SDL_Log ("Failed to set frames in flight: %s", SDL_GetError ());
+    }
+    SDL_GPUPresentMode present_mode = info->present_mode;
+    if (!SDL_WindowSupportsGPUPresentMode (
+            info->device, info->window, present_mode
+        )) {
+        SDL_Log ("Present mode %d unsupported, using vsync", present_mode);
+        present_mode = SDL_GPU_PRESENTMODE_VSYNC;
+    }
+    if (!SDL_SetGPUSwapchainParameters (
+            info->device, info->window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR,
+            present_mode
+        )) {
+        SDL_Log ("Failed to set present mode: %s", SDL_GetError ());
     }
 
     // texture format
     renderer->format =
         SDL_GetGPUSwapchainTextureFormat (info->device, info->window);
     if (renderer->format == SDL_GPU_TEXTUREFORMAT_INVALID) {
-        SDL_ReleaseGPUTexture (info->device, renderer->depth_texture);
         free (renderer);
         SDL_Log ("Failed to get swapchain texture format: %s", SDL_GetError ());
         return NULL;
     }
 
+    if (!create_targets (
+            renderer, target_extent (info->width, max_scale),
+            target_extent (info->height, max_scale)
+        )) {
+        free (renderer);
+        return NULL;
+    }
+    renderer->render_width = renderer->dwidth;
+    renderer->render_height = renderer->dheight;
+
     SDL_GPUBufferCreateInfo ssbo_info = {
         .size = 1024,
         .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
@@ -525,7 +1225,7 @@ PAL_GPURenderer* renderer_init (const PAL_RendererCreateInfo* info) {
 
     renderer->point_ssbo = SDL_CreateGPUBuffer (renderer->device, &ssbo_info);
     if (renderer->point_ssbo == NULL) {
-        SDL_ReleaseGPUTexture (info->device, renderer->depth_texture);
+        release_targets (renderer);
         free (renderer);
         return NULL;
     }
@@ -534,11 +1234,108 @@ PAL_GPURenderer* renderer_init (const PAL_RendererCreateInfo* info) {
     renderer->ambient_ssbo = SDL_CreateGPUBuffer (renderer->device, &ssbo_info);
     if (renderer->ambient_ssbo == NULL) {
         SDL_ReleaseGPUBuffer (info->device, renderer->point_ssbo);
-        SDL_ReleaseGPUTexture (info->device, renderer->depth_texture);
+        release_targets (renderer);
         free (renderer);
         return NULL;
     }
     renderer->ambient_size = 1024;
+    // the new buffers get every light on the first frame
+    light_resync = true;
+    ambient_dirty = true;
+    materials_dirty = true;
+
+    renderer->upload = PAL_CreateUploadRing (
+        renderer->device,
+        info->upload_size ? info->upload_size : UPLOAD_RING_SIZE
+    );
+    if (renderer->upload == NULL) {
+        SDL_ReleaseGPUBuffer (info->device, renderer->ambient_ssbo);
+        SDL_ReleaseGPUBuffer (info->device, renderer->point_ssbo);
+        release_targets (renderer);
+        free (renderer);
+        return NULL;
+    }
+
+    ssbo_info.size = PAL_LIGHT_GRID_CLUSTERS * sizeof (PAL_LightCluster);
+    renderer->cluster_ssbo = SDL_CreateGPUBuffer (renderer->device, &ssbo_info);
+    renderer->cluster_size = ssbo_info.size;
+    renderer->light_grid = PAL_CreateLightGrid ();
+    if (renderer->cluster_ssbo == NULL || renderer->light_grid == NULL) {
+        SDL_Log ("Failed to create light clusters: %s", SDL_GetError ());
+        PAL_DestroyLightGrid (renderer->light_grid);
+        SDL_ReleaseGPUBuffer (info->device, renderer->cluster_ssbo);
+        PAL_DestroyUploadRing (renderer->upload);
+        SDL_ReleaseGPUBuffer (info->device, renderer->ambient_ssbo);
+        SDL_ReleaseGPUBuffer (info->device, renderer->point_ssbo);
+        release_targets (renderer);
+        free (renderer);
+        return NULL;
+    }
+
+    if (info->occlusion_culling) {
+        renderer->occlusion =
+            PAL_CreateOcclusionBuffer (OCCLUSION_WIDTH, OCCLUSION_HEIGHT);
+        if (renderer->occlusion == NULL) {
+            SDL_Log ("Occlusion culling disabled");
+        }
+    }
+
+    if (info->gpu_culling) {
+        PAL_ComputePipelineCreateInfo cull_info = {
+            .device = info->device,
+            .filename = "shaders/cull.comp.spv",
+            .readonly_storage_buffer_count = 2,
+            .readwrite_storage_buffer_count = 4,
+            .uniform_buffer_count = 1,
+            .threadcount_x = CULL_THREADS,
+        };
+        SDL_GPUComputePipeline* pipeline = PAL_LoadComputePipeline (&cull_info);
+        if (pipeline) {
+            renderer->culler = PAL_CreateGPUCuller (info->device, pipeline);
+            if (renderer->culler == NULL) {
+                SDL_ReleaseGPUComputePipeline (info->device, pipeline);
+            }
+        }
+        if (renderer->culler == NULL) SDL_Log ("GPU culling disabled");
+    }
+
+    renderer->depth_prepass = info->depth_prepass;
+    if (renderer->deferred && !create_deferred (renderer)) {
+        SDL_Log ("Deferred shading disabled");
+        renderer->deferred = false;
+        SDL_ReleaseGPUTexture (info->device, renderer->gbuffer_albedo);
+        SDL_ReleaseGPUTexture (info->device, renderer->gbuffer_normal);
+        renderer->gbuffer_albedo = NULL;
+        renderer->gbuffer_normal = NULL;
+    }
+    if (renderer->deferred) {
+        renderer->material_targets[0] =
+            (SDL_GPUColorTargetDescription) {.format = GBUFFER_ALBEDO_FORMAT};
+        renderer->material_targets[1] =
+            (SDL_GPUColorTargetDescription) {.format = GBUFFER_NORMAL_FORMAT};
+        renderer->num_material_targets = 2;
+    } else {
+        renderer->material_targets[0] =
+            (SDL_GPUColorTargetDescription) {.format = renderer->format};
+        renderer->num_material_targets = 1;
+    }
+
+    // without a thread render_system records on the caller's
+    if (info->render_thread) {
+        renderer->frame_ready = SDL_CreateSemaphore (0);
+        renderer->frame_done = SDL_CreateSemaphore (0);
+        if (renderer->frame_ready && renderer->frame_done) {
+            renderer->render_thread =
+                SDL_CreateThread (render_thread_main, "render", renderer);
+        }
+        if (renderer->render_thread == NULL) {
+            SDL_Log ("Render thread disabled: %s", SDL_GetError ());
+            SDL_DestroySemaphore (renderer->frame_ready);
+            SDL_DestroySemaphore (renderer->frame_done);
+            renderer->frame_ready = NULL;
+            renderer->frame_done = NULL;
+        }
+    }
 
     return renderer;
 }
@@ -581,6 +1378,7 @@ void fps_controller_event_system (SDL_Event* event) {
                 trans->rotation =
                     quat_from_euler ((vec3) {clamped_pitch, curr_yaw, 0.0f});
             }
+            mark_transform_dirty (e);
             break;
         }
         default:
@@ -613,196 +1411,473 @@ void fps_controller_update_system (float dt) {
         motion = vec3_normalize (motion);
         motion = vec3_scale (motion, dt * ctrl->move_speed);
         trans->position = vec3_add (trans->position, motion);
+        mark_transform_dirty (e);
     }
 }
 
-SDL_AppResult render_system (
+// Occlusion culling
+typedef struct {
+    Entity e;
+    float score; // squared size over squared distance
+} OccluderCandidate;
+
+static OccluderCandidate* occluder_candidates = NULL;
+static Uint32 occluder_candidate_capacity = 0;
+
+static int compare_occluders (const void* a, const void* b) {
+    float sa = ((const OccluderCandidate*) a)->score;
+    float sb = ((const OccluderCandidate*) b)->score;
+    return (sa < sb) - (sa > sb);
+}
+
+static bool push_occluder (Uint32* count, Entity e, aabb box, vec3 cam_pos) {
+    if (*count == occluder_candidate_capacity) {
+        Uint32 new_cap =
+            occluder_candidate_capacity ? occluder_candidate_capacity * 2 : 64;
+        OccluderCandidate* new_candidates = (OccluderCandidate*) realloc (
+            occluder_candidates, new_cap * sizeof (OccluderCandidate)
+        );
+        if (!new_candidates) return false;
+        occluder_candidates = new_candidates;
+        occluder_candidate_capacity = new_cap;
+    }
+    vec3 size = vec3_sub (box.max, box.min);
+    vec3 to_box = vec3_sub (aabb_center (box), cam_pos);
+    occluder_candidates[(*count)++] = (OccluderCandidate) {
+        .e = e,
+        .score = vec3_dot (size, size) / (vec3_dot (to_box, to_box) + 1e-4f),
+    };
+    return true;
+}
+
+// rasterizes the biggest on-screen occluders and drops every entry of the
+// draw list they hide; returns the new draw list length
+static Uint32 occlusion_cull (
     PAL_GPURenderer* renderer,
-    Entity cam,
-    Uint64* prerender,
-    Uint64* preui,
-    Uint64* postrender
+    PAL_RenderFrame* frame,
+    mat4 view_proj,
+    const frustum* view_frustum,
+    const TransformComponent* cam_trans,
+    Uint32 visible
 ) {
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (renderer->device);
-    SDL_GPUTexture* swapchain;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture (
-            cmd, renderer->window, &swapchain, &renderer->width,
-            &renderer->height
-        )) {
-        SDL_Log ("Failed to get swapchain texture: %s", SDL_GetError ());
-        return SDL_APP_FAILURE;
+    PAL_OcclusionBuffer* ob = renderer->occlusion;
+    PAL_OcclusionClear (ob, view_proj);
+
+    // flagged occluders
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < occluder_pool.count; i++) {
+        Entity e = occluder_pool.index_to_entity[i];
+        OccluderComponent* occ = &((OccluderComponent*) occluder_pool.data)[i];
+        TransformComponent* trans = get_transform (e);
+        if (!trans || has_billboard (e)) continue;
+        aabb local;
+        if (occ->positions) {
+            local = occ->bounds;
+        } else if (has_mesh (e)) {
+            local = PAL_GetMeshComponent (e)->bounds;
+        } else {
+            continue;
+        }
+
+        mat4 model;
+        model_matrix (e, trans, cam_trans->rotation, model);
+        aabb box = aabb_transform (local, model);
+        if (!frustum_test_aabb (view_frustum, box)) continue;
+        if (!push_occluder (&count, e, box, cam_trans->position)) break;
     }
-    if (swapchain == NULL) {
-        SDL_Log ("Failed to get swapchain texture: %s", SDL_GetError ());
-        SDL_SubmitGPUCommandBuffer (cmd);
-        return SDL_APP_FAILURE;
+
+    // large boxes and planes that survived frustum culling
+    for (Uint32 i = 0; i < visible; i++) {
+        Entity e = renderer->draw_list[i];
+        PAL_MeshComponent* mesh = PAL_GetMeshComponent (e);
+        if (!mesh->box_occluder || has_occluder (e) || has_billboard (e)) {
+            continue;
+        }
+        aabb box = world_bounds (e, get_transform (e), mesh);
+        vec3 size = vec3_sub (box.max, box.min);
+        if (vec3_dot (size, size) < OCCLUDER_MIN_SIZE * OCCLUDER_MIN_SIZE) {
+            continue;
+        }
+        if (!push_occluder (&count, e, box, cam_trans->position)) break;
     }
 
-    TransformComponent* cam_trans = get_transform (cam);
-    CameraComponent* cam_comp = get_camera (cam);
-    if (!cam_trans || !cam_comp) {
-        SDL_Log ("No active camera entity");
-        SDL_SubmitGPUCommandBuffer (cmd);
-        return SDL_APP_CONTINUE;
+    qsort (
+        occluder_candidates, count, sizeof (OccluderCandidate),
+        compare_occluders
+    );
+    if (count > MAX_OCCLUDERS) count = MAX_OCCLUDERS;
+
+    for (Uint32 i = 0; i < count; i++) {
+        Entity e = occluder_candidates[i].e;
+        TransformComponent* trans = get_transform (e);
+        mat4 model;
+        model_matrix (e, trans, cam_trans->rotation, model);
+
+        OccluderComponent* occ = get_occluder (e);
+        if (occ && occ->positions) {
+            PAL_OcclusionRasterize (
+                ob, occ->positions, occ->indices, occ->num_indices, model
+            );
+        } else {
+            PAL_OcclusionRasterizeBox (
+                ob, PAL_GetMeshComponent (e)->bounds, model
+            );
+        }
+        SceneEntry* entry = scene_entry (e);
+        if (entry) entry->occluder = true;
     }
 
-    SDL_GPUColorTargetInfo color_target_info = {
-        .texture = swapchain,
-        .clear_color = {0.0f, 0.0f, 0.0f, 1.0f},
-        .load_op = SDL_GPU_LOADOP_CLEAR,
-        .store_op = SDL_GPU_STOREOP_STORE
-    };
+    // occluders always pass; everything else is tested against the buffer
+    Uint32 kept = 0;
+    for (Uint32 i = 0; i < visible; i++) {
+        Entity e = renderer->draw_list[i];
+        if (scene_entries[e].occluder) {
+            renderer->draw_list[kept++] = e;
+            continue;
+        }
+        aabb box =
+            world_bounds (e, get_transform (e), PAL_GetMeshComponent (e));
+        if (PAL_OcclusionTestAABB (ob, box)) {
+            renderer->draw_list[kept++] = e;
+        }
+    }
+    for (Uint32 i = 0; i < count; i++) {
+        Entity e = occluder_candidates[i].e;
+        if (e < scene_capacity) scene_entries[e].occluder = false;
+    }
 
-    SDL_GPUDepthStencilTargetInfo depth_target_info = {
-        .texture = renderer->depth_texture,
-        .load_op = SDL_GPU_LOADOP_CLEAR,
-        .store_op = SDL_GPU_STOREOP_STORE,
-        .cycle = false,
-        .clear_depth = 1.0f
+    frame->stats.occluders = count;
+    frame->stats.occluded = visible - kept;
+    return kept;
+}
+
+// grows an SSBO read by the graphics stages to hold size bytes
+static bool reserve_storage_buffer (
+    SDL_GPUDevice* device,
+    SDL_GPUBuffer** ssbo,
+    Uint32* capacity,
+    Uint32 size
+) {
+    size = size > 1024 ? size : 1024;
+    if (*ssbo && *capacity >= size) return true;
+    if (*ssbo) SDL_ReleaseGPUBuffer (device, *ssbo);
+    *capacity = 0;
+
+    SDL_GPUBufferCreateInfo ssbo_info = {
+        .size = size,
+        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ
     };
+    *ssbo = SDL_CreateGPUBuffer (device, &ssbo_info);
+    if (*ssbo == NULL) {
+        SDL_Log ("Failed to create storage buffer: %s", SDL_GetError ());
+        return false;
+    }
+    *capacity = size;
+    return true;
+}
 
-    SDL_GPURenderPass* pass =
-        SDL_BeginGPURenderPass (cmd, &color_target_info, 1, &depth_target_info);
-    SDL_GPUViewport viewport = {
-        0.0f, 0.0f, (float) renderer->width, (float) renderer->height,
-        0.0f, 1.0f
+static int compare_slots (const void* a, const void* b) {
+    Uint32 x = *(const Uint32*) a;
+    Uint32 y = *(const Uint32*) b;
+    return x < y ? -1 : x > y;
+}
+
+// rebuilds a point light's mirror slot from its components
+static void write_light_slot (Uint32 slot) {
+    Entity light_entity = point_light_pool.index_to_entity[slot];
+    TransformComponent* transform = get_transform (light_entity);
+    PointLightComponent* light =
+        &((PointLightComponent*) point_light_pool.data)[slot];
+    vec4 position = {.w = light->radius};
+    if (transform) {
+        position.x = transform->position.x;
+        position.y = transform->position.y;
+        position.z = transform->position.z;
+    }
+    light_mirror[slot] = (GPUPointLight) {
+        .position = position,
+        .color = light->color,
     };
-    SDL_SetGPUViewport (pass, &viewport);
+}
 
-    // frame UBOs (set 0)
-    mat4 view;
-    mat4_identity (view);
-    vec4 conj_rot = quat_conjugate (cam_trans->rotation);
-    mat4_rotate_quat (view, conj_rot);
-    mat4_translate (view, vec3_scale (cam_trans->position, -1.0f));
+// rewrites the point light slots marked since the last frame, or all of
+// them on a resync, then snapshots every light and the marked slots;
+// recording stages only those slots unless it has to resync
+static void extract_lights (PAL_RenderFrame* frame) {
+    Uint32 ambient = ambient_light_pool.count;
+    Uint32 count = point_light_pool.count;
+    frame->num_ambient_lights = 0;
+    frame->num_point_lights = 0;
+    frame->num_dirty_slots = 0;
+    if (!grow_array (
+            (void**) &frame->ambient_lights, &frame->ambient_light_capacity,
+            ambient, sizeof (GPUAmbientLight)
+        ) ||
+        !grow_array (
+            (void**) &light_mirror, &light_mirror_capacity, count,
+            sizeof (GPUPointLight)
+        ) ||
+        !grow_array (
+            (void**) &frame->point_lights, &frame->point_light_capacity,
+            count, sizeof (GPUPointLight)
+        ) ||
+        !grow_array (
+            (void**) &frame->dirty_slots, &frame->dirty_slot_capacity,
+            light_dirty_count, sizeof (Uint32)
+        )) {
+        // this frame goes unlit and the next one restages everything
+        SDL_Log ("Failed to grow frame lights");
+        frame->ambient_dirty = true;
+        frame->light_resync = true;
+        ambient_dirty = true;
+        light_resync = true;
+        return;
+    }
 
-    mat4 proj;
-    float aspect = (float) renderer->width / (float) renderer->height;
-    mat4_perspective (
-        proj, cam_comp->fov * (float) M_PI / 180.0f, aspect,
-        cam_comp->near_clip, cam_comp->far_clip
-    );
+    if (ambient > 0) {
+        memcpy (
+            frame->ambient_lights, ambient_light_pool.data,
+            ambient * sizeof (GPUAmbientLight)
+        );
+    }
+    frame->num_ambient_lights = ambient;
+    frame->ambient_dirty = ambient_dirty;
+    ambient_dirty = false;
+
+    // removals can leave dirty slots past the end
+    Uint32 dirty = 0;
+    for (Uint32 i = 0; i < light_dirty_count; i++) {
+        Uint32 slot = light_dirty_slots[i];
+        light_slot_dirty[slot] = false;
+        if (slot >= count) continue;
+        if (!light_resync) write_light_slot (slot);
+        frame->dirty_slots[dirty++] = slot;
+    }
+    light_dirty_count = 0;
+    if (light_resync) {
+        for (Uint32 i = 0; i < count; i++) write_light_slot (i);
+    }
+    // the frame may be recorded on the render thread while the next one
+    // is extracted, so it takes a copy of the mirror
+    if (count > 0) {
+        memcpy (
+            frame->point_lights, light_mirror, count * sizeof (GPUPointLight)
+        );
+    }
+    frame->num_point_lights = count;
 
-    Uint32 ambient_count = ambient_light_pool.count;
-    Uint32 point_count = point_light_pool.count;
+    // dirty_slots stays NULL until a light is first marked
+    if (dirty > 1) {
+        qsort (frame->dirty_slots, dirty, sizeof (Uint32), compare_slots);
+    }
+    frame->num_dirty_slots = dirty;
+    frame->light_resync = light_resync;
+    light_resync = false;
+}
 
-    // vertex stage
-    //  must-have
-    //  - view matrix
-    //  - projection matrix
-    //  sometimes
-    //  - normal or inverse-transpose
-    //  - time
-    //  - per-instance index
-    struct {
-        mat4 view;
-        mat4 proj;
-    } vertex_ubo;
-    // because C is annoying and won't let me just copy the array over smh
-    memcpy (&vertex_ubo.view, &view, sizeof (view));
-    memcpy (&vertex_ubo.proj, &proj, sizeof (proj));
-    SDL_PushGPUVertexUniformData (cmd, 0, &vertex_ubo, sizeof (vertex_ubo));
+// snapshots the material parameter table if it changed
+static void extract_materials (PAL_RenderFrame* frame) {
+    frame->materials_dirty = false;
+    if (!materials_dirty) return;
+    if (!grow_array (
+            (void**) &frame->materials, &frame->material_capacity,
+            material_param_count, sizeof (PAL_GPUMaterial)
+        )) {
+        SDL_Log ("Failed to grow frame materials");
+        return;
+    }
+    if (material_param_count > 0) {
+        memcpy (
+            frame->materials, material_params,
+            material_param_count * sizeof (PAL_GPUMaterial)
+        );
+    }
+    frame->num_materials = material_param_count;
+    frame->materials_dirty = true;
+    materials_dirty = false;
+}
 
-    // fragment stage
-    //  must-have
-    //  - camera transform
-    //  - exposure time for tonemapping
-    //  often
-    //  - environment parameters
-    //  - light counts
-    //  shadow/map transforms/handles
-    vec4 cam_pos = {
-        .x = cam_trans->position.x,
-        .y = cam_trans->position.y,
-        .z = cam_trans->position.z,
-        .w = 0.0f,
-    };
-    struct {
-        vec4 cam_pos;
-        vec4 cam_rot;
-        Uint32 ambient_count;
-        Uint32 point_count;
-        Uint32 pad0;
-        Uint32 pad1;
-    } fragment_ubo = {
-        .cam_pos = cam_pos,
-        .cam_rot = cam_trans->rotation,
-        .ambient_count = ambient_count,
-        .point_count = point_count,
-        .pad0 = 0,
-        .pad1 = 1,
-    };
-    SDL_PushGPUFragmentUniformData (
-        cmd, 0, &fragment_ubo, sizeof (fragment_ubo)
+static bool
+sync_ambient_lights (PAL_GPURenderer* renderer, const PAL_RenderFrame* frame) {
+    Uint32 ambient_size = frame->num_ambient_lights * sizeof (GPUAmbientLight);
+    if (!reserve_storage_buffer (
+            renderer->device, &renderer->ambient_ssbo, &renderer->ambient_size,
+            ambient_size
+        )) {
+        return false;
+    }
+    if (ambient_size > 0) {
+        void* map = PAL_UploadRingBuffer (
+            renderer->upload, renderer->ambient_ssbo, 0, ambient_size
+        );
+        if (map == NULL) return false;
+        memcpy (map, frame->ambient_lights, ambient_size);
+    }
+    return true;
+}
+
+// stages point light slots [first, first + count) into the upload ring
+static bool stage_point_lights (
+    PAL_GPURenderer* renderer,
+    const PAL_RenderFrame* frame,
+    Uint32 first,
+    Uint32 count
+) {
+    GPUPointLight* lights = (GPUPointLight*) PAL_UploadRingBuffer (
+        renderer->upload, renderer->point_ssbo, first * sizeof (GPUPointLight),
+        count * sizeof (GPUPointLight)
     );
+    if (lights == NULL) return false;
+    memcpy (
+        lights, frame->point_lights + first, count * sizeof (GPUPointLight)
+    );
+    return true;
+}
 
-    *prerender = SDL_GetTicksNS ();
-    for (Uint32 i = 0; i < mesh_pool.count; i++) {
-        Entity e = mesh_pool.index_to_entity[i];
-        PAL_MeshComponent* mesh = PAL_GetMeshComponent (e);
-        if (mesh == NULL) continue;
-        PAL_MaterialComponent* mat = PAL_GetMaterialComponent (e);
-        TransformComponent* trans = get_transform (e);
-        if (!mat || !mat->pipeline || !trans) continue;
+// stages the light changes of a frame; anything that fails is restaged
+// whole on the next one
+static void
+sync_lights (PAL_GPURenderer* renderer, const PAL_RenderFrame* frame) {
+    bool restage = renderer->restage_lights;
+    renderer->restage_lights = false;
+    if ((frame->ambient_dirty || restage) &&
+        !sync_ambient_lights (renderer, frame)) {
+        renderer->restage_lights = true;
+    }
 
-        // object vertex ubo (set 2)
-        // TODO: encode arbitrary number of custom per-object uniforms
-        mat4 model;
-        mat4_identity (model);
-        if (has_billboard (e)) {
-            mat4_translate (model, trans->position);
-            mat4_rotate_quat (model, cam_trans->rotation);
-            mat4_rotate_y (model, (float) M_PI);
-            mat4_scale (model, trans->scale);
-        } else {
-            mat4_translate (model, trans->position);
-            mat4_rotate_quat (model, trans->rotation);
-            mat4_scale (model, trans->scale);
+    Uint32 count = frame->num_point_lights;
+    SDL_GPUBuffer* old_ssbo = renderer->point_ssbo;
+    if (!reserve_storage_buffer (
+            renderer->device, &renderer->point_ssbo, &renderer->point_size,
+            count * sizeof (GPUPointLight)
+        )) {
+        renderer->restage_lights = true;
+        return;
+    }
+    // a regrown buffer starts out empty
+    if (renderer->point_ssbo != old_ssbo) restage = true;
+
+    if (frame->light_resync || restage) {
+        if (count > 0 && !stage_point_lights (renderer, frame, 0, count)) {
+            renderer->restage_lights = true;
+        }
+        return;
+    }
+    const Uint32* slots = frame->dirty_slots;
+    Uint32 dirty = frame->num_dirty_slots;
+    for (Uint32 i = 0; i < dirty;) {
+        Uint32 end = i + 1;
+        while (end < dirty && slots[end] == slots[end - 1] + 1) end++;
+        if (!stage_point_lights (renderer, frame, slots[i], end - i)) {
+            renderer->restage_lights = true;
+            return;
         }
-        struct {
-            mat4 model;
-            vec4 color;
-        } vertex_ubo;
-        memcpy (&vertex_ubo.model, &model, sizeof (model));
-        memcpy (&vertex_ubo.color, &mat->color, sizeof (SDL_FColor));
-        SDL_PushGPUVertexUniformData (cmd, 1, &vertex_ubo, sizeof (vertex_ubo));
+        i = end;
+    }
+}
 
-        SDL_BindGPUGraphicsPipeline (pass, mat->pipeline);
+// stages the frame's material parameter table, if it carries one
+static void
+sync_materials (PAL_GPURenderer* renderer, PAL_RenderFrame* frame) {
+    if (!frame->materials_dirty) return;
+    Uint32 size = frame->num_materials * sizeof (PAL_GPUMaterial);
+    if (!reserve_storage_buffer (
+            renderer->device, &renderer->material_ssbo,
+            &renderer->material_size, size
+        )) {
+        return;
+    }
+    if (size > 0) {
+        void* map = PAL_UploadRingBuffer (
+            renderer->upload, renderer->material_ssbo, 0, size
+        );
+        if (map == NULL) return;
+        memcpy (map, frame->materials, size);
+    }
+    frame->materials_dirty = false;
+}
 
-        SDL_GPUBufferBinding vbo_binding = {
-            .buffer = mesh->vertex_buffer,
-            .offset = 0
-        };
-        SDL_BindGPUVertexBuffers (pass, 0, &vbo_binding, 1);
+// assigns the point lights to the clusters of the frame's view and stages
+// the cluster SSBO, so the clusters follow lights that move
+static bool
+upload_clusters (PAL_GPURenderer* renderer, const PAL_RenderFrame* frame) {
+    Uint32 count = frame->num_point_lights;
+    if (count > renderer->light_sphere_capacity) {
+        vec4* spheres =
+            (vec4*) realloc (renderer->light_spheres, count * sizeof (vec4));
+        if (spheres == NULL) {
+            SDL_Log ("Failed to grow light list");
+            return false;
+        }
+        renderer->light_spheres = spheres;
+        renderer->light_sphere_capacity = count;
+    }
+    for (Uint32 i = 0; i < count; i++) {
+        renderer->light_spheres[i] = frame->point_lights[i].position;
+    }
 
-        SDL_GPUTextureSamplerBinding tex_bind = {
-            .texture = mat->texture,
-            .sampler = mat->sampler
-        };
-        SDL_BindGPUFragmentSamplers (pass, 0, &tex_bind, 1);
-        SDL_GPUBuffer* buffers[] = {
-            renderer->ambient_ssbo, renderer->point_ssbo
-        };
-        SDL_BindGPUFragmentStorageBuffers (pass, 0, buffers, 2);
+    PAL_LightGridView view = {
+        .proj_x = frame->proj[MAT4_IDX (0, 0)],
+        .proj_y = frame->proj[MAT4_IDX (1, 1)],
+        .near_clip = frame->near_clip,
+        .far_clip = frame->far_clip,
+    };
+    memcpy (view.view, frame->view, sizeof (view.view));
+    if (!PAL_LightGridBuild (
+            renderer->light_grid, &view, renderer->light_spheres, count
+        )) {
+        return false;
+    }
+    PAL_LightGridOutput grid = PAL_LightGridGetOutput (renderer->light_grid);
+
+    // table and index list share one buffer, so they are always staged
+    // together and the table never points past the list
+    Uint32 table_size = PAL_LIGHT_GRID_CLUSTERS * sizeof (PAL_LightCluster);
+    if (grid.num_indices > (SDL_MAX_UINT32 - table_size) / sizeof (Uint32)) {
+        SDL_Log ("Too many light cluster entries");
+        return false;
+    }
+    Uint32 size = table_size + grid.num_indices * sizeof (Uint32);
+    if (!reserve_storage_buffer (
+            renderer->device, &renderer->cluster_ssbo, &renderer->cluster_size,
+            size
+        )) {
+        return false;
+    }
+    Uint8* map = (Uint8*) PAL_UploadRingBuffer (
+        renderer->upload, renderer->cluster_ssbo, 0, size
+    );
+    if (map == NULL) return false;
+    memcpy (map, grid.clusters, table_size);
+    if (grid.num_indices > 0) {
+        memcpy (map + table_size, grid.indices, size - table_size);
+    }
+    return true;
+}
 
-        if (mesh->index_buffer) {
-            SDL_GPUBufferBinding ibo_binding = {
-                .buffer = mesh->index_buffer,
-                .offset = 0
-            };
-            SDL_BindGPUIndexBuffer (pass, &ibo_binding, mesh->index_size);
-            SDL_DrawGPUIndexedPrimitives (pass, mesh->num_indices, 1, 0, 0, 0);
-        } else {
-            SDL_DrawGPUPrimitives (pass, mesh->num_vertices, 1, 0, 0);
+// releases the text textures and pixels held by rects
+static void release_rects (
+    SDL_GPUDevice* device,
+    SDL_GPUTexture* white_texture,
+    UIRect* rects,
+    Uint32 count
+) {
+    for (Uint32 r = 0; r < count; r++) {
+        if (rects[r].texture && rects[r].texture != white_texture) {
+            SDL_ReleaseGPUTexture (device, rects[r].texture);
         }
+        if (rects[r].pixels) SDL_DestroySurface (rects[r].pixels);
     }
+}
 
-    // draw queued texts
-    *preui = SDL_GetTicksNS ();
+// turns the queued microui commands into rects, then moves every queued
+// rect into the frame. Text is rasterized here, on the caller's thread,
+// since fonts are also used by the microui layout.
+static void extract_ui (PAL_GPURenderer* renderer, PAL_RenderFrame* frame) {
+    frame->num_ui = 0;
+    frame->num_rects = 0;
     for (Uint32 i = 0; i < ui_pool.count; i++) {
         UIComponent* ui = &((UIComponent*) ui_pool.data)[i];
-
-        bool scissor_enabled = false;
         mu_Command* mu_command = NULL;
         while (mu_next_command (&ui->context, &mu_command)) {
             switch (mu_command->type) {
@@ -832,120 +1907,1038 @@ SDL_AppResult render_system (
             case MU_COMMAND_CLIP:
                 if (mu_command->clip.rect.w <= 0 ||
                     mu_command->clip.rect.h <= 0) {
-                    if (scissor_enabled) {
-                        SDL_SetGPUScissor (pass, NULL);
-                        scissor_enabled = false;
-                    }
+                    ui->clip = (SDL_Rect) {0};
                 } else {
-                    SDL_Rect scissor = {
-                        (Uint32) mu_command->clip.rect.x,
-                        (Uint32) mu_command->clip.rect.y,
-                        (Uint32) mu_command->clip.rect.w,
-                        (Uint32) mu_command->clip.rect.h,
+                    ui->clip = (SDL_Rect) {
+                        mu_command->clip.rect.x,
+                        mu_command->clip.rect.y,
+                        mu_command->clip.rect.w,
+                        mu_command->clip.rect.h,
                     };
-                    SDL_SetGPUScissor (pass, &scissor);
-                    scissor_enabled = true;
                 }
                 break;
             default:
                 break;
             }
         }
-        if (scissor_enabled) SDL_SetGPUScissor (pass, NULL);
-
+        ui->clip = (SDL_Rect) {0};
         if (ui->rect_count == 0) continue;
-        SDL_BindGPUGraphicsPipeline (pass, ui->pipeline);
 
-        for (Uint32 r = 0; r < ui->rect_count; r++) {
-            UIRect* rect = &ui->rects[r];
+        if (!grow_array (
+                (void**) &frame->ui, &frame->ui_capacity, frame->num_ui + 1,
+                sizeof (UIBatch)
+            ) ||
+            !grow_array (
+                (void**) &frame->rects, &frame->rect_capacity,
+                frame->num_rects + ui->rect_count, sizeof (UIRect)
+            )) {
+            SDL_Log ("Failed to grow frame UI");
+            release_rects (
+                renderer->device, ui->white_texture, ui->rects, ui->rect_count
+            );
+            ui->rect_count = 0;
+            continue;
+        }
+        frame->ui[frame->num_ui++] = (UIBatch) {
+            .pipeline = ui->pipeline,
+            .vbo = ui->vbo,
+            .ibo = ui->ibo,
+            .sampler = ui->sampler,
+            .white_texture = ui->white_texture,
+            .first_rect = frame->num_rects,
+            .num_rects = ui->rect_count,
+        };
+        memcpy (
+            frame->rects + frame->num_rects, ui->rects,
+            ui->rect_count * sizeof (UIRect)
+        );
+        frame->num_rects += ui->rect_count;
+        ui->rect_count = 0;
+    }
+}
 
-            float rx = (float) renderer->width;
-            float ry = (float) renderer->height;
+// stages the vertices of the frame's rects and the pixels of its text; runs
+// before the render pass so the uploads join the frame's copy pass
+static void stage_ui (PAL_GPURenderer* renderer, PAL_RenderFrame* frame) {
+    float rx = (float) frame->width;
+    float ry = (float) frame->height;
+    for (Uint32 i = 0; i < frame->num_ui; i++) {
+        UIBatch* batch = &frame->ui[i];
+        // four vertices of ten floats per rect
+        float* verts = (float*) PAL_UploadRingBuffer (
+            renderer->upload, batch->vbo, 0,
+            batch->num_rects * 40 * sizeof (float)
+        );
+        batch->staged = verts != NULL;
+        if (verts == NULL) continue;
+
+        for (Uint32 r = 0; r < batch->num_rects; r++) {
+            UIRect* rect = &frame->rects[batch->first_rect + r];
             float x1 = rect->rect.x;
             float y1 = rect->rect.y;
             float x2 = rect->rect.x + rect->rect.w;
             float y2 = rect->rect.y + rect->rect.h;
             SDL_FColor col = rect->color;
-            float verts[40] = {
+            float quad[40] = {
                 x1, y2, rx, ry, col.r, col.g, col.b, col.a, 0.0f, 1.0f,
                 x2, y2, rx, ry, col.r, col.g, col.b, col.a, 1.0f, 1.0f,
                 x1, y1, rx, ry, col.r, col.g, col.b, col.a, 0.0f, 0.0f,
                 x2, y1, rx, ry, col.r, col.g, col.b, col.a, 1.0f, 0.0f,
             };
-            uint32_t inds[6] = {0, 1, 2, 1, 3, 2};
+            memcpy (verts + r * 40, quad, sizeof (quad));
 
-            uint32_t vsize = sizeof (verts);
-            uint32_t isize = sizeof (inds);
-
-            SDL_GPUTransferBufferCreateInfo vtinfo = {
-                .size = vsize,
-                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-            };
-            SDL_GPUTransferBuffer* vtbuf =
-                SDL_CreateGPUTransferBuffer (renderer->device, &vtinfo);
-            void* vmap =
-                SDL_MapGPUTransferBuffer (renderer->device, vtbuf, false);
-            memcpy (vmap, verts, vsize);
-            SDL_UnmapGPUTransferBuffer (renderer->device, vtbuf);
-
-            SDL_GPUTransferBufferCreateInfo itinfo = {
-                .size = isize,
-                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-            };
-            SDL_GPUTransferBuffer* itbuf =
-                SDL_CreateGPUTransferBuffer (renderer->device, &itinfo);
-            void* imap =
-                SDL_MapGPUTransferBuffer (renderer->device, itbuf, false);
-            memcpy (imap, inds, isize);
-            SDL_UnmapGPUTransferBuffer (renderer->device, itbuf);
-
-            SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass (cmd);
-            SDL_GPUTransferBufferLocation vsrc = {
-                .transfer_buffer = vtbuf,
-                .offset = 0
+            SDL_Surface* pixels = rect->pixels;
+            if (pixels == NULL) continue;
+            SDL_GPUTextureRegion dst = {
+                .texture = rect->texture,
+                .w = pixels->w,
+                .h = pixels->h,
+                .d = 1
             };
-            SDL_GPUBufferRegion vdst =
-                {.buffer = ui->vbo, .offset = 0, .size = vsize};
-            SDL_UploadToGPUBuffer (copy, &vsrc, &vdst, false);
-            SDL_GPUTransferBufferLocation isrc = {
-                .transfer_buffer = itbuf,
-                .offset = 0
+            void* map = PAL_UploadRingTexture (
+                renderer->upload, &dst, pixels->pitch / 4,
+                pixels->pitch * pixels->h
+            );
+            if (map) {
+                memcpy (map, pixels->pixels, pixels->pitch * pixels->h);
+            } else {
+                SDL_Log ("UI text upload failed");
+                SDL_ReleaseGPUTexture (renderer->device, rect->texture);
+                rect->texture = NULL; // not drawn
+            }
+            SDL_DestroySurface (pixels);
+            rect->pixels = NULL;
+        }
+    }
+}
+
+static void release_ui (PAL_GPURenderer* renderer, PAL_RenderFrame* frame) {
+    for (Uint32 i = 0; i < frame->num_ui; i++) {
+        const UIBatch* batch = &frame->ui[i];
+        release_rects (
+            renderer->device, batch->white_texture,
+            frame->rects + batch->first_rect, batch->num_rects
+        );
+    }
+    frame->num_ui = 0;
+    frame->num_rects = 0;
+}
+
+// Draws
+// Visible meshes become draw items sorted by render state. Their object
+// constants and indirect commands are staged in that order, so every run of
+// items sharing a pipeline, texture and geometry block is a single indirect
+// draw. Shaders find their object through an instance-rate attribute that
+// reads the identity sequence in instance_buffer at first_instance.
+static int compare_draws (const void* a, const void* b) {
+    return PAL_CompareDrawState (
+        &((const DrawItem*) a)->state, &((const DrawItem*) b)->state
+    );
+}
+
+// grows the per-draw buffers to hold count draws
+static bool reserve_draw_buffers (PAL_GPURenderer* renderer, Uint32 count) {
+    if (count <= renderer->draw_capacity) return true;
+    Uint32 capacity = renderer->draw_capacity ? renderer->draw_capacity
+                                              : MIN_DRAW_CAPACITY;
+    while (capacity < count) capacity *= 2;
+
+    // in-flight frames keep the old buffers until they retire
+    SDL_ReleaseGPUBuffer (renderer->device, renderer->object_buffer);
+    SDL_ReleaseGPUBuffer (renderer->device, renderer->indirect_buffer);
+    SDL_ReleaseGPUBuffer (renderer->device, renderer->instance_buffer);
+    renderer->draw_capacity = 0;
+
+    SDL_GPUBufferCreateInfo object_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+        .size = capacity * sizeof (PAL_GPUObject)
+    };
+    SDL_GPUBufferCreateInfo indirect_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_INDIRECT,
+        .size = capacity * sizeof (SDL_GPUIndexedIndirectDrawCommand)
+    };
+    SDL_GPUBufferCreateInfo instance_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_VERTEX,
+        .size = capacity * sizeof (Uint32)
+    };
+    renderer->object_buffer =
+        SDL_CreateGPUBuffer (renderer->device, &object_info);
+    renderer->indirect_buffer =
+        SDL_CreateGPUBuffer (renderer->device, &indirect_info);
+    renderer->instance_buffer =
+        SDL_CreateGPUBuffer (renderer->device, &instance_info);
+    Uint32* ids = NULL;
+    if (renderer->object_buffer && renderer->indirect_buffer &&
+        renderer->instance_buffer) {
+        ids = (Uint32*) PAL_UploadRingBuffer (
+            renderer->upload, renderer->instance_buffer, 0,
+            capacity * sizeof (Uint32)
+        );
+    }
+    if (ids == NULL) {
+        SDL_Log ("Failed to create draw buffers: %s", SDL_GetError ());
+        SDL_ReleaseGPUBuffer (renderer->device, renderer->object_buffer);
+        SDL_ReleaseGPUBuffer (renderer->device, renderer->indirect_buffer);
+        SDL_ReleaseGPUBuffer (renderer->device, renderer->instance_buffer);
+        renderer->object_buffer = NULL;
+        renderer->indirect_buffer = NULL;
+        renderer->instance_buffer = NULL;
+        return false;
+    }
+    for (Uint32 i = 0; i < capacity; i++) ids[i] = i;
+    renderer->draw_capacity = capacity;
+    return true;
+}
+
+// turns the visible entities into the frame's sorted draws and their object
+// constants
+static void build_draws (
+    PAL_GPURenderer* renderer,
+    PAL_RenderFrame* frame,
+    Uint32 visible,
+    const TransformComponent* cam_trans,
+    float pixels_per_radian
+) {
+    frame->num_draws = 0;
+    if (!grow_array (
+            (void**) &frame->draws, &frame->draw_capacity, visible,
+            sizeof (DrawItem)
+        ) ||
+        !grow_array (
+            (void**) &frame->objects, &frame->object_capacity, visible,
+            sizeof (PAL_GPUObject)
+        )) {
+        SDL_Log ("Failed to grow draw items");
+        return;
+    }
+
+    DrawItem* draw_items = frame->draws;
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < visible; i++) {
+        Entity e = renderer->draw_list[i];
+        PAL_MeshComponent* mesh = PAL_GetMeshComponent (e);
+        if (mesh == NULL) continue;
+        PAL_MaterialComponent* mat = PAL_GetMaterialComponent (e);
+        TransformComponent* trans = get_transform (e);
+        // pending templates draw with their fallback, if any
+        const PAL_MaterialTemplate* tmpl =
+            mat ? PAL_ResolveMaterialTemplate (mat->tmpl) : NULL;
+        if (!tmpl || !trans) continue;
+
+        PAL_MeshLOD lod = {
+            .vertex_buffer = mesh->vertex_buffer,
+            .num_vertices = mesh->num_vertices,
+            .index_buffer = mesh->index_buffer,
+            .num_indices = mesh->num_indices,
+            .first_index = mesh->first_index,
+            .vertex_offset = mesh->vertex_offset,
+        };
+        if (mesh->num_lods > 1) {
+            lod = mesh->lods[select_lod (
+                e, trans, mesh, cam_trans->position, pixels_per_radian
+            )];
+        }
+
+        draw_items[count++] = (DrawItem) {
+            .state = {
+                .pipeline = tmpl->pipeline,
+                .depth_pipeline = tmpl->depth_pipeline,
+                .ambient_pipeline = tmpl->ambient_pipeline,
+                .texture = PAL_GetTextureArrayTexture (mat->texture.array),
+                .sampler = mat->sampler,
+                .vertex_buffer = lod.vertex_buffer,
+                .index_buffer = lod.index_buffer,
+                .index_size = mesh->index_size,
+            },
+            .num_elements =
+                lod.index_buffer ? lod.num_indices : lod.num_vertices,
+            .first_index = lod.first_index,
+            .vertex_offset = lod.vertex_offset,
+            .entity = e,
+            .trans = trans,
+            .material = mat->params,
+        };
+    }
+    qsort (draw_items, count, sizeof (DrawItem), compare_draws);
+    for (Uint32 i = 0; i < count; i++) {
+        const DrawItem* item = &draw_items[i];
+        object_transform (
+            &frame->objects[i], item->entity, item->trans, cam_trans->rotation
+        );
+        frame->objects[i].material = item->material;
+    }
+    frame->num_draws = count;
+}
+
+// stages the frame's object constants and indirect commands; returns the
+// number of draws
+static Uint32
+stage_draws (PAL_GPURenderer* renderer, const PAL_RenderFrame* frame) {
+    Uint32 count = frame->num_draws;
+    if (count == 0) return 0;
+    if (!reserve_draw_buffers (renderer, count)) return 0;
+
+    // each staging pointer is only valid until the next reservation
+    PAL_GPUObject* objects = (PAL_GPUObject*) PAL_UploadRingBuffer (
+        renderer->upload, renderer->object_buffer, 0,
+        count * sizeof (PAL_GPUObject)
+    );
+    if (objects == NULL) return 0;
+    memcpy (objects, frame->objects, count * sizeof (PAL_GPUObject));
+
+    const DrawItem* draw_items = frame->draws;
+    SDL_GPUIndexedIndirectDrawCommand* commands =
+        (SDL_GPUIndexedIndirectDrawCommand*) PAL_UploadRingBuffer (
+            renderer->upload, renderer->indirect_buffer, 0,
+            count * sizeof (SDL_GPUIndexedIndirectDrawCommand)
+        );
+    if (commands == NULL) return 0;
+    for (Uint32 i = 0; i < count; i++) {
+        const DrawItem* item = &draw_items[i];
+        // non-indexed items are drawn directly and skip their slot
+        commands[i] = (SDL_GPUIndexedIndirectDrawCommand) {
+            .num_indices = item->state.index_buffer ? item->num_elements : 0,
+            .num_instances = item->state.index_buffer ? 1 : 0,
+            .first_index = item->first_index,
+            .vertex_offset = item->vertex_offset,
+            .first_instance = i,
+        };
+    }
+    return count;
+}
+
+// binds the parts of state that differ from bound, which is NULL after a
+// pipeline change. The depth pre-pass binds the depth pipeline and skips the
+// fragment resources; a frame without point lights binds the variant that
+// doesn't look for them, where the state has one.
+static void bind_draw_state (
+    PAL_GPURenderer* renderer,
+    const PAL_RenderFrame* frame,
+    SDL_GPURenderPass* pass,
+    const PAL_DrawState* state,
+    const PAL_DrawState* bound,
+    SDL_GPUBuffer* objects,
+    SDL_GPUBuffer* instances,
+    bool depth_only
+) {
+    if (bound == NULL || state->pipeline != bound->pipeline) {
+        SDL_GPUGraphicsPipeline* pipeline = state->pipeline;
+        if (depth_only) {
+            pipeline = state->depth_pipeline;
+        } else if (frame->num_point_lights == 0 && state->ambient_pipeline) {
+            pipeline = state->ambient_pipeline;
+        }
+        SDL_GPUBuffer* lights[] = {
+            renderer->ambient_ssbo, renderer->point_ssbo,
+            renderer->cluster_ssbo
+        };
+        // the depth-only shader reads no material parameters
+        SDL_GPUBuffer* storage[] = {objects, renderer->material_ssbo};
+        SDL_GPUBufferBinding instance_binding = {.buffer = instances};
+        SDL_BindGPUGraphicsPipeline (pass, pipeline);
+        SDL_BindGPUVertexBuffers (pass, 1, &instance_binding, 1);
+        SDL_BindGPUVertexStorageBuffers (pass, 0, storage, depth_only ? 1 : 2);
+        // G-buffer shaders don't light; the lighting pass binds these
+        if (!renderer->deferred && !depth_only) {
+            SDL_BindGPUFragmentStorageBuffers (pass, 0, lights, 3);
+        }
+        bound = NULL;
+    }
+    // untextured pipelines declare no sampler
+    if (!depth_only && state->texture &&
+        (bound == NULL || state->texture != bound->texture ||
+         state->sampler != bound->sampler)) {
+        SDL_GPUTextureSamplerBinding tex_bind = {
+            .texture = state->texture,
+            .sampler = state->sampler
+        };
+        SDL_BindGPUFragmentSamplers (pass, 0, &tex_bind, 1);
+    }
+    if (bound == NULL || state->vertex_buffer != bound->vertex_buffer) {
+        SDL_GPUBufferBinding vbo_binding = {
+            .buffer = state->vertex_buffer,
+            .offset = 0
+        };
+        SDL_BindGPUVertexBuffers (pass, 0, &vbo_binding, 1);
+    }
+    if (state->index_buffer &&
+        (bound == NULL || state->index_buffer != bound->index_buffer ||
+         state->index_size != bound->index_size)) {
+        SDL_GPUBufferBinding ibo_binding = {
+            .buffer = state->index_buffer,
+            .offset = 0
+        };
+        SDL_BindGPUIndexBuffer (pass, &ibo_binding, state->index_size);
+    }
+}
+
+// issues the staged draws, binding state only where consecutive runs differ;
+// with depth_only the depth pre-pass is drawn and counted instead
+static void draw_meshes (
+    PAL_GPURenderer* renderer,
+    PAL_RenderFrame* frame,
+    SDL_GPURenderPass* pass,
+    Uint32 count,
+    bool depth_only
+) {
+    const DrawItem* draw_items = frame->draws;
+    Uint32* draw_calls = depth_only ? &frame->stats.prepass_draw_calls
+                                    : &frame->stats.draw_calls;
+    const PAL_DrawState* bound = NULL;
+    for (Uint32 i = 0; i < count;) {
+        const DrawItem* item = &draw_items[i];
+        Uint32 end = i + 1;
+        while (end < count &&
+               !PAL_CompareDrawState (&item->state, &draw_items[end].state)) {
+            end++;
+        }
+        if (depth_only && item->state.depth_pipeline == NULL) {
+            i = end;
+            continue;
+        }
+
+        bind_draw_state (
+            renderer, frame, pass, &item->state, bound,
+            renderer->object_buffer, renderer->instance_buffer, depth_only
+        );
+        bound = &item->state;
+        if (!depth_only) {
+            for (Uint32 j = i; j < end; j++) {
+                frame->stats.triangles += draw_items[j].num_elements / 3;
+            }
+        }
+        if (item->state.index_buffer) {
+            SDL_DrawGPUIndexedPrimitivesIndirect (
+                pass, renderer->indirect_buffer,
+                i * sizeof (SDL_GPUIndexedIndirectDrawCommand), end - i
+            );
+            (*draw_calls)++;
+        } else {
+            for (Uint32 j = i; j < end; j++) {
+                SDL_DrawGPUPrimitives (
+                    pass, draw_items[j].num_elements, 1, 0, j
+                );
+                (*draw_calls)++;
+            }
+        }
+        i = end;
+    }
+    if (!depth_only) frame->stats.objects = count;
+}
+
+// draws the commands written by the culling pass; instance counts are only
+// known on the GPU, so visible, objects and triangles stay zero
+static void draw_culled (
+    PAL_GPURenderer* renderer,
+    PAL_RenderFrame* frame,
+    SDL_GPURenderPass* pass,
+    bool depth_only
+) {
+    PAL_CullOutput out = PAL_GPUCullerOutput (renderer->culler);
+    const PAL_DrawState* bound = NULL;
+    for (Uint32 i = 0; i < out.num_runs; i++) {
+        const PAL_CullRun* run = &out.runs[i];
+        if (depth_only && run->state.depth_pipeline == NULL) continue;
+        bind_draw_state (
+            renderer, frame, pass, &run->state, bound, out.objects,
+            out.instances, depth_only
+        );
+        bound = &run->state;
+        SDL_DrawGPUIndexedPrimitivesIndirect (
+            pass, out.commands,
+            run->first_command * sizeof (SDL_GPUIndexedIndirectDrawCommand),
+            run->num_commands
+        );
+        if (depth_only) {
+            frame->stats.prepass_draw_calls++;
+        } else {
+            frame->stats.draw_calls++;
+        }
+    }
+}
+
+// fragment constants of the lit materials and the deferred lighting pass
+typedef struct {
+    vec4 cam_pos;
+    vec4 cam_rot;
+    vec4 view_z;
+    vec4 cluster_scale;
+    Uint32 ambient_count;
+    Uint32 point_count;
+    Uint32 pad0;
+    Uint32 pad1;
+} LightingUBO;
+
+// shades the G-buffer into target once per pixel; returns the open pass so
+// the UI can draw over the result
+static SDL_GPURenderPass* draw_lighting (
+    PAL_GPURenderer* renderer,
+    SDL_GPUCommandBuffer* cmd,
+    const SDL_GPUColorTargetInfo* target,
+    const SDL_GPUViewport* viewport,
+    mat4 view_proj,
+    const LightingUBO* lighting
+) {
+    struct {
+        mat4 inverse_view_projection;
+        vec4 pixel_size; // xy: one pixel of the viewport in [0, 1]
+        LightingUBO lighting;
+    } fragment_ubo = {
+        .pixel_size = {1.0f / viewport->w, 1.0f / viewport->h, 0.0f, 0.0f},
+        .lighting = *lighting,
+    };
+    if (!mat4_inverse (fragment_ubo.inverse_view_projection, view_proj)) {
+        mat4_identity (fragment_ubo.inverse_view_projection);
+    }
+    SDL_PushGPUFragmentUniformData (
+        cmd, 0, &fragment_ubo, sizeof (fragment_ubo)
+    );
+
+    SDL_GPURenderPass* pass = SDL_BeginGPURenderPass (cmd, target, 1, NULL);
+    SDL_SetGPUViewport (pass, viewport);
+    SDL_GPUTextureSamplerBinding gbuffer[] = {
+        {.texture = renderer->gbuffer_albedo,
+         .sampler = renderer->gbuffer_sampler},
+        {.texture = renderer->gbuffer_normal,
+         .sampler = renderer->gbuffer_sampler},
+        {.texture = renderer->depth_texture,
+         .sampler = renderer->gbuffer_sampler},
+    };
+    SDL_GPUBuffer* lights[] = {
+        renderer->ambient_ssbo, renderer->point_ssbo, renderer->cluster_ssbo
+    };
+    SDL_BindGPUGraphicsPipeline (pass, renderer->lighting_pipeline);
+    SDL_BindGPUFragmentSamplers (pass, 0, gbuffer, 3);
+    SDL_BindGPUFragmentStorageBuffers (pass, 0, lights, 3);
+    SDL_DrawGPUPrimitives (pass, 3, 1, 0, 0); // fullscreen triangle
+    return pass;
+}
+
+// snapshots the frame seen by cam; runs on the caller's thread
+static void
+extract_frame (PAL_GPURenderer* renderer, PAL_RenderFrame* frame, Entity cam) {
+    frame->stats = (PAL_FrameStats) {0};
+    frame->num_draws = 0;
+    frame->num_cull_updates = 0;
+    // the culler keeps the textures it was last refreshed with, draws made
+    // here take the current ones
+    frame->texture_growths =
+        renderer->culler ? texture_growths : PAL_GetTextureArrayGrowths ();
+    TransformComponent* cam_trans = get_transform (cam);
+    CameraComponent* cam_comp = get_camera (cam);
+    frame->has_camera = cam_trans && cam_comp;
+    if (!frame->has_camera) {
+        // scene, light and UI changes wait for a frame with a camera
+        frame->num_ambient_lights = 0;
+        frame->num_point_lights = 0;
+        frame->num_dirty_slots = 0;
+        frame->materials_dirty = false;
+        frame->num_ui = 0;
+        frame->num_rects = 0;
+        return;
+    }
+    extract_lights (frame);
+    extract_materials (frame);
+    extract_ui (renderer, frame);
+
+    // frame UBOs (set 0); the aspect is that of the last recorded frame
+    mat4_identity (frame->view);
+    vec4 conj_rot = quat_conjugate (cam_trans->rotation);
+    mat4_rotate_quat (frame->view, conj_rot);
+    mat4_translate (frame->view, vec3_scale (cam_trans->position, -1.0f));
+
+    float aspect = (float) renderer->width / (float) renderer->height;
+    mat4_perspective (
+        frame->proj, cam_comp->fov * (float) M_PI / 180.0f, aspect,
+        cam_comp->near_clip, cam_comp->far_clip
+    );
+    mat4_multiply (frame->view_proj, frame->proj, frame->view);
+    frustum_from_matrix (&frame->frustum, frame->view_proj);
+    frame->cam_pos = cam_trans->position;
+    frame->cam_rot = cam_trans->rotation;
+    frame->near_clip = cam_comp->near_clip;
+    frame->far_clip = cam_comp->far_clip;
+
+    // the GPU culler gets the changes; culling then runs on the GPU
+    scene_update (renderer, frame);
+    if (renderer->culler) return;
+
+    // cull against the scene index
+    Uint32 renderables = scene_bvh ? PAL_BVHCount (scene_bvh) : 0;
+    if (renderables > renderer->draw_list_capacity) {
+        Entity* new_list = (Entity*) realloc (
+            renderer->draw_list, renderables * sizeof (Entity)
+        );
+        if (new_list) {
+            renderer->draw_list = new_list;
+            renderer->draw_list_capacity = renderables;
+        } else {
+            SDL_Log ("Failed to grow draw list");
+            renderables = 0;
+        }
+    }
+    Uint32 visible = 0;
+    if (renderables > 0) {
+        visible = PAL_BVHQueryFrustum (
+            scene_bvh, &frame->frustum, renderer->draw_list
+        );
+    }
+    frame->stats.renderables = renderables;
+    frame->stats.visible = visible;
+    if (renderer->occlusion && visible > 0) {
+        visible = occlusion_cull (
+            renderer, frame, frame->view_proj, &frame->frustum, cam_trans,
+            visible
+        );
+    }
+
+    // pixels covered by one world unit at distance one, for LOD selection
+    float pixels_per_radian = frame->proj[MAT4_IDX (1, 1)] *
+                              (float) renderer->render_height * 0.5f;
+    build_draws (renderer, frame, visible, cam_trans, pixels_per_radian);
+}
+
+// records and submits a frame from its snapshot alone
+static SDL_AppResult
+record_frame (PAL_GPURenderer* renderer, PAL_RenderFrame* frame) {
+    // wait for the frame that last used this slot, so at most
+    // frames_in_flight frames are queued behind the one being recorded
+    SDL_GPUFence** fence = &renderer->frame_fences[renderer->frame_index];
+    if (*fence != NULL) {
+        SDL_WaitForGPUFences (renderer->device, true, fence, 1);
+        SDL_ReleaseGPUFence (renderer->device, *fence);
+        *fence = NULL;
+    }
+    // frames behind a fence still pending may bind textures retired since
+    // they were extracted; this frame and the ones after it only those
+    // retired after its own count
+    frame->unbound_growths = frame->texture_growths;
+    for (Uint32 i = 0; i < PAL_MAX_FRAMES_IN_FLIGHT; i++) {
+        if (renderer->frame_fences[i] == NULL) continue;
+        frame->unbound_growths =
+            SDL_min (frame->unbound_growths, renderer->fence_growths[i]);
+    }
+
+    // the culler takes the changes whether or not the frame is drawn
+    for (Uint32 i = 0; i < frame->num_cull_updates; i++) {
+        const CullUpdate* update = &frame->cull_updates[i];
+        if (update->remove) {
+            PAL_GPUCullerRemove (renderer->culler, update->id);
+        } else {
+            PAL_GPUCullerSet (
+                renderer->culler, update->id, &update->batch,
+                &update->instance
+            );
+        }
+    }
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (renderer->device);
+    if (cmd == NULL) {
+        SDL_Log ("Failed to acquire command buffer: %s", SDL_GetError ());
+        return SDL_APP_FAILURE;
+    }
+    SDL_GPUTexture* swapchain;
+    if (!SDL_AcquireGPUSwapchainTexture (
+            cmd, renderer->window, &swapchain, &frame->width, &frame->height
+        )) {
+        SDL_Log ("Failed to get swapchain texture: %s", SDL_GetError ());
+        SDL_CancelGPUCommandBuffer (cmd);
+        return SDL_APP_FAILURE;
+    }
+    // no image free (e.g. minimized, or presentation is behind); skip the
+    // frame rather than block. Its light changes are lost with it.
+    if (swapchain == NULL) {
+        SDL_CancelGPUCommandBuffer (cmd);
+        frame->skipped = true;
+        renderer->restage_lights = true;
+        return SDL_APP_CONTINUE;
+    }
+
+    if (!frame->has_camera) {
+        SDL_Log ("No active camera entity");
+        SDL_SubmitGPUCommandBuffer (cmd);
+        return SDL_APP_CONTINUE;
+    }
+
+    // follow window resizes; targets are sized for the largest render scale
+    update_render_scale (renderer);
+    Uint32 target_width =
+        target_extent (frame->width, renderer->max_render_scale);
+    Uint32 target_height =
+        target_extent (frame->height, renderer->max_render_scale);
+    if ((target_width != renderer->dwidth ||
+         target_height != renderer->dheight) &&
+        !create_targets (renderer, target_width, target_height)) {
+        SDL_SubmitGPUCommandBuffer (cmd);
+        return SDL_APP_FAILURE;
+    }
+    // the scene fills the top-left of the targets and is scaled up after
+    Uint32 render_width = SDL_min (
+        target_extent (frame->width, renderer->render_scale), renderer->dwidth
+    );
+    Uint32 render_height = SDL_min (
+        target_extent (frame->height, renderer->render_scale),
+        renderer->dheight
+    );
+
+    // stage this frame's dynamic data; it is copied in one pass below
+    sync_lights (renderer, frame);
+    sync_materials (renderer, frame);
+    stage_ui (renderer, frame);
+    upload_clusters (renderer, frame);
+
+    Uint32 draws = 0;
+    bool culled = false;
+    frame->prerender = SDL_GetTicksNS ();
+    if (renderer->culler) {
+        // culling and LOD selection run in a compute pass before rendering
+        frame->stats.renderables = PAL_GPUCullerCount (renderer->culler);
+        culled = PAL_GPUCullerPrepare (renderer->culler, renderer->upload);
+        frame->stats.upload_bytes =
+            PAL_UploadRingFlush (renderer->upload, cmd);
+        if (culled) {
+            PAL_CullView cull_view = {
+                .frustum = frame->frustum,
+                .cam_pos = frame->cam_pos,
+                .cam_rot = frame->cam_rot,
+                .pixels_per_radian = frame->proj[MAT4_IDX (1, 1)] *
+                                     (float) render_height * 0.5f,
             };
-            SDL_GPUBufferRegion idst =
-                {.buffer = ui->ibo, .offset = 0, .size = isize};
-            SDL_UploadToGPUBuffer (copy, &isrc, &idst, false);
-            SDL_EndGPUCopyPass (copy);
-            SDL_ReleaseGPUTransferBuffer (renderer->device, vtbuf);
-            SDL_ReleaseGPUTransferBuffer (renderer->device, itbuf);
+            PAL_GPUCullerDispatch (renderer->culler, cmd, &cull_view);
+        }
+    } else {
+        draws = stage_draws (renderer, frame);
+        frame->stats.upload_bytes =
+            PAL_UploadRingFlush (renderer->upload, cmd);
+    }
+
+    frame->stats.render_width = render_width;
+    frame->stats.render_height = render_height;
+    SDL_GPUColorTargetInfo color_target_info = {
+        .texture = renderer->scaled ? renderer->color_target : swapchain,
+        .clear_color = {0.0f, 0.0f, 0.0f, 1.0f},
+        .load_op = SDL_GPU_LOADOP_CLEAR,
+        .store_op = SDL_GPU_STOREOP_STORE
+    };
+
+    // vertex stage
+    //  must-have
+    //  - view matrix
+    //  - projection matrix
+    //  sometimes
+    //  - normal or inverse-transpose
+    //  - time
+    //  - per-instance index
+    struct {
+        mat4 view;
+        mat4 proj;
+        mat4 view_proj;
+    } vertex_ubo;
+    // because C is annoying and won't let me just copy the array over smh
+    memcpy (&vertex_ubo.view, &frame->view, sizeof (frame->view));
+    memcpy (&vertex_ubo.proj, &frame->proj, sizeof (frame->proj));
+    memcpy (
+        &vertex_ubo.view_proj, &frame->view_proj, sizeof (frame->view_proj)
+    );
+    SDL_PushGPUVertexUniformData (cmd, 0, &vertex_ubo, sizeof (vertex_ubo));
+
+    SDL_GPUDepthStencilTargetInfo depth_target_info = {
+        .texture = renderer->depth_texture,
+        .load_op = SDL_GPU_LOADOP_CLEAR,
+        .store_op = SDL_GPU_STOREOP_STORE,
+        .cycle = false,
+        .clear_depth = 1.0f
+    };
+    SDL_GPUViewport viewport = {
+        0.0f, 0.0f, (float) render_width, (float) render_height, 0.0f, 1.0f
+    };
+
+    // depth pre-pass; the materials then shade where depth is EQUAL, so
+    // every pixel is shaded once however much overdraw there is
+    if (renderer->depth_prepass) {
+        SDL_GPURenderPass* prepass =
+            SDL_BeginGPURenderPass (cmd, NULL, 0, &depth_target_info);
+        SDL_SetGPUViewport (prepass, &viewport);
+        if (culled) {
+            draw_culled (renderer, frame, prepass, true);
+        } else {
+            draw_meshes (renderer, frame, prepass, draws, true);
+        }
+        SDL_EndGPURenderPass (prepass);
+        depth_target_info.load_op = SDL_GPU_LOADOP_LOAD;
+    }
+
+    // deferred mode draws the meshes into the G-buffer and lights it after
+    SDL_GPUColorTargetInfo gbuffer_target_info[] = {
+        {.texture = renderer->gbuffer_albedo,
+         .load_op = SDL_GPU_LOADOP_CLEAR,
+         .store_op = SDL_GPU_STOREOP_STORE},
+        {.texture = renderer->gbuffer_normal,
+         .load_op = SDL_GPU_LOADOP_CLEAR,
+         .store_op = SDL_GPU_STOREOP_STORE},
+    };
+    SDL_GPURenderPass* pass =
+        renderer->deferred
+            ? SDL_BeginGPURenderPass (
+                  cmd, gbuffer_target_info, 2, &depth_target_info
+              )
+            : SDL_BeginGPURenderPass (
+                  cmd, &color_target_info, 1, &depth_target_info
+              );
+    SDL_SetGPUViewport (pass, &viewport);
+
+    Uint32 ambient_count = frame->num_ambient_lights;
+    Uint32 point_count = frame->num_point_lights;
+
+    // fragment stage
+    //  must-have
+    //  - camera transform
+    //  - exposure time for tonemapping
+    //  often
+    //  - environment parameters
+    //  - light counts
+    //  shadow/map transforms/handles
+    vec4 cam_pos = {
+        .x = frame->cam_pos.x,
+        .y = frame->cam_pos.y,
+        .z = frame->cam_pos.z,
+        .w = 0.0f,
+    };
+    // a fragment's cluster: tile from its pixel, slice from its view depth
+    PAL_LightGridOutput grid = PAL_LightGridGetOutput (renderer->light_grid);
+    vec4 view_z = {
+        frame->view[MAT4_IDX (2, 0)], frame->view[MAT4_IDX (2, 1)],
+        frame->view[MAT4_IDX (2, 2)], frame->view[MAT4_IDX (2, 3)],
+    };
+    vec4 cluster_scale = {
+        (float) PAL_LIGHT_GRID_X / (float) render_width,
+        (float) PAL_LIGHT_GRID_Y / (float) render_height,
+        grid.slice_scale,
+        grid.slice_bias,
+    };
+    LightingUBO fragment_ubo = {
+        .cam_pos = cam_pos,
+        .cam_rot = frame->cam_rot,
+        .view_z = view_z,
+        .cluster_scale = cluster_scale,
+        .ambient_count = ambient_count,
+        .point_count = point_count,
+        .pad0 = 0,
+        .pad1 = 1,
+    };
+    if (!renderer->deferred) {
+        SDL_PushGPUFragmentUniformData (
+            cmd, 0, &fragment_ubo, sizeof (fragment_ubo)
+        );
+    }
+
+    if (culled) {
+        draw_culled (renderer, frame, pass, false);
+    } else {
+        draw_meshes (renderer, frame, pass, draws, false);
+    }
+
+    if (renderer->deferred) {
+        SDL_EndGPURenderPass (pass);
+        pass = draw_lighting (
+            renderer, cmd, &color_target_info, &viewport, frame->view_proj,
+            &fragment_ubo
+        );
+    }
+
+    // scale the scene up to the window; the UI is drawn at full resolution
+    if (renderer->scaled) {
+        SDL_EndGPURenderPass (pass);
+        SDL_GPUBlitInfo blit = {
+            .source =
+                {.texture = renderer->color_target,
+                 .w = render_width,
+                 .h = render_height},
+            .destination =
+                {.texture = swapchain,
+                 .w = frame->width,
+                 .h = frame->height},
+            .load_op = SDL_GPU_LOADOP_DONT_CARE,
+            .filter = SDL_GPU_FILTER_LINEAR,
+        };
+        SDL_BlitGPUTexture (cmd, &blit);
+        SDL_GPUColorTargetInfo ui_target_info = {
+            .texture = swapchain,
+            .load_op = SDL_GPU_LOADOP_LOAD,
+            .store_op = SDL_GPU_STOREOP_STORE
+        };
+        pass = SDL_BeginGPURenderPass (cmd, &ui_target_info, 1, NULL);
+    }
+
+    // draw the frame's rects; their vertices were uploaded before the pass
+    frame->preui = SDL_GetTicksNS ();
+    SDL_Rect full = {0, 0, (int) frame->width, (int) frame->height};
+    for (Uint32 i = 0; i < frame->num_ui; i++) {
+        const UIBatch* batch = &frame->ui[i];
+        if (!batch->staged) continue;
+
+        SDL_BindGPUGraphicsPipeline (pass, batch->pipeline);
+        SDL_GPUBufferBinding vbind = {.buffer = batch->vbo, .offset = 0};
+        SDL_BindGPUVertexBuffers (pass, 0, &vbind, 1);
+        SDL_GPUBufferBinding ibind = {.buffer = batch->ibo, .offset = 0};
+        SDL_BindGPUIndexBuffer (pass, &ibind, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+
+        SDL_Rect scissor = full;
+        for (Uint32 r = 0; r < batch->num_rects; r++) {
+            const UIRect* rect = &frame->rects[batch->first_rect + r];
+            if (rect->texture == NULL) continue;
+
+            SDL_Rect clip = rect->clip.w > 0 ? rect->clip : full;
+            if (!SDL_RectsEqual (&clip, &scissor)) {
+                SDL_SetGPUScissor (pass, &clip);
+                scissor = clip;
+            }
 
             SDL_GPUTextureSamplerBinding tex_bind = {
                 .texture = rect->texture,
-                .sampler = ui->sampler
+                .sampler = batch->sampler
             };
             SDL_BindGPUFragmentSamplers (pass, 0, &tex_bind, 1);
+            SDL_DrawGPUIndexedPrimitives (pass, 6, 1, 0, (Sint32) r * 4, 0);
+        }
+        if (!SDL_RectsEqual (&scissor, &full)) SDL_SetGPUScissor (pass, &full);
+    }
+    frame->postrender = SDL_GetTicksNS ();
 
-            SDL_GPUBufferBinding vbind = {.buffer = ui->vbo, .offset = 0};
-            SDL_BindGPUVertexBuffers (pass, 0, &vbind, 1);
-            SDL_GPUBufferBinding ibind = {.buffer = ui->ibo, .offset = 0};
-            SDL_BindGPUIndexBuffer (
-                pass, &ibind, SDL_GPU_INDEXELEMENTSIZE_32BIT
-            );
-            SDL_DrawGPUIndexedPrimitives (pass, 6, 1, 0, 0, 0);
+    SDL_EndGPURenderPass (pass);
+    *fence = SDL_SubmitGPUCommandBufferAndAcquireFence (cmd);
+    renderer->fence_growths[renderer->frame_index] = frame->texture_growths;
+    renderer->frame_index =
+        (renderer->frame_index + 1) % renderer->frames_in_flight;
+    return SDL_APP_CONTINUE;
+}
 
-            // If this was a text texture, release it now (keep white texture)
-            if (rect->texture != ui->white_texture) {
-                SDL_ReleaseGPUTexture (renderer->device, rect->texture);
-                rect->texture = ui->white_texture;
-            }
+// records frame and drops what only the recording needed
+static void render_frame (PAL_GPURenderer* renderer, PAL_RenderFrame* frame) {
+    frame->skipped = false;
+    frame->width = 0;
+    frame->height = 0;
+    frame->prerender = SDL_GetTicksNS ();
+    frame->preui = frame->prerender;
+    frame->postrender = frame->prerender;
+    frame->result = record_frame (renderer, frame);
+    release_ui (renderer, frame);
+}
+
+// publishes a recorded frame's results; runs on the caller's thread
+static SDL_AppResult finish_frame (
+    PAL_GPURenderer* renderer,
+    const PAL_RenderFrame* frame,
+    Uint64* prerender,
+    Uint64* preui,
+    Uint64* postrender
+) {
+    if (frame->skipped) renderer->skipped_frames++;
+    PAL_ReleaseRetiredTextures (frame->unbound_growths);
+    // a table that was never staged is extracted again
+    if (frame->materials_dirty) materials_dirty = true;
+    if (frame->width > 0) {
+        renderer->width = frame->width;
+        renderer->height = frame->height;
+    }
+    if (frame->stats.render_width > 0) {
+        renderer->stats = frame->stats;
+        renderer->render_width = frame->stats.render_width;
+        renderer->render_height = frame->stats.render_height;
+    }
+    *prerender = frame->prerender;
+    *preui = frame->preui;
+    *postrender = frame->postrender;
+    return frame->result;
+}
+
+// records each frame handed over by render_system; a NULL frame stops it
+static int SDLCALL render_thread_main (void* data) {
+    PAL_GPURenderer* renderer = (PAL_GPURenderer*) data;
+    for (;;) {
+        SDL_WaitSemaphore (renderer->frame_ready);
+        PAL_RenderFrame* frame = renderer->recording;
+        if (frame == NULL) return 0;
+        render_frame (renderer, frame);
+        SDL_SignalSemaphore (renderer->frame_done);
+    }
+}
+
+SDL_AppResult render_system (
+    PAL_GPURenderer* renderer,
+    Entity cam,
+    Uint64* prerender,
+    Uint64* preui,
+    Uint64* postrender
+) {
+    PAL_RenderFrame** slot = &renderer->frames[renderer->extract_slot];
+    if (*slot == NULL) {
+        *slot = (PAL_RenderFrame*) calloc (1, sizeof (PAL_RenderFrame));
+        if (*slot == NULL) {
+            SDL_Log ("Failed to allocate render frame");
+            return SDL_APP_FAILURE;
         }
+    }
+    PAL_RenderFrame* frame = *slot;
+    extract_frame (renderer, frame, cam);
 
-        ui->rect_count = 0;
+    if (renderer->render_thread == NULL) {
+        render_frame (renderer, frame);
+        return finish_frame (renderer, frame, prerender, preui, postrender);
     }
-    *postrender = SDL_GetTicksNS ();
 
-    SDL_EndGPURenderPass (pass);
-    SDL_SubmitGPUCommandBuffer (cmd);
-    return SDL_APP_CONTINUE;
+    // collect the previous frame, then hand this one over and return while
+    // it records; the other slot is free for the next extraction
+    SDL_AppResult result = SDL_APP_CONTINUE;
+    *prerender = SDL_GetTicksNS ();
+    *preui = *prerender;
+    *postrender = *prerender;
+    if (renderer->recording != NULL) {
+        SDL_WaitSemaphore (renderer->frame_done);
+        result = finish_frame (
+            renderer, renderer->recording, prerender, preui, postrender
+        );
+    }
+    renderer->recording = frame;
+    SDL_SignalSemaphore (renderer->frame_ready);
+    renderer->extract_slot ^= 1;
+    return result;
+}
+
+void renderer_wait (PAL_GPURenderer* renderer) {
+    if (renderer == NULL || renderer->recording == NULL) return;
+    Uint64 prerender, preui, postrender;
+    SDL_WaitSemaphore (renderer->frame_done);
+    finish_frame (
+        renderer, renderer->recording, &prerender, &preui, &postrender
+    );
+    renderer->recording = NULL;
+}
+
+void renderer_quit (PAL_GPURenderer* renderer) {
+    if (renderer == NULL) return;
+    renderer_wait (renderer);
+    PAL_QuitMaterialLoader ();
+    if (renderer->render_thread) {
+        SDL_SignalSemaphore (renderer->frame_ready); // recording is NULL
+        SDL_WaitThread (renderer->render_thread, NULL);
+        renderer->render_thread = NULL;
+    }
+    SDL_DestroySemaphore (renderer->frame_ready);
+    SDL_DestroySemaphore (renderer->frame_done);
+    renderer->frame_ready = NULL;
+    renderer->frame_done = NULL;
+    for (Uint32 i = 0; i < 2; i++) {
+        free_frame (renderer->frames[i]);
+        renderer->frames[i] = NULL;
+    }
+
+    SDL_WaitForGPUIdle (renderer->device);
+    for (Uint32 i = 0; i < PAL_MAX_FRAMES_IN_FLIGHT; i++) {
+        SDL_ReleaseGPUFence (renderer->device, renderer->frame_fences[i]);
+        renderer->frame_fences[i] = NULL;
+    }
+    PAL_ReleaseRetiredTextures (SDL_MAX_UINT32);
 }
 
 void free_pools (SDL_GPUDevice* device) {
@@ -979,6 +2972,10 @@ void free_pools (SDL_GPUDevice* device) {
     free (billboard_pool.entity_to_index);
     free (billboard_pool.index_to_entity);
 
+    free (occluder_pool.data);
+    free (occluder_pool.entity_to_index);
+    free (occluder_pool.index_to_entity);
+
     free (ambient_light_pool.data);
     free (ambient_light_pool.entity_to_index);
     free (ambient_light_pool.index_to_entity);
@@ -990,4 +2987,45 @@ void free_pools (SDL_GPUDevice* device) {
     free (ui_pool.data);
     free (ui_pool.entity_to_index);
     free (ui_pool.index_to_entity);
+
+    PAL_DestroyBVH (scene_bvh);
+    scene_bvh = NULL;
+    free (scene_entries);
+    scene_entries = NULL;
+    scene_capacity = 0;
+    free (scene_dirty);
+    scene_dirty = NULL;
+    scene_dirty_count = 0;
+    scene_dirty_capacity = 0;
+    free (light_mirror);
+    light_mirror = NULL;
+    light_mirror_capacity = 0;
+    free (light_dirty_slots);
+    light_dirty_slots = NULL;
+    light_dirty_count = 0;
+    light_dirty_capacity = 0;
+    free (light_slot_dirty);
+    light_slot_dirty = NULL;
+    light_slot_capacity = 0;
+    light_resync = true;
+    ambient_dirty = true;
+    free (material_params);
+    material_params = NULL;
+    material_param_count = 0;
+    material_param_capacity = 0;
+    free (free_params);
+    free_params = NULL;
+    free_param_count = 0;
+    free_param_capacity = 0;
+    free (param_live);
+    param_live = NULL;
+    param_live_capacity = 0;
+    materials_dirty = true;
+    free (occluder_candidates);
+    occluder_candidates = NULL;
+    occluder_candidate_capacity = 0;
+
+    // generated meshes are gone with their entities
+    PAL_DestroyMeshArena ();
+    PAL_FreeShaderCode ();
 }
\ No newline at end of file
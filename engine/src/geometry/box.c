@@ -59,32 +59,9 @@ PAL_MeshComponent* PAL_CreateBoxMesh (const PAL_BoxMeshCreateInfo* info) {
 
     PAL_ComputeNormals (vertices, 24, indices, 36, 8, 0, 3);
 
-    Uint64 vertices_size = sizeof (vertices);
-    SDL_GPUBuffer* vbo =
-        PAL_UploadVertices (info->device, vertices, vertices_size);
-    if (vbo == NULL) return NULL; // caller handles logging
-
-    Uint64 indices_size = sizeof (indices);
-    SDL_GPUBuffer* ibo =
-        PAL_UploadIndices (info->device, indices, indices_size);
-    if (ibo == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        return NULL; // caller handles logging
-    }
-
-    PAL_MeshComponent* mesh = malloc (sizeof (PAL_MeshComponent));
-    if (mesh == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        SDL_ReleaseGPUBuffer (info->device, ibo);
-        return NULL;
-    }
-    *mesh = (PAL_MeshComponent) {
-        .vertex_buffer = vbo,
-        .num_vertices = 24,
-        .index_buffer = ibo,
-        .num_indices = 36,
-        .index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT,
-    };
-
+    PAL_MeshComponent* mesh = PAL_CreateMesh (
+        info->device, info->batch, vertices, 24, indices, 36
+    );
+    if (mesh) mesh->box_occluder = true;
     return mesh;
 }
\ No newline at end of file
@@ -43,7 +43,8 @@ PAL_CreateCapsuleMesh (const PAL_CapsuleMeshCreateInfo* info) {
         .segments = info->radial_segments,
         .phi_start = 0.0f,
         .phi_length = (float) M_PI * 2.0f,
-        .device = info->device
+        .device = info->device,
+        .batch = info->batch
     };
     PAL_MeshComponent* mesh = PAL_CreateLatheMesh (&lathe_info);
     free (points);
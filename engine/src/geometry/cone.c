@@ -12,7 +12,8 @@ PAL_MeshComponent* PAL_CreateConeMesh (const PAL_ConeMeshCreateInfo* info) {
         .open_ended = info->open_ended,
         .theta_start = info->theta_start,
         .theta_length = info->theta_length,
-        .device = info->device
+        .device = info->device,
+        .batch = info->batch
     };
     return PAL_CreateCylinderMesh (&cylinder_info);
 }
\ No newline at end of file
@@ -49,7 +49,8 @@ PAL_CreateCylinderMesh (const PAL_CylinderMeshCreateInfo* info) {
         .segments = info->radial_segments,
         .phi_start = info->theta_start,
         .phi_length = info->theta_length,
-        .device = info->device
+        .device = info->device,
+        .batch = info->batch
     };
     PAL_MeshComponent* mesh = PAL_CreateLatheMesh (&lathe_info);
     free (points);
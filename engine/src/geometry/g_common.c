@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdlib.h>
 
 #include <SDL3/SDL.h>
@@ -5,126 +6,54 @@
 
 #include <geometry/g_common.h>
 #include <math/matrix.h>
+#include <util/hash_table.h>
 
-SDL_GPUBuffer* PAL_UploadVertices (
+static SDL_GPUBuffer* upload_buffer (
     SDL_GPUDevice* device,
-    const void* vertices,
-    Uint64 vertices_size
+    PAL_UploadBatch* batch,
+    const void* data,
+    Uint64 size,
+    SDL_GPUBufferUsageFlags usage
 ) {
-    SDL_GPUBufferCreateInfo vbo_info = {
-        .size = vertices_size,
-        .usage = SDL_GPU_BUFFERUSAGE_VERTEX
-    };
-    SDL_GPUBuffer* vbo = SDL_CreateGPUBuffer (device, &vbo_info);
-    if (vbo == NULL) return NULL;
-
-    SDL_GPUTransferBufferCreateInfo tinfo = {
-        .size = vertices_size,
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-    };
-    SDL_GPUTransferBuffer* tbuf = SDL_CreateGPUTransferBuffer (device, &tinfo);
-    if (tbuf == NULL) {
-        SDL_ReleaseGPUBuffer (device, vbo);
-        return NULL;
-    }
+    SDL_GPUBufferCreateInfo buffer_info = {.size = size, .usage = usage};
+    SDL_GPUBuffer* buffer = SDL_CreateGPUBuffer (device, &buffer_info);
+    if (buffer == NULL) return NULL;
 
-    void* data = SDL_MapGPUTransferBuffer (device, tbuf, false);
-    if (data == NULL) {
-        SDL_ReleaseGPUTransferBuffer (device, tbuf);
-        SDL_ReleaseGPUBuffer (device, vbo);
-        return NULL;
+    // without a batch, upload through a batch of one
+    PAL_UploadBatch* own = NULL;
+    if (batch == NULL) {
+        own = PAL_BeginUploadBatch (device, size);
+        batch = own;
     }
-    memcpy (data, vertices, vertices_size);
-    SDL_UnmapGPUTransferBuffer (device, tbuf);
-
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
-    if (cmd == NULL) {
-        SDL_ReleaseGPUTransferBuffer (device, tbuf);
-        SDL_ReleaseGPUBuffer (device, vbo);
-        return NULL;
-    }
-
-    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
-    if (copy_pass == NULL) {
-        SDL_SubmitGPUCommandBuffer (cmd);
-        SDL_ReleaseGPUTransferBuffer (device, tbuf);
-        SDL_ReleaseGPUBuffer (device, vbo);
+    void* map = PAL_UploadBatchBuffer (batch, buffer, 0, size);
+    if (map) memcpy (map, data, size);
+    if ((own && !PAL_SubmitUploadBatch (own, NULL)) || map == NULL) {
+        SDL_ReleaseGPUBuffer (device, buffer);
         return NULL;
     }
+    return buffer;
+}
 
-    SDL_GPUTransferBufferLocation src_loc = {
-        .transfer_buffer = tbuf,
-        .offset = 0
-    };
-    SDL_GPUBufferRegion dst_reg =
-        {.buffer = vbo, .offset = 0, .size = vertices_size};
-    SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
-    SDL_EndGPUCopyPass (copy_pass);
-    SDL_SubmitGPUCommandBuffer (cmd);
-
-    SDL_ReleaseGPUTransferBuffer (device, tbuf);
-    return vbo;
+SDL_GPUBuffer* PAL_UploadVertices (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const void* vertices,
+    Uint64 vertices_size
+) {
+    return upload_buffer (
+        device, batch, vertices, vertices_size, SDL_GPU_BUFFERUSAGE_VERTEX
+    );
 }
 
-// Returns 0 on success, 1 on failure
 SDL_GPUBuffer* PAL_UploadIndices (
     SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
     const void* indices,
     Uint64 indices_size
 ) {
-    SDL_GPUBufferCreateInfo ibo_info = {
-        .size = indices_size,
-        .usage = SDL_GPU_BUFFERUSAGE_INDEX
-    };
-    SDL_GPUBuffer* ibo = SDL_CreateGPUBuffer (device, &ibo_info);
-    if (ibo == NULL) return NULL;
-
-    SDL_GPUTransferBufferCreateInfo tinfo = {
-        .size = indices_size,
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-    };
-    SDL_GPUTransferBuffer* tbuf = SDL_CreateGPUTransferBuffer (device, &tinfo);
-    if (tbuf == NULL) {
-        SDL_ReleaseGPUBuffer (device, ibo);
-        return NULL;
-    }
-
-    void* data = SDL_MapGPUTransferBuffer (device, tbuf, false);
-    if (data == NULL) {
-        SDL_ReleaseGPUTransferBuffer (device, tbuf);
-        SDL_ReleaseGPUBuffer (device, ibo);
-        return NULL;
-    }
-    memcpy (data, indices, indices_size);
-    SDL_UnmapGPUTransferBuffer (device, tbuf);
-
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
-    if (cmd == NULL) {
-        SDL_ReleaseGPUTransferBuffer (device, tbuf);
-        SDL_ReleaseGPUBuffer (device, ibo);
-        return NULL;
-    }
-
-    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
-    if (copy_pass == NULL) {
-        SDL_SubmitGPUCommandBuffer (cmd);
-        SDL_ReleaseGPUTransferBuffer (device, tbuf);
-        SDL_ReleaseGPUBuffer (device, ibo);
-        return NULL;
-    }
-
-    SDL_GPUTransferBufferLocation src_loc = {
-        .transfer_buffer = tbuf,
-        .offset = 0
-    };
-    SDL_GPUBufferRegion dst_reg =
-        {.buffer = ibo, .offset = 0, .size = indices_size};
-    SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
-    SDL_EndGPUCopyPass (copy_pass);
-    SDL_SubmitGPUCommandBuffer (cmd);
-
-    SDL_ReleaseGPUTransferBuffer (device, tbuf);
-    return ibo;
+    return upload_buffer (
+        device, batch, indices, indices_size, SDL_GPU_BUFFERUSAGE_INDEX
+    );
 }
 
 void PAL_ComputeNormals (
@@ -182,4 +111,258 @@ void PAL_ComputeNormals (
     }
 
     free (accum_norms);
+}
+
+aabb PAL_ComputeBounds (
+    const float* vertices,
+    Uint32 num_vertices,
+    Uint32 stride,
+    Uint32 pos_offset
+) {
+    aabb bounds = aabb_empty ();
+    for (Uint32 i = 0; i < num_vertices; i++) {
+        vec3 p = {
+            vertices[i * stride + pos_offset],
+            vertices[i * stride + pos_offset + 1],
+            vertices[i * stride + pos_offset + 2]
+        };
+        bounds = aabb_union (bounds, (aabb) {p, p});
+    }
+    return bounds;
+}
+
+// one vertex is pos3/norm3/uv2
+#define VERTEX_STRIDE (8 * sizeof (float))
+#define MESH_ARENA_BLOCK_SIZE (32u << 20)
+
+static PAL_GeometryArena* mesh_arena = NULL;
+
+PAL_GeometryArena* PAL_GetMeshArena (SDL_GPUDevice* device) {
+    if (mesh_arena == NULL) {
+        mesh_arena = PAL_CreateGeometryArena (device, MESH_ARENA_BLOCK_SIZE);
+    }
+    return mesh_arena;
+}
+
+void PAL_DestroyMeshArena (void) {
+    PAL_DestroyGeometryArena (mesh_arena);
+    mesh_arena = NULL;
+}
+
+PAL_MeshComponent* PAL_CreateMesh (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const float* vertices,
+    Uint32 num_vertices,
+    const Uint32* indices,
+    Uint32 num_indices
+) {
+    // vertices then indices in one range; starting it on a vertex boundary
+    // lets vertex_offset count whole vertices
+    Uint32 vertices_size = num_vertices * VERTEX_STRIDE;
+    Uint32 indices_size = num_indices * sizeof (Uint32);
+    Uint32 size = vertices_size + indices_size;
+    PAL_GeometryArena* arena = PAL_GetMeshArena (device);
+    Uint32 offset;
+    SDL_GPUBuffer* block =
+        PAL_GeometryArenaAlloc (arena, size, VERTEX_STRIDE, &offset);
+    if (block == NULL) {
+        SDL_Log ("Failed to allocate %u bytes of mesh geometry", size);
+        return NULL;
+    }
+
+    PAL_UploadBatch* own = NULL;
+    if (batch == NULL) {
+        own = PAL_BeginUploadBatch (device, size);
+        batch = own;
+    }
+    Uint8* map = (Uint8*) PAL_UploadBatchBuffer (batch, block, offset, size);
+    if (map) {
+        memcpy (map, vertices, vertices_size);
+        memcpy (map + vertices_size, indices, indices_size);
+    }
+    PAL_MeshComponent* mesh = map ? malloc (sizeof (PAL_MeshComponent)) : NULL;
+    if ((own && !PAL_SubmitUploadBatch (own, NULL)) || mesh == NULL) {
+        PAL_GeometryArenaFree (arena, block, offset, size);
+        free (mesh);
+        return NULL;
+    }
+
+    Uint32 first_index = (offset + vertices_size) / sizeof (Uint32);
+    Sint32 vertex_offset = (Sint32) (offset / VERTEX_STRIDE);
+    *mesh = (PAL_MeshComponent) {
+        .vertex_buffer = block,
+        .num_vertices = num_vertices,
+        .index_buffer = block,
+        .num_indices = num_indices,
+        .first_index = first_index,
+        .vertex_offset = vertex_offset,
+        .arena = true,
+        .index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT,
+        .bounds = PAL_ComputeBounds (vertices, num_vertices, 8, 0),
+        .lods[0] = {
+            .vertex_buffer = block,
+            .num_vertices = num_vertices,
+            .index_buffer = block,
+            .num_indices = num_indices,
+            .first_index = first_index,
+            .vertex_offset = vertex_offset,
+            .arena = true,
+        },
+        .num_lods = 1,
+        .owned = true,
+    };
+
+    return mesh;
+}
+
+// returns an arena range, or releases the buffers of a hand-built level
+static void release_geometry (SDL_GPUDevice* device, const PAL_MeshLOD* lod) {
+    if (lod->arena) {
+        // the arena may already be gone at shutdown
+        PAL_GeometryArenaFree (
+            mesh_arena, lod->vertex_buffer,
+            (Uint32) lod->vertex_offset * VERTEX_STRIDE,
+            lod->num_vertices * VERTEX_STRIDE +
+                lod->num_indices * sizeof (Uint32)
+        );
+        return;
+    }
+    if (lod->vertex_buffer) SDL_ReleaseGPUBuffer (device, lod->vertex_buffer);
+    if (lod->index_buffer) SDL_ReleaseGPUBuffer (device, lod->index_buffer);
+}
+
+static PAL_MeshLOD base_level (const PAL_MeshComponent* mesh) {
+    return (PAL_MeshLOD) {
+        .vertex_buffer = mesh->vertex_buffer,
+        .num_vertices = mesh->num_vertices,
+        .index_buffer = mesh->index_buffer,
+        .num_indices = mesh->num_indices,
+        .first_index = mesh->first_index,
+        .vertex_offset = mesh->vertex_offset,
+        .arena = mesh->arena,
+    };
+}
+
+bool PAL_AppendMeshLOD (
+    SDL_GPUDevice* device,
+    PAL_MeshComponent* mesh,
+    PAL_MeshComponent* level,
+    float error
+) {
+    if (mesh->num_lods == 0) {
+        mesh->lods[0] = base_level (mesh);
+        mesh->num_lods = 1;
+    }
+    PAL_MeshLOD lod = base_level (level);
+    free (level);
+    if (mesh->num_lods == PAL_MAX_MESH_LODS) {
+        SDL_Log ("Mesh LOD chain is full");
+        release_geometry (device, &lod);
+        return false;
+    }
+
+    lod.error = error;
+    mesh->lods[mesh->num_lods++] = lod;
+    return true;
+}
+
+#define LOD_PIXEL_ERROR 1.0f
+#define LOD_HYSTERESIS 0.75f // coarsen only once well under the threshold
+
+Uint32 PAL_SelectMeshLOD (
+    const PAL_MeshComponent* mesh,
+    float pixels_per_unit,
+    Uint32 current
+) {
+    if (mesh->num_lods <= 1) return 0;
+
+    Uint32 level = current < mesh->num_lods ? current : mesh->num_lods - 1;
+    while (level > 0 &&
+           mesh->lods[level].error * pixels_per_unit > LOD_PIXEL_ERROR) {
+        level--;
+    }
+    while (level + 1 < mesh->num_lods &&
+           mesh->lods[level + 1].error * pixels_per_unit <=
+               LOD_PIXEL_ERROR * LOD_HYSTERESIS) {
+        level++;
+    }
+    return level;
+}
+
+// Mesh registry
+// Live shared meshes in a hash table keyed by the bytes they were made from
+// (see util/hash_table.h); a mesh keeps its key's hash so its release finds
+// the entry without a scan.
+static PAL_HashTable mesh_registry = {0};
+
+static void unregister_mesh (const PAL_MeshComponent* mesh) {
+    PAL_HashSlot* slot =
+        PAL_HashTableFindValueFrom (&mesh_registry, mesh->key, mesh);
+    if (slot) PAL_HashTableRemove (&mesh_registry, slot);
+}
+
+void PAL_RetainMesh (PAL_MeshComponent* mesh) {
+    if (mesh) mesh->refs++;
+}
+
+bool PAL_ReleaseMesh (SDL_GPUDevice* device, PAL_MeshComponent* mesh) {
+    if (mesh == NULL) return false;
+    if (mesh->refs > 1) {
+        mesh->refs--;
+        return false;
+    }
+    mesh->refs = 0;
+
+    // lods[0] aliases the mesh's own geometry
+    if (mesh->num_lods == 0) {
+        PAL_MeshLOD base = base_level (mesh);
+        release_geometry (device, &base);
+    }
+    for (Uint32 i = 0; i < mesh->num_lods; i++) {
+        release_geometry (device, &mesh->lods[i]);
+    }
+    if (mesh->shared) unregister_mesh (mesh);
+    if (mesh->owned) free (mesh);
+    return true;
+}
+
+PAL_MeshComponent* PAL_AcquireSharedMesh (
+    const char* generator,
+    PAL_MeshGenerator create,
+    const void* info,
+    Uint64 params_size,
+    SDL_GPUDevice* device
+) {
+    // the key is the generator name with its terminator, the device and the
+    // params, back to back
+    PAL_HashKey key;
+    PAL_InitHashKey (&key);
+    PAL_HashKeyAppendString (&key, generator);
+    PAL_HashKeyAppend (&key, &device, sizeof (device));
+    PAL_HashKeyAppend (&key, info, params_size);
+    if (key.failed) {
+        SDL_Log ("Failed to allocate mesh key; %s mesh not shared", generator);
+        PAL_FreeHashKey (&key);
+        return create (info);
+    }
+
+    PAL_HashSlot* slot =
+        PAL_HashTableFind (&mesh_registry, key.bytes, key.size);
+    PAL_MeshComponent* mesh = NULL;
+    if (slot) {
+        mesh = slot->value;
+    } else if ((mesh = create (info))) {
+        slot = PAL_HashTableInsert (&mesh_registry, key.bytes, key.size, mesh);
+        if (slot) {
+            mesh->key = slot->hash;
+            mesh->shared = true;
+        } else {
+            SDL_Log (
+                "Failed to grow mesh registry; %s mesh not shared", generator
+            );
+        }
+    }
+    PAL_FreeHashKey (&key);
+    return mesh;
 }
\ No newline at end of file
@@ -63,31 +63,10 @@ PAL_CreateIcosahedronMesh (const PAL_IcosahedronMeshCreateInfo* info) {
     // Compute normals using standard_indices
     PAL_ComputeNormals (vertices, num_vertices, standard_indices, 60, 8, 0, 3);
 
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    SDL_GPUBuffer* vbo =
-        PAL_UploadVertices (info->device, vertices, vertices_size);
+    PAL_MeshComponent* mesh = PAL_CreateMesh (
+        info->device, info->batch, vertices, num_vertices, standard_indices,
+        60
+    );
     free (vertices);
-    if (vbo == NULL) return NULL;
-
-    Uint64 indices_size = 60 * sizeof (Uint32);
-    SDL_GPUBuffer* ibo =
-        PAL_UploadIndices (info->device, standard_indices, indices_size);
-    if (ibo == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        return NULL;
-    }
-
-    PAL_MeshComponent* mesh = malloc (sizeof (PAL_MeshComponent));
-    if (mesh == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        SDL_ReleaseGPUBuffer (info->device, ibo);
-        return NULL;
-    }
-    *mesh = (PAL_MeshComponent) {.vertex_buffer = vbo,
-                                 .num_vertices = num_vertices,
-                                 .index_buffer = ibo,
-                                 .num_indices = 60,
-                                 .index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT};
-
     return mesh;
 }
\ No newline at end of file
@@ -81,36 +81,46 @@ PAL_MeshComponent* PAL_CreateLatheMesh (const PAL_LatheMeshCreateInfo* info) {
     // Compute normals
     PAL_ComputeNormals (vertices, num_vertices, indices, num_indices, 8, 0, 3);
 
-    // Upload to GPU
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    SDL_GPUBuffer* vbo =
-        PAL_UploadVertices (info->device, vertices, vertices_size);
+    PAL_MeshComponent* mesh = PAL_CreateMesh (
+        info->device, info->batch, vertices, num_vertices, indices,
+        num_indices
+    );
     free (vertices);
-    if (vbo == NULL) {
-        free (indices);
-        return NULL;
-    }
-
-    Uint64 indices_size = num_indices * sizeof (Uint32);
-    SDL_GPUBuffer* ibo =
-        PAL_UploadIndices (info->device, indices, indices_size);
     free (indices);
-    if (ibo == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        return NULL;
-    }
+    return mesh;
+}
 
-    PAL_MeshComponent* mesh = malloc (sizeof (PAL_MeshComponent));
-    if (mesh == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        SDL_ReleaseGPUBuffer (info->device, ibo);
-        return NULL;
-    }
-    *mesh = (PAL_MeshComponent) {.vertex_buffer = vbo,
-                                 .num_vertices = num_vertices,
-                                 .index_buffer = ibo,
-                                 .num_indices = num_indices,
-                                 .index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT};
+#define LATHE_MIN_SEGMENTS 6
 
+static float lathe_error (const PAL_LatheMeshCreateInfo* info) {
+    float max_radius = 0.0f;
+    for (Uint32 i = 0; i < info->path_length; i++) {
+        max_radius = fmaxf (max_radius, fabsf (info->path[i].x));
+    }
+    return max_radius *
+           (1.0f - cosf (info->phi_length * 0.5f / (float) info->segments));
+}
+
+PAL_MeshComponent* PAL_CreateLatheMeshLODs (
+    const PAL_LatheMeshCreateInfo* info,
+    Uint32 num_levels
+) {
+    PAL_MeshComponent* mesh = PAL_CreateLatheMesh (info);
+    if (mesh == NULL) return NULL;
+    mesh->lods[0].error = lathe_error (info);
+
+    Uint32 prev = info->segments;
+    for (Uint32 l = 1; l < num_levels && l < PAL_MAX_MESH_LODS; l++) {
+        if (prev <= LATHE_MIN_SEGMENTS) break;
+        PAL_LatheMeshCreateInfo level_info = *info;
+        level_info.segments =
+            prev / 2 > LATHE_MIN_SEGMENTS ? prev / 2 : LATHE_MIN_SEGMENTS;
+        PAL_MeshComponent* level = PAL_CreateLatheMesh (&level_info);
+        if (level == NULL) break; // keep the levels built so far
+        PAL_AppendMeshLOD (
+            info->device, mesh, level, lathe_error (&level_info)
+        );
+        prev = level_info.segments;
+    }
     return mesh;
 }
\ No newline at end of file
@@ -45,31 +45,8 @@ PAL_CreateOctahedronMesh (const PAL_OctahedronMeshCreateInfo* info) {
         0, 3
     );
 
-    Uint64 vertices_size = sizeof (vertices);
-    SDL_GPUBuffer* vbo =
-        PAL_UploadVertices (info->device, vertices, vertices_size);
-    if (vbo == NULL) return NULL;
-
-    Uint64 indices_size = sizeof (indices);
-    SDL_GPUBuffer* ibo =
-        PAL_UploadIndices (info->device, indices, indices_size);
-    if (ibo == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        return NULL;
-    }
-
-    PAL_MeshComponent* mesh = malloc (sizeof (PAL_MeshComponent));
-    if (mesh == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        SDL_ReleaseGPUBuffer (info->device, ibo);
-        return NULL;
-    }
-    *mesh =
-        (PAL_MeshComponent) {.vertex_buffer = vbo,
-                             .num_vertices = num_vertices,
-                             .index_buffer = ibo,
-                             .num_indices = sizeof (indices) / sizeof (Uint32),
-                             .index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT};
-
-    return mesh;
+    return PAL_CreateMesh (
+        info->device, info->batch, vertices, num_vertices, indices,
+        sizeof (indices) / sizeof (Uint32)
+    );
 }
\ No newline at end of file
@@ -68,35 +68,12 @@ PAL_MeshComponent* PAL_CreatePlaneMesh (const PAL_PlaneMeshCreateInfo* info) {
         }
     }
 
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    SDL_GPUBuffer* vbo =
-        PAL_UploadVertices (info->device, vertices, vertices_size);
+    PAL_MeshComponent* mesh = PAL_CreateMesh (
+        info->device, info->batch, vertices, num_vertices, indices,
+        num_indices
+    );
     free (vertices);
-    if (vbo == NULL) {
-        free (indices);
-        return NULL;
-    }
-
-    Uint64 indices_size = num_indices * sizeof (Uint32);
-    SDL_GPUBuffer* ibo =
-        PAL_UploadIndices (info->device, indices, indices_size);
     free (indices);
-    if (ibo == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        return NULL;
-    }
-
-    PAL_MeshComponent* mesh = malloc (sizeof (PAL_MeshComponent));
-    if (mesh == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        SDL_ReleaseGPUBuffer (info->device, ibo);
-        return NULL;
-    }
-    *mesh = (PAL_MeshComponent) {.vertex_buffer = vbo,
-                                 .num_vertices = num_vertices,
-                                 .index_buffer = ibo,
-                                 .num_indices = num_indices,
-                                 .index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT};
-
+    if (mesh) mesh->box_occluder = true;
     return mesh;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include <geometry/g_common.h>
 #include <geometry/lathe.h>
 #include <geometry/sphere.h>
 
@@ -29,9 +30,63 @@ PAL_CreateSphereMesh (const PAL_SphereMeshCreateInfo* info) {
         .segments = info->width_segments,
         .phi_start = info->phi_start,
         .phi_length = info->phi_length,
-        .device = info->device
+        .device = info->device,
+        .batch = info->batch
     };
     PAL_MeshComponent* mesh = PAL_CreateLatheMesh (&lathe_info);
     free (points);
     return mesh;
+}
+
+#define SPHERE_MIN_WIDTH_SEGMENTS 6
+#define SPHERE_MIN_HEIGHT_SEGMENTS 4
+
+static Uint32 lod_segments (Uint32 segments, Uint32 level, Uint32 minimum) {
+    if (segments <= minimum) return segments;
+    Uint32 reduced = level < 32 ? segments >> level : 0;
+    return reduced > minimum ? reduced : minimum;
+}
+
+PAL_SphereMeshCreateInfo
+PAL_SphereMeshLODInfo (const PAL_SphereMeshCreateInfo* info, Uint32 level) {
+    PAL_SphereMeshCreateInfo level_info = *info;
+    level_info.width_segments = lod_segments (
+        info->width_segments, level, SPHERE_MIN_WIDTH_SEGMENTS
+    );
+    level_info.height_segments = lod_segments (
+        info->height_segments, level, SPHERE_MIN_HEIGHT_SEGMENTS
+    );
+    return level_info;
+}
+
+float PAL_SphereMeshError (const PAL_SphereMeshCreateInfo* info) {
+    // deviation at the center of a facet
+    float dphi = info->phi_length / (float) info->width_segments;
+    float dtheta = info->theta_length / (float) info->height_segments;
+    return info->radius * (1.0f - cosf (dphi * 0.5f) * cosf (dtheta * 0.5f));
+}
+
+PAL_MeshComponent* PAL_CreateSphereMeshLODs (
+    const PAL_SphereMeshCreateInfo* info,
+    Uint32 num_levels
+) {
+    PAL_MeshComponent* mesh = PAL_CreateSphereMesh (info);
+    if (mesh == NULL) return NULL;
+    mesh->lods[0].error = PAL_SphereMeshError (info);
+
+    PAL_SphereMeshCreateInfo prev = *info;
+    for (Uint32 l = 1; l < num_levels && l < PAL_MAX_MESH_LODS; l++) {
+        PAL_SphereMeshCreateInfo level_info = PAL_SphereMeshLODInfo (info, l);
+        if (level_info.width_segments == prev.width_segments &&
+            level_info.height_segments == prev.height_segments) {
+            break;
+        }
+        PAL_MeshComponent* level = PAL_CreateSphereMesh (&level_info);
+        if (level == NULL) break; // keep the levels built so far
+        PAL_AppendMeshLOD (
+            info->device, mesh, level, PAL_SphereMeshError (&level_info)
+        );
+        prev = level_info;
+    }
+    return mesh;
 }
\ No newline at end of file
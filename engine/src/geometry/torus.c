@@ -99,38 +99,60 @@ PAL_MeshComponent* PAL_CreateTorusMesh (const PAL_TorusMeshCreateInfo* info) {
         }
     }
 
-    // Upload to GPU
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    SDL_GPUBuffer* vbo =
-        PAL_UploadVertices (info->device, vertices, vertices_size);
-    if (vbo == NULL) {
-        free (vertices);
-        free (indices);
-        return NULL;
-    }
+    PAL_MeshComponent* mesh = PAL_CreateMesh (
+        info->device, info->batch, vertices, num_vertices, indices,
+        num_indices
+    );
     free (vertices);
-
-    Uint64 indices_size = num_indices * sizeof (Uint32);
-    SDL_GPUBuffer* ibo =
-        PAL_UploadIndices (info->device, indices, indices_size);
-    if (ibo == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        free (indices);
-        return NULL;
-    }
     free (indices);
-
-    PAL_MeshComponent* mesh = malloc (sizeof (PAL_MeshComponent));
-    if (mesh == NULL) {
-        SDL_ReleaseGPUBuffer (info->device, vbo);
-        SDL_ReleaseGPUBuffer (info->device, ibo);
-        return NULL;
+    return mesh;
+}
+
+#define TORUS_MIN_RADIAL_SEGMENTS 4
+#define TORUS_MIN_TUBULAR_SEGMENTS 6
+
+static Uint32 lod_segments (Uint32 segments, Uint32 level, Uint32 minimum) {
+    if (segments <= minimum) return segments;
+    Uint32 reduced = level < 32 ? segments >> level : 0;
+    return reduced > minimum ? reduced : minimum;
+}
+
+static float torus_error (const PAL_TorusMeshCreateInfo* info) {
+    // chord deviation around the tube plus around the ring
+    float tube = info->tube_radius *
+                 (1.0f - cosf ((float) M_PI / (float) info->radial_segments));
+    float ring_step = info->arc * 0.5f / (float) info->tubular_segments;
+    float ring = (info->radius + info->tube_radius) * (1.0f - cosf (ring_step));
+    return tube + ring;
+}
+
+PAL_MeshComponent* PAL_CreateTorusMeshLODs (
+    const PAL_TorusMeshCreateInfo* info,
+    Uint32 num_levels
+) {
+    PAL_MeshComponent* mesh = PAL_CreateTorusMesh (info);
+    if (mesh == NULL) return NULL;
+    mesh->lods[0].error = torus_error (info);
+
+    PAL_TorusMeshCreateInfo prev = *info;
+    for (Uint32 l = 1; l < num_levels && l < PAL_MAX_MESH_LODS; l++) {
+        PAL_TorusMeshCreateInfo level_info = *info;
+        level_info.radial_segments = lod_segments (
+            info->radial_segments, l, TORUS_MIN_RADIAL_SEGMENTS
+        );
+        level_info.tubular_segments = lod_segments (
+            info->tubular_segments, l, TORUS_MIN_TUBULAR_SEGMENTS
+        );
+        if (level_info.radial_segments == prev.radial_segments &&
+            level_info.tubular_segments == prev.tubular_segments) {
+            break;
+        }
+        PAL_MeshComponent* level = PAL_CreateTorusMesh (&level_info);
+        if (level == NULL) break; // keep the levels built so far
+        PAL_AppendMeshLOD (
+            info->device, mesh, level, torus_error (&level_info)
+        );
+        prev = level_info;
     }
-    *mesh = (PAL_MeshComponent) {.vertex_buffer = vbo,
-                                 .num_vertices = num_vertices,
-                                 .index_buffer = ibo,
-                                 .num_indices = num_indices,
-                                 .index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT};
-
     return mesh;
 }
\ No newline at end of file
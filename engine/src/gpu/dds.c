@@ -0,0 +1,165 @@
+#include <SDL3/SDL.h>
+
+#include <gpu/dds.h>
+
+SDL_COMPILE_TIME_ASSERT (dds_header_size, sizeof (PAL_DDSHeader) == 124);
+SDL_COMPILE_TIME_ASSERT (dds_dx10_size, sizeof (PAL_DDSHeaderDX10) == 20);
+
+Uint32 PAL_DDSLevelSize (Uint32 width, Uint32 height, Uint32 block_size) {
+    Uint32 blocks_x = SDL_max ((width + 3) / 4, 1u);
+    Uint32 blocks_y = SDL_max ((height + 3) / 4, 1u);
+    return blocks_x * blocks_y * block_size;
+}
+
+bool PAL_IsDDS (const void* data, size_t size) {
+    Uint32 magic = 0;
+    if (size < sizeof (magic)) return false;
+    SDL_memcpy (&magic, data, sizeof (magic));
+    return SDL_Swap32LE (magic) == PAL_DDS_MAGIC;
+}
+
+static bool legacy_format (Uint32 fourcc, SDL_GPUTextureFormat* format) {
+    switch (fourcc) {
+    case PAL_DDS_FOURCC ('D', 'X', 'T', '1'):
+        *format = SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+        return true;
+    case PAL_DDS_FOURCC ('D', 'X', 'T', '5'):
+        *format = SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+        return true;
+    case PAL_DDS_FOURCC ('A', 'T', 'I', '2'):
+    case PAL_DDS_FOURCC ('B', 'C', '5', 'U'):
+        *format = SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+        return true;
+    default: return false;
+    }
+}
+
+static bool dxgi_format (Uint32 dxgi, SDL_GPUTextureFormat* format) {
+    switch (dxgi) {
+    case PAL_DXGI_BC1_UNORM:
+        *format = SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+        return true;
+    case PAL_DXGI_BC1_UNORM_SRGB:
+        *format = SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM_SRGB;
+        return true;
+    case PAL_DXGI_BC3_UNORM:
+        *format = SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+        return true;
+    case PAL_DXGI_BC3_UNORM_SRGB:
+        *format = SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM_SRGB;
+        return true;
+    case PAL_DXGI_BC5_UNORM:
+        *format = SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+        return true;
+    case PAL_DXGI_BC7_UNORM:
+        *format = SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+        return true;
+    case PAL_DXGI_BC7_UNORM_SRGB:
+        *format = SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM_SRGB;
+        return true;
+    default: return false;
+    }
+}
+
+static Uint32 block_size_of (SDL_GPUTextureFormat format) {
+    switch (format) {
+    case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM:
+    case SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM_SRGB: return 8;
+    default: return 16;
+    }
+}
+
+// the headers are read as laid out in the file, which assumes a little
+// endian host like the rest of the asset code
+bool PAL_ParseDDS (
+    const void* data,
+    size_t size,
+    Uint64 file_size,
+    PAL_DDSImage* image
+) {
+    const Uint8* bytes = data;
+    size_t offset = sizeof (Uint32);
+    PAL_DDSHeader header;
+    if (!PAL_IsDDS (data, size) || size < offset + sizeof (header)) {
+        SDL_Log ("Not a DDS file");
+        return false;
+    }
+    SDL_memcpy (&header, bytes + offset, sizeof (header));
+    offset += sizeof (header);
+    if (header.size != sizeof (header) ||
+        header.format.size != sizeof (PAL_DDSPixelFormat)) {
+        SDL_Log ("Malformed DDS header");
+        return false;
+    }
+    if (header.caps2 & (PAL_DDSCAPS2_CUBEMAP | PAL_DDSCAPS2_VOLUME)) {
+        SDL_Log ("DDS cube maps and volumes are not supported");
+        return false;
+    }
+
+    SDL_GPUTextureFormat format;
+    bool known = false;
+    Uint32 fourcc = header.format.fourcc;
+    if (!(header.format.flags & PAL_DDPF_FOURCC)) {
+        // uncompressed formats are described by masks instead
+    } else if (fourcc == PAL_DDS_FOURCC ('D', 'X', '1', '0')) {
+        PAL_DDSHeaderDX10 dx10;
+        if (size < offset + sizeof (dx10)) {
+            SDL_Log ("Truncated DDS DX10 header");
+            return false;
+        }
+        SDL_memcpy (&dx10, bytes + offset, sizeof (dx10));
+        offset += sizeof (dx10);
+        if (dx10.resource_dimension != PAL_DX10_TEXTURE2D ||
+            dx10.array_size > 1) {
+            SDL_Log ("DDS texture is not a single 2D image");
+            return false;
+        }
+        known = dxgi_format (dx10.dxgi_format, &format);
+    } else {
+        known = legacy_format (fourcc, &format);
+    }
+    if (!known) {
+        SDL_Log ("DDS format is not BC1, BC3, BC5 or BC7");
+        return false;
+    }
+
+    if (header.width == 0 || header.height == 0 || header.width % 4 != 0 ||
+        header.height % 4 != 0) {
+        SDL_Log (
+            "DDS size %ux%u is not a multiple of 4", header.width,
+            header.height
+        );
+        return false;
+    }
+    Uint32 num_levels = 1;
+    if (header.flags & PAL_DDSD_MIPMAPCOUNT) {
+        num_levels = SDL_max (header.mip_map_count, 1u);
+    }
+    Uint32 edge = SDL_max (header.width, header.height);
+    if (num_levels > PAL_DDS_MAX_LEVELS || (edge >> (num_levels - 1)) == 0) {
+        SDL_Log ("DDS file has too many mip levels (%u)", num_levels);
+        return false;
+    }
+
+    *image = (PAL_DDSImage) {
+        .format = format,
+        .width = header.width,
+        .height = header.height,
+        .block_size = block_size_of (format),
+        .num_levels = num_levels,
+    };
+    Uint64 level_offset = offset;
+    for (Uint32 level = 0; level < num_levels; level++) {
+        Uint32 w = SDL_max (header.width >> level, 1u);
+        Uint32 h = SDL_max (header.height >> level, 1u);
+        Uint32 level_size = PAL_DDSLevelSize (w, h, image->block_size);
+        if (file_size < level_offset + level_size) {
+            SDL_Log ("Truncated DDS file (level %u)", level);
+            return false;
+        }
+        image->level_offsets[level] = level_offset;
+        image->level_sizes[level] = level_size;
+        level_offset += level_size;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include <gpu/geometry.h>
+
+typedef struct {
+    Uint32 offset;
+    Uint32 size;
+} FreeRange;
+
+typedef struct {
+    SDL_GPUBuffer* buffer;
+    Uint32 size;
+    FreeRange* free; // sorted by offset, never adjacent
+    Uint32 free_count;
+    Uint32 free_capacity;
+} ArenaBlock;
+
+struct PAL_GeometryArena {
+    SDL_GPUDevice* device;
+    Uint32 block_size;
+    ArenaBlock* blocks;
+    Uint32 block_count;
+    Uint32 block_capacity;
+    Uint64 used;
+};
+
+PAL_GeometryArena*
+PAL_CreateGeometryArena (SDL_GPUDevice* device, Uint32 block_size) {
+    PAL_GeometryArena* arena = calloc (1, sizeof (PAL_GeometryArena));
+    if (arena == NULL) {
+        SDL_Log ("Failed to allocate geometry arena");
+        return NULL;
+    }
+    arena->device = device;
+    arena->block_size = block_size;
+    return arena;
+}
+
+void PAL_DestroyGeometryArena (PAL_GeometryArena* arena) {
+    if (arena == NULL) return;
+    for (Uint32 i = 0; i < arena->block_count; i++) {
+        SDL_ReleaseGPUBuffer (arena->device, arena->blocks[i].buffer);
+        free (arena->blocks[i].free);
+    }
+    free (arena->blocks);
+    free (arena);
+}
+
+static bool insert_range (ArenaBlock* block, Uint32 at, FreeRange range) {
+    if (block->free_count == block->free_capacity) {
+        Uint32 capacity = block->free_capacity ? block->free_capacity * 2 : 16;
+        FreeRange* ranges =
+            realloc (block->free, capacity * sizeof (FreeRange));
+        if (ranges == NULL) return false;
+        block->free = ranges;
+        block->free_capacity = capacity;
+    }
+    SDL_memmove (
+        &block->free[at + 1], &block->free[at],
+        (block->free_count - at) * sizeof (FreeRange)
+    );
+    block->free[at] = range;
+    block->free_count++;
+    return true;
+}
+
+static void remove_range (ArenaBlock* block, Uint32 at) {
+    SDL_memmove (
+        &block->free[at], &block->free[at + 1],
+        (block->free_count - at - 1) * sizeof (FreeRange)
+    );
+    block->free_count--;
+}
+
+// first fit; returns false if no free range can hold the request
+static bool
+block_alloc (ArenaBlock* block, Uint32 size, Uint32 alignment, Uint32* out) {
+    for (Uint32 i = 0; i < block->free_count; i++) {
+        FreeRange range = block->free[i];
+        Uint32 start = (range.offset + alignment - 1) & ~(alignment - 1);
+        Uint32 padding = start - range.offset;
+        if (padding > range.size || range.size - padding < size) continue;
+
+        Uint32 tail_offset = start + size;
+        Uint32 tail_size = range.offset + range.size - tail_offset;
+        FreeRange tail = {tail_offset, tail_size};
+        if (padding > 0) {
+            block->free[i].size = padding;
+            if (tail_size > 0 && !insert_range (block, i + 1, tail)) {
+                block->free[i].size = range.size;
+                return false;
+            }
+        } else if (tail_size > 0) {
+            block->free[i] = tail;
+        } else {
+            remove_range (block, i);
+        }
+        *out = start;
+        return true;
+    }
+    return false;
+}
+
+static ArenaBlock* add_block (PAL_GeometryArena* arena, Uint32 size) {
+    if (arena->block_count == arena->block_capacity) {
+        Uint32 capacity = arena->block_capacity ? arena->block_capacity * 2 : 4;
+        ArenaBlock* blocks =
+            realloc (arena->blocks, capacity * sizeof (ArenaBlock));
+        if (blocks == NULL) return NULL;
+        arena->blocks = blocks;
+        arena->block_capacity = capacity;
+    }
+
+    SDL_GPUBufferCreateInfo info = {
+        .usage = SDL_GPU_BUFFERUSAGE_VERTEX | SDL_GPU_BUFFERUSAGE_INDEX,
+        .size = size
+    };
+    SDL_GPUBuffer* buffer = SDL_CreateGPUBuffer (arena->device, &info);
+    if (buffer == NULL) {
+        SDL_Log ("Failed to create geometry block: %s", SDL_GetError ());
+        return NULL;
+    }
+
+    ArenaBlock* block = &arena->blocks[arena->block_count];
+    *block = (ArenaBlock) {.buffer = buffer, .size = size};
+    if (!insert_range (block, 0, (FreeRange) {0, size})) {
+        SDL_ReleaseGPUBuffer (arena->device, buffer);
+        return NULL;
+    }
+    arena->block_count++;
+    return block;
+}
+
+SDL_GPUBuffer* PAL_GeometryArenaAlloc (
+    PAL_GeometryArena* arena,
+    Uint32 size,
+    Uint32 alignment,
+    Uint32* offset
+) {
+    if (arena == NULL || size == 0) return NULL;
+    for (Uint32 i = 0; i < arena->block_count; i++) {
+        if (block_alloc (&arena->blocks[i], size, alignment, offset)) {
+            arena->used += size;
+            return arena->blocks[i].buffer;
+        }
+    }
+
+    Uint32 block_size = size > arena->block_size ? size : arena->block_size;
+    ArenaBlock* block = add_block (arena, block_size);
+    if (block == NULL || !block_alloc (block, size, alignment, offset)) {
+        return NULL;
+    }
+    arena->used += size;
+    return block->buffer;
+}
+
+void PAL_GeometryArenaFree (
+    PAL_GeometryArena* arena,
+    SDL_GPUBuffer* block_buffer,
+    Uint32 offset,
+    Uint32 size
+) {
+    if (arena == NULL || size == 0) return;
+    ArenaBlock* block = NULL;
+    for (Uint32 i = 0; i < arena->block_count; i++) {
+        if (arena->blocks[i].buffer == block_buffer) {
+            block = &arena->blocks[i];
+            break;
+        }
+    }
+    if (block == NULL) return;
+    arena->used -= size;
+
+    // first free range after the freed one
+    Uint32 lo = 0;
+    Uint32 hi = block->free_count;
+    while (lo < hi) {
+        Uint32 mid = (lo + hi) / 2;
+        if (block->free[mid].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    FreeRange* prev = lo > 0 ? &block->free[lo - 1] : NULL;
+    bool merge_prev = prev && prev->offset + prev->size == offset;
+    bool merge_next =
+        lo < block->free_count && offset + size == block->free[lo].offset;
+    if (merge_prev && merge_next) {
+        prev->size += size + block->free[lo].size;
+        remove_range (block, lo);
+    } else if (merge_prev) {
+        prev->size += size;
+    } else if (merge_next) {
+        block->free[lo].offset = offset;
+        block->free[lo].size += size;
+    } else if (!insert_range (block, lo, (FreeRange) {offset, size})) {
+        SDL_Log ("Failed to return geometry range to the arena");
+    }
+}
+
+Uint64 PAL_GeometryArenaUsed (const PAL_GeometryArena* arena) {
+    return arena ? arena->used : 0;
+}
+
+Uint64 PAL_GeometryArenaCapacity (const PAL_GeometryArena* arena) {
+    if (arena == NULL) return 0;
+    Uint64 capacity = 0;
+    for (Uint32 i = 0; i < arena->block_count; i++) {
+        capacity += arena->blocks[i].size;
+    }
+    return capacity;
+}
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include <gpu/texture_array.h>
+
+struct PAL_TextureArray {
+    SDL_GPUDevice* device;
+    SDL_GPUTextureCreateInfo info; // layer_count_or_depth is the capacity
+    SDL_GPUTexture* texture;
+    bool* used;   // per layer
+    Uint32* free; // free layers, handed out from the end
+    Uint32 free_count;
+    Uint32 count; // layers in use
+};
+
+static PAL_TextureArray** arrays = NULL;
+static Uint32 array_count = 0;
+static Uint32 array_capacity = 0;
+static Uint32 growths = 0;
+
+// A texture replaced by growth. Frames extracted before the growth may still
+// bind it, and the batch copying out of it may not be submitted yet; it is
+// released once both are past (see PAL_ReleaseRetiredTextures).
+typedef struct {
+    SDL_GPUDevice* device;
+    SDL_GPUTexture* texture;
+    Uint32 growth; // the growths count it was replaced at
+    bool copied;   // the batch with the copies out of it was submitted
+} RetiredTexture;
+
+static RetiredTexture* retired = NULL;
+static Uint32 retired_count = 0;
+static Uint32 retired_capacity = 0;
+
+static bool same_kind (
+    const PAL_TextureArray* array,
+    SDL_GPUDevice* device,
+    const SDL_GPUTextureCreateInfo* info
+) {
+    const SDL_GPUTextureCreateInfo* a = &array->info;
+    return array->device == device && a->format == info->format &&
+           a->usage == info->usage && a->width == info->width &&
+           a->height == info->height && a->num_levels == info->num_levels &&
+           a->sample_count == info->sample_count;
+}
+
+static SDL_GPUTexture*
+create_texture (PAL_TextureArray* array, Uint32 layers) {
+    SDL_GPUTextureCreateInfo info = array->info;
+    info.layer_count_or_depth = layers;
+    SDL_GPUTexture* texture = SDL_CreateGPUTexture (array->device, &info);
+    if (texture == NULL) {
+        SDL_Log ("Failed to create texture array: %s", SDL_GetError ());
+    }
+    return texture;
+}
+
+// sizes the per-layer bookkeeping for capacity layers
+static bool reserve_layers (PAL_TextureArray* array, Uint32 capacity) {
+    bool* used = realloc (array->used, capacity * sizeof (bool));
+    if (used == NULL) return false;
+    array->used = used;
+    Uint32* free_layers = realloc (array->free, capacity * sizeof (Uint32));
+    if (free_layers == NULL) return false;
+    array->free = free_layers;
+    return true;
+}
+
+// makes layers first to capacity - 1 available, the lowest first
+static void
+add_layers (PAL_TextureArray* array, Uint32 first, Uint32 capacity) {
+    for (Uint32 layer = capacity; layer-- > first;) {
+        array->used[layer] = false;
+        array->free[array->free_count++] = layer;
+    }
+    array->info.layer_count_or_depth = capacity;
+}
+
+static void destroy_array (PAL_TextureArray* array) {
+    SDL_ReleaseGPUTexture (array->device, array->texture);
+    free (array->used);
+    free (array->free);
+    free (array);
+}
+
+static PAL_TextureArray*
+create_array (SDL_GPUDevice* device, const SDL_GPUTextureCreateInfo* info) {
+    if (array_count == array_capacity) {
+        Uint32 capacity = array_capacity ? array_capacity * 2 : 8;
+        PAL_TextureArray** grown =
+            realloc (arrays, capacity * sizeof (PAL_TextureArray*));
+        if (grown == NULL) {
+            SDL_Log ("Failed to grow texture array list");
+            return NULL;
+        }
+        arrays = grown;
+        array_capacity = capacity;
+    }
+    PAL_TextureArray* array = calloc (1, sizeof (PAL_TextureArray));
+    if (array == NULL) {
+        SDL_Log ("Failed to allocate texture array");
+        return NULL;
+    }
+    array->device = device;
+    array->info = *info;
+    array->info.type = SDL_GPU_TEXTURETYPE_2D_ARRAY;
+    array->info.props = 0;
+    if (!reserve_layers (array, PAL_TEXTURE_ARRAY_MIN_LAYERS)) {
+        SDL_Log ("Failed to allocate texture array layers");
+        destroy_array (array);
+        return NULL;
+    }
+    array->texture = create_texture (array, PAL_TEXTURE_ARRAY_MIN_LAYERS);
+    if (array->texture == NULL) {
+        destroy_array (array);
+        return NULL;
+    }
+    add_layers (array, 0, PAL_TEXTURE_ARRAY_MIN_LAYERS);
+    arrays[array_count++] = array;
+    return array;
+}
+
+// true if the levels past the first are generated from it, which the
+// loaders do for every texture that can be rendered to
+static bool generated_mips (const SDL_GPUTextureCreateInfo* info) {
+    return info->num_levels > 1 &&
+           (info->usage & SDL_GPU_TEXTUREUSAGE_COLOR_TARGET);
+}
+
+// queues a copy of the layers in use into texture. Generated levels are
+// generated again in texture instead: the old texture's may still be
+// waiting for the end of this very batch.
+static bool copy_layers (
+    const PAL_TextureArray* array,
+    PAL_UploadBatch* batch,
+    SDL_GPUTexture* texture
+) {
+    const SDL_GPUTextureCreateInfo* info = &array->info;
+    Uint32 num_levels = generated_mips (info) ? 1 : info->num_levels;
+    for (Uint32 layer = 0; layer < info->layer_count_or_depth; layer++) {
+        if (!array->used[layer]) continue;
+        for (Uint32 level = 0; level < num_levels; level++) {
+            SDL_GPUTextureLocation src = {
+                .texture = array->texture,
+                .mip_level = level,
+                .layer = layer,
+            };
+            SDL_GPUTextureRegion dst = {
+                .texture = texture,
+                .mip_level = level,
+                .layer = layer,
+                .w = SDL_max (info->width >> level, 1u),
+                .h = SDL_max (info->height >> level, 1u),
+                .d = 1,
+            };
+            if (!PAL_UploadBatchCopyTexture (batch, &src, &dst)) return false;
+        }
+    }
+    return !generated_mips (info) ||
+           PAL_UploadBatchGenerateMipmaps (batch, texture);
+}
+
+static void retired_copied (void* texture) {
+    for (Uint32 i = 0; i < retired_count; i++) {
+        if (retired[i].texture == texture) retired[i].copied = true;
+    }
+}
+
+// doubles the layers; the old texture is retired
+static bool grow_array (PAL_TextureArray* array, PAL_UploadBatch* batch) {
+    Uint32 capacity = array->info.layer_count_or_depth;
+    Uint32 new_capacity = SDL_min (capacity * 2, PAL_TEXTURE_ARRAY_MAX_LAYERS);
+    if (!reserve_layers (array, new_capacity)) {
+        SDL_Log ("Failed to allocate texture array layers");
+        return false;
+    }
+    if (retired_count == retired_capacity) {
+        Uint32 retired_cap = retired_capacity ? retired_capacity * 2 : 8;
+        RetiredTexture* grown =
+            realloc (retired, retired_cap * sizeof (RetiredTexture));
+        if (grown == NULL) {
+            SDL_Log ("Failed to grow retired texture list");
+            return false;
+        }
+        retired = grown;
+        retired_capacity = retired_cap;
+    }
+    SDL_GPUTexture* texture = create_texture (array, new_capacity);
+    if (texture == NULL) return false;
+
+    PAL_UploadBatch* own = NULL;
+    if (batch == NULL) {
+        own = PAL_BeginUploadBatch (array->device, 0);
+        batch = own;
+    }
+    if (!copy_layers (array, batch, texture) ||
+        !PAL_UploadBatchOnSubmit (batch, retired_copied, array->texture)) {
+        SDL_Log ("Failed to queue texture array growth");
+        PAL_UploadBatchDiscard (batch, texture, PAL_UPLOAD_ALL_LAYERS);
+        SDL_ReleaseGPUTexture (array->device, texture);
+        if (own) PAL_SubmitUploadBatch (own, NULL);
+        return false;
+    }
+    retired[retired_count++] = (RetiredTexture) {
+        .device = array->device,
+        .texture = array->texture,
+        .growth = ++growths,
+    };
+    array->texture = texture;
+    add_layers (array, capacity, new_capacity);
+    if (own) PAL_SubmitUploadBatch (own, NULL);
+    return true;
+}
+
+PAL_TextureLayer PAL_AcquireTextureLayer (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const SDL_GPUTextureCreateInfo* info
+) {
+    // a free layer first, then an array with room to grow, then a new one
+    PAL_TextureArray* array = NULL;
+    for (Uint32 i = 0; i < array_count && array == NULL; i++) {
+        if (arrays[i]->free_count > 0 && same_kind (arrays[i], device, info)) {
+            array = arrays[i];
+        }
+    }
+    for (Uint32 i = 0; i < array_count && array == NULL; i++) {
+        Uint32 layers = arrays[i]->info.layer_count_or_depth;
+        if (layers < PAL_TEXTURE_ARRAY_MAX_LAYERS &&
+            same_kind (arrays[i], device, info) &&
+            grow_array (arrays[i], batch)) {
+            array = arrays[i];
+        }
+    }
+    if (array == NULL) array = create_array (device, info);
+    if (array == NULL) return (PAL_TextureLayer) {0};
+
+    Uint32 layer = array->free[--array->free_count];
+    array->used[layer] = true;
+    array->count++;
+    return (PAL_TextureLayer) {.array = array, .layer = layer};
+}
+
+void PAL_ReleaseTextureLayer (PAL_TextureLayer layer) {
+    PAL_TextureArray* array = layer.array;
+    if (array == NULL) return;
+    if (layer.layer >= array->info.layer_count_or_depth ||
+        !array->used[layer.layer]) {
+        SDL_Log ("Texture array layer %u is not in use", layer.layer);
+        return;
+    }
+    array->used[layer.layer] = false;
+    array->free[array->free_count++] = layer.layer;
+    if (--array->count > 0) return;
+
+    for (Uint32 i = 0; i < array_count; i++) {
+        if (arrays[i] == array) {
+            arrays[i] = arrays[--array_count];
+            break;
+        }
+    }
+    destroy_array (array);
+}
+
+SDL_GPUTexture* PAL_GetTextureArrayTexture (const PAL_TextureArray* array) {
+    return array ? array->texture : NULL;
+}
+
+const SDL_GPUTextureCreateInfo*
+PAL_GetTextureArrayInfo (const PAL_TextureArray* array) {
+    return &array->info;
+}
+
+Uint32 PAL_GetTextureArrayGrowths (void) {
+    return growths;
+}
+
+void PAL_ReleaseRetiredTextures (Uint32 unbound) {
+    Uint32 kept = 0;
+    for (Uint32 i = 0; i < retired_count; i++) {
+        if (retired[i].copied && retired[i].growth <= unbound) {
+            SDL_ReleaseGPUTexture (retired[i].device, retired[i].texture);
+        } else {
+            retired[kept++] = retired[i];
+        }
+    }
+    retired_count = kept;
+    if (retired_count == 0) {
+        free (retired);
+        retired = NULL;
+        retired_capacity = 0;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,484 @@
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include <gpu/upload.h>
+
+// texture uploads need offsets aligned to the texel (or block) size
+#define UPLOAD_ALIGNMENT 16
+
+typedef enum {
+    COPY_BUFFER,
+    COPY_TEXTURE,
+    COPY_TEXTURE_TO_TEXTURE, // from a GPU texture, no staged bytes
+} CopyKind;
+
+typedef struct {
+    CopyKind kind;
+    SDL_GPUTransferBuffer* source;
+    Uint32 source_offset;
+    Uint32 size;
+    Uint32 pixels_per_row;
+    SDL_GPUBufferRegion buffer;
+    SDL_GPUTextureRegion region; // the destination of texture copies
+    SDL_GPUTextureLocation from;
+} UploadCopy;
+
+struct PAL_UploadRing {
+    SDL_GPUDevice* device;
+    SDL_GPUTransferBuffer* buffer;
+    Uint32 capacity;
+    Uint32 head;
+    Uint8* map; // NULL while unmapped
+
+    UploadCopy* copies;
+    Uint32 copy_count;
+    Uint32 copy_capacity;
+
+    // outgrown buffers still referenced by queued copies
+    SDL_GPUTransferBuffer** retired;
+    Uint32 retired_count;
+    Uint32 retired_capacity;
+};
+
+static SDL_GPUTransferBuffer*
+create_transfer_buffer (SDL_GPUDevice* device, Uint32 size) {
+    SDL_GPUTransferBufferCreateInfo info = {
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = size
+    };
+    SDL_GPUTransferBuffer* buffer = SDL_CreateGPUTransferBuffer (device, &info);
+    if (buffer == NULL) {
+        SDL_Log ("Failed to create upload buffer: %s", SDL_GetError ());
+    }
+    return buffer;
+}
+
+PAL_UploadRing* PAL_CreateUploadRing (SDL_GPUDevice* device, Uint32 size) {
+    PAL_UploadRing* ring = calloc (1, sizeof (PAL_UploadRing));
+    if (ring == NULL) {
+        SDL_Log ("Failed to allocate upload ring");
+        return NULL;
+    }
+    ring->device = device;
+    ring->capacity = size < UPLOAD_ALIGNMENT ? UPLOAD_ALIGNMENT : size;
+    ring->buffer = create_transfer_buffer (device, ring->capacity);
+    if (ring->buffer == NULL) {
+        free (ring);
+        return NULL;
+    }
+    return ring;
+}
+
+void PAL_DestroyUploadRing (PAL_UploadRing* ring) {
+    if (ring == NULL) return;
+    if (ring->map) SDL_UnmapGPUTransferBuffer (ring->device, ring->buffer);
+    SDL_ReleaseGPUTransferBuffer (ring->device, ring->buffer);
+    for (Uint32 i = 0; i < ring->retired_count; i++) {
+        SDL_ReleaseGPUTransferBuffer (ring->device, ring->retired[i]);
+    }
+    free (ring->retired);
+    free (ring->copies);
+    free (ring);
+}
+
+// swaps in a transfer buffer big enough for this frame plus size bytes
+static bool grow (PAL_UploadRing* ring, Uint32 size) {
+    if (ring->retired_count == ring->retired_capacity) {
+        Uint32 capacity =
+            ring->retired_capacity ? ring->retired_capacity * 2 : 4;
+        SDL_GPUTransferBuffer** retired = realloc (
+            ring->retired, capacity * sizeof (SDL_GPUTransferBuffer*)
+        );
+        if (retired == NULL) return false;
+        ring->retired = retired;
+        ring->retired_capacity = capacity;
+    }
+
+    Uint64 needed = (Uint64) ring->head + size;
+    Uint64 capacity = (Uint64) ring->capacity * 2;
+    while (capacity < needed) capacity *= 2;
+    if (capacity > SDL_MAX_UINT32) return false;
+
+    SDL_GPUTransferBuffer* buffer =
+        create_transfer_buffer (ring->device, (Uint32) capacity);
+    if (buffer == NULL) return false;
+
+    if (ring->map) SDL_UnmapGPUTransferBuffer (ring->device, ring->buffer);
+    ring->map = NULL;
+    ring->retired[ring->retired_count++] = ring->buffer;
+    ring->buffer = buffer;
+    ring->capacity = (Uint32) capacity;
+    ring->head = 0;
+    return true;
+}
+
+// makes room for one more queued copy
+static bool reserve_copy (PAL_UploadRing* ring) {
+    if (ring->copy_count == ring->copy_capacity) {
+        Uint32 capacity = ring->copy_capacity ? ring->copy_capacity * 2 : 64;
+        UploadCopy* copies =
+            realloc (ring->copies, capacity * sizeof (UploadCopy));
+        if (copies == NULL) {
+            SDL_Log ("Failed to grow upload queue");
+            return false;
+        }
+        ring->copies = copies;
+        ring->copy_capacity = capacity;
+    }
+    return true;
+}
+
+static void* reserve (PAL_UploadRing* ring, Uint32 size, UploadCopy** copy) {
+    if (!reserve_copy (ring)) return NULL;
+
+    Uint32 head = (ring->head + UPLOAD_ALIGNMENT - 1) &
+                  ~(Uint32) (UPLOAD_ALIGNMENT - 1);
+    if ((Uint64) head + size > ring->capacity) {
+        if (!grow (ring, size)) {
+            SDL_Log ("Failed to grow upload ring to fit %u bytes", size);
+            return NULL;
+        }
+        head = 0;
+    }
+
+    if (ring->map == NULL) {
+        // the first map of a frame gets a backing store the GPU is done with
+        ring->map = (Uint8*) SDL_MapGPUTransferBuffer (
+            ring->device, ring->buffer, true
+        );
+        if (ring->map == NULL) {
+            SDL_Log ("Failed to map upload ring: %s", SDL_GetError ());
+            return NULL;
+        }
+    }
+
+    ring->head = head + size;
+    *copy = &ring->copies[ring->copy_count++];
+    **copy = (UploadCopy) {
+        .source = ring->buffer,
+        .source_offset = head,
+        .size = size,
+    };
+    return ring->map + head;
+}
+
+void* PAL_UploadRingBuffer (
+    PAL_UploadRing* ring,
+    SDL_GPUBuffer* dst,
+    Uint32 offset,
+    Uint32 size
+) {
+    if (ring == NULL || dst == NULL || size == 0) return NULL;
+    UploadCopy* copy;
+    void* data = reserve (ring, size, &copy);
+    if (data == NULL) return NULL;
+    copy->buffer = (SDL_GPUBufferRegion) {
+        .buffer = dst,
+        .offset = offset,
+        .size = size
+    };
+    return data;
+}
+
+void* PAL_UploadRingTexture (
+    PAL_UploadRing* ring,
+    const SDL_GPUTextureRegion* dst,
+    Uint32 pixels_per_row,
+    Uint32 size
+) {
+    if (ring == NULL || dst == NULL || size == 0) return NULL;
+    UploadCopy* copy;
+    void* data = reserve (ring, size, &copy);
+    if (data == NULL) return NULL;
+    copy->kind = COPY_TEXTURE;
+    copy->region = *dst;
+    copy->pixels_per_row = pixels_per_row;
+    return data;
+}
+
+bool PAL_UploadRingCopyTexture (
+    PAL_UploadRing* ring,
+    const SDL_GPUTextureLocation* src,
+    const SDL_GPUTextureRegion* dst
+) {
+    if (ring == NULL || src == NULL || dst == NULL) return false;
+    if (!reserve_copy (ring)) return false;
+    ring->copies[ring->copy_count++] = (UploadCopy) {
+        .kind = COPY_TEXTURE_TO_TEXTURE,
+        .region = *dst,
+        .from = *src,
+    };
+    return true;
+}
+
+Uint32 PAL_UploadRingFlush (PAL_UploadRing* ring, SDL_GPUCommandBuffer* cmd) {
+    if (ring == NULL) return 0;
+    if (ring->map) SDL_UnmapGPUTransferBuffer (ring->device, ring->buffer);
+    ring->map = NULL;
+
+    Uint32 bytes = 0;
+    if (ring->copy_count > 0) {
+        SDL_GPUCopyPass* pass = SDL_BeginGPUCopyPass (cmd);
+        for (Uint32 i = 0; i < ring->copy_count; i++) {
+            const UploadCopy* copy = &ring->copies[i];
+            bytes += copy->size;
+            if (copy->kind == COPY_TEXTURE_TO_TEXTURE) {
+                const SDL_GPUTextureRegion* r = &copy->region;
+                SDL_GPUTextureLocation dst = {
+                    .texture = r->texture,
+                    .mip_level = r->mip_level,
+                    .layer = r->layer,
+                    .x = r->x,
+                    .y = r->y,
+                    .z = r->z,
+                };
+                SDL_CopyGPUTextureToTexture (
+                    pass, &copy->from, &dst, r->w, r->h, r->d, false
+                );
+                continue;
+            }
+            if (copy->kind == COPY_TEXTURE) {
+                SDL_GPUTextureTransferInfo src = {
+                    .transfer_buffer = copy->source,
+                    .offset = copy->source_offset,
+                    .pixels_per_row = copy->pixels_per_row,
+                };
+                SDL_UploadToGPUTexture (pass, &src, &copy->region, false);
+                continue;
+            }
+            SDL_GPUTransferBufferLocation src = {
+                .transfer_buffer = copy->source,
+                .offset = copy->source_offset
+            };
+            SDL_UploadToGPUBuffer (pass, &src, &copy->buffer, false);
+        }
+        SDL_EndGPUCopyPass (pass);
+    }
+
+    // releases are deferred by SDL until the copies above have executed
+    for (Uint32 i = 0; i < ring->retired_count; i++) {
+        SDL_ReleaseGPUTransferBuffer (ring->device, ring->retired[i]);
+    }
+    ring->retired_count = 0;
+    ring->copy_count = 0;
+    ring->head = 0;
+    return bytes;
+}
+
+typedef struct {
+    PAL_UploadCallback callback;
+    void* data;
+} UploadCallback;
+
+struct PAL_UploadBatch {
+    SDL_GPUDevice* device;
+    PAL_UploadRing* ring;
+    // textures whose mip chains are generated after the copies
+    SDL_GPUTexture** mipmaps;
+    Uint32 mipmap_count;
+    Uint32 mipmap_capacity;
+    // textures released once the copies are submitted
+    SDL_GPUTexture** releases;
+    Uint32 release_count;
+    Uint32 release_capacity;
+    // run after the releases (PAL_UploadBatchOnSubmit)
+    UploadCallback* callbacks;
+    Uint32 callback_count;
+    Uint32 callback_capacity;
+};
+
+// appends texture to a growing list; false if memory runs out
+static bool push_texture (
+    SDL_GPUTexture*** list,
+    Uint32* count,
+    Uint32* capacity,
+    SDL_GPUTexture* texture
+) {
+    if (*count == *capacity) {
+        Uint32 new_capacity = SDL_max (*capacity * 2, 8u);
+        SDL_GPUTexture** grown =
+            realloc (*list, new_capacity * sizeof (SDL_GPUTexture*));
+        if (grown == NULL) {
+            SDL_Log ("Failed to grow upload batch");
+            return false;
+        }
+        *list = grown;
+        *capacity = new_capacity;
+    }
+    (*list)[(*count)++] = texture;
+    return true;
+}
+
+PAL_UploadBatch* PAL_BeginUploadBatch (SDL_GPUDevice* device, Uint32 size) {
+    PAL_UploadBatch* batch = calloc (1, sizeof (PAL_UploadBatch));
+    if (batch == NULL) {
+        SDL_Log ("Failed to allocate upload batch");
+        return NULL;
+    }
+    batch->device = device;
+    batch->ring = PAL_CreateUploadRing (device, size);
+    if (batch->ring == NULL) {
+        free (batch);
+        return NULL;
+    }
+    return batch;
+}
+
+void* PAL_UploadBatchBuffer (
+    PAL_UploadBatch* batch,
+    SDL_GPUBuffer* dst,
+    Uint32 offset,
+    Uint32 size
+) {
+    if (batch == NULL) return NULL;
+    return PAL_UploadRingBuffer (batch->ring, dst, offset, size);
+}
+
+void* PAL_UploadBatchTexture (
+    PAL_UploadBatch* batch,
+    const SDL_GPUTextureRegion* dst,
+    Uint32 pixels_per_row,
+    Uint32 size
+) {
+    if (batch == NULL) return NULL;
+    return PAL_UploadRingTexture (batch->ring, dst, pixels_per_row, size);
+}
+
+bool PAL_UploadBatchCopyTexture (
+    PAL_UploadBatch* batch,
+    const SDL_GPUTextureLocation* src,
+    const SDL_GPUTextureRegion* dst
+) {
+    if (batch == NULL) return false;
+    return PAL_UploadRingCopyTexture (batch->ring, src, dst);
+}
+
+bool PAL_UploadBatchGenerateMipmaps (
+    PAL_UploadBatch* batch,
+    SDL_GPUTexture* texture
+) {
+    if (batch == NULL) return false;
+    // array layers staged into the same texture share one pass
+    for (Uint32 i = 0; i < batch->mipmap_count; i++) {
+        if (batch->mipmaps[i] == texture) return true;
+    }
+    return push_texture (
+        &batch->mipmaps, &batch->mipmap_count, &batch->mipmap_capacity,
+        texture
+    );
+}
+
+bool PAL_UploadBatchReleaseTexture (
+    PAL_UploadBatch* batch,
+    SDL_GPUTexture* texture
+) {
+    if (batch == NULL) return false;
+    return push_texture (
+        &batch->releases, &batch->release_count, &batch->release_capacity,
+        texture
+    );
+}
+
+bool PAL_UploadBatchOnSubmit (
+    PAL_UploadBatch* batch,
+    PAL_UploadCallback callback,
+    void* data
+) {
+    if (batch == NULL) return false;
+    if (batch->callback_count == batch->callback_capacity) {
+        Uint32 capacity = SDL_max (batch->callback_capacity * 2, 8u);
+        UploadCallback* grown =
+            realloc (batch->callbacks, capacity * sizeof (UploadCallback));
+        if (grown == NULL) {
+            SDL_Log ("Failed to grow upload batch");
+            return false;
+        }
+        batch->callbacks = grown;
+        batch->callback_capacity = capacity;
+    }
+    batch->callbacks[batch->callback_count++] =
+        (UploadCallback) {.callback = callback, .data = data};
+    return true;
+}
+
+void PAL_UploadBatchDiscard (
+    PAL_UploadBatch* batch,
+    SDL_GPUTexture* texture,
+    Uint32 layer
+) {
+    if (batch == NULL) return;
+    PAL_UploadRing* ring = batch->ring;
+    Uint32 kept = 0;
+    bool all = layer == PAL_UPLOAD_ALL_LAYERS;
+    bool targeted = false; // copies into texture remain
+    for (Uint32 i = 0; i < ring->copy_count; i++) {
+        const UploadCopy* copy = &ring->copies[i];
+        const SDL_GPUTextureRegion* to = &copy->region;
+        const SDL_GPUTextureLocation* from = &copy->from;
+        bool into = copy->kind != COPY_BUFFER && to->texture == texture;
+        bool out_of = copy->kind == COPY_TEXTURE_TO_TEXTURE &&
+                      from->texture == texture;
+        if ((into && (all || to->layer == layer)) ||
+            (out_of && (all || from->layer == layer))) {
+            continue;
+        }
+        targeted |= into;
+        ring->copies[kept++] = *copy;
+    }
+    ring->copy_count = kept;
+    if (targeted) return;
+    kept = 0;
+    for (Uint32 i = 0; i < batch->mipmap_count; i++) {
+        if (batch->mipmaps[i] != texture) {
+            batch->mipmaps[kept++] = batch->mipmaps[i];
+        }
+    }
+    batch->mipmap_count = kept;
+}
+
+bool PAL_SubmitUploadBatch (PAL_UploadBatch* batch, SDL_GPUFence** fence) {
+    if (fence) *fence = NULL;
+    if (batch == NULL) return false;
+
+    bool ok = true;
+    if (batch->ring->copy_count > 0 || batch->mipmap_count > 0) {
+        SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (batch->device);
+        if (cmd == NULL) {
+            SDL_Log (
+                "Failed to acquire upload command buffer: %s", SDL_GetError ()
+            );
+            ok = false;
+        } else {
+            PAL_UploadRingFlush (batch->ring, cmd);
+            // blits from each level to the next, after the copy pass
+            for (Uint32 i = 0; i < batch->mipmap_count; i++) {
+                SDL_GenerateMipmapsForGPUTexture (cmd, batch->mipmaps[i]);
+            }
+            if (fence) {
+                *fence = SDL_SubmitGPUCommandBufferAndAcquireFence (cmd);
+                ok = *fence != NULL;
+            } else {
+                ok = SDL_SubmitGPUCommandBuffer (cmd);
+            }
+            if (!ok) {
+                SDL_Log ("Failed to submit upload batch: %s", SDL_GetError ());
+            }
+        }
+    }
+
+    // the transfer buffers are released once the GPU is done with them
+    PAL_DestroyUploadRing (batch->ring);
+    // deferred by SDL until the copies that read them have executed
+    for (Uint32 i = 0; i < batch->release_count; i++) {
+        SDL_ReleaseGPUTexture (batch->device, batch->releases[i]);
+    }
+    for (Uint32 i = 0; i < batch->callback_count; i++) {
+        batch->callbacks[i].callback (batch->callbacks[i].data);
+    }
+    free (batch->mipmaps);
+    free (batch->releases);
+    free (batch->callbacks);
+    free (batch);
+    return ok;
+}
\ No newline at end of file
@@ -5,63 +5,54 @@
 #include <material/basic_material.h>
 #include <material/m_common.h>
 
-PAL_MaterialComponent* PAL_CreateBasicMaterial (const PAL_BasicMaterialCreateInfo* info) {
-    PAL_MaterialComponent* mat = malloc (sizeof (PAL_MaterialComponent));
-    if (mat == NULL) return NULL;
-
+static bool build_basic (PAL_MaterialTemplate* tmpl, const PAL_GPURenderer* renderer, const void* args) {
+    SDL_GPUCullMode cullmode = *(const SDL_GPUCullMode*) args;
     PAL_ShaderCreateInfo vertex_info = {
-        .device = info->renderer->device,
+        .device = renderer->device,
         .filename = "shaders/basic_material.vert.spv",
         .stage = SDL_GPU_SHADERSTAGE_VERTEX,
         .sampler_count = 0,
-        .uniform_buffer_count = 2,
-        .storage_buffer_count = 0,
+        .uniform_buffer_count = 1,
+        .storage_buffer_count = 2,
         .storage_texture_count = 0
     };
-    SDL_GPUShader* vertex_shader = PAL_LoadShader (&vertex_info);
-    if (vertex_shader == NULL) {
-        free (mat);
-        return NULL;
-    }
 
     PAL_ShaderCreateInfo fragment_info = {
-        .device = info->renderer->device,
-        .filename = "shaders/basic_material.frag.spv",
+        .device = renderer->device,
+        // basic materials have no texture; see SHADER_VARIANTS in
+        // engine/CMakeLists.txt
+        .filename = "shaders/basic_material_untextured.frag.spv",
         .stage = SDL_GPU_SHADERSTAGE_FRAGMENT,
-        .sampler_count = 1,
+        .sampler_count = 0,
         .uniform_buffer_count = 1,
-        .storage_buffer_count = 2,
+        .storage_buffer_count = 3,
         .storage_texture_count = 0
     };
-    SDL_GPUShader* fragment_shader = PAL_LoadShader (&fragment_info);
-    if (fragment_shader == NULL) {
-        free (mat);
-        SDL_ReleaseGPUShader (info->renderer->device, vertex_shader);
-        return NULL;
+    // deferred mode only fills the G-buffer; lighting is a separate pass
+    if (renderer->deferred) {
+        fragment_info.filename = "shaders/basic_gbuffer_untextured.frag.spv";
+        fragment_info.uniform_buffer_count = 0;
+        fragment_info.storage_buffer_count = 0;
     }
 
     SDL_GPUGraphicsPipelineCreateInfo pipe_info = {
-        .target_info =
-            {.num_color_targets = 1,
-             .color_target_descriptions =
-                 (SDL_GPUColorTargetDescription[]) {
-                     {.format = info->renderer->format}
-                 },
-             .has_depth_stencil_target = true,
-             .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM},
+        .target_info = PAL_GetMaterialTargets (renderer),
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-        .vertex_shader = vertex_shader,
-        .fragment_shader = fragment_shader,
         .vertex_input_state =
             {.vertex_buffer_descriptions =
                  (SDL_GPUVertexBufferDescription[]) {
                      {.slot = 0,
                       .pitch = 8 * sizeof (float),
                       .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+                      .instance_step_rate = 0},
+                     // object index, see render_system
+                     {.slot = 1,
+                      .pitch = sizeof (Uint32),
+                      .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
                       .instance_step_rate = 0}
                  },
-             .num_vertex_buffers = 1,
-             .num_vertex_attributes = 3,
+             .num_vertex_buffers = 2,
+             .num_vertex_attributes = 4,
              .vertex_attributes =
                  (SDL_GPUVertexAttribute[]) {
                      {.location = 0,
@@ -75,34 +66,62 @@ PAL_MaterialComponent* PAL_CreateBasicMaterial (const PAL_BasicMaterialCreateInf
                      {.location = 2,
                       .buffer_slot = 0,
                       .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-                      .offset = 6 * sizeof (float)}
+                      .offset = 6 * sizeof (float)},
+                     {.location = 3,
+                      .buffer_slot = 1,
+                      .format = SDL_GPU_VERTEXELEMENTFORMAT_UINT,
+                      .offset = 0}
                  }},
         .rasterizer_state =
             {.fill_mode = SDL_GPU_FILLMODE_FILL,
-             .cull_mode = info->cullmode,
+             .cull_mode = cullmode,
              .front_face = SDL_GPU_FRONTFACE_CLOCKWISE},
+        // after a depth pre-pass only the front-most surface passes
         .depth_stencil_state = {
             .enable_depth_test = true,
-            .enable_depth_write = true,
-            .compare_op = SDL_GPU_COMPAREOP_LESS,
+            .enable_depth_write = !renderer->depth_prepass,
+            .compare_op = renderer->depth_prepass
+                              ? SDL_GPU_COMPAREOP_EQUAL
+                              : SDL_GPU_COMPAREOP_LESS,
             .enable_stencil_test = false
         }
     };
-    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline (info->renderer->device, &pipe_info);
-    if (pipeline == NULL) {
-        free (mat);
-        SDL_ReleaseGPUShader (info->renderer->device, vertex_shader);
-        SDL_ReleaseGPUShader (info->renderer->device, fragment_shader);
-        return NULL;
-    }
+    return PAL_CreateTemplatePipelines (tmpl, renderer, &vertex_info, &fragment_info, &pipe_info);
+}
 
-    *mat = (PAL_MaterialComponent) {
-        .color = info->color,
-        .texture = NULL,
-        .vertex_shader = vertex_shader,
-        .fragment_shader = fragment_shader,
-        .pipeline = pipeline
+static PAL_MaterialTemplate* basic_template (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode, bool async, PAL_MaterialTemplate* fallback) {
+    PAL_TemplateBuildInfo info = {
+        .renderer = renderer,
+        .build = build_basic,
+        .args = &cullmode,
+        .args_size = sizeof (cullmode),
+        .textured = false,
+        .async = async,
+        .fallback = fallback
     };
+    return PAL_BuildMaterialTemplate (&info);
+}
+
+PAL_MaterialTemplate* PAL_CreateBasicTemplate (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode) {
+    return basic_template (renderer, cullmode, false, NULL);
+}
 
+PAL_MaterialTemplate* PAL_LoadBasicTemplate (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode, PAL_MaterialTemplate* fallback) {
+    return basic_template (renderer, cullmode, true, fallback);
+}
+
+PAL_MaterialComponent* PAL_CreateBasicMaterial (const PAL_BasicMaterialCreateInfo* info) {
+    PAL_MaterialTemplate* tmpl = info->tmpl;
+    if (tmpl == NULL) {
+        tmpl = basic_template (info->renderer, info->cullmode, info->async, NULL);
+        if (tmpl == NULL) return NULL;
+    }
+
+    PAL_GPUMaterial params = {.color = info->color};
+    PAL_MaterialComponent* mat = PAL_CreateMaterialInstance (tmpl, &params, (PAL_TextureLayer) {0}, NULL);
+    // a template made here has no other users
+    if (mat == NULL && info->tmpl == NULL) {
+        PAL_ReleaseMaterialTemplate (info->renderer->device, tmpl);
+    }
     return mat;
 }
\ No newline at end of file
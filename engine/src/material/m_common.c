@@ -1,32 +1,160 @@
+#include <stdlib.h>
+
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_filesystem.h>
 #include <SDL3/SDL_gpu.h>
 #include <SDL3_image/SDL_image.h>
 
+#include <gpu/dds.h>
 #include <material/m_common.h>
+#include <util/hash_table.h>
 
-// shader loader helper function
-SDL_GPUShader* PAL_LoadShader (const PAL_ShaderCreateInfo* info) {
-    if (!SDL_GetPathInfo (info->filename, NULL)) {
-        SDL_Log ("Couldn't read file %s: %s", info->filename, SDL_GetError ());
-        return NULL;
+// Caches
+// SPIR-V files, shaders, pipelines and samplers live in hash tables keyed by
+// the full bytes they were made from, like the mesh registry. Few distinct
+// objects exist, so a release finds its entry by scanning. The material
+// loader builds pipelines too, so the tables are only touched under
+// cache_lock; files are read and objects created outside it, and a thread
+// that loses the race to publish one releases its own. An entry's data is
+// its reference count, or the size of the SPIR-V in the file cache.
+#define SPIRV_MAGIC 0x07230203u
+#define SPIRV_HEADER_SIZE 20
+
+static PAL_HashTable code_cache = {0};
+static PAL_HashTable shader_cache = {0};
+static PAL_HashTable pipeline_cache = {0};
+static PAL_HashTable sampler_cache = {0};
+static SDL_SpinLock cache_lock = 0;
+
+// takes a reference to the value under key; NULL if there is none
+static void* cache_acquire (PAL_HashTable* cache, const PAL_HashKey* key) {
+    if (key->failed) return NULL;
+    SDL_LockSpinlock (&cache_lock);
+    PAL_HashSlot* slot = PAL_HashTableFind (cache, key->bytes, key->size);
+    void* value = slot ? slot->value : NULL;
+    if (slot) slot->data++;
+    SDL_UnlockSpinlock (&cache_lock);
+    return value;
+}
+
+// adds value, made outside the lock, under key. If another thread added the
+// key meanwhile, its value is returned with a reference for the caller to
+// use instead. Returns NULL if the value couldn't be cached.
+static void*
+cache_publish (PAL_HashTable* cache, const PAL_HashKey* key, void* value) {
+    if (key->failed) return NULL;
+    SDL_LockSpinlock (&cache_lock);
+    PAL_HashSlot* slot = PAL_HashTableFind (cache, key->bytes, key->size);
+    if (slot) {
+        slot->data++;
+        value = slot->value;
+    } else {
+        slot = PAL_HashTableInsert (cache, key->bytes, key->size, value);
+        if (slot) {
+            slot->data = 1;
+        } else {
+            value = NULL;
+        }
     }
+    SDL_UnlockSpinlock (&cache_lock);
+    return value;
+}
+
+// drops a reference to value; true if the caller should destroy it, which
+// is also the case for values the cache doesn't hold
+static bool cache_release (PAL_HashTable* cache, const void* value) {
+    SDL_LockSpinlock (&cache_lock);
+    PAL_HashSlot* slot = PAL_HashTableFindValue (cache, value);
+    bool last = true;
+    if (slot) {
+        last = --slot->data == 0;
+        if (last) PAL_HashTableRemove (cache, slot);
+    }
+    SDL_UnlockSpinlock (&cache_lock);
+    return last;
+}
 
-    const char* entrypoint = "main";
-    SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_SPIRV;
+// reads and checks a SPIR-V file the first time it is asked for; the code
+// stays cached until PAL_FreeShaderCode
+static const void* load_code (const char* filename, Uint64* size) {
+    Uint64 key_size = SDL_strlen (filename);
+    SDL_LockSpinlock (&cache_lock);
+    PAL_HashSlot* slot = PAL_HashTableFind (&code_cache, filename, key_size);
+    void* cached = slot ? slot->value : NULL;
+    if (cached) *size = slot->data;
+    SDL_UnlockSpinlock (&cache_lock);
+    if (cached) return cached;
 
+    if (!SDL_GetPathInfo (filename, NULL)) {
+        SDL_Log ("Couldn't read file %s: %s", filename, SDL_GetError ());
+        return NULL;
+    }
     Uint64 code_size;
-    void* code = SDL_LoadFile (info->filename, &code_size);
+    void* code = SDL_LoadFile (filename, &code_size);
     if (code == NULL) {
-        SDL_Log ("Could't read file %s: %s", info->filename, SDL_GetError ());
+        SDL_Log ("Could't read file %s: %s", filename, SDL_GetError ());
+        return NULL;
+    }
+    Uint32 magic = 0;
+    if (code_size >= SPIRV_HEADER_SIZE) SDL_memcpy (&magic, code, 4);
+    if (code_size % 4 != 0 || magic != SPIRV_MAGIC) {
+        SDL_Log ("%s is not SPIR-V", filename);
+        SDL_free (code);
         return NULL;
     }
 
+    // the same file read by another thread meanwhile wins
+    SDL_LockSpinlock (&cache_lock);
+    slot = PAL_HashTableFind (&code_cache, filename, key_size);
+    if (slot) {
+        SDL_free (code);
+        code = slot->value;
+        code_size = slot->data;
+    } else {
+        slot = PAL_HashTableInsert (&code_cache, filename, key_size, code);
+        if (slot) {
+            slot->data = code_size;
+        } else {
+            SDL_Log ("Failed to grow shader code cache");
+            SDL_free (code);
+            code = NULL;
+        }
+    }
+    SDL_UnlockSpinlock (&cache_lock);
+    *size = code_size;
+    return code;
+}
+
+void PAL_FreeShaderCode (void) {
+    SDL_LockSpinlock (&cache_lock);
+    PAL_HashTable cache = code_cache;
+    code_cache = (PAL_HashTable) {0};
+    SDL_UnlockSpinlock (&cache_lock);
+    for (Uint32 i = 0; i < cache.capacity; i++) {
+        SDL_free (cache.slots[i].value);
+    }
+    PAL_FreeHashTable (&cache);
+}
+
+static void shader_key (PAL_HashKey* key, const PAL_ShaderCreateInfo* info) {
+    PAL_HashKeyAppendString (key, info->filename);
+    PAL_HashKeyAppend (key, &info->stage, sizeof (info->stage));
+    PAL_HashKeyAppend (key, &info->sampler_count, sizeof (Uint32));
+    PAL_HashKeyAppend (key, &info->uniform_buffer_count, sizeof (Uint32));
+    PAL_HashKeyAppend (key, &info->storage_buffer_count, sizeof (Uint32));
+    PAL_HashKeyAppend (key, &info->storage_texture_count, sizeof (Uint32));
+}
+
+static SDL_GPUShader* create_shader (const PAL_ShaderCreateInfo* info) {
+    Uint64 code_size;
+    const void* code = load_code (info->filename, &code_size);
+    if (code == NULL) return NULL;
+
     SDL_GPUShaderCreateInfo shader_info = {
         .code = code,
         .code_size = code_size,
-        .entrypoint = entrypoint,
-        .format = format,
+        .entrypoint = "main",
+        .format = SDL_GPU_SHADERFORMAT_SPIRV,
         .stage = info->stage,
         .num_samplers = info->sampler_count,
         .num_uniform_buffers = info->uniform_buffer_count,
@@ -35,109 +163,936 @@ SDL_GPUShader* PAL_LoadShader (const PAL_ShaderCreateInfo* info) {
     };
 
     SDL_GPUShader* shader = SDL_CreateGPUShader (info->device, &shader_info);
-    SDL_free (code);
     if (shader == NULL) {
         SDL_Log ("Couldn't create GPU Shader: %s", SDL_GetError ());
-        return NULL;
     }
     return shader;
 }
 
-// texture loader helper function
-SDL_GPUTexture*
-PAL_LoadTexture (SDL_GPUDevice* device, const char* bmp_file_path) {
-    // note to self: don't forget to look at texture wrapping, texture
-    // filtering, mipmaps https://learnopengl.com/Getting-started/Textures load
-    // texture
-    // does the file exist
-    if (!SDL_GetPathInfo (bmp_file_path, NULL)) {
-        SDL_Log ("Couldn't read file: %s", SDL_GetError ());
+// shader loader helper function
+SDL_GPUShader* PAL_LoadShader (const PAL_ShaderCreateInfo* info) {
+    PAL_HashKey key;
+    PAL_InitHashKey (&key);
+    PAL_HashKeyAppend (&key, &info->device, sizeof (info->device));
+    shader_key (&key, info);
+    SDL_GPUShader* cached = cache_acquire (&shader_cache, &key);
+    SDL_GPUShader* shader = NULL;
+    if (cached == NULL) shader = create_shader (info);
+    if (shader) cached = cache_publish (&shader_cache, &key, shader);
+    PAL_FreeHashKey (&key);
+    if (shader == NULL) return cached;
+
+    // an uncached shader still works; its release just can't be shared
+    if (cached == NULL) {
+        SDL_Log ("Failed to cache shader; %s not shared", info->filename);
+        return shader;
+    }
+    if (cached != shader) SDL_ReleaseGPUShader (info->device, shader);
+    return cached;
+}
+
+void PAL_ReleaseShader (SDL_GPUDevice* device, SDL_GPUShader* shader) {
+    if (shader == NULL) return;
+    if (cache_release (&shader_cache, shader)) {
+        SDL_ReleaseGPUShader (device, shader);
+    }
+}
+
+// compute pipeline loader helper function
+SDL_GPUComputePipeline*
+PAL_LoadComputePipeline (const PAL_ComputePipelineCreateInfo* info) {
+    Uint64 code_size;
+    const void* code = load_code (info->filename, &code_size);
+    if (code == NULL) return NULL;
+
+    SDL_GPUComputePipelineCreateInfo pipeline_info = {
+        .code = code,
+        .code_size = code_size,
+        .entrypoint = "main",
+        .format = SDL_GPU_SHADERFORMAT_SPIRV,
+        .num_readonly_storage_buffers = info->readonly_storage_buffer_count,
+        .num_readwrite_storage_buffers = info->readwrite_storage_buffer_count,
+        .num_uniform_buffers = info->uniform_buffer_count,
+        .threadcount_x = info->threadcount_x,
+        .threadcount_y = 1,
+        .threadcount_z = 1,
+    };
+
+    SDL_GPUComputePipeline* pipeline =
+        SDL_CreateGPUComputePipeline (info->device, &pipeline_info);
+    if (pipeline == NULL) {
+        SDL_Log ("Couldn't create GPU compute pipeline: %s", SDL_GetError ());
         return NULL;
     }
+    return pipeline;
+}
 
-    // surface
-    SDL_Surface* surface = IMG_Load (bmp_file_path);
-    if (surface == NULL) {
-        SDL_Log ("Failed to load texture: %s", SDL_GetError ());
+// SDL pads its GPU state structs explicitly, so they're keyed byte for
+// byte; the arrays they point to are keyed in place of the pointers
+static void pipeline_key (
+    PAL_HashKey* key,
+    SDL_GPUDevice* device,
+    const PAL_ShaderCreateInfo* vertex,
+    const PAL_ShaderCreateInfo* fragment,
+    const SDL_GPUGraphicsPipelineCreateInfo* info
+) {
+    PAL_HashKeyAppend (key, &device, sizeof (device));
+    shader_key (key, vertex);
+    shader_key (key, fragment);
+
+    // the counts go in too, so an array can't pass for its neighbour
+    const SDL_GPUVertexInputState* input = &info->vertex_input_state;
+    PAL_HashKeyAppend (
+        key, &input->num_vertex_buffers, sizeof (input->num_vertex_buffers)
+    );
+    PAL_HashKeyAppend (
+        key, input->vertex_buffer_descriptions,
+        input->num_vertex_buffers * sizeof (SDL_GPUVertexBufferDescription)
+    );
+    PAL_HashKeyAppend (
+        key, &input->num_vertex_attributes,
+        sizeof (input->num_vertex_attributes)
+    );
+    PAL_HashKeyAppend (
+        key, input->vertex_attributes,
+        input->num_vertex_attributes * sizeof (SDL_GPUVertexAttribute)
+    );
+    PAL_HashKeyAppend (
+        key, &info->primitive_type, sizeof (info->primitive_type)
+    );
+    PAL_HashKeyAppend (
+        key, &info->rasterizer_state, sizeof (info->rasterizer_state)
+    );
+    PAL_HashKeyAppend (
+        key, &info->multisample_state, sizeof (info->multisample_state)
+    );
+    PAL_HashKeyAppend (
+        key, &info->depth_stencil_state, sizeof (info->depth_stencil_state)
+    );
+
+    const SDL_GPUGraphicsPipelineTargetInfo* targets = &info->target_info;
+    PAL_HashKeyAppend (
+        key, &targets->num_color_targets, sizeof (targets->num_color_targets)
+    );
+    PAL_HashKeyAppend (
+        key, targets->color_target_descriptions,
+        targets->num_color_targets * sizeof (SDL_GPUColorTargetDescription)
+    );
+    PAL_HashKeyAppend (
+        key, &targets->depth_stencil_format,
+        sizeof (targets->depth_stencil_format)
+    );
+    PAL_HashKeyAppend (
+        key, &targets->has_depth_stencil_target,
+        sizeof (targets->has_depth_stencil_target)
+    );
+}
+
+static SDL_GPUGraphicsPipeline* create_pipeline (
+    SDL_GPUDevice* device,
+    const PAL_ShaderCreateInfo* vertex,
+    const PAL_ShaderCreateInfo* fragment,
+    const SDL_GPUGraphicsPipelineCreateInfo* info
+) {
+    // the pipeline keeps what it needs of the shaders
+    SDL_GPUShader* vertex_shader = PAL_LoadShader (vertex);
+    SDL_GPUShader* fragment_shader = PAL_LoadShader (fragment);
+    SDL_GPUGraphicsPipeline* pipeline = NULL;
+    if (vertex_shader && fragment_shader) {
+        SDL_GPUGraphicsPipelineCreateInfo pipe_info = *info;
+        pipe_info.vertex_shader = vertex_shader;
+        pipe_info.fragment_shader = fragment_shader;
+        pipeline = SDL_CreateGPUGraphicsPipeline (device, &pipe_info);
+        if (pipeline == NULL) {
+            SDL_Log ("Couldn't create pipeline: %s", SDL_GetError ());
+        }
+    }
+    PAL_ReleaseShader (device, vertex_shader);
+    PAL_ReleaseShader (device, fragment_shader);
+    return pipeline;
+}
+
+SDL_GPUGraphicsPipeline* PAL_AcquireGraphicsPipeline (
+    SDL_GPUDevice* device,
+    const PAL_ShaderCreateInfo* vertex,
+    const PAL_ShaderCreateInfo* fragment,
+    const SDL_GPUGraphicsPipelineCreateInfo* info
+) {
+    PAL_HashKey key;
+    PAL_InitHashKey (&key);
+    pipeline_key (&key, device, vertex, fragment, info);
+    SDL_GPUGraphicsPipeline* cached = cache_acquire (&pipeline_cache, &key);
+    SDL_GPUGraphicsPipeline* pipeline = NULL;
+    if (cached == NULL) {
+        pipeline = create_pipeline (device, vertex, fragment, info);
+    }
+    if (pipeline) cached = cache_publish (&pipeline_cache, &key, pipeline);
+    PAL_FreeHashKey (&key);
+    if (pipeline == NULL) return cached;
+
+    if (cached == NULL) {
+        SDL_Log ("Failed to cache pipeline; pipeline not shared");
+        return pipeline;
+    }
+    if (cached != pipeline) SDL_ReleaseGPUGraphicsPipeline (device, pipeline);
+    return cached;
+}
+
+void PAL_ReleaseGraphicsPipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUGraphicsPipeline* pipeline
+) {
+    if (pipeline == NULL) return;
+    if (cache_release (&pipeline_cache, pipeline)) {
+        SDL_ReleaseGPUGraphicsPipeline (device, pipeline);
+    }
+}
+
+// no clamp on the mip chain
+#define SAMPLER_MAX_LOD 1000.0f
+
+static const SDL_GPUSamplerCreateInfo sampler_presets[] = {
+    [PAL_SAMPLER_LINEAR_REPEAT] = {
+        .min_filter = SDL_GPU_FILTER_LINEAR,
+        .mag_filter = SDL_GPU_FILTER_LINEAR,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .max_lod = SAMPLER_MAX_LOD,
+    },
+    [PAL_SAMPLER_LINEAR_CLAMP] = {
+        .min_filter = SDL_GPU_FILTER_LINEAR,
+        .mag_filter = SDL_GPU_FILTER_LINEAR,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .max_lod = SAMPLER_MAX_LOD,
+    },
+    [PAL_SAMPLER_NEAREST_REPEAT] = {
+        .min_filter = SDL_GPU_FILTER_NEAREST,
+        .mag_filter = SDL_GPU_FILTER_NEAREST,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .max_lod = SAMPLER_MAX_LOD,
+    },
+    [PAL_SAMPLER_NEAREST_CLAMP] = {
+        .min_filter = SDL_GPU_FILTER_NEAREST,
+        .mag_filter = SDL_GPU_FILTER_NEAREST,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .max_lod = SAMPLER_MAX_LOD,
+    },
+};
+
+// the create info is keyed whole, properties ID and padding included
+SDL_GPUSampler* PAL_AcquireSampler (
+    SDL_GPUDevice* device,
+    const SDL_GPUSamplerCreateInfo* info
+) {
+    PAL_HashKey key;
+    PAL_InitHashKey (&key);
+    PAL_HashKeyAppend (&key, &device, sizeof (device));
+    PAL_HashKeyAppend (&key, info, sizeof (*info));
+    SDL_GPUSampler* cached = cache_acquire (&sampler_cache, &key);
+    SDL_GPUSampler* sampler = NULL;
+    if (cached == NULL) {
+        sampler = SDL_CreateGPUSampler (device, info);
+        if (sampler == NULL) {
+            SDL_Log ("Failed to create sampler: %s", SDL_GetError ());
+        }
+    }
+    if (sampler) cached = cache_publish (&sampler_cache, &key, sampler);
+    PAL_FreeHashKey (&key);
+    if (sampler == NULL) return cached;
+
+    if (cached == NULL) {
+        SDL_Log ("Failed to cache sampler");
+        SDL_ReleaseGPUSampler (device, sampler);
         return NULL;
     }
-    SDL_Surface* abgr_surface =
-        SDL_ConvertSurface (surface, SDL_PIXELFORMAT_ABGR8888);
-    SDL_DestroySurface (surface);
-    if (abgr_surface == NULL) {
-        SDL_Log ("Failed to convert surface format: %s", SDL_GetError ());
+    if (cached != sampler) SDL_ReleaseGPUSampler (device, sampler);
+    return cached;
+}
+
+SDL_GPUSampler*
+PAL_AcquirePresetSampler (SDL_GPUDevice* device, PAL_SamplerPreset preset) {
+    if (preset >= SDL_arraysize (sampler_presets)) {
+        SDL_Log ("Unknown sampler preset %d", (int) preset);
         return NULL;
     }
-    SDL_GPUTextureCreateInfo tex_create_info = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
-        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, // RGBA,
-        .width = abgr_surface->w,
-        .height = abgr_surface->h,
-        .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER
+    return PAL_AcquireSampler (device, &sampler_presets[preset]);
+}
+
+bool PAL_RetainSampler (SDL_GPUSampler* sampler) {
+    SDL_LockSpinlock (&cache_lock);
+    PAL_HashSlot* slot = PAL_HashTableFindValue (&sampler_cache, sampler);
+    if (slot) slot->data++;
+    SDL_UnlockSpinlock (&cache_lock);
+    return slot != NULL;
+}
+
+void PAL_ReleaseSampler (SDL_GPUDevice* device, SDL_GPUSampler* sampler) {
+    if (sampler == NULL) return;
+    if (cache_release (&sampler_cache, sampler)) {
+        SDL_ReleaseGPUSampler (device, sampler);
+    }
+}
+
+SDL_GPUGraphicsPipeline* PAL_CreateDepthPipeline (
+    const PAL_GPURenderer* renderer,
+    SDL_GPUCullMode cullmode
+) {
+    PAL_ShaderCreateInfo vertex_info = {
+        .device = renderer->device,
+        .filename = "shaders/depth_only.vert.spv",
+        .stage = SDL_GPU_SHADERSTAGE_VERTEX,
+        .uniform_buffer_count = 1,
+        .storage_buffer_count = 1,
+    };
+    PAL_ShaderCreateInfo fragment_info = {
+        .device = renderer->device,
+        .filename = "shaders/depth_only.frag.spv",
+        .stage = SDL_GPU_SHADERSTAGE_FRAGMENT,
     };
-    SDL_GPUTexture* texture = SDL_CreateGPUTexture (device, &tex_create_info);
-    if (texture == NULL) {
-        SDL_Log ("Failed to create texture: %s", SDL_GetError ());
+    SDL_GPUGraphicsPipelineCreateInfo pipe_info = {
+        .target_info =
+            {.num_color_targets = 0,
+             .has_depth_stencil_target = true,
+             .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM},
+        .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+        .vertex_input_state =
+            {.vertex_buffer_descriptions =
+                 (SDL_GPUVertexBufferDescription[]) {
+                     {.slot = 0,
+                      .pitch = 8 * sizeof (float),
+                      .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX},
+                     {.slot = 1,
+                      .pitch = sizeof (Uint32),
+                      .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE}
+                 },
+             .num_vertex_buffers = 2,
+             .num_vertex_attributes = 2,
+             .vertex_attributes =
+                 (SDL_GPUVertexAttribute[]) {
+                     {.location = 0,
+                      .buffer_slot = 0,
+                      .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
+                      .offset = 0},
+                     {.location = 1,
+                      .buffer_slot = 1,
+                      .format = SDL_GPU_VERTEXELEMENTFORMAT_UINT,
+                      .offset = 0}
+                 }},
+        .rasterizer_state =
+            {.fill_mode = SDL_GPU_FILLMODE_FILL,
+             .cull_mode = cullmode,
+             .front_face = SDL_GPU_FRONTFACE_CLOCKWISE},
+        .depth_stencil_state = {
+            .enable_depth_test = true,
+            .enable_depth_write = true,
+            .compare_op = SDL_GPU_COMPAREOP_LESS,
+        }
+    };
+    return PAL_AcquireGraphicsPipeline (
+        renderer->device, &vertex_info, &fragment_info, &pipe_info
+    );
+}
+
+bool PAL_CreateTemplatePipelines (
+    PAL_MaterialTemplate* tmpl,
+    const PAL_GPURenderer* renderer,
+    const PAL_ShaderCreateInfo* vertex,
+    const PAL_ShaderCreateInfo* fragment,
+    const SDL_GPUGraphicsPipelineCreateInfo* info
+) {
+    tmpl->pipeline =
+        PAL_AcquireGraphicsPipeline (renderer->device, vertex, fragment, info);
+    if (tmpl->pipeline == NULL) return false;
+    if (renderer->depth_prepass) {
+        tmpl->depth_pipeline = PAL_CreateDepthPipeline (
+            renderer, info->rasterizer_state.cull_mode
+        );
+        if (tmpl->depth_pipeline == NULL) return false;
+    }
+    return true;
+}
+
+static void
+release_pipelines (SDL_GPUDevice* device, PAL_MaterialTemplate* tmpl) {
+    PAL_ReleaseGraphicsPipeline (device, tmpl->pipeline);
+    PAL_ReleaseGraphicsPipeline (device, tmpl->depth_pipeline);
+    PAL_ReleaseGraphicsPipeline (device, tmpl->ambient_pipeline);
+    tmpl->pipeline = NULL;
+    tmpl->depth_pipeline = NULL;
+    tmpl->ambient_pipeline = NULL;
+}
+
+PAL_MaterialTemplate* PAL_CreateMaterialTemplate (
+    const PAL_GPURenderer* renderer,
+    const PAL_ShaderCreateInfo* vertex,
+    const PAL_ShaderCreateInfo* fragment,
+    const SDL_GPUGraphicsPipelineCreateInfo* info
+) {
+    PAL_MaterialTemplate* tmpl = calloc (1, sizeof (PAL_MaterialTemplate));
+    if (tmpl == NULL) {
+        SDL_Log ("Failed to allocate material template");
         return NULL;
     }
+    tmpl->textured = fragment->sampler_count > 0;
+    if (!PAL_CreateTemplatePipelines (tmpl, renderer, vertex, fragment, info)) {
+        release_pipelines (renderer->device, tmpl);
+        free (tmpl);
+        return NULL;
+    }
+    return tmpl;
+}
 
-    // create transfer buffer
-    SDL_GPUTransferBufferCreateInfo transfer_info = {
-        .size = abgr_surface->pitch * abgr_surface->h,
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-    };
-    SDL_GPUTransferBuffer* transfer_buf =
-        SDL_CreateGPUTransferBuffer (device, &transfer_info);
-    if (transfer_buf == NULL) {
-        SDL_Log ("Failed to create transfer buffer: %s", SDL_GetError ());
+// Loader
+// One thread builds queued templates in order. It starts with the first
+// asynchronous template and drains its queue before PAL_QuitMaterialLoader
+// stops it.
+#define TEMPLATE_ABANDONED 3 // released while pending; the loader frees it
+
+typedef struct LoadJob {
+    struct LoadJob* next;
+    PAL_MaterialTemplate* tmpl;
+    const PAL_GPURenderer* renderer;
+    PAL_TemplateBuilder build;
+    void* args;
+} LoadJob;
+
+static SDL_Thread* loader = NULL;
+static SDL_Mutex* loader_lock = NULL;
+static SDL_Condition* loader_wake = NULL;
+static LoadJob* load_head = NULL;
+static LoadJob* load_tail = NULL;
+static bool loader_quit = false;
+static SDL_AtomicInt templates_settled = {0};
+
+static void run_job (LoadJob* job) {
+    PAL_MaterialTemplate* tmpl = job->tmpl;
+    SDL_GPUDevice* device = job->renderer->device;
+    bool built = job->build (tmpl, job->renderer, job->args);
+    if (!built) release_pipelines (device, tmpl);
+
+    // publishes the pipelines unless the template was released meanwhile
+    int state = built ? PAL_TEMPLATE_READY : PAL_TEMPLATE_FAILED;
+    if (!SDL_CompareAndSwapAtomicInt (
+            &tmpl->state, PAL_TEMPLATE_PENDING, state
+        )) {
+        release_pipelines (device, tmpl);
+        free (tmpl);
+    } else {
+        // failures count too: their instances stop drawing the fallback
+        SDL_AddAtomicInt (&templates_settled, 1);
+    }
+    free (job->args);
+    free (job);
+}
+
+static int SDLCALL loader_main (void* data) {
+    (void) data;
+    SDL_LockMutex (loader_lock);
+    for (;;) {
+        while (load_head == NULL && !loader_quit) {
+            SDL_WaitCondition (loader_wake, loader_lock);
+        }
+        LoadJob* job = load_head;
+        if (job == NULL) break;
+        load_head = job->next;
+        if (load_head == NULL) load_tail = NULL;
+        SDL_UnlockMutex (loader_lock);
+        run_job (job);
+        SDL_LockMutex (loader_lock);
+    }
+    SDL_UnlockMutex (loader_lock);
+    return 0;
+}
+
+static bool start_loader (void) {
+    if (loader) return true;
+    loader_lock = SDL_CreateMutex ();
+    loader_wake = SDL_CreateCondition ();
+    if (loader_lock && loader_wake) {
+        loader_quit = false;
+        loader = SDL_CreateThread (loader_main, "material loader", NULL);
+    }
+    if (loader == NULL) {
+        SDL_Log ("Material loader disabled: %s", SDL_GetError ());
+        SDL_DestroyCondition (loader_wake);
+        SDL_DestroyMutex (loader_lock);
+        loader_wake = NULL;
+        loader_lock = NULL;
+        return false;
+    }
+    return true;
+}
+
+void PAL_QuitMaterialLoader (void) {
+    if (loader == NULL) return;
+    SDL_LockMutex (loader_lock);
+    loader_quit = true;
+    SDL_SignalCondition (loader_wake);
+    SDL_UnlockMutex (loader_lock);
+    SDL_WaitThread (loader, NULL);
+    loader = NULL;
+    SDL_DestroyCondition (loader_wake);
+    SDL_DestroyMutex (loader_lock);
+    loader_wake = NULL;
+    loader_lock = NULL;
+}
+
+PAL_MaterialTemplate*
+PAL_BuildMaterialTemplate (const PAL_TemplateBuildInfo* info) {
+    PAL_MaterialTemplate* tmpl = calloc (1, sizeof (PAL_MaterialTemplate));
+    if (tmpl == NULL) {
+        SDL_Log ("Failed to allocate material template");
         return NULL;
     }
-    void* data_ptr = SDL_MapGPUTransferBuffer (device, transfer_buf, false);
-    if (data_ptr == NULL) {
-        SDL_Log ("Failed to map transfer buffer: %s", SDL_GetError ());
-        SDL_ReleaseGPUTransferBuffer (device, transfer_buf);
-        SDL_DestroySurface (abgr_surface);
+    tmpl->textured = info->textured;
+    if (!info->async) {
+        if (!info->build (tmpl, info->renderer, info->args)) {
+            release_pipelines (info->renderer->device, tmpl);
+            free (tmpl);
+            return NULL;
+        }
+        return tmpl;
+    }
+
+    LoadJob* job = malloc (sizeof (LoadJob));
+    void* args = malloc (SDL_max (info->args_size, 1));
+    if (job == NULL || args == NULL) {
+        SDL_Log ("Failed to queue material template");
+        free (job);
+        free (args);
+        free (tmpl);
         return NULL;
     }
-    SDL_memcpy (data_ptr, abgr_surface->pixels, transfer_info.size);
-    SDL_UnmapGPUTransferBuffer (device, transfer_buf);
+    SDL_memcpy (args, info->args, info->args_size);
+    *job = (LoadJob) {
+        .tmpl = tmpl,
+        .renderer = info->renderer,
+        .build = info->build,
+        .args = args,
+    };
+    // a fallback drawn with the instances' textures must sample like them
+    if (info->fallback && info->fallback->textured != info->textured) {
+        SDL_Log (
+            "Fallback template is not %s; ignored",
+            info->textured ? "textured" : "untextured"
+        );
+    } else if (info->fallback) {
+        tmpl->fallback = info->fallback;
+        PAL_RetainMaterialTemplate (tmpl->fallback);
+    }
+    SDL_SetAtomicInt (&tmpl->state, PAL_TEMPLATE_PENDING);
+
+    // without a loader the template is built here, but still reported
+    // through its state
+    if (!start_loader ()) {
+        run_job (job);
+        return tmpl;
+    }
+    SDL_LockMutex (loader_lock);
+    if (load_tail) {
+        load_tail->next = job;
+    } else {
+        load_head = job;
+    }
+    load_tail = job;
+    SDL_SignalCondition (loader_wake);
+    SDL_UnlockMutex (loader_lock);
+    return tmpl;
+}
+
+PAL_TemplateState
+PAL_GetMaterialTemplateState (const PAL_MaterialTemplate* tmpl) {
+    return (PAL_TemplateState) SDL_GetAtomicInt ((SDL_AtomicInt*) &tmpl->state);
+}
+
+const PAL_MaterialTemplate*
+PAL_ResolveMaterialTemplate (const PAL_MaterialTemplate* tmpl) {
+    if (tmpl == NULL) return NULL;
+    PAL_TemplateState state = PAL_GetMaterialTemplateState (tmpl);
+    if (state == PAL_TEMPLATE_PENDING) {
+        return PAL_ResolveMaterialTemplate (tmpl->fallback);
+    }
+    return state == PAL_TEMPLATE_READY && tmpl->pipeline ? tmpl : NULL;
+}
+
+Uint32 PAL_GetMaterialTemplateSettles (void) {
+    return (Uint32) SDL_GetAtomicInt (&templates_settled);
+}
+
+void PAL_RetainMaterialTemplate (PAL_MaterialTemplate* tmpl) {
+    if (tmpl) tmpl->refs++;
+}
+
+bool PAL_ReleaseMaterialTemplate (
+    SDL_GPUDevice* device,
+    PAL_MaterialTemplate* tmpl
+) {
+    if (tmpl == NULL) return false;
+    if (tmpl->refs > 1) {
+        tmpl->refs--;
+        return false;
+    }
+    PAL_ReleaseMaterialTemplate (device, tmpl->fallback);
+    tmpl->fallback = NULL;
+    // the loader frees a template it is still building once it is done
+    if (SDL_CompareAndSwapAtomicInt (
+            &tmpl->state, PAL_TEMPLATE_PENDING, TEMPLATE_ABANDONED
+        )) {
+        return true;
+    }
+    release_pipelines (device, tmpl);
+    free (tmpl);
+    return true;
+}
 
-    // upload with a command buffer
-    SDL_GPUCommandBuffer* upload_cmd = SDL_AcquireGPUCommandBuffer (device);
-    if (upload_cmd == NULL) {
-        SDL_Log ("Failed to acquire GPU command buffer: %s", SDL_GetError ());
+PAL_MaterialComponent* PAL_CreateMaterialInstance (
+    PAL_MaterialTemplate* tmpl,
+    const PAL_GPUMaterial* params,
+    PAL_TextureLayer texture,
+    SDL_GPUSampler* sampler
+) {
+    if (tmpl->textured && (texture.array == NULL || sampler == NULL)) {
+        SDL_Log ("Textured material needs a texture and sampler");
+        return NULL;
+    }
+    PAL_MaterialComponent* mat = malloc (sizeof (PAL_MaterialComponent));
+    if (mat == NULL) {
+        SDL_Log ("Failed to allocate material");
+        return NULL;
+    }
+    PAL_GPUMaterial layered = *params;
+    layered.layer = texture.layer;
+    Uint32 index = PAL_AddMaterialParams (&layered);
+    if (index == PAL_MATERIAL_NULL) {
+        free (mat);
         return NULL;
     }
-    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (upload_cmd);
-    if (copy_pass == NULL) {
-        SDL_Log ("Failed to begin GPU copy pass: %s", SDL_GetError ());
+    if (sampler && !PAL_RetainSampler (sampler)) {
+        SDL_Log ("Material sampler doesn't come from PAL_AcquireSampler");
+        PAL_RemoveMaterialParams (index);
+        free (mat);
         return NULL;
     }
-    SDL_GPUTextureTransferInfo src_info = {
-        .transfer_buffer = transfer_buf,
-        .offset = 0,
-        .pixels_per_row = abgr_surface->w,
-        .rows_per_layer = abgr_surface->h,
+    PAL_RetainMaterialTemplate (tmpl);
+    *mat = (PAL_MaterialComponent) {
+        .tmpl = tmpl,
+        .params = index,
+        .texture = texture,
+        .sampler = sampler,
     };
+    return mat;
+}
+
+// stages pixels into batch, or uploads them right away without one
+static bool upload_texture (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const SDL_GPUTextureRegion* region,
+    Uint32 pixels_per_row,
+    const void* pixels,
+    Uint32 size
+) {
+    PAL_UploadBatch* own = NULL;
+    if (batch == NULL) {
+        own = PAL_BeginUploadBatch (device, size);
+        batch = own;
+    }
+    void* map = PAL_UploadBatchTexture (batch, region, pixels_per_row, size);
+    if (map) SDL_memcpy (map, pixels, size);
+    if (own && !PAL_SubmitUploadBatch (own, NULL)) return false;
+    if (map == NULL) {
+        SDL_Log ("Failed to stage texture upload");
+        return false;
+    }
+    return true;
+}
+
+// where a loader puts its texels: a 2D texture of its own, or a layer of a
+// texture array (see gpu/texture_array.h)
+typedef struct {
+    bool layered;
+    SDL_GPUTexture* texture; // the array's texture when layered
+    PAL_TextureLayer layer;  // layer 0 of nothing when not
+} TextureTarget;
+
+// creates target's texture, or acquires its layer through batch so the
+// copies of a growth are ordered before what the loader stages
+static bool create_target (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const SDL_GPUTextureCreateInfo* info,
+    TextureTarget* target
+) {
+    if (target->layered) {
+        target->layer = PAL_AcquireTextureLayer (device, batch, info);
+        target->texture = PAL_GetTextureArrayTexture (target->layer.array);
+    } else {
+        target->texture = SDL_CreateGPUTexture (device, info);
+        if (target->texture == NULL) {
+            SDL_Log ("Failed to create texture: %s", SDL_GetError ());
+        }
+    }
+    return target->texture != NULL;
+}
+
+static void release_target (SDL_GPUDevice* device, TextureTarget* target) {
+    if (target->layered) {
+        PAL_ReleaseTextureLayer (target->layer);
+    } else {
+        SDL_ReleaseGPUTexture (device, target->texture);
+    }
+    target->texture = NULL;
+    target->layer = (PAL_TextureLayer) {0};
+}
+
+// submits a batch the loader began itself; the target is dropped if that
+// fails
+static bool submit_own_batch (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* own,
+    TextureTarget* target
+) {
+    if (own && !PAL_SubmitUploadBatch (own, NULL)) {
+        release_target (device, target);
+        return false;
+    }
+    return true;
+}
+
+// drops the target and whatever was staged for it
+static bool abandon_target (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    PAL_UploadBatch* own,
+    TextureTarget* target
+) {
+    Uint32 layer =
+        target->layered ? target->layer.layer : PAL_UPLOAD_ALL_LAYERS;
+    PAL_UploadBatchDiscard (batch, target->texture, layer);
+    release_target (device, target);
+    if (own) PAL_SubmitUploadBatch (own, NULL);
+    return false;
+}
+
+// uploads every level of a block-compressed DDS file as it is, reading each
+// straight from the file into its staging memory
+static bool load_dds (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    SDL_IOStream* io,
+    const void* header,
+    size_t header_size,
+    TextureTarget* target
+) {
+    PAL_DDSImage image;
+    Sint64 file_size = SDL_GetIOSize (io);
+    if (file_size < 0 ||
+        !PAL_ParseDDS (header, header_size, (Uint64) file_size, &image)) {
+        return false;
+    }
+    SDL_GPUTextureType type = target->layered ? SDL_GPU_TEXTURETYPE_2D_ARRAY
+                                              : SDL_GPU_TEXTURETYPE_2D;
+    if (!SDL_GPUTextureSupportsFormat (
+            device, image.format, type, SDL_GPU_TEXTUREUSAGE_SAMPLER
+        )) {
+        SDL_Log ("Device can't sample this block-compressed format");
+        return false;
+    }
+    SDL_GPUTextureCreateInfo tex_create_info = {
+        .type = type,
+        .format = image.format,
+        .width = image.width,
+        .height = image.height,
+        .layer_count_or_depth = 1,
+        .num_levels = image.num_levels,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER
+    };
+
+    PAL_UploadBatch* own = NULL;
+    if (batch == NULL) {
+        Uint32 size = 0;
+        for (Uint32 level = 0; level < image.num_levels; level++) {
+            size += image.level_sizes[level];
+        }
+        own = PAL_BeginUploadBatch (device, size);
+        batch = own;
+    }
+    if (!create_target (device, batch, &tex_create_info, target)) {
+        if (own) PAL_SubmitUploadBatch (own, NULL);
+        return false;
+    }
+    for (Uint32 level = 0; level < image.num_levels; level++) {
+        SDL_GPUTextureRegion dst_region = {
+            .texture = target->texture,
+            .mip_level = level,
+            .layer = target->layer.layer,
+            .w = SDL_max (image.width >> level, 1u),
+            .h = SDL_max (image.height >> level, 1u),
+            .d = 1,
+        };
+        Uint32 level_size = image.level_sizes[level];
+        void* map = PAL_UploadBatchTexture (batch, &dst_region, 0, level_size);
+        // a failed read leaves garbage in the reserved range; the copy is
+        // discarded before the batch reaches the GPU
+        Sint64 offset = (Sint64) image.level_offsets[level];
+        bool read = map && SDL_SeekIO (io, offset, SDL_IO_SEEK_SET) >= 0 &&
+                    SDL_ReadIO (io, map, level_size) == level_size;
+        if (!read) {
+            SDL_Log (
+                "Failed to stage texture level %u: %s", level, SDL_GetError ()
+            );
+            return abandon_target (device, batch, own, target);
+        }
+    }
+    return submit_own_batch (device, own, target);
+}
+
+// converts surface to RGBA8 rows pitch bytes apart, the way
+// SDL_ConvertSurface would but without allocating a converted copy
+static bool convert_into (SDL_Surface* surface, void* pixels, int pitch) {
+    if (!SDL_ISPIXELFORMAT_INDEXED (surface->format) &&
+        !SDL_SurfaceHasColorKey (surface)) {
+        return SDL_ConvertPixels (
+            surface->w, surface->h, surface->format, surface->pixels,
+            surface->pitch, SDL_PIXELFORMAT_ABGR8888, pixels, pitch
+        );
+    }
+    // palettes and color keys take a blit, onto a surface that wraps the
+    // destination; keyed texels are left transparent black
+    SDL_Surface* dst = SDL_CreateSurfaceFrom (
+        surface->w, surface->h, SDL_PIXELFORMAT_ABGR8888, pixels, pitch
+    );
+    if (dst == NULL) return false;
+    SDL_memset (pixels, 0, (size_t) pitch * surface->h);
+    bool ok = SDL_SetSurfaceBlendMode (surface, SDL_BLENDMODE_NONE) &&
+              SDL_BlitSurface (surface, NULL, dst, NULL);
+    SDL_DestroySurface (dst);
+    return ok;
+}
+
+// decodes any format SDL_image reads and converts it to RGBA8 right in the
+// staging memory, then has the GPU build the mip chain from it
+static bool load_image (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    SDL_IOStream* io,
+    TextureTarget* target
+) {
+    SDL_Surface* surface = IMG_Load_IO (io, false);
+    if (surface == NULL) {
+        SDL_Log ("Failed to load texture: %s", SDL_GetError ());
+        return false;
+    }
+    Uint32 num_levels = 1;
+    for (int edge = SDL_max (surface->w, surface->h); edge > 1; edge >>= 1) {
+        num_levels++;
+    }
+    SDL_GPUTextureCreateInfo tex_create_info = {
+        .type = target->layered ? SDL_GPU_TEXTURETYPE_2D_ARRAY
+                                : SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, // RGBA,
+        .width = surface->w,
+        .height = surface->h,
+        .layer_count_or_depth = 1,
+        .num_levels = num_levels,
+        // mipmap generation blits into the levels
+        .usage =
+            SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET
+    };
+
+    // tightly packed rows, so the staged size is exactly the image
+    Uint32 pitch = (Uint32) surface->w * 4;
+    Uint32 size = pitch * (Uint32) surface->h;
+    PAL_UploadBatch* own = NULL;
+    if (batch == NULL) {
+        own = PAL_BeginUploadBatch (device, size);
+        batch = own;
+    }
+    if (!create_target (device, batch, &tex_create_info, target)) {
+        SDL_DestroySurface (surface);
+        if (own) PAL_SubmitUploadBatch (own, NULL);
+        return false;
+    }
     SDL_GPUTextureRegion dst_region = {
-        .texture = texture,
-        .w = abgr_surface->w,
-        .h = abgr_surface->h,
+        .texture = target->texture,
+        .layer = target->layer.layer,
+        .w = surface->w,
+        .h = surface->h,
         .d = 1,
     };
-    SDL_UploadToGPUTexture (copy_pass, &src_info, &dst_region, false);
-    SDL_EndGPUCopyPass (copy_pass);
-    SDL_SubmitGPUCommandBuffer (upload_cmd);
-    SDL_ReleaseGPUTransferBuffer (device, transfer_buf);
-    SDL_DestroySurface (abgr_surface);
+    void* map = PAL_UploadBatchTexture (batch, &dst_region, surface->w, size);
+    bool staged = map && convert_into (surface, map, (int) pitch);
+    SDL_DestroySurface (surface);
+    // in an array every layer's chain is rebuilt, each from its own first
+    // level
+    if (!staged || (num_levels > 1 &&
+                    !PAL_UploadBatchGenerateMipmaps (batch, target->texture))) {
+        SDL_Log ("Failed to stage texture upload: %s", SDL_GetError ());
+        return abandon_target (device, batch, own, target);
+    }
+    return submit_own_batch (device, own, target);
+}
 
-    return texture;
+static bool load_target (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const char* file_path,
+    TextureTarget* target
+) {
+    SDL_IOStream* io = SDL_IOFromFile (file_path, "rb");
+    if (io == NULL) {
+        SDL_Log ("Couldn't read file %s: %s", file_path, SDL_GetError ());
+        return false;
+    }
+    Uint8 header[PAL_DDS_HEADER_SIZE];
+    size_t header_size = SDL_ReadIO (io, header, sizeof (header));
+    bool loaded = false;
+    if (PAL_IsDDS (header, header_size)) {
+        loaded = load_dds (device, batch, io, header, header_size, target);
+    } else if (SDL_SeekIO (io, 0, SDL_IO_SEEK_SET) < 0) {
+        SDL_Log ("Couldn't rewind %s: %s", file_path, SDL_GetError ());
+    } else {
+        loaded = load_image (device, batch, io, target);
+    }
+    SDL_CloseIO (io);
+    return loaded;
+}
+
+// texture loader helper function
+SDL_GPUTexture* PAL_LoadTexture (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const char* file_path
+) {
+    TextureTarget target = {.layered = false};
+    load_target (device, batch, file_path, &target);
+    return target.texture;
+}
+
+PAL_TextureLayer PAL_LoadTextureLayer (
+    SDL_GPUDevice* device,
+    PAL_UploadBatch* batch,
+    const char* file_path
+) {
+    TextureTarget target = {.layered = true};
+    load_target (device, batch, file_path, &target);
+    return target.layer;
 }
 
 // used for solid-color objects
-SDL_GPUTexture* create_white_texture (SDL_GPUDevice* device) {
+SDL_GPUTexture*
+create_white_texture (SDL_GPUDevice* device, PAL_UploadBatch* batch) {
     SDL_GPUTextureCreateInfo tex_info = {
         .type = SDL_GPU_TEXTURETYPE_2D,
         .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
@@ -154,67 +1109,39 @@ SDL_GPUTexture* create_white_texture (SDL_GPUDevice* device) {
     }
 
     Uint8 pixel[4] = {255, 255, 255, 255}; // White pixel
-
-    SDL_GPUTransferBufferCreateInfo tinfo = {
-        .size = 4,
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-    };
-    SDL_GPUTransferBuffer* trans = SDL_CreateGPUTransferBuffer (device, &tinfo);
-    if (!trans) {
-        SDL_Log (
-            "Failed to create transfer buffer for white texture: %s",
-            SDL_GetError ()
-        );
-        SDL_ReleaseGPUTexture (device, tex);
-        return NULL;
-    }
-
-    void* data = SDL_MapGPUTransferBuffer (device, trans, false);
-    if (!data) {
-        SDL_Log (
-            "Failed to map transfer buffer for white texture: %s",
-            SDL_GetError ()
-        );
-        SDL_ReleaseGPUTransferBuffer (device, trans);
-        SDL_ReleaseGPUTexture (device, tex);
-        return NULL;
-    }
-    memcpy (data, pixel, 4);
-    SDL_UnmapGPUTransferBuffer (device, trans);
-
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
-    if (!cmd) {
-        SDL_Log (
-            "Failed to acquire command buffer for white texture: %s",
-            SDL_GetError ()
-        );
-        SDL_ReleaseGPUTransferBuffer (device, trans);
-        SDL_ReleaseGPUTexture (device, tex);
-        return NULL;
-    }
-
-    SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass (cmd);
-    if (!copy) {
-        SDL_Log (
-            "Failed to begin copy pass for white texture: %s", SDL_GetError ()
-        );
-        SDL_SubmitGPUCommandBuffer (cmd);
-        SDL_ReleaseGPUTransferBuffer (device, trans);
+    SDL_GPUTextureRegion dst = {.texture = tex, .w = 1, .h = 1, .d = 1};
+    if (!upload_texture (device, batch, &dst, 1, pixel, 4)) {
         SDL_ReleaseGPUTexture (device, tex);
         return NULL;
     }
+    return tex;
+}
 
-    SDL_GPUTextureTransferInfo src = {
-        .transfer_buffer = trans,
-        .offset = 0,
-        .pixels_per_row = 1,
-        .rows_per_layer = 1
+PAL_TextureLayer
+PAL_CreateWhiteTextureLayer (SDL_GPUDevice* device, PAL_UploadBatch* batch) {
+    SDL_GPUTextureCreateInfo tex_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
+        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+        .width = 1,
+        .height = 1,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER
     };
-    SDL_GPUTextureRegion dst = {.texture = tex, .w = 1, .h = 1, .d = 1};
-    SDL_UploadToGPUTexture (copy, &src, &dst, false);
-    SDL_EndGPUCopyPass (copy);
-    SDL_SubmitGPUCommandBuffer (cmd);
+    PAL_TextureLayer layer = PAL_AcquireTextureLayer (device, batch, &tex_info);
+    if (layer.array == NULL) return layer;
 
-    SDL_ReleaseGPUTransferBuffer (device, trans);
-    return tex;
+    Uint8 pixel[4] = {255, 255, 255, 255};
+    SDL_GPUTextureRegion dst = {
+        .texture = PAL_GetTextureArrayTexture (layer.array),
+        .layer = layer.layer,
+        .w = 1,
+        .h = 1,
+        .d = 1,
+    };
+    if (!upload_texture (device, batch, &dst, 1, pixel, 4)) {
+        PAL_ReleaseTextureLayer (layer);
+        return (PAL_TextureLayer) {0};
+    }
+    return layer;
 }
\ No newline at end of file
@@ -5,63 +5,60 @@
 #include <material/m_common.h>
 #include <material/phong_material.h>
 
-PAL_MaterialComponent* PAL_CreatePhongMaterial (const PAL_PhongMaterialCreateInfo* info) {
-    PAL_MaterialComponent* mat = malloc (sizeof (PAL_MaterialComponent));
-    if (mat == NULL) return NULL;
+typedef struct {
+    SDL_GPUCullMode cullmode;
+    bool textured;
+} PhongVariant;
 
+static bool build_phong (PAL_MaterialTemplate* tmpl, const PAL_GPURenderer* renderer, const void* args) {
+    const PhongVariant* variant = args;
+    SDL_GPUCullMode cullmode = variant->cullmode;
+    bool textured = variant->textured;
     PAL_ShaderCreateInfo vertex_info = {
-        .device = info->renderer->device,
+        .device = renderer->device,
         .filename = "shaders/phong_material.vert.spv",
         .stage = SDL_GPU_SHADERSTAGE_VERTEX,
         .sampler_count = 0,
-        .uniform_buffer_count = 2,
-        .storage_buffer_count = 0,
+        .uniform_buffer_count = 1,
+        .storage_buffer_count = 2,
         .storage_texture_count = 0
     };
-    SDL_GPUShader* vertex_shader = PAL_LoadShader (&vertex_info);
-    if (vertex_shader == NULL) {
-        free (mat);
-        return NULL;
-    }
 
     PAL_ShaderCreateInfo fragment_info = {
-        .device = info->renderer->device,
-        .filename = "shaders/phong_material.frag.spv",
+        .device = renderer->device,
+        // variants are built with SHADER_VARIANTS in engine/CMakeLists.txt
+        .filename = textured ? "shaders/phong_material.frag.spv" : "shaders/phong_material_untextured.frag.spv",
         .stage = SDL_GPU_SHADERSTAGE_FRAGMENT,
-        .sampler_count = 1,
+        .sampler_count = textured ? 1 : 0,
         .uniform_buffer_count = 1,
-        .storage_buffer_count = 2,
+        .storage_buffer_count = 3,
         .storage_texture_count = 0
     };
-    SDL_GPUShader* fragment_shader = PAL_LoadShader (&fragment_info);
-    if (fragment_shader == NULL) {
-        free (mat);
-        SDL_ReleaseGPUShader (info->renderer->device, vertex_shader);
-        return NULL;
+    // deferred mode only fills the G-buffer; lighting is a separate pass
+    if (renderer->deferred) {
+        fragment_info.filename = textured ? "shaders/phong_gbuffer.frag.spv" : "shaders/phong_gbuffer_untextured.frag.spv";
+        fragment_info.uniform_buffer_count = 0;
+        fragment_info.storage_buffer_count = 0;
     }
 
     SDL_GPUGraphicsPipelineCreateInfo pipe_info = {
-        .target_info =
-            {.num_color_targets = 1,
-             .color_target_descriptions =
-                 (SDL_GPUColorTargetDescription[]) {
-                     {.format = info->renderer->format}
-                 },
-             .has_depth_stencil_target = true,
-             .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM},
+        .target_info = PAL_GetMaterialTargets (renderer),
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-        .vertex_shader = vertex_shader,
-        .fragment_shader = fragment_shader,
         .vertex_input_state =
             {.vertex_buffer_descriptions =
                  (SDL_GPUVertexBufferDescription[]) {
                      {.slot = 0,
                       .pitch = 8 * sizeof (float),
                       .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+                      .instance_step_rate = 0},
+                     // object index, see render_system
+                     {.slot = 1,
+                      .pitch = sizeof (Uint32),
+                      .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE,
                       .instance_step_rate = 0}
                  },
-             .num_vertex_buffers = 1,
-             .num_vertex_attributes = 3,
+             .num_vertex_buffers = 2,
+             .num_vertex_attributes = 4,
              .vertex_attributes =
                  (SDL_GPUVertexAttribute[]) {
                      {.location = 0,
@@ -75,59 +72,75 @@ PAL_MaterialComponent* PAL_CreatePhongMaterial (const PAL_PhongMaterialCreateInf
                      {.location = 2,
                       .buffer_slot = 0,
                       .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-                      .offset = 6 * sizeof (float)}
+                      .offset = 6 * sizeof (float)},
+                     {.location = 3,
+                      .buffer_slot = 1,
+                      .format = SDL_GPU_VERTEXELEMENTFORMAT_UINT,
+                      .offset = 0}
                  }},
         .rasterizer_state =
             {.fill_mode = SDL_GPU_FILLMODE_FILL,
-             .cull_mode = info->cullmode,
+             .cull_mode = cullmode,
              .front_face = SDL_GPU_FRONTFACE_CLOCKWISE},
+        // after a depth pre-pass only the front-most surface passes
         .depth_stencil_state = {
             .enable_depth_test = true,
-            .enable_depth_write = true,
-            .compare_op = SDL_GPU_COMPAREOP_LESS,
+            .enable_depth_write = !renderer->depth_prepass,
+            .compare_op = renderer->depth_prepass
+                              ? SDL_GPU_COMPAREOP_EQUAL
+                              : SDL_GPU_COMPAREOP_LESS,
             .enable_stencil_test = false
         }
     };
-    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline (info->renderer->device, &pipe_info);
-    if (pipeline == NULL) {
-        free (mat);
-        SDL_ReleaseGPUShader (info->renderer->device, vertex_shader);
-        SDL_ReleaseGPUShader (info->renderer->device, fragment_shader);
-        return NULL;
-    }
+    if (!PAL_CreateTemplatePipelines (tmpl, renderer, &vertex_info, &fragment_info, &pipe_info)) return false;
 
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (info->renderer->device);
-    if (cmd == NULL) {
-        free (mat);
-        SDL_ReleaseGPUShader (info->renderer->device, vertex_shader);
-        SDL_ReleaseGPUShader (info->renderer->device, fragment_shader);
-        SDL_ReleaseGPUGraphicsPipeline (info->renderer->device, pipeline);
-        return NULL;
+    // forward shading gets a variant without the point light lookup for
+    // frames that have none; if it fails they use the full shader
+    if (!renderer->deferred) {
+        fragment_info.filename = textured ? "shaders/phong_material_nopoint.frag.spv" : "shaders/phong_material_untextured_nopoint.frag.spv";
+        fragment_info.storage_buffer_count = 1;
+        tmpl->ambient_pipeline = PAL_AcquireGraphicsPipeline (renderer->device, &vertex_info, &fragment_info, &pipe_info);
     }
+    return true;
+}
 
-    // material UBO (descriptor set 1)
-    Uint32 ubo_size = 0;
-    ubo_size += sizeof (info->color);
-    ubo_size += sizeof (info->emissive);
-    // PBR params (metallic, roughness, specular, sheen, clearcoat, IOR, etc.)
-    // opacity/alpha cutoff for alpha test
-    // UV transform/scale/offset (prob not)
-    // flags/modes
-    // indices/scales for texture channels
-    Uint8 fragment_ubo[ubo_size > 0 ? ubo_size : 1];
-    memcpy (fragment_ubo, &info->color, sizeof (info->color));
-    memcpy (fragment_ubo + sizeof (info->color), &info->emissive, sizeof (info->emissive));
-    SDL_PushGPUFragmentUniformData (cmd, 0, fragment_ubo, ubo_size);
+static PAL_MaterialTemplate* phong_template (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode, bool textured, bool async, PAL_MaterialTemplate* fallback) {
+    PhongVariant variant = {.cullmode = cullmode, .textured = textured};
+    PAL_TemplateBuildInfo info = {
+        .renderer = renderer,
+        .build = build_phong,
+        .args = &variant,
+        .args_size = sizeof (variant),
+        .textured = textured,
+        .async = async,
+        .fallback = fallback
+    };
+    return PAL_BuildMaterialTemplate (&info);
+}
 
-    *mat = (PAL_MaterialComponent) {
+PAL_MaterialTemplate* PAL_CreatePhongTemplate (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode, bool textured) {
+    return phong_template (renderer, cullmode, textured, false, NULL);
+}
+
+PAL_MaterialTemplate* PAL_LoadPhongTemplate (const PAL_GPURenderer* renderer, SDL_GPUCullMode cullmode, bool textured, PAL_MaterialTemplate* fallback) {
+    return phong_template (renderer, cullmode, textured, true, fallback);
+}
+
+PAL_MaterialComponent* PAL_CreatePhongMaterial (const PAL_PhongMaterialCreateInfo* info) {
+    PAL_MaterialTemplate* tmpl = info->tmpl;
+    if (tmpl == NULL) {
+        tmpl = phong_template (info->renderer, info->cullmode, info->texture.array != NULL, info->async, NULL);
+        if (tmpl == NULL) return NULL;
+    }
+
+    PAL_GPUMaterial params = {
         .color = info->color,
-        .emissive = info->emissive,
-        .texture = info->texture,
-        .sampler = info->sampler,
-        .vertex_shader = vertex_shader,
-        .fragment_shader = fragment_shader,
-        .pipeline = pipeline
+        .emissive = info->emissive
     };
-
+    PAL_MaterialComponent* mat = PAL_CreateMaterialInstance (tmpl, &params, info->texture, info->sampler);
+    // a template made here has no other users
+    if (mat == NULL && info->tmpl == NULL) {
+        PAL_ReleaseMaterialTemplate (info->renderer->device, tmpl);
+    }
     return mat;
 }
\ No newline at end of file
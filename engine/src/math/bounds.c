@@ -0,0 +1,111 @@
+#include <float.h>
+#include <math.h>
+
+#include <math/bounds.h>
+
+aabb aabb_empty (void) {
+    return (aabb) {
+        .min = {FLT_MAX, FLT_MAX, FLT_MAX},
+        .max = {-FLT_MAX, -FLT_MAX, -FLT_MAX},
+    };
+}
+
+aabb aabb_union (aabb a, aabb b) {
+    return (aabb) {
+        .min = {fminf (a.min.x, b.min.x), fminf (a.min.y, b.min.y),
+                fminf (a.min.z, b.min.z)},
+        .max = {fmaxf (a.max.x, b.max.x), fmaxf (a.max.y, b.max.y),
+                fmaxf (a.max.z, b.max.z)},
+    };
+}
+
+aabb aabb_expand (aabb a, float margin) {
+    vec3 m = {margin, margin, margin};
+    return (aabb) {.min = vec3_sub (a.min, m), .max = vec3_add (a.max, m)};
+}
+
+bool aabb_contains (aabb outer, aabb inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+           outer.min.z <= inner.min.z && outer.max.x >= inner.max.x &&
+           outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+float aabb_surface_area (aabb a) {
+    vec3 d = vec3_sub (a.max, a.min);
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+vec3 aabb_center (aabb a) {
+    return vec3_scale (vec3_add (a.min, a.max), 0.5f);
+}
+
+// Arvo's method: transform the center, then sum the absolute rotated extents
+aabb aabb_transform (aabb a, mat4 m) {
+    vec3 c = aabb_center (a);
+    vec3 e = vec3_scale (vec3_sub (a.max, a.min), 0.5f);
+
+    vec3 wc = {
+        m[MAT4_IDX (0, 0)] * c.x + m[MAT4_IDX (0, 1)] * c.y +
+            m[MAT4_IDX (0, 2)] * c.z + m[MAT4_IDX (0, 3)],
+        m[MAT4_IDX (1, 0)] * c.x + m[MAT4_IDX (1, 1)] * c.y +
+            m[MAT4_IDX (1, 2)] * c.z + m[MAT4_IDX (1, 3)],
+        m[MAT4_IDX (2, 0)] * c.x + m[MAT4_IDX (2, 1)] * c.y +
+            m[MAT4_IDX (2, 2)] * c.z + m[MAT4_IDX (2, 3)],
+    };
+    vec3 we = {
+        fabsf (m[MAT4_IDX (0, 0)]) * e.x + fabsf (m[MAT4_IDX (0, 1)]) * e.y +
+            fabsf (m[MAT4_IDX (0, 2)]) * e.z,
+        fabsf (m[MAT4_IDX (1, 0)]) * e.x + fabsf (m[MAT4_IDX (1, 1)]) * e.y +
+            fabsf (m[MAT4_IDX (1, 2)]) * e.z,
+        fabsf (m[MAT4_IDX (2, 0)]) * e.x + fabsf (m[MAT4_IDX (2, 1)]) * e.y +
+            fabsf (m[MAT4_IDX (2, 2)]) * e.z,
+    };
+    return (aabb) {.min = vec3_sub (wc, we), .max = vec3_add (wc, we)};
+}
+
+static vec4 plane_normalize (vec4 p) {
+    float len = sqrtf (p.x * p.x + p.y * p.y + p.z * p.z);
+    if (len > 0.0f) return vec4_scale (p, 1.0f / len);
+    return p;
+}
+
+// Gribb-Hartmann plane extraction from the rows of the clip matrix
+void frustum_from_matrix (frustum* f, mat4 m) {
+    vec4 rows[4];
+    for (Uint32 r = 0; r < 4; r++) {
+        rows[r] = (vec4) {m[MAT4_IDX (r, 0)], m[MAT4_IDX (r, 1)],
+                          m[MAT4_IDX (r, 2)], m[MAT4_IDX (r, 3)]};
+    }
+    f->planes[0] = plane_normalize (vec4_add (rows[3], rows[0])); // left
+    f->planes[1] = plane_normalize (vec4_sub (rows[3], rows[0])); // right
+    f->planes[2] = plane_normalize (vec4_add (rows[3], rows[1])); // bottom
+    f->planes[3] = plane_normalize (vec4_sub (rows[3], rows[1])); // top
+    f->planes[4] = plane_normalize (rows[2]);                     // near (z >= 0)
+    f->planes[5] = plane_normalize (vec4_sub (rows[3], rows[2])); // far
+}
+
+FrustumResult frustum_classify_aabb (const frustum* f, aabb a) {
+    FrustumResult result = FRUSTUM_INSIDE;
+    for (Uint32 i = 0; i < 6; i++) {
+        vec4 p = f->planes[i];
+
+        // corner furthest along the plane normal
+        float px = p.x >= 0.0f ? a.max.x : a.min.x;
+        float py = p.y >= 0.0f ? a.max.y : a.min.y;
+        float pz = p.z >= 0.0f ? a.max.z : a.min.z;
+        if (p.x * px + p.y * py + p.z * pz + p.w < 0.0f) return FRUSTUM_OUTSIDE;
+
+        // corner furthest against the plane normal
+        float nx = p.x >= 0.0f ? a.min.x : a.max.x;
+        float ny = p.y >= 0.0f ? a.min.y : a.max.y;
+        float nz = p.z >= 0.0f ? a.min.z : a.max.z;
+        if (p.x * nx + p.y * ny + p.z * nz + p.w < 0.0f) {
+            result = FRUSTUM_INTERSECT;
+        }
+    }
+    return result;
+}
+
+bool frustum_test_aabb (const frustum* f, aabb a) {
+    return frustum_classify_aabb (f, a) != FRUSTUM_OUTSIDE;
+}
\ No newline at end of file
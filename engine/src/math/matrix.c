@@ -276,6 +276,73 @@ void mat4_look_at (mat4 m, vec3 eye, vec3 center, vec3 up) {
     m[MAT4_IDX (1, 3)] = -vec3_dot (u, eye);
     m[MAT4_IDX (2, 3)] = vec3_dot (f, eye);
 }
+bool mat4_inverse (mat4 out, mat4 m) {
+    // 2x2 sub-determinants of the top two and bottom two rows
+    float s0 = m[0] * m[5] - m[4] * m[1];
+    float s1 = m[0] * m[9] - m[8] * m[1];
+    float s2 = m[0] * m[13] - m[12] * m[1];
+    float s3 = m[4] * m[9] - m[8] * m[5];
+    float s4 = m[4] * m[13] - m[12] * m[5];
+    float s5 = m[8] * m[13] - m[12] * m[9];
+    float c5 = m[10] * m[15] - m[14] * m[11];
+    float c4 = m[6] * m[15] - m[14] * m[7];
+    float c3 = m[6] * m[11] - m[10] * m[7];
+    float c2 = m[2] * m[15] - m[14] * m[3];
+    float c1 = m[2] * m[11] - m[10] * m[3];
+    float c0 = m[2] * m[7] - m[6] * m[3];
+
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.0f) return false;
+    float inv = 1.0f / det;
+
+    mat4 r;
+    r[0] = (m[5] * c5 - m[9] * c4 + m[13] * c3) * inv;
+    r[4] = (-m[4] * c5 + m[8] * c4 - m[12] * c3) * inv;
+    r[8] = (m[7] * s5 - m[11] * s4 + m[15] * s3) * inv;
+    r[12] = (-m[6] * s5 + m[10] * s4 - m[14] * s3) * inv;
+    r[1] = (-m[1] * c5 + m[9] * c2 - m[13] * c1) * inv;
+    r[5] = (m[0] * c5 - m[8] * c2 + m[12] * c1) * inv;
+    r[9] = (-m[3] * s5 + m[11] * s2 - m[15] * s1) * inv;
+    r[13] = (m[2] * s5 - m[10] * s2 + m[14] * s1) * inv;
+    r[2] = (m[1] * c4 - m[5] * c2 + m[13] * c0) * inv;
+    r[6] = (-m[0] * c4 + m[4] * c2 - m[12] * c0) * inv;
+    r[10] = (m[3] * s4 - m[7] * s2 + m[15] * s0) * inv;
+    r[14] = (-m[2] * s4 + m[6] * s2 - m[14] * s0) * inv;
+    r[3] = (-m[1] * c3 + m[5] * c1 - m[9] * c0) * inv;
+    r[7] = (m[0] * c3 - m[4] * c1 + m[8] * c0) * inv;
+    r[11] = (-m[3] * s3 + m[7] * s1 - m[11] * s0) * inv;
+    r[15] = (m[2] * s3 - m[6] * s1 + m[10] * s0) * inv;
+    for (Uint32 i = 0; i < 16; i++)
+        out[i] = r[i];
+    return true;
+}
+void mat3_normal (mat3 out, mat4 m) {
+    // the inverse-transpose is the cofactor matrix divided by the
+    // determinant; each cofactor column is a cross product of the others
+    vec3 c0 = {m[MAT4_IDX (0, 0)], m[MAT4_IDX (1, 0)], m[MAT4_IDX (2, 0)]};
+    vec3 c1 = {m[MAT4_IDX (0, 1)], m[MAT4_IDX (1, 1)], m[MAT4_IDX (2, 1)]};
+    vec3 c2 = {m[MAT4_IDX (0, 2)], m[MAT4_IDX (1, 2)], m[MAT4_IDX (2, 2)]};
+    vec3 n0 = vec3_cross (c1, c2);
+    vec3 n1 = vec3_cross (c2, c0);
+    vec3 n2 = vec3_cross (c0, c1);
+    float det = vec3_dot (c0, n0);
+    if (det == 0.0f) {
+        n0 = c0;
+        n1 = c1;
+        n2 = c2;
+    } else {
+        float inv = 1.0f / det;
+        n0 = vec3_scale (n0, inv);
+        n1 = vec3_scale (n1, inv);
+        n2 = vec3_scale (n2, inv);
+    }
+    vec3 cols[3] = {n0, n1, n2};
+    for (Uint32 col = 0; col < 3; col++) {
+        out[MAT3_IDX (0, col)] = cols[col].x;
+        out[MAT3_IDX (1, col)] = cols[col].y;
+        out[MAT3_IDX (2, col)] = cols[col].z;
+    }
+}
 
 void random_seed (Uint32 seed) {
     srand (seed);
@@ -0,0 +1,810 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include <scene/bvh.h>
+
+#define BVH_SAH_BINS 12
+#define BVH_MIN_REBUILD_LEAVES 256
+#define BVH_INSIDE_FLAG 0x80000000u
+
+typedef struct {
+    aabb box;
+    Uint32 parent; // next free node while on the free list
+    Uint32 child1;
+    Uint32 child2;
+    Uint32 proxy;  // PAL_BVH_NULL for internal nodes
+    Sint32 height; // 0 for leaves, -1 for free nodes
+} BVHNode;
+
+typedef struct {
+    aabb box; // fat box
+    Entity entity;
+    Uint32 node;
+    Uint32 next_free;
+    Uint32 journal_epoch;
+    bool alive;
+} BVHProxy;
+
+// background SAH rebuild job; the worker only touches this struct
+typedef struct {
+    Uint32* proxies;
+    aabb* boxes;
+    Uint32 count;
+
+    BVHNode* nodes;
+    Uint32 node_count;
+    Uint32 root;
+} BVHBuild;
+
+struct PAL_BVH {
+    BVHNode* nodes;
+    Uint32 node_capacity;
+    Uint32 free_node;
+    Uint32 root;
+
+    BVHProxy* proxies;
+    Uint32 proxy_capacity;
+    Uint32 proxy_count; // high-water mark
+    Uint32 free_proxy;
+    Uint32 leaf_count;
+
+    float margin;
+    Uint32 churn; // reinsertions since the last rebuild
+
+    Uint32* stack;
+    Uint32 stack_capacity;
+
+    SDL_Thread* worker;
+    SDL_AtomicInt worker_done;
+    BVHBuild build;
+    Uint32* journal; // proxies touched while a rebuild is in flight
+    Uint32 journal_count;
+    Uint32 journal_capacity;
+    Uint32 epoch;
+};
+
+static bool is_leaf (const BVHNode* node) {
+    return node->child1 == PAL_BVH_NULL;
+}
+
+// Nodes
+static Uint32 allocate_node (PAL_BVH* bvh) {
+    if (bvh->free_node == PAL_BVH_NULL) {
+        Uint32 old_cap = bvh->node_capacity;
+        Uint32 new_cap = old_cap ? old_cap * 2 : 64;
+        BVHNode* new_nodes =
+            (BVHNode*) realloc (bvh->nodes, new_cap * sizeof (BVHNode));
+        if (new_nodes == NULL) {
+            SDL_Log ("Failed to grow BVH nodes");
+            return PAL_BVH_NULL;
+        }
+        bvh->nodes = new_nodes;
+        bvh->node_capacity = new_cap;
+        for (Uint32 i = old_cap; i < new_cap; i++) {
+            bvh->nodes[i].parent = i + 1 < new_cap ? i + 1 : PAL_BVH_NULL;
+            bvh->nodes[i].height = -1;
+        }
+        bvh->free_node = old_cap;
+    }
+
+    Uint32 index = bvh->free_node;
+    BVHNode* node = &bvh->nodes[index];
+    bvh->free_node = node->parent;
+    *node = (BVHNode) {
+        .box = aabb_empty (),
+        .parent = PAL_BVH_NULL,
+        .child1 = PAL_BVH_NULL,
+        .child2 = PAL_BVH_NULL,
+        .proxy = PAL_BVH_NULL,
+        .height = 0,
+    };
+    return index;
+}
+
+static void free_node (PAL_BVH* bvh, Uint32 index) {
+    bvh->nodes[index].parent = bvh->free_node;
+    bvh->nodes[index].height = -1;
+    bvh->free_node = index;
+}
+
+// AVL rotation (as in Box2D's b2DynamicTree); returns the new subtree root
+static Uint32 balance (PAL_BVH* bvh, Uint32 ia) {
+    BVHNode* a = &bvh->nodes[ia];
+    if (is_leaf (a) || a->height < 2) return ia;
+
+    Uint32 ib = a->child1;
+    Uint32 ic = a->child2;
+    BVHNode* b = &bvh->nodes[ib];
+    BVHNode* c = &bvh->nodes[ic];
+    Sint32 diff = c->height - b->height;
+
+    // rotate C up
+    if (diff > 1) {
+        Uint32 if_ = c->child1;
+        Uint32 ig = c->child2;
+        BVHNode* f = &bvh->nodes[if_];
+        BVHNode* g = &bvh->nodes[ig];
+
+        c->child1 = ia;
+        c->parent = a->parent;
+        a->parent = ic;
+        if (c->parent != PAL_BVH_NULL) {
+            if (bvh->nodes[c->parent].child1 == ia) {
+                bvh->nodes[c->parent].child1 = ic;
+            } else {
+                bvh->nodes[c->parent].child2 = ic;
+            }
+        } else {
+            bvh->root = ic;
+        }
+
+        if (f->height > g->height) {
+            c->child2 = if_;
+            a->child2 = ig;
+            g->parent = ia;
+            a->box = aabb_union (b->box, g->box);
+            c->box = aabb_union (a->box, f->box);
+            a->height = 1 + SDL_max (b->height, g->height);
+            c->height = 1 + SDL_max (a->height, f->height);
+        } else {
+            c->child2 = ig;
+            a->child2 = if_;
+            f->parent = ia;
+            a->box = aabb_union (b->box, f->box);
+            c->box = aabb_union (a->box, g->box);
+            a->height = 1 + SDL_max (b->height, f->height);
+            c->height = 1 + SDL_max (a->height, g->height);
+        }
+        return ic;
+    }
+
+    // rotate B up
+    if (diff < -1) {
+        Uint32 id = b->child1;
+        Uint32 ie = b->child2;
+        BVHNode* d = &bvh->nodes[id];
+        BVHNode* e = &bvh->nodes[ie];
+
+        b->child1 = ia;
+        b->parent = a->parent;
+        a->parent = ib;
+        if (b->parent != PAL_BVH_NULL) {
+            if (bvh->nodes[b->parent].child1 == ia) {
+                bvh->nodes[b->parent].child1 = ib;
+            } else {
+                bvh->nodes[b->parent].child2 = ib;
+            }
+        } else {
+            bvh->root = ib;
+        }
+
+        if (d->height > e->height) {
+            b->child2 = id;
+            a->child1 = ie;
+            e->parent = ia;
+            a->box = aabb_union (c->box, e->box);
+            b->box = aabb_union (a->box, d->box);
+            a->height = 1 + SDL_max (c->height, e->height);
+            b->height = 1 + SDL_max (a->height, d->height);
+        } else {
+            b->child2 = ie;
+            a->child1 = id;
+            d->parent = ia;
+            a->box = aabb_union (c->box, d->box);
+            b->box = aabb_union (a->box, e->box);
+            a->height = 1 + SDL_max (c->height, d->height);
+            b->height = 1 + SDL_max (a->height, e->height);
+        }
+        return ib;
+    }
+
+    return ia;
+}
+
+// walk up from index fixing boxes and heights
+static void refit_ancestors (PAL_BVH* bvh, Uint32 index) {
+    while (index != PAL_BVH_NULL) {
+        index = balance (bvh, index);
+        BVHNode* node = &bvh->nodes[index];
+        BVHNode* c1 = &bvh->nodes[node->child1];
+        BVHNode* c2 = &bvh->nodes[node->child2];
+        node->height = 1 + SDL_max (c1->height, c2->height);
+        node->box = aabb_union (c1->box, c2->box);
+        index = node->parent;
+    }
+}
+
+static bool insert_leaf (PAL_BVH* bvh, Uint32 leaf) {
+    if (bvh->root == PAL_BVH_NULL) {
+        bvh->root = leaf;
+        bvh->nodes[leaf].parent = PAL_BVH_NULL;
+        return true;
+    }
+
+    // find the cheapest sibling by surface area heuristic
+    aabb leaf_box = bvh->nodes[leaf].box;
+    Uint32 index = bvh->root;
+    while (!is_leaf (&bvh->nodes[index])) {
+        const BVHNode* node = &bvh->nodes[index];
+        float area = aabb_surface_area (node->box);
+        float combined_area =
+            aabb_surface_area (aabb_union (node->box, leaf_box));
+
+        // cost of making a new parent for this node and the leaf
+        float cost = 2.0f * combined_area;
+        // minimum cost of pushing the leaf further down
+        float inheritance = 2.0f * (combined_area - area);
+
+        float child_cost[2];
+        Uint32 children[2] = {node->child1, node->child2};
+        for (Uint32 i = 0; i < 2; i++) {
+            const BVHNode* child = &bvh->nodes[children[i]];
+            float union_area =
+                aabb_surface_area (aabb_union (child->box, leaf_box));
+            child_cost[i] = is_leaf (child)
+                                ? union_area + inheritance
+                                : union_area - aabb_surface_area (child->box) +
+                                      inheritance;
+        }
+
+        if (cost < child_cost[0] && cost < child_cost[1]) break;
+        index = child_cost[0] < child_cost[1] ? children[0] : children[1];
+    }
+
+    Uint32 sibling = index;
+    Uint32 new_parent = allocate_node (bvh);
+    if (new_parent == PAL_BVH_NULL) return false;
+
+    Uint32 old_parent = bvh->nodes[sibling].parent;
+    BVHNode* parent = &bvh->nodes[new_parent];
+    parent->parent = old_parent;
+    parent->box = aabb_union (leaf_box, bvh->nodes[sibling].box);
+    parent->height = bvh->nodes[sibling].height + 1;
+    parent->child1 = sibling;
+    parent->child2 = leaf;
+    bvh->nodes[sibling].parent = new_parent;
+    bvh->nodes[leaf].parent = new_parent;
+
+    if (old_parent != PAL_BVH_NULL) {
+        if (bvh->nodes[old_parent].child1 == sibling) {
+            bvh->nodes[old_parent].child1 = new_parent;
+        } else {
+            bvh->nodes[old_parent].child2 = new_parent;
+        }
+    } else {
+        bvh->root = new_parent;
+    }
+
+    refit_ancestors (bvh, bvh->nodes[leaf].parent);
+    return true;
+}
+
+static void remove_leaf (PAL_BVH* bvh, Uint32 leaf) {
+    if (leaf == bvh->root) {
+        bvh->root = PAL_BVH_NULL;
+        return;
+    }
+
+    Uint32 parent = bvh->nodes[leaf].parent;
+    Uint32 grand_parent = bvh->nodes[parent].parent;
+    Uint32 sibling = bvh->nodes[parent].child1 == leaf
+                         ? bvh->nodes[parent].child2
+                         : bvh->nodes[parent].child1;
+
+    if (grand_parent != PAL_BVH_NULL) {
+        if (bvh->nodes[grand_parent].child1 == parent) {
+            bvh->nodes[grand_parent].child1 = sibling;
+        } else {
+            bvh->nodes[grand_parent].child2 = sibling;
+        }
+        bvh->nodes[sibling].parent = grand_parent;
+        free_node (bvh, parent);
+        refit_ancestors (bvh, grand_parent);
+    } else {
+        bvh->root = sibling;
+        bvh->nodes[sibling].parent = PAL_BVH_NULL;
+        free_node (bvh, parent);
+    }
+}
+
+// Journal
+static void journal_proxy (PAL_BVH* bvh, Uint32 proxy) {
+    if (bvh->worker == NULL) return;
+    BVHProxy* p = &bvh->proxies[proxy];
+    if (p->journal_epoch == bvh->epoch) return;
+
+    if (bvh->journal_count == bvh->journal_capacity) {
+        Uint32 new_cap = bvh->journal_capacity ? bvh->journal_capacity * 2 : 256;
+        Uint32* new_journal =
+            (Uint32*) realloc (bvh->journal, new_cap * sizeof (Uint32));
+        if (new_journal == NULL) {
+            // without the journal entry the swapped-in tree would be stale
+            SDL_Log ("Failed to grow BVH journal; dropping pending rebuild");
+            SDL_WaitThread (bvh->worker, NULL);
+            bvh->worker = NULL;
+            free (bvh->build.nodes);
+            bvh->build.nodes = NULL;
+            return;
+        }
+        bvh->journal = new_journal;
+        bvh->journal_capacity = new_cap;
+    }
+    bvh->journal[bvh->journal_count++] = proxy;
+    p->journal_epoch = bvh->epoch;
+}
+
+// Proxies
+PAL_BVH* PAL_CreateBVH (float margin) {
+    PAL_BVH* bvh = calloc (1, sizeof (PAL_BVH));
+    if (bvh == NULL) {
+        SDL_Log ("Failed to allocate BVH");
+        return NULL;
+    }
+    bvh->free_node = PAL_BVH_NULL;
+    bvh->root = PAL_BVH_NULL;
+    bvh->free_proxy = PAL_BVH_NULL;
+    bvh->margin = margin;
+    SDL_SetAtomicInt (&bvh->worker_done, 0);
+    return bvh;
+}
+
+void PAL_DestroyBVH (PAL_BVH* bvh) {
+    if (bvh == NULL) return;
+    if (bvh->worker) SDL_WaitThread (bvh->worker, NULL);
+    free (bvh->build.nodes);
+    free (bvh->build.proxies);
+    free (bvh->build.boxes);
+    free (bvh->nodes);
+    free (bvh->proxies);
+    free (bvh->stack);
+    free (bvh->journal);
+    free (bvh);
+}
+
+Uint32 PAL_BVHInsert (PAL_BVH* bvh, Entity e, aabb box) {
+    if (bvh->free_proxy == PAL_BVH_NULL &&
+        bvh->proxy_count == bvh->proxy_capacity) {
+        Uint32 new_cap = bvh->proxy_capacity ? bvh->proxy_capacity * 2 : 64;
+        BVHProxy* new_proxies =
+            (BVHProxy*) realloc (bvh->proxies, new_cap * sizeof (BVHProxy));
+        if (new_proxies == NULL) {
+            SDL_Log ("Failed to grow BVH proxies");
+            return PAL_BVH_NULL;
+        }
+        bvh->proxies = new_proxies;
+        bvh->proxy_capacity = new_cap;
+    }
+
+    Uint32 proxy;
+    if (bvh->free_proxy != PAL_BVH_NULL) {
+        proxy = bvh->free_proxy;
+        bvh->free_proxy = bvh->proxies[proxy].next_free;
+    } else {
+        proxy = bvh->proxy_count++;
+        bvh->proxies[proxy].journal_epoch = ~0u;
+    }
+
+    Uint32 leaf = allocate_node (bvh);
+    if (leaf == PAL_BVH_NULL) {
+        bvh->proxies[proxy].next_free = bvh->free_proxy;
+        bvh->free_proxy = proxy;
+        return PAL_BVH_NULL;
+    }
+
+    BVHProxy* p = &bvh->proxies[proxy];
+    p->box = aabb_expand (box, bvh->margin);
+    p->entity = e;
+    p->node = leaf;
+    p->next_free = PAL_BVH_NULL;
+    p->alive = true;
+
+    bvh->nodes[leaf].box = p->box;
+    bvh->nodes[leaf].proxy = proxy;
+    if (!insert_leaf (bvh, leaf)) {
+        free_node (bvh, leaf);
+        p->alive = false;
+        p->next_free = bvh->free_proxy;
+        bvh->free_proxy = proxy;
+        return PAL_BVH_NULL;
+    }
+    bvh->leaf_count++;
+    journal_proxy (bvh, proxy);
+    return proxy;
+}
+
+void PAL_BVHRemove (PAL_BVH* bvh, Uint32 proxy) {
+    if (proxy >= bvh->proxy_count || !bvh->proxies[proxy].alive) return;
+    BVHProxy* p = &bvh->proxies[proxy];
+
+    remove_leaf (bvh, p->node);
+    free_node (bvh, p->node);
+    p->node = PAL_BVH_NULL;
+    p->alive = false;
+    p->next_free = bvh->free_proxy;
+    bvh->free_proxy = proxy;
+    bvh->leaf_count--;
+    journal_proxy (bvh, proxy);
+}
+
+bool PAL_BVHMove (PAL_BVH* bvh, Uint32 proxy, aabb box) {
+    if (proxy >= bvh->proxy_count || !bvh->proxies[proxy].alive) return false;
+    BVHProxy* p = &bvh->proxies[proxy];
+    if (aabb_contains (p->box, box)) return false;
+
+    remove_leaf (bvh, p->node);
+    p->box = aabb_expand (box, bvh->margin);
+    bvh->nodes[p->node].box = p->box;
+    // the leaf node is reused, so insert_leaf only allocates its new parent;
+    // removal just freed one, so this cannot fail
+    insert_leaf (bvh, p->node);
+    bvh->churn++;
+    journal_proxy (bvh, proxy);
+    return true;
+}
+
+Uint32 PAL_BVHCount (const PAL_BVH* bvh) {
+    return bvh->leaf_count;
+}
+
+// SAH build
+typedef struct {
+    Uint32 start;
+    Uint32 end;
+    Uint32 node;
+} BuildTask;
+
+static float centroid_axis (aabb box, Uint32 axis) {
+    vec3 c = aabb_center (box);
+    return axis == 0 ? c.x : (axis == 1 ? c.y : c.z);
+}
+
+// partitions order[start, end) and returns the split point, or start if no
+// useful split exists
+static Uint32 sah_split (
+    const aabb* boxes,
+    Uint32* order,
+    Uint32 start,
+    Uint32 end
+) {
+    aabb centroid_bounds = aabb_empty ();
+    for (Uint32 i = start; i < end; i++) {
+        vec3 c = aabb_center (boxes[order[i]]);
+        centroid_bounds = aabb_union (centroid_bounds, (aabb) {c, c});
+    }
+    vec3 extent = vec3_sub (centroid_bounds.max, centroid_bounds.min);
+
+    float best_cost = INFINITY;
+    Uint32 best_axis = 0;
+    Uint32 best_bin = 0;
+    for (Uint32 axis = 0; axis < 3; axis++) {
+        float lo = axis == 0 ? centroid_bounds.min.x
+                             : (axis == 1 ? centroid_bounds.min.y
+                                          : centroid_bounds.min.z);
+        float len = axis == 0 ? extent.x : (axis == 1 ? extent.y : extent.z);
+        if (len <= 0.0f) continue;
+
+        aabb bin_box[BVH_SAH_BINS];
+        Uint32 bin_count[BVH_SAH_BINS] = {0};
+        for (Uint32 b = 0; b < BVH_SAH_BINS; b++) {
+            bin_box[b] = aabb_empty ();
+        }
+        float scale = (float) BVH_SAH_BINS / len;
+        for (Uint32 i = start; i < end; i++) {
+            aabb box = boxes[order[i]];
+            Uint32 b = (Uint32) ((centroid_axis (box, axis) - lo) * scale);
+            if (b >= BVH_SAH_BINS) b = BVH_SAH_BINS - 1;
+            bin_box[b] = aabb_union (bin_box[b], box);
+            bin_count[b]++;
+        }
+
+        // sweep from the right, then evaluate each plane from the left
+        float right_area[BVH_SAH_BINS];
+        Uint32 right_count[BVH_SAH_BINS];
+        aabb acc = aabb_empty ();
+        Uint32 count = 0;
+        for (Uint32 b = BVH_SAH_BINS - 1; b > 0; b--) {
+            acc = aabb_union (acc, bin_box[b]);
+            count += bin_count[b];
+            right_area[b] = aabb_surface_area (acc);
+            right_count[b] = count;
+        }
+        acc = aabb_empty ();
+        count = 0;
+        for (Uint32 b = 1; b < BVH_SAH_BINS; b++) {
+            acc = aabb_union (acc, bin_box[b - 1]);
+            count += bin_count[b - 1];
+            if (count == 0 || right_count[b] == 0) continue;
+            float cost = aabb_surface_area (acc) * (float) count +
+                         right_area[b] * (float) right_count[b];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = b;
+            }
+        }
+    }
+
+    if (best_cost == INFINITY) return start;
+
+    float lo = best_axis == 0 ? centroid_bounds.min.x
+                              : (best_axis == 1 ? centroid_bounds.min.y
+                                                : centroid_bounds.min.z);
+    float len = best_axis == 0 ? extent.x
+                               : (best_axis == 1 ? extent.y : extent.z);
+    float scale = (float) BVH_SAH_BINS / len;
+    Uint32 mid = start;
+    for (Uint32 i = start; i < end; i++) {
+        Uint32 b =
+            (Uint32) ((centroid_axis (boxes[order[i]], best_axis) - lo) * scale);
+        if (b >= BVH_SAH_BINS) b = BVH_SAH_BINS - 1;
+        if (b < best_bin) {
+            Uint32 tmp = order[mid];
+            order[mid] = order[i];
+            order[i] = tmp;
+            mid++;
+        }
+    }
+    return mid;
+}
+
+// builds build->nodes from build->proxies/boxes; runs on the worker thread
+static bool sah_build (BVHBuild* build) {
+    build->nodes = NULL;
+    build->node_count = 0;
+    build->root = PAL_BVH_NULL;
+    if (build->count == 0) return true;
+
+    Uint32 max_nodes = build->count * 2 - 1;
+    build->nodes = (BVHNode*) malloc (max_nodes * sizeof (BVHNode));
+    Uint32* order = (Uint32*) malloc (build->count * sizeof (Uint32));
+    BuildTask* tasks = (BuildTask*) malloc (max_nodes * sizeof (BuildTask));
+    if (build->nodes == NULL || order == NULL || tasks == NULL) {
+        free (build->nodes);
+        free (order);
+        free (tasks);
+        build->nodes = NULL;
+        return false;
+    }
+    for (Uint32 i = 0; i < build->count; i++) {
+        order[i] = i;
+    }
+
+    BVHNode* nodes = build->nodes;
+    Uint32 node_count = 1;
+    nodes[0].parent = PAL_BVH_NULL;
+    Uint32 task_count = 0;
+    tasks[task_count++] = (BuildTask) {0, build->count, 0};
+
+    while (task_count > 0) {
+        BuildTask task = tasks[--task_count];
+        BVHNode* node = &nodes[task.node];
+
+        if (task.end - task.start == 1) {
+            Uint32 item = order[task.start];
+            node->box = build->boxes[item];
+            node->child1 = PAL_BVH_NULL;
+            node->child2 = PAL_BVH_NULL;
+            node->proxy = build->proxies[item];
+            node->height = 0;
+            continue;
+        }
+
+        Uint32 mid = sah_split (build->boxes, order, task.start, task.end);
+        if (mid == task.start || mid == task.end) {
+            mid = task.start + (task.end - task.start) / 2; // degenerate
+        }
+
+        Uint32 c1 = node_count++;
+        Uint32 c2 = node_count++;
+        node->child1 = c1;
+        node->child2 = c2;
+        node->proxy = PAL_BVH_NULL;
+        nodes[c1].parent = task.node;
+        nodes[c2].parent = task.node;
+        tasks[task_count++] = (BuildTask) {task.start, mid, c1};
+        tasks[task_count++] = (BuildTask) {mid, task.end, c2};
+    }
+
+    // children always come after their parent, so a reverse sweep sees
+    // both children before the parent
+    for (Uint32 i = node_count; i-- > 0;) {
+        BVHNode* node = &nodes[i];
+        if (node->child1 == PAL_BVH_NULL) continue;
+        node->box = aabb_union (nodes[node->child1].box, nodes[node->child2].box);
+        node->height =
+            1 + SDL_max (nodes[node->child1].height, nodes[node->child2].height);
+    }
+
+    free (order);
+    free (tasks);
+    build->node_count = node_count;
+    build->root = 0;
+    return true;
+}
+
+static int SDLCALL sah_build_thread (void* data) {
+    PAL_BVH* bvh = (PAL_BVH*) data;
+    sah_build (&bvh->build);
+    SDL_SetAtomicInt (&bvh->worker_done, 1);
+    return 0;
+}
+
+static bool snapshot_leaves (PAL_BVH* bvh) {
+    BVHBuild* build = &bvh->build;
+    free (build->proxies);
+    free (build->boxes);
+    build->proxies = (Uint32*) malloc (SDL_max (bvh->leaf_count, 1) * sizeof (Uint32));
+    build->boxes = (aabb*) malloc (SDL_max (bvh->leaf_count, 1) * sizeof (aabb));
+    build->count = 0;
+    if (build->proxies == NULL || build->boxes == NULL) {
+        SDL_Log ("Failed to allocate BVH rebuild snapshot");
+        return false;
+    }
+    for (Uint32 i = 0; i < bvh->proxy_count; i++) {
+        if (!bvh->proxies[i].alive) continue;
+        build->proxies[build->count] = i;
+        build->boxes[build->count] = bvh->proxies[i].box;
+        build->count++;
+    }
+    return true;
+}
+
+// replaces the live tree with the rebuilt one and replays every proxy that
+// changed since the snapshot was taken
+static void install_build (PAL_BVH* bvh) {
+    BVHBuild* build = &bvh->build;
+    if (build->nodes == NULL && build->count > 0) {
+        // build failed; the live tree is still valid
+        bvh->journal_count = 0;
+        return;
+    }
+
+    // each replayed proxy needs at most a leaf and a parent; with room for
+    // them up front the replay can't fail partway and drop a proxy its
+    // owner still holds. Without it the live tree, which is up to date, is
+    // kept instead.
+    Uint32 capacity = build->node_count + 2 * bvh->journal_count;
+    if (capacity > build->node_count) {
+        BVHNode* nodes =
+            (BVHNode*) realloc (build->nodes, capacity * sizeof (BVHNode));
+        if (nodes == NULL) {
+            SDL_Log ("Failed to grow rebuilt BVH; keeping the live tree");
+            free (build->nodes);
+            build->nodes = NULL;
+            bvh->journal_count = 0;
+            return;
+        }
+        build->nodes = nodes;
+    }
+
+    free (bvh->nodes);
+    bvh->nodes = build->nodes;
+    bvh->node_capacity = capacity;
+    bvh->free_node = PAL_BVH_NULL;
+    for (Uint32 i = capacity; i-- > build->node_count;) {
+        free_node (bvh, i);
+    }
+    bvh->root = build->root;
+    build->nodes = NULL;
+
+    for (Uint32 i = 0; i < bvh->proxy_count; i++) {
+        bvh->proxies[i].node = PAL_BVH_NULL;
+    }
+    for (Uint32 i = 0; i < build->node_count; i++) {
+        if (bvh->nodes[i].proxy != PAL_BVH_NULL) {
+            bvh->proxies[bvh->nodes[i].proxy].node = i;
+        }
+    }
+
+    Uint32 leaf_count = build->count;
+    for (Uint32 i = 0; i < bvh->journal_count; i++) {
+        Uint32 proxy = bvh->journal[i];
+        BVHProxy* p = &bvh->proxies[proxy];
+        if (p->node != PAL_BVH_NULL) {
+            remove_leaf (bvh, p->node);
+            free_node (bvh, p->node);
+            p->node = PAL_BVH_NULL;
+            leaf_count--;
+        }
+        if (!p->alive) continue;
+
+        // reserved above, so neither this nor insert_leaf can fail
+        Uint32 leaf = allocate_node (bvh);
+        bvh->nodes[leaf].box = p->box;
+        bvh->nodes[leaf].proxy = proxy;
+        p->node = leaf;
+        insert_leaf (bvh, leaf);
+        leaf_count++;
+    }
+    bvh->leaf_count = leaf_count;
+    bvh->journal_count = 0;
+    bvh->churn = 0;
+}
+
+void PAL_BVHMaintain (PAL_BVH* bvh) {
+    if (bvh->worker) {
+        if (!SDL_GetAtomicInt (&bvh->worker_done)) return;
+        SDL_WaitThread (bvh->worker, NULL);
+        bvh->worker = NULL;
+        install_build (bvh);
+        return;
+    }
+
+    if (bvh->leaf_count < BVH_MIN_REBUILD_LEAVES) return;
+    if (bvh->churn < bvh->leaf_count / 4) return;
+    if (!snapshot_leaves (bvh)) return;
+
+    bvh->epoch++;
+    bvh->journal_count = 0;
+    bvh->churn = 0;
+    SDL_SetAtomicInt (&bvh->worker_done, 0);
+    bvh->worker = SDL_CreateThread (sah_build_thread, "bvh rebuild", bvh);
+    if (bvh->worker == NULL) {
+        SDL_Log ("Failed to start BVH rebuild thread: %s", SDL_GetError ());
+    }
+}
+
+void PAL_BVHRebuild (PAL_BVH* bvh) {
+    if (bvh->worker) {
+        SDL_WaitThread (bvh->worker, NULL);
+        bvh->worker = NULL;
+        install_build (bvh);
+    }
+    if (!snapshot_leaves (bvh)) return;
+    bvh->journal_count = 0;
+    if (!sah_build (&bvh->build)) {
+        SDL_Log ("Failed to rebuild BVH");
+        return;
+    }
+    install_build (bvh);
+}
+
+// Queries
+static bool push (PAL_BVH* bvh, Uint32* sp, Uint32 value) {
+    if (*sp == bvh->stack_capacity) {
+        Uint32 new_cap = bvh->stack_capacity ? bvh->stack_capacity * 2 : 64;
+        Uint32* new_stack =
+            (Uint32*) realloc (bvh->stack, new_cap * sizeof (Uint32));
+        if (new_stack == NULL) return false;
+        bvh->stack = new_stack;
+        bvh->stack_capacity = new_cap;
+    }
+    bvh->stack[(*sp)++] = value;
+    return true;
+}
+
+Uint32 PAL_BVHQueryFrustum (PAL_BVH* bvh, const frustum* f, Entity* out) {
+    if (bvh->root == PAL_BVH_NULL) return 0;
+
+    Uint32 count = 0;
+    Uint32 sp = 0;
+    push (bvh, &sp, bvh->root);
+    while (sp > 0) {
+        Uint32 entry = bvh->stack[--sp];
+        Uint32 index = entry & ~BVH_INSIDE_FLAG;
+        const BVHNode* node = &bvh->nodes[index];
+
+        bool inside = (entry & BVH_INSIDE_FLAG) != 0;
+        if (!inside) {
+            FrustumResult result = frustum_classify_aabb (f, node->box);
+            if (result == FRUSTUM_OUTSIDE) continue;
+            inside = result == FRUSTUM_INSIDE;
+        }
+
+        if (is_leaf (node)) {
+            out[count++] = bvh->proxies[node->proxy].entity;
+            continue;
+        }
+
+        Uint32 flag = inside ? BVH_INSIDE_FLAG : 0;
+        Uint32 child1 = node->child1;
+        Uint32 child2 = node->child2;
+        if (!push (bvh, &sp, child1 | flag) || !push (bvh, &sp, child2 | flag)) {
+            SDL_Log ("Failed to grow BVH traversal stack");
+            break;
+        }
+    }
+    return count;
+}
\ No newline at end of file
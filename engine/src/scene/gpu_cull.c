@@ -0,0 +1,674 @@
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include <scene/gpu_cull.h>
+
+#define CULL_GROUP_SIZE 64 // local_size_x in cull.comp
+#define CULL_BILLBOARD 1u
+#define MIN_CULL_CAPACITY 256
+#define NO_SLOT (~0u)
+
+// std430 layouts shared with cull.comp
+typedef struct {
+    vec4 bounds_min; // w unused
+    vec4 bounds_max;
+    Uint32 batch;
+    Uint32 flags;
+    Uint32 pad[2];
+} CullRecord;
+
+typedef struct {
+    Uint32 num_lods; // 0 for a free batch
+    Uint32 pad[3];
+    Uint32 commands[PAL_CULL_MAX_LODS];
+    float errors[PAL_CULL_MAX_LODS];
+} GPUCullBatch;
+
+// std140
+typedef struct {
+    vec4 planes[6];
+    vec4 cam_pos;
+    vec4 cam_rot;
+    float pixels_per_radian;
+    Uint32 count;
+    Uint32 pad[2];
+} CullUBO;
+
+typedef struct {
+    PAL_CullBatchInfo info;
+    Uint32 instances; // 0 marks a free batch
+    Uint32 commands[PAL_CULL_MAX_LODS];
+} CullBatch;
+
+typedef struct {
+    PAL_DrawState state;
+    Uint32 batch;
+    Uint32 lod;
+} CommandKey;
+
+struct PAL_GPUCuller {
+    SDL_GPUDevice* device;
+    SDL_GPUComputePipeline* pipeline;
+
+    // instances are packed into slots; CPU copies of their data are kept so
+    // moved slots and grown buffers can be re-uploaded
+    Uint32* id_to_slot;
+    Uint32 id_capacity;
+    Uint32* slot_to_id;
+    PAL_GPUObject* objects;
+    CullRecord* records;
+    bool* dirty;
+    Uint32* dirty_slots;
+    Uint32 dirty_count;
+    Uint32 count;
+    Uint32 capacity;
+    bool resync; // upload every slot on the next prepare
+
+    CullBatch* batches;
+    Uint32 batch_count; // including free ones
+    Uint32 batch_capacity;
+    bool layout_dirty; // batches or their instance counts changed
+    bool batches_dirty;
+
+    // indirect command templates (num_instances 0), sorted by state
+    SDL_GPUIndexedIndirectDrawCommand* commands;
+    CommandKey* keys;
+    Uint32 command_count;
+    Uint32 command_capacity;
+    PAL_CullRun* runs;
+    Uint32 run_count;
+    Uint32 stream_size; // instance stream entries the layout needs
+
+    // GPU buffers; capacities are in elements
+    SDL_GPUBuffer* object_buffer;
+    SDL_GPUBuffer* record_buffer;
+    SDL_GPUBuffer* lod_buffer; // last selected level, for hysteresis
+    Uint32 gpu_capacity;
+    SDL_GPUBuffer* batch_buffer;
+    Uint32 gpu_batch_capacity;
+    SDL_GPUBuffer* command_buffer;
+    Uint32 gpu_command_capacity;
+    SDL_GPUBuffer* instance_buffer;
+    Uint32 gpu_stream_capacity;
+};
+
+static int compare_pointers (const void* a, const void* b) {
+    return (uintptr_t) a < (uintptr_t) b ? -1 : (uintptr_t) a > (uintptr_t) b;
+}
+
+int PAL_CompareDrawState (const PAL_DrawState* a, const PAL_DrawState* b) {
+    int order = compare_pointers (a->pipeline, b->pipeline);
+    if (order == 0) {
+        order = compare_pointers (a->depth_pipeline, b->depth_pipeline);
+    }
+    if (order == 0) {
+        order = compare_pointers (a->ambient_pipeline, b->ambient_pipeline);
+    }
+    if (order == 0) order = compare_pointers (a->texture, b->texture);
+    if (order == 0) order = compare_pointers (a->sampler, b->sampler);
+    if (order == 0) {
+        order = compare_pointers (a->vertex_buffer, b->vertex_buffer);
+    }
+    if (order == 0) {
+        order = compare_pointers (a->index_buffer, b->index_buffer);
+    }
+    if (order == 0) order = (int) a->index_size - (int) b->index_size;
+    return order;
+}
+
+static int compare_keys (const void* a, const void* b) {
+    return PAL_CompareDrawState (
+        &((const CommandKey*) a)->state, &((const CommandKey*) b)->state
+    );
+}
+
+static int compare_slots (const void* a, const void* b) {
+    Uint32 x = *(const Uint32*) a;
+    Uint32 y = *(const Uint32*) b;
+    return x < y ? -1 : x > y;
+}
+
+PAL_GPUCuller*
+PAL_CreateGPUCuller (SDL_GPUDevice* device, SDL_GPUComputePipeline* pipeline) {
+    PAL_GPUCuller* culler = calloc (1, sizeof (PAL_GPUCuller));
+    if (culler == NULL) {
+        SDL_Log ("Failed to allocate GPU culler");
+        return NULL;
+    }
+    culler->device = device;
+    culler->pipeline = pipeline;
+    return culler;
+}
+
+void PAL_DestroyGPUCuller (PAL_GPUCuller* culler) {
+    if (culler == NULL) return;
+    SDL_ReleaseGPUBuffer (culler->device, culler->object_buffer);
+    SDL_ReleaseGPUBuffer (culler->device, culler->record_buffer);
+    SDL_ReleaseGPUBuffer (culler->device, culler->lod_buffer);
+    SDL_ReleaseGPUBuffer (culler->device, culler->batch_buffer);
+    SDL_ReleaseGPUBuffer (culler->device, culler->command_buffer);
+    SDL_ReleaseGPUBuffer (culler->device, culler->instance_buffer);
+    SDL_ReleaseGPUComputePipeline (culler->device, culler->pipeline);
+    free (culler->id_to_slot);
+    free (culler->slot_to_id);
+    free (culler->objects);
+    free (culler->records);
+    free (culler->dirty);
+    free (culler->dirty_slots);
+    free (culler->batches);
+    free (culler->commands);
+    free (culler->keys);
+    free (culler->runs);
+    free (culler);
+}
+
+static bool reserve_ids (PAL_GPUCuller* culler, Uint32 id) {
+    if (id < culler->id_capacity) return true;
+    Uint32 capacity = culler->id_capacity ? culler->id_capacity * 2 : 1024;
+    if (capacity <= id) capacity = id + 1;
+    Uint32* map = realloc (culler->id_to_slot, capacity * sizeof (Uint32));
+    if (map == NULL) return false;
+    for (Uint32 i = culler->id_capacity; i < capacity; i++) map[i] = NO_SLOT;
+    culler->id_to_slot = map;
+    culler->id_capacity = capacity;
+    return true;
+}
+
+static bool reserve_slots (PAL_GPUCuller* culler, Uint32 count) {
+    if (count <= culler->capacity) return true;
+    Uint32 capacity = culler->capacity ? culler->capacity * 2 : 64;
+    while (capacity < count) capacity *= 2;
+
+    Uint32* ids = realloc (culler->slot_to_id, capacity * sizeof (Uint32));
+    if (ids) culler->slot_to_id = ids;
+    PAL_GPUObject* objects =
+        realloc (culler->objects, capacity * sizeof (PAL_GPUObject));
+    if (objects) culler->objects = objects;
+    CullRecord* records =
+        realloc (culler->records, capacity * sizeof (CullRecord));
+    if (records) culler->records = records;
+    bool* dirty = realloc (culler->dirty, capacity * sizeof (bool));
+    if (dirty) {
+        for (Uint32 i = culler->capacity; i < capacity; i++) dirty[i] = false;
+        culler->dirty = dirty;
+    }
+    Uint32* dirty_slots =
+        realloc (culler->dirty_slots, capacity * sizeof (Uint32));
+    if (dirty_slots) culler->dirty_slots = dirty_slots;
+    if (!ids || !objects || !records || !dirty || !dirty_slots) return false;
+    culler->capacity = capacity;
+    return true;
+}
+
+// every slot is listed at most once, so the list never outgrows capacity
+static void mark_dirty (PAL_GPUCuller* culler, Uint32 slot) {
+    if (culler->dirty[slot]) return;
+    culler->dirty[slot] = true;
+    culler->dirty_slots[culler->dirty_count++] = slot;
+}
+
+static bool
+batch_equal (const PAL_CullBatchInfo* a, const PAL_CullBatchInfo* b) {
+    if (a->pipeline != b->pipeline ||
+        a->depth_pipeline != b->depth_pipeline ||
+        a->ambient_pipeline != b->ambient_pipeline ||
+        a->texture != b->texture || a->sampler != b->sampler ||
+        a->index_size != b->index_size || a->num_lods != b->num_lods) {
+        return false;
+    }
+    for (Uint32 i = 0; i < a->num_lods; i++) {
+        const PAL_CullLOD* x = &a->lods[i];
+        const PAL_CullLOD* y = &b->lods[i];
+        if (x->vertex_buffer != y->vertex_buffer ||
+            x->index_buffer != y->index_buffer ||
+            x->num_indices != y->num_indices ||
+            x->first_index != y->first_index ||
+            x->vertex_offset != y->vertex_offset || x->error != y->error) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// returns the index of a batch equal to info, creating it if needed
+static Uint32
+find_batch (PAL_GPUCuller* culler, const PAL_CullBatchInfo* info) {
+    Uint32 free_batch = NO_SLOT;
+    for (Uint32 i = 0; i < culler->batch_count; i++) {
+        CullBatch* batch = &culler->batches[i];
+        if (batch->instances == 0) {
+            if (free_batch == NO_SLOT) free_batch = i;
+        } else if (batch_equal (&batch->info, info)) {
+            return i;
+        }
+    }
+
+    if (free_batch == NO_SLOT) {
+        if (culler->batch_count == culler->batch_capacity) {
+            Uint32 capacity =
+                culler->batch_capacity ? culler->batch_capacity * 2 : 16;
+            CullBatch* batches =
+                realloc (culler->batches, capacity * sizeof (CullBatch));
+            if (batches == NULL) return NO_SLOT;
+            culler->batches = batches;
+            culler->batch_capacity = capacity;
+        }
+        free_batch = culler->batch_count++;
+    }
+    culler->batches[free_batch] = (CullBatch) {.info = *info};
+    return free_batch;
+}
+
+// drops trailing free batches
+static void trim_batches (PAL_GPUCuller* culler) {
+    while (culler->batch_count > 0 &&
+           culler->batches[culler->batch_count - 1].instances == 0) {
+        culler->batch_count--;
+    }
+}
+
+static void release_batch (PAL_GPUCuller* culler, Uint32 batch) {
+    culler->batches[batch].instances--;
+    trim_batches (culler);
+}
+
+bool PAL_GPUCullerSet (
+    PAL_GPUCuller* culler,
+    Uint32 id,
+    const PAL_CullBatchInfo* batch,
+    const PAL_CullInstance* instance
+) {
+    bool drawable = batch->num_lods > 0 && batch->num_lods <= PAL_CULL_MAX_LODS;
+    for (Uint32 i = 0; drawable && i < batch->num_lods; i++) {
+        drawable = batch->lods[i].index_buffer && batch->lods[i].num_indices;
+    }
+    if (!drawable || !reserve_ids (culler, id)) {
+        PAL_GPUCullerRemove (culler, id);
+        return false;
+    }
+
+    Uint32 slot = culler->id_to_slot[id];
+    Uint32 old = slot != NO_SLOT ? culler->records[slot].batch : NO_SLOT;
+    Uint32 b = old;
+    if (old == NO_SLOT || !batch_equal (&culler->batches[old].info, batch)) {
+        b = find_batch (culler, batch);
+        if (b == NO_SLOT) {
+            SDL_Log ("Failed to grow GPU culling batches");
+            PAL_GPUCullerRemove (culler, id);
+            return false;
+        }
+        if (slot == NO_SLOT) {
+            if (!reserve_slots (culler, culler->count + 1)) {
+                SDL_Log ("Failed to grow GPU culling instances");
+                trim_batches (culler);
+                return false;
+            }
+            slot = culler->count++;
+            culler->id_to_slot[id] = slot;
+            culler->slot_to_id[slot] = id;
+        }
+        // claim the new batch first so releasing the old one can't trim it
+        culler->batches[b].instances++;
+        if (old != NO_SLOT) release_batch (culler, old);
+        culler->layout_dirty = true;
+    }
+
+    vec3 lo = instance->bounds.min;
+    vec3 hi = instance->bounds.max;
+    culler->objects[slot] = instance->object;
+    culler->records[slot] = (CullRecord) {
+        .bounds_min = {lo.x, lo.y, lo.z, 0.0f},
+        .bounds_max = {hi.x, hi.y, hi.z, 0.0f},
+        .batch = b,
+        .flags = instance->billboard ? CULL_BILLBOARD : 0,
+    };
+    mark_dirty (culler, slot);
+    return true;
+}
+
+void PAL_GPUCullerRemove (PAL_GPUCuller* culler, Uint32 id) {
+    if (id >= culler->id_capacity || culler->id_to_slot[id] == NO_SLOT) return;
+    Uint32 slot = culler->id_to_slot[id];
+    release_batch (culler, culler->records[slot].batch);
+    culler->layout_dirty = true;
+
+    // move the last instance into the hole
+    Uint32 last = --culler->count;
+    if (slot != last) {
+        Uint32 moved = culler->slot_to_id[last];
+        culler->objects[slot] = culler->objects[last];
+        culler->records[slot] = culler->records[last];
+        culler->slot_to_id[slot] = moved;
+        culler->id_to_slot[moved] = slot;
+        mark_dirty (culler, slot);
+    }
+    culler->id_to_slot[id] = NO_SLOT;
+}
+
+Uint32 PAL_GPUCullerCount (const PAL_GPUCuller* culler) {
+    return culler ? culler->count : 0;
+}
+
+// assigns every (batch, level) an indirect command and a region of the
+// instance stream, then groups the commands into runs by state
+static bool build_layout (PAL_GPUCuller* culler) {
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < culler->batch_count; i++) {
+        if (culler->batches[i].instances) {
+            count += culler->batches[i].info.num_lods;
+        }
+    }
+    if (count > culler->command_capacity) {
+        Uint32 capacity = culler->command_capacity ? culler->command_capacity
+                                                   : MIN_CULL_CAPACITY;
+        while (capacity < count) capacity *= 2;
+        SDL_GPUIndexedIndirectDrawCommand* commands = realloc (
+            culler->commands,
+            capacity * sizeof (SDL_GPUIndexedIndirectDrawCommand)
+        );
+        if (commands) culler->commands = commands;
+        CommandKey* keys =
+            realloc (culler->keys, capacity * sizeof (CommandKey));
+        if (keys) culler->keys = keys;
+        PAL_CullRun* runs =
+            realloc (culler->runs, capacity * sizeof (PAL_CullRun));
+        if (runs) culler->runs = runs;
+        if (!commands || !keys || !runs) {
+            SDL_Log ("Failed to grow GPU culling commands");
+            return false;
+        }
+        culler->command_capacity = capacity;
+    }
+
+    Uint32 k = 0;
+    for (Uint32 i = 0; i < culler->batch_count; i++) {
+        const CullBatch* batch = &culler->batches[i];
+        if (batch->instances == 0) continue;
+        for (Uint32 l = 0; l < batch->info.num_lods; l++) {
+            culler->keys[k++] = (CommandKey) {
+                .state = {
+                    .pipeline = batch->info.pipeline,
+                    .depth_pipeline = batch->info.depth_pipeline,
+                    .ambient_pipeline = batch->info.ambient_pipeline,
+                    .texture = batch->info.texture,
+                    .sampler = batch->info.sampler,
+                    .vertex_buffer = batch->info.lods[l].vertex_buffer,
+                    .index_buffer = batch->info.lods[l].index_buffer,
+                    .index_size = batch->info.index_size,
+                },
+                .batch = i,
+                .lod = l,
+            };
+        }
+    }
+    qsort (culler->keys, count, sizeof (CommandKey), compare_keys);
+
+    // every level of a batch gets room for all of its instances
+    Uint32 base = 0;
+    culler->run_count = 0;
+    for (Uint32 i = 0; i < count; i++) {
+        const CommandKey* key = &culler->keys[i];
+        CullBatch* batch = &culler->batches[key->batch];
+        const PAL_CullLOD* lod = &batch->info.lods[key->lod];
+        culler->commands[i] = (SDL_GPUIndexedIndirectDrawCommand) {
+            .num_indices = lod->num_indices,
+            .num_instances = 0,
+            .first_index = lod->first_index,
+            .vertex_offset = lod->vertex_offset,
+            .first_instance = base,
+        };
+        base += batch->instances;
+        batch->commands[key->lod] = i;
+
+        if (i == 0 ||
+            PAL_CompareDrawState (&key->state, &culler->keys[i - 1].state)) {
+            culler->runs[culler->run_count++] = (PAL_CullRun) {
+                .state = key->state,
+                .first_command = i,
+            };
+        }
+        culler->runs[culler->run_count - 1].num_commands++;
+    }
+    culler->command_count = count;
+    culler->stream_size = base;
+    culler->layout_dirty = false;
+    culler->batches_dirty = true;
+    return true;
+}
+
+// replaces *buffer with one holding at least count elements; returns the new
+// capacity, or 0 on failure
+static Uint32 grow_buffer (
+    PAL_GPUCuller* culler,
+    SDL_GPUBuffer** buffer,
+    SDL_GPUBufferUsageFlags usage,
+    Uint32 element_size,
+    Uint32 count
+) {
+    Uint32 capacity = MIN_CULL_CAPACITY;
+    while (capacity < count) capacity *= 2;
+    // in-flight frames keep the old buffer until they retire
+    SDL_ReleaseGPUBuffer (culler->device, *buffer);
+    SDL_GPUBufferCreateInfo info = {
+        .usage = usage,
+        .size = capacity * element_size
+    };
+    *buffer = SDL_CreateGPUBuffer (culler->device, &info);
+    if (*buffer == NULL) {
+        SDL_Log ("Failed to create GPU culling buffer: %s", SDL_GetError ());
+        return 0;
+    }
+    return capacity;
+}
+
+static bool reserve_gpu_buffers (PAL_GPUCuller* culler) {
+    const SDL_GPUBufferUsageFlags compute_rw =
+        SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ |
+        SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+
+    if (culler->count > culler->gpu_capacity) {
+        Uint32 capacity = grow_buffer (
+            culler, &culler->object_buffer,
+            SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ | compute_rw,
+            sizeof (PAL_GPUObject), culler->count
+        );
+        if (capacity) {
+            capacity = grow_buffer (
+                culler, &culler->record_buffer,
+                SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ, sizeof (CullRecord),
+                culler->count
+            );
+        }
+        if (capacity) {
+            capacity = grow_buffer (
+                culler, &culler->lod_buffer, compute_rw, sizeof (Uint32),
+                culler->count
+            );
+        }
+        culler->gpu_capacity = capacity;
+        culler->resync = true;
+        if (capacity == 0) return false;
+    }
+    if (culler->batch_count > culler->gpu_batch_capacity) {
+        culler->gpu_batch_capacity = grow_buffer (
+            culler, &culler->batch_buffer,
+            SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ, sizeof (GPUCullBatch),
+            culler->batch_count
+        );
+        culler->batches_dirty = true;
+        if (culler->gpu_batch_capacity == 0) return false;
+    }
+    if (culler->command_count > culler->gpu_command_capacity) {
+        culler->gpu_command_capacity = grow_buffer (
+            culler, &culler->command_buffer,
+            SDL_GPU_BUFFERUSAGE_INDIRECT | compute_rw,
+            sizeof (SDL_GPUIndexedIndirectDrawCommand), culler->command_count
+        );
+        if (culler->gpu_command_capacity == 0) return false;
+    }
+    if (culler->stream_size > culler->gpu_stream_capacity) {
+        culler->gpu_stream_capacity = grow_buffer (
+            culler, &culler->instance_buffer,
+            SDL_GPU_BUFFERUSAGE_VERTEX | compute_rw, sizeof (Uint32),
+            culler->stream_size
+        );
+        if (culler->gpu_stream_capacity == 0) return false;
+    }
+    return true;
+}
+
+// stages slots [first, first + count) of the object and record copies
+static bool stage_slots (
+    PAL_GPUCuller* culler,
+    PAL_UploadRing* ring,
+    Uint32 first,
+    Uint32 count
+) {
+    void* objects = PAL_UploadRingBuffer (
+        ring, culler->object_buffer, first * sizeof (PAL_GPUObject),
+        count * sizeof (PAL_GPUObject)
+    );
+    if (objects == NULL) return false;
+    SDL_memcpy (
+        objects, &culler->objects[first], count * sizeof (PAL_GPUObject)
+    );
+    void* records = PAL_UploadRingBuffer (
+        ring, culler->record_buffer, first * sizeof (CullRecord),
+        count * sizeof (CullRecord)
+    );
+    if (records == NULL) return false;
+    SDL_memcpy (records, &culler->records[first], count * sizeof (CullRecord));
+    return true;
+}
+
+static bool stage_batches (PAL_GPUCuller* culler, PAL_UploadRing* ring) {
+    GPUCullBatch* table = (GPUCullBatch*) PAL_UploadRingBuffer (
+        ring, culler->batch_buffer, 0,
+        culler->batch_count * sizeof (GPUCullBatch)
+    );
+    if (table == NULL) return false;
+    for (Uint32 i = 0; i < culler->batch_count; i++) {
+        const CullBatch* batch = &culler->batches[i];
+        table[i] = (GPUCullBatch) {0};
+        if (batch->instances == 0) continue;
+        table[i].num_lods = batch->info.num_lods;
+        for (Uint32 l = 0; l < batch->info.num_lods; l++) {
+            table[i].commands[l] = batch->commands[l];
+            table[i].errors[l] = batch->info.lods[l].error;
+        }
+    }
+    return true;
+}
+
+static bool stage_changes (PAL_GPUCuller* culler, PAL_UploadRing* ring) {
+    if (culler->batches_dirty) {
+        if (!stage_batches (culler, ring)) return false;
+        culler->batches_dirty = false;
+    }
+
+    if (culler->resync) {
+        for (Uint32 i = 0; i < culler->dirty_count; i++) {
+            culler->dirty[culler->dirty_slots[i]] = false;
+        }
+        culler->dirty_count = 0;
+        if (!stage_slots (culler, ring, 0, culler->count)) return false;
+        culler->resync = false;
+        return true;
+    }
+
+    // removals can leave dirty slots past the end
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < culler->dirty_count; i++) {
+        Uint32 slot = culler->dirty_slots[i];
+        culler->dirty[slot] = false;
+        if (slot < culler->count) culler->dirty_slots[count++] = slot;
+    }
+    culler->dirty_count = 0;
+    qsort (culler->dirty_slots, count, sizeof (Uint32), compare_slots);
+    for (Uint32 i = 0; i < count;) {
+        Uint32 end = i + 1;
+        while (end < count &&
+               culler->dirty_slots[end] == culler->dirty_slots[end - 1] + 1) {
+            end++;
+        }
+        if (!stage_slots (culler, ring, culler->dirty_slots[i], end - i)) {
+            return false;
+        }
+        i = end;
+    }
+    return true;
+}
+
+bool PAL_GPUCullerPrepare (PAL_GPUCuller* culler, PAL_UploadRing* ring) {
+    if (culler->layout_dirty && !build_layout (culler)) return false;
+    if (culler->count == 0) return true;
+    if (!reserve_gpu_buffers (culler)) return false;
+
+    bool staged = stage_changes (culler, ring);
+    SDL_GPUIndexedIndirectDrawCommand* commands = NULL;
+    if (staged) {
+        commands = (SDL_GPUIndexedIndirectDrawCommand*) PAL_UploadRingBuffer (
+            ring, culler->command_buffer, 0,
+            culler->command_count * sizeof (SDL_GPUIndexedIndirectDrawCommand)
+        );
+    }
+    if (commands == NULL) {
+        // start over from the CPU copies next frame
+        SDL_Log ("Failed to stage GPU culling data");
+        culler->resync = true;
+        culler->batches_dirty = true;
+        return false;
+    }
+    // the templates reset every instance count before the dispatch
+    SDL_memcpy (
+        commands, culler->commands,
+        culler->command_count * sizeof (SDL_GPUIndexedIndirectDrawCommand)
+    );
+    return true;
+}
+
+void PAL_GPUCullerDispatch (
+    PAL_GPUCuller* culler,
+    SDL_GPUCommandBuffer* cmd,
+    const PAL_CullView* view
+) {
+    if (culler->count == 0) return;
+
+    CullUBO ubo = {
+        .cam_pos = {view->cam_pos.x, view->cam_pos.y, view->cam_pos.z, 0.0f},
+        .cam_rot = view->cam_rot,
+        .pixels_per_radian = view->pixels_per_radian,
+        .count = culler->count,
+    };
+    for (int i = 0; i < 6; i++) ubo.planes[i] = view->frustum.planes[i];
+
+    // the instance stream is rewritten from scratch, so it may be cycled
+    SDL_GPUStorageBufferReadWriteBinding outputs[] = {
+        {.buffer = culler->object_buffer, .cycle = false},
+        {.buffer = culler->lod_buffer, .cycle = false},
+        {.buffer = culler->command_buffer, .cycle = false},
+        {.buffer = culler->instance_buffer, .cycle = true},
+    };
+    SDL_GPUComputePass* pass =
+        SDL_BeginGPUComputePass (cmd, NULL, 0, outputs, 4);
+    SDL_BindGPUComputePipeline (pass, culler->pipeline);
+    SDL_GPUBuffer* inputs[] = {culler->record_buffer, culler->batch_buffer};
+    SDL_BindGPUComputeStorageBuffers (pass, 0, inputs, 2);
+    SDL_PushGPUComputeUniformData (cmd, 0, &ubo, sizeof (ubo));
+    SDL_DispatchGPUCompute (
+        pass, (culler->count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1
+    );
+    SDL_EndGPUComputePass (pass);
+}
+
+PAL_CullOutput PAL_GPUCullerOutput (const PAL_GPUCuller* culler) {
+    if (culler->count == 0) return (PAL_CullOutput) {0};
+    return (PAL_CullOutput) {
+        .objects = culler->object_buffer,
+        .commands = culler->command_buffer,
+        .instances = culler->instance_buffer,
+        .runs = culler->runs,
+        .num_runs = culler->run_count,
+    };
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+#include <scene/light_grid.h>
+
+#define GRID_X PAL_LIGHT_GRID_X
+#define GRID_Y PAL_LIGHT_GRID_Y
+#define GRID_Z PAL_LIGHT_GRID_Z
+
+struct PAL_LightGrid {
+    PAL_LightCluster clusters[PAL_LIGHT_GRID_CLUSTERS];
+    float slice_depth[GRID_Z + 1]; // near edge of each slice, then far
+    float slice_scale;
+    float slice_bias;
+    Uint32* indices;
+    Uint32 num_indices;
+    Uint32 index_capacity;
+    vec4* spheres; // view-space lights of the current build
+    Uint32 sphere_capacity;
+};
+
+PAL_LightGrid* PAL_CreateLightGrid (void) {
+    PAL_LightGrid* grid = calloc (1, sizeof (PAL_LightGrid));
+    if (grid == NULL) {
+        SDL_Log ("Failed to allocate light grid");
+        return NULL;
+    }
+    return grid;
+}
+
+void PAL_DestroyLightGrid (PAL_LightGrid* grid) {
+    if (grid == NULL) return;
+    free (grid->indices);
+    free (grid->spheres);
+    free (grid);
+}
+
+static Uint32 slice_of (const PAL_LightGrid* grid, float depth) {
+    float slice = logf (depth) * grid->slice_scale + grid->slice_bias;
+    if (slice < 0.0f) return 0;
+    if (slice >= (float) (GRID_Z - 1)) return GRID_Z - 1;
+    return (Uint32) slice;
+}
+
+// maps an NDC interval to a clamped tile range; false if it misses the screen
+static bool tile_range (
+    float lo,
+    float hi,
+    Uint32 tiles,
+    bool flip,
+    Uint32* first,
+    Uint32* last
+) {
+    if (hi < -1.0f || lo > 1.0f) return false;
+    if (flip) {
+        float t = -lo;
+        lo = -hi;
+        hi = t;
+    }
+    float top = (float) (tiles - 1);
+    float a = SDL_clamp ((lo + 1.0f) * 0.5f * (float) tiles, 0.0f, top);
+    float b = SDL_clamp ((hi + 1.0f) * 0.5f * (float) tiles, 0.0f, top);
+    *first = (Uint32) a;
+    *last = (Uint32) b;
+    return true;
+}
+
+// visits the clusters overlapped by a view-space sphere. Within each slice
+// the sphere is bounded by the box of its widest cross-section between the
+// slice's depths, and the box is projected conservatively: the extreme x/z
+// of a box in front of the camera lies on its near or far face. With fill
+// false only the cluster counts are bumped; otherwise the light is written
+// at each cluster's cursor.
+static void assign_light (
+    PAL_LightGrid* grid,
+    const PAL_LightGridView* view,
+    vec4 s,
+    Uint32 light,
+    bool fill
+) {
+    float r = s.w;
+    float near_clip = grid->slice_depth[0];
+    float far_clip = grid->slice_depth[GRID_Z];
+    Uint32 first_slice = slice_of (grid, SDL_max (s.z - r, near_clip));
+    Uint32 last_slice = slice_of (grid, SDL_min (s.z + r, far_clip));
+    for (Uint32 z = first_slice; z <= last_slice; z++) {
+        float d0 = SDL_max (grid->slice_depth[z], s.z - r);
+        float d1 = SDL_min (grid->slice_depth[z + 1], s.z + r);
+        if (d0 > d1) continue;
+        float dz = s.z < d0 ? d0 - s.z : (s.z > d1 ? s.z - d1 : 0.0f);
+        float h = sqrtf (SDL_max (r * r - dz * dz, 0.0f));
+
+        float x0 = s.x - h, x1 = s.x + h;
+        float y0 = s.y - h, y1 = s.y + h;
+        float nx0 = view->proj_x * (x0 < 0.0f ? x0 / d0 : x0 / d1);
+        float nx1 = view->proj_x * (x1 > 0.0f ? x1 / d0 : x1 / d1);
+        float ny0 = view->proj_y * (y0 < 0.0f ? y0 / d0 : y0 / d1);
+        float ny1 = view->proj_y * (y1 > 0.0f ? y1 / d0 : y1 / d1);
+        Uint32 tx0, tx1, ty0, ty1;
+        // NDC y points up, tile rows go down the screen
+        if (!tile_range (nx0, nx1, GRID_X, false, &tx0, &tx1) ||
+            !tile_range (ny0, ny1, GRID_Y, true, &ty0, &ty1)) {
+            continue;
+        }
+
+        for (Uint32 y = ty0; y <= ty1; y++) {
+            PAL_LightCluster* row = &grid->clusters[(z * GRID_Y + y) * GRID_X];
+            for (Uint32 x = tx0; x <= tx1; x++) {
+                if (fill) {
+                    grid->indices[row[x].offset + row[x].count] = light;
+                }
+                row[x].count++;
+            }
+        }
+    }
+}
+
+bool PAL_LightGridBuild (
+    PAL_LightGrid* grid,
+    const PAL_LightGridView* view,
+    const vec4* lights,
+    Uint32 count
+) {
+    memset (grid->clusters, 0, sizeof (grid->clusters));
+    grid->num_indices = 0;
+
+    float near_clip = SDL_max (view->near_clip, 1e-4f);
+    float far_clip = SDL_max (view->far_clip, near_clip * 1.001f);
+    float log_ratio = logf (far_clip / near_clip);
+    grid->slice_scale = (float) GRID_Z / log_ratio;
+    grid->slice_bias = -(float) GRID_Z * logf (near_clip) / log_ratio;
+    for (Uint32 z = 0; z <= GRID_Z; z++) {
+        grid->slice_depth[z] =
+            near_clip * expf (log_ratio * (float) z / (float) GRID_Z);
+    }
+
+    if (count > grid->sphere_capacity) {
+        vec4* spheres = realloc (grid->spheres, count * sizeof (vec4));
+        if (spheres == NULL) {
+            SDL_Log ("Failed to grow light grid");
+            return false;
+        }
+        grid->spheres = spheres;
+        grid->sphere_capacity = count;
+    }
+
+    // to view space; lights outside the depth range get a zero radius
+    const float* m = view->view;
+    for (Uint32 i = 0; i < count; i++) {
+        vec4 l = lights[i];
+        vec4 s = {
+            m[0] * l.x + m[4] * l.y + m[8] * l.z + m[12],
+            m[1] * l.x + m[5] * l.y + m[9] * l.z + m[13],
+            m[2] * l.x + m[6] * l.y + m[10] * l.z + m[14],
+            l.w > 0.0f ? l.w : 0.0f,
+        };
+        if (s.z + s.w < near_clip || s.z - s.w > far_clip) s.w = 0.0f;
+        grid->spheres[i] = s;
+    }
+
+    // count, turn the counts into offsets, then fill
+    for (Uint32 i = 0; i < count; i++) {
+        if (grid->spheres[i].w > 0.0f) {
+            assign_light (grid, view, grid->spheres[i], i, false);
+        }
+    }
+    Uint64 total = 0;
+    for (Uint32 c = 0; c < PAL_LIGHT_GRID_CLUSTERS; c++) {
+        grid->clusters[c].offset = (Uint32) total;
+        total += grid->clusters[c].count;
+        grid->clusters[c].count = 0;
+    }
+    if (total > SDL_MAX_UINT32) {
+        SDL_Log ("Too many light cluster entries");
+        memset (grid->clusters, 0, sizeof (grid->clusters));
+        return false;
+    }
+    if (total > grid->index_capacity) {
+        Uint32 capacity = SDL_max ((Uint32) total, grid->index_capacity * 2);
+        Uint32* indices = realloc (grid->indices, capacity * sizeof (Uint32));
+        if (indices == NULL) {
+            SDL_Log ("Failed to grow light grid");
+            memset (grid->clusters, 0, sizeof (grid->clusters));
+            return false;
+        }
+        grid->indices = indices;
+        grid->index_capacity = capacity;
+    }
+    for (Uint32 i = 0; i < count; i++) {
+        if (grid->spheres[i].w > 0.0f) {
+            assign_light (grid, view, grid->spheres[i], i, true);
+        }
+    }
+    grid->num_indices = (Uint32) total;
+    return true;
+}
+
+PAL_LightGridOutput PAL_LightGridGetOutput (const PAL_LightGrid* grid) {
+    return (PAL_LightGridOutput) {
+        .clusters = grid->clusters,
+        .indices = grid->indices,
+        .num_indices = grid->num_indices,
+        .slice_scale = grid->slice_scale,
+        .slice_bias = grid->slice_bias,
+    };
+}
\ No newline at end of file
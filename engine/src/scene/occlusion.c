@@ -0,0 +1,379 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+#include <scene/occlusion.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#endif
+
+#define TILE_W 8
+#define TILE_H 4
+#define FULL_MASK 0xFFFFFFFFu
+
+typedef struct {
+    float zmax0; // every pixel in the tile is at least this close
+    float zmax1; // furthest depth of the working layer
+    Uint32 mask; // coverage of the working layer, bit = row * 8 + column
+} OcclusionTile;
+
+struct PAL_OcclusionBuffer {
+    Uint32 width;
+    Uint32 height;
+    Uint32 tiles_x;
+    Uint32 tiles_y;
+    OcclusionTile* tiles;
+    mat4 view_proj;
+};
+
+typedef struct {
+    float x;
+    float y;
+    float z;
+    float w;
+} ClipVertex;
+
+typedef struct {
+    float x;
+    float y;
+    float z;
+} ScreenVertex;
+
+PAL_OcclusionBuffer* PAL_CreateOcclusionBuffer (Uint32 width, Uint32 height) {
+    if (width == 0 || height == 0 || width % TILE_W || height % TILE_H) {
+        SDL_Log (
+            "Occlusion buffer size must be a multiple of %dx%d", TILE_W,
+            TILE_H
+        );
+        return NULL;
+    }
+
+    PAL_OcclusionBuffer* ob = calloc (1, sizeof (PAL_OcclusionBuffer));
+    if (ob == NULL) {
+        SDL_Log ("Failed to allocate occlusion buffer");
+        return NULL;
+    }
+    ob->width = width;
+    ob->height = height;
+    ob->tiles_x = width / TILE_W;
+    ob->tiles_y = height / TILE_H;
+    ob->tiles = malloc (ob->tiles_x * ob->tiles_y * sizeof (OcclusionTile));
+    if (ob->tiles == NULL) {
+        SDL_Log ("Failed to allocate occlusion tiles");
+        free (ob);
+        return NULL;
+    }
+    mat4_identity (ob->view_proj);
+    return ob;
+}
+
+void PAL_DestroyOcclusionBuffer (PAL_OcclusionBuffer* ob) {
+    if (ob == NULL) return;
+    free (ob->tiles);
+    free (ob);
+}
+
+void PAL_OcclusionClear (PAL_OcclusionBuffer* ob, mat4 view_proj) {
+    memcpy (ob->view_proj, view_proj, sizeof (mat4));
+    Uint32 count = ob->tiles_x * ob->tiles_y;
+    for (Uint32 i = 0; i < count; i++) {
+        ob->tiles[i] = (OcclusionTile) {.zmax0 = 1.0f, .zmax1 = 0.0f};
+    }
+}
+
+static ClipVertex transform_vertex (mat4 m, vec3 p) {
+    return (ClipVertex) {
+        m[MAT4_IDX (0, 0)] * p.x + m[MAT4_IDX (0, 1)] * p.y +
+            m[MAT4_IDX (0, 2)] * p.z + m[MAT4_IDX (0, 3)],
+        m[MAT4_IDX (1, 0)] * p.x + m[MAT4_IDX (1, 1)] * p.y +
+            m[MAT4_IDX (1, 2)] * p.z + m[MAT4_IDX (1, 3)],
+        m[MAT4_IDX (2, 0)] * p.x + m[MAT4_IDX (2, 1)] * p.y +
+            m[MAT4_IDX (2, 2)] * p.z + m[MAT4_IDX (2, 3)],
+        m[MAT4_IDX (3, 0)] * p.x + m[MAT4_IDX (3, 1)] * p.y +
+            m[MAT4_IDX (3, 2)] * p.z + m[MAT4_IDX (3, 3)],
+    };
+}
+
+static ScreenVertex to_screen (const PAL_OcclusionBuffer* ob, ClipVertex v) {
+    float inv_w = 1.0f / v.w;
+    return (ScreenVertex) {
+        (v.x * inv_w * 0.5f + 0.5f) * (float) ob->width,
+        (0.5f - v.y * inv_w * 0.5f) * (float) ob->height,
+        v.z * inv_w,
+    };
+}
+
+// 32-bit coverage mask of one tile for a triangle given as three edge
+// functions e(x, y) = a * x + b * y + c, inside where all are >= 0
+static Uint32 tile_coverage (
+    const float a[3],
+    const float b[3],
+    const float c[3],
+    float x0,
+    float y0
+) {
+    Uint32 mask = 0;
+#ifdef OCCLUSION_SSE2
+    __m128 lo = _mm_add_ps (
+        _mm_set1_ps (x0), _mm_setr_ps (0.5f, 1.5f, 2.5f, 3.5f)
+    );
+    __m128 hi = _mm_add_ps (lo, _mm_set1_ps (4.0f));
+    __m128 zero = _mm_setzero_ps ();
+    __m128 edge_lo[3];
+    __m128 edge_hi[3];
+    __m128 step[3];
+    for (Uint32 e = 0; e < 3; e++) {
+        __m128 va = _mm_set1_ps (a[e]);
+        __m128 row = _mm_set1_ps (b[e] * (y0 + 0.5f) + c[e]);
+        edge_lo[e] = _mm_add_ps (_mm_mul_ps (va, lo), row);
+        edge_hi[e] = _mm_add_ps (_mm_mul_ps (va, hi), row);
+        step[e] = _mm_set1_ps (b[e]);
+    }
+    for (Uint32 r = 0; r < TILE_H; r++) {
+        __m128 in_lo = _mm_cmpge_ps (edge_lo[0], zero);
+        __m128 in_hi = _mm_cmpge_ps (edge_hi[0], zero);
+        for (Uint32 e = 1; e < 3; e++) {
+            in_lo = _mm_and_ps (in_lo, _mm_cmpge_ps (edge_lo[e], zero));
+            in_hi = _mm_and_ps (in_hi, _mm_cmpge_ps (edge_hi[e], zero));
+        }
+        Uint32 bits = (Uint32) _mm_movemask_ps (in_lo) |
+                      ((Uint32) _mm_movemask_ps (in_hi) << 4);
+        mask |= bits << (r * TILE_W);
+        for (Uint32 e = 0; e < 3; e++) {
+            edge_lo[e] = _mm_add_ps (edge_lo[e], step[e]);
+            edge_hi[e] = _mm_add_ps (edge_hi[e], step[e]);
+        }
+    }
+#else
+    for (Uint32 r = 0; r < TILE_H; r++) {
+        float py = y0 + (float) r + 0.5f;
+        for (Uint32 col = 0; col < TILE_W; col++) {
+            float px = x0 + (float) col + 0.5f;
+            bool inside = true;
+            for (Uint32 e = 0; e < 3; e++) {
+                inside = inside && a[e] * px + b[e] * py + c[e] >= 0.0f;
+            }
+            if (inside) mask |= 1u << (r * TILE_W + col);
+        }
+    }
+#endif
+    return mask;
+}
+
+// merges a triangle's coverage into a tile (the "masked" update)
+static void update_tile (OcclusionTile* tile, Uint32 mask, float ztri) {
+    if (ztri >= tile->zmax0) return;
+
+    // drop the working layer if the new triangle is much closer than it
+    float dist1t = tile->zmax1 - ztri;
+    float dist01 = tile->zmax0 - tile->zmax1;
+    if (dist1t > dist01) {
+        tile->zmax1 = 0.0f;
+        tile->mask = 0;
+    }
+
+    tile->zmax1 = fmaxf (tile->zmax1, ztri);
+    tile->mask |= mask;
+    if (tile->mask == FULL_MASK) {
+        tile->zmax0 = tile->zmax1;
+        tile->zmax1 = 0.0f;
+        tile->mask = 0;
+    }
+}
+
+static void rasterize_triangle (
+    PAL_OcclusionBuffer* ob,
+    ScreenVertex v0,
+    ScreenVertex v1,
+    ScreenVertex v2
+) {
+    float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+    if (fabsf (area) < 1e-6f) return;
+    if (area < 0.0f) {
+        ScreenVertex tmp = v1;
+        v1 = v2;
+        v2 = tmp;
+        area = -area;
+    }
+
+    float min_x = fminf (v0.x, fminf (v1.x, v2.x));
+    float max_x = fmaxf (v0.x, fmaxf (v1.x, v2.x));
+    float min_y = fminf (v0.y, fminf (v1.y, v2.y));
+    float max_y = fmaxf (v0.y, fmaxf (v1.y, v2.y));
+    if (max_x < 0.0f || max_y < 0.0f || min_x >= (float) ob->width ||
+        min_y >= (float) ob->height) {
+        return;
+    }
+    float last_x = (float) ob->width - 1.0f;
+    float last_y = (float) ob->height - 1.0f;
+    Sint32 tx0 = (Sint32) fmaxf (min_x, 0.0f) / TILE_W;
+    Sint32 ty0 = (Sint32) fmaxf (min_y, 0.0f) / TILE_H;
+    Sint32 tx1 = (Sint32) fminf (max_x, last_x) / TILE_W;
+    Sint32 ty1 = (Sint32) fminf (max_y, last_y) / TILE_H;
+
+    // edge functions for (v0, v1), (v1, v2), (v2, v0)
+    const ScreenVertex* verts[3] = {&v0, &v1, &v2};
+    float a[3];
+    float b[3];
+    float c[3];
+    for (Uint32 e = 0; e < 3; e++) {
+        const ScreenVertex* p = verts[e];
+        const ScreenVertex* q = verts[(e + 1) % 3];
+        a[e] = p->y - q->y;
+        b[e] = q->x - p->x;
+        c[e] = -(a[e] * p->x + b[e] * p->y);
+    }
+
+    // depth is linear in screen space
+    float dz1 = v1.z - v0.z;
+    float dz2 = v2.z - v0.z;
+    float dzdx = (dz1 * (v2.y - v0.y) - dz2 * (v1.y - v0.y)) / area;
+    float dzdy = (dz2 * (v1.x - v0.x) - dz1 * (v2.x - v0.x)) / area;
+    float zmax_tri = fmaxf (v0.z, fmaxf (v1.z, v2.z));
+    // furthest corner of a tile relative to its top-left corner
+    float corner_dz =
+        fmaxf (dzdx, 0.0f) * TILE_W + fmaxf (dzdy, 0.0f) * TILE_H;
+
+    for (Sint32 ty = ty0; ty <= ty1; ty++) {
+        float y = (float) (ty * TILE_H);
+        for (Sint32 tx = tx0; tx <= tx1; tx++) {
+            float x = (float) (tx * TILE_W);
+            Uint32 mask = tile_coverage (a, b, c, x, y);
+            if (mask == 0) continue;
+
+            float z = v0.z + dzdx * (x - v0.x) + dzdy * (y - v0.y) + corner_dz;
+            float ztri = fminf (z, zmax_tri);
+            update_tile (&ob->tiles[ty * ob->tiles_x + tx], mask, ztri);
+        }
+    }
+}
+
+// clips against the near plane (z >= 0 in clip space) and rasterizes the
+// resulting triangle or quad
+static void clip_and_rasterize (
+    PAL_OcclusionBuffer* ob,
+    ClipVertex v0,
+    ClipVertex v1,
+    ClipVertex v2
+) {
+    ClipVertex in[3] = {v0, v1, v2};
+    ClipVertex out[4];
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < 3; i++) {
+        ClipVertex p = in[i];
+        ClipVertex q = in[(i + 1) % 3];
+        bool p_in = p.z >= 0.0f;
+        bool q_in = q.z >= 0.0f;
+        if (p_in) out[count++] = p;
+        if (p_in != q_in) {
+            float t = p.z / (p.z - q.z);
+            out[count++] = (ClipVertex) {
+                p.x + (q.x - p.x) * t,
+                p.y + (q.y - p.y) * t,
+                0.0f,
+                p.w + (q.w - p.w) * t,
+            };
+        }
+    }
+    if (count < 3) return;
+
+    ScreenVertex s[4];
+    for (Uint32 i = 0; i < count; i++) {
+        if (out[i].w <= 1e-6f) return;
+        s[i] = to_screen (ob, out[i]);
+    }
+    rasterize_triangle (ob, s[0], s[1], s[2]);
+    if (count == 4) rasterize_triangle (ob, s[0], s[2], s[3]);
+}
+
+void PAL_OcclusionRasterize (
+    PAL_OcclusionBuffer* ob,
+    const vec3* positions,
+    const Uint32* indices,
+    Uint32 num_indices,
+    mat4 model
+) {
+    mat4 mvp;
+    mat4_multiply (mvp, ob->view_proj, model);
+    for (Uint32 i = 0; i + 2 < num_indices; i += 3) {
+        clip_and_rasterize (
+            ob, transform_vertex (mvp, positions[indices[i]]),
+            transform_vertex (mvp, positions[indices[i + 1]]),
+            transform_vertex (mvp, positions[indices[i + 2]])
+        );
+    }
+}
+
+void PAL_OcclusionRasterizeBox (
+    PAL_OcclusionBuffer* ob,
+    aabb box,
+    mat4 model
+) {
+    vec3 corners[8];
+    for (Uint32 i = 0; i < 8; i++) {
+        corners[i] = (vec3) {
+            i & 1 ? box.max.x : box.min.x,
+            i & 2 ? box.max.y : box.min.y,
+            i & 4 ? box.max.z : box.min.z,
+        };
+    }
+    static const Uint32 indices[36] = {
+        0, 1, 3, 0, 3, 2, // -z
+        4, 6, 7, 4, 7, 5, // +z
+        0, 2, 6, 0, 6, 4, // -x
+        1, 5, 7, 1, 7, 3, // +x
+        0, 4, 5, 0, 5, 1, // -y
+        2, 3, 7, 2, 7, 6, // +y
+    };
+    PAL_OcclusionRasterize (ob, corners, indices, 36, model);
+}
+
+bool PAL_OcclusionTestAABB (const PAL_OcclusionBuffer* ob, aabb box) {
+    float min_x = INFINITY;
+    float max_x = -INFINITY;
+    float min_y = INFINITY;
+    float max_y = -INFINITY;
+    float min_z = INFINITY;
+    for (Uint32 i = 0; i < 8; i++) {
+        vec3 p = {
+            i & 1 ? box.max.x : box.min.x,
+            i & 2 ? box.max.y : box.min.y,
+            i & 4 ? box.max.z : box.min.z,
+        };
+        ClipVertex v = transform_vertex ((float*) ob->view_proj, p);
+        // crosses the near plane: the camera is (almost) inside the box
+        if (v.z < 0.0f || v.w <= 1e-6f) return true;
+
+        ScreenVertex s = to_screen (ob, v);
+        min_x = fminf (min_x, s.x);
+        max_x = fmaxf (max_x, s.x);
+        min_y = fminf (min_y, s.y);
+        max_y = fmaxf (max_y, s.y);
+        min_z = fminf (min_z, s.z);
+    }
+
+    // off screen: leave it to the frustum test
+    if (max_x < 0.0f || max_y < 0.0f || min_x >= (float) ob->width ||
+        min_y >= (float) ob->height) {
+        return true;
+    }
+    float last_x = (float) ob->width - 1.0f;
+    float last_y = (float) ob->height - 1.0f;
+    Sint32 tx0 = (Sint32) fmaxf (min_x, 0.0f) / TILE_W;
+    Sint32 ty0 = (Sint32) fmaxf (min_y, 0.0f) / TILE_H;
+    Sint32 tx1 = (Sint32) fminf (max_x, last_x) / TILE_W;
+    Sint32 ty1 = (Sint32) fminf (max_y, last_y) / TILE_H;
+
+    for (Sint32 ty = ty0; ty <= ty1; ty++) {
+        const OcclusionTile* row = &ob->tiles[ty * ob->tiles_x];
+        for (Sint32 tx = tx0; tx <= tx1; tx++) {
+            if (min_z <= row[tx].zmax0) return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
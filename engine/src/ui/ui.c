@@ -109,32 +109,24 @@ UIComponent* create_ui_component (
     }
     ui->rect_count = 0;
     ui->max_rects = max_rects;
+    ui->clip = (SDL_Rect) {0};
+    ui->upload = renderer->upload;
 
     // white texture
-    ui->white_texture = create_white_texture (renderer->device);
+    ui->white_texture = create_white_texture (renderer->device, NULL);
     if (ui->white_texture == NULL) {
         free (ui->rects);
         free (ui);
         return NULL;
     }
 
-    // sampler
-    SDL_GPUSamplerCreateInfo sampler_info = {
-        .min_filter = SDL_GPU_FILTER_LINEAR,
-        .mag_filter = SDL_GPU_FILTER_LINEAR,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
-        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .max_anisotropy = 1.0f,
-        .enable_anisotropy = false
-    };
-    ui->sampler = SDL_CreateGPUSampler (renderer->device, &sampler_info);
+    // sampler, shared with every UI and material sampling alike
+    ui->sampler =
+        PAL_AcquirePresetSampler (renderer->device, PAL_SAMPLER_LINEAR_REPEAT);
     if (ui->sampler == NULL) {
         free (ui->rects);
         SDL_ReleaseGPUTexture (renderer->device, ui->white_texture);
         free (ui);
-        SDL_Log ("Failed to create sampler: %s", SDL_GetError ());
         return NULL;
     }
 
@@ -183,6 +175,21 @@ UIComponent* create_ui_component (
     }
     ui->ibo_size = isize;
 
+    // every rect is drawn from this quad with a vertex offset
+    Uint32* inds = (Uint32*) PAL_UploadRingBuffer (
+        ui->upload, ui->ibo, 0, 6 * sizeof (Uint32)
+    );
+    if (inds == NULL) {
+        free (ui->rects);
+        TTF_CloseFont (ui->font);
+        SDL_ReleaseGPUTexture (renderer->device, ui->white_texture);
+        SDL_ReleaseGPUBuffer (renderer->device, ui->vbo);
+        SDL_ReleaseGPUBuffer (renderer->device, ui->ibo);
+        free (ui);
+        return NULL;
+    }
+    memcpy (inds, (Uint32[]) {0, 1, 2, 1, 3, 2}, 6 * sizeof (Uint32));
+
     PAL_ShaderCreateInfo vertex_info = {
         .device = renderer->device,
         .filename = "shaders/ui.vert.spv",
@@ -218,7 +225,7 @@ UIComponent* create_ui_component (
         SDL_ReleaseGPUTexture (renderer->device, ui->white_texture);
         SDL_ReleaseGPUBuffer (renderer->device, ui->vbo);
         SDL_ReleaseGPUBuffer (renderer->device, ui->ibo);
-        SDL_ReleaseGPUShader (renderer->device, ui->vertex);
+        PAL_ReleaseShader (renderer->device, ui->vertex);
         free (ui);
         return NULL;
     }
@@ -245,7 +252,10 @@ UIComponent* create_ui_component (
                                  .alpha_blend_op = SDL_GPU_BLENDOP_ADD,
                              }}
                     },
-                .has_depth_stencil_target = true,
+                // deferred and scaled rendering draw the UI in a pass
+                // without depth
+                .has_depth_stencil_target =
+                    !renderer->deferred && !renderer->scaled,
                 .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM,
             },
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
@@ -297,8 +307,8 @@ UIComponent* create_ui_component (
         SDL_ReleaseGPUTexture (renderer->device, ui->white_texture);
         SDL_ReleaseGPUBuffer (renderer->device, ui->vbo);
         SDL_ReleaseGPUBuffer (renderer->device, ui->ibo);
-        SDL_ReleaseGPUShader (renderer->device, ui->vertex);
-        SDL_ReleaseGPUShader (renderer->device, ui->fragment);
+        PAL_ReleaseShader (renderer->device, ui->vertex);
+        PAL_ReleaseShader (renderer->device, ui->fragment);
         free (ui);
         SDL_Log ("Unable to create UI graphics pipeline: %s", SDL_GetError ());
         return NULL;
@@ -324,9 +334,13 @@ void draw_rectangle (
     ui->rects[ui->rect_count].rect = (SDL_FRect) {x, y, w, h};
     ui->rects[ui->rect_count].color = (SDL_FColor) {r, g, b, a};
     ui->rects[ui->rect_count].texture = ui->white_texture;
+    ui->rects[ui->rect_count].pixels = NULL;
+    ui->rects[ui->rect_count].clip = ui->clip;
     ui->rect_count++;
 }
 
+// the pixels stay with the rect until the renderer stages them in its
+// upload ring, which may belong to the render thread
 static SDL_GPUTexture*
 ui_create_text_texture (SDL_GPUDevice* device, SDL_Surface* abgr) {
     SDL_GPUTextureCreateInfo texinfo = {
@@ -343,40 +357,6 @@ ui_create_text_texture (SDL_GPUDevice* device, SDL_Surface* abgr) {
         SDL_Log ("UI text texture create failed: %s", SDL_GetError ());
         return NULL;
     }
-    SDL_GPUTransferBufferCreateInfo tbinfo = {
-        .size = abgr->pitch * abgr->h,
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-    };
-    SDL_GPUTransferBuffer* tbuf = SDL_CreateGPUTransferBuffer (device, &tbinfo);
-    if (!tbuf) {
-        SDL_ReleaseGPUTexture (device, tex);
-        SDL_Log ("UI text transfer buffer create failed: %s", SDL_GetError ());
-        return NULL;
-    }
-    void* map = SDL_MapGPUTransferBuffer (device, tbuf, false);
-    if (!map) {
-        SDL_ReleaseGPUTransferBuffer (device, tbuf);
-        SDL_ReleaseGPUTexture (device, tex);
-        SDL_Log ("UI text transfer buffer map failed: %s", SDL_GetError ());
-        return NULL;
-    }
-    memcpy (map, abgr->pixels, tbinfo.size);
-    SDL_UnmapGPUTransferBuffer (device, tbuf);
-
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
-    SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass (cmd);
-    SDL_GPUTextureTransferInfo src = {
-        .transfer_buffer = tbuf,
-        .offset = 0,
-        .pixels_per_row = abgr->w,
-        .rows_per_layer = abgr->h
-    };
-    SDL_GPUTextureRegion dst =
-        {.texture = tex, .w = abgr->w, .h = abgr->h, .d = 1};
-    SDL_UploadToGPUTexture (copy, &src, &dst, false);
-    SDL_EndGPUCopyPass (copy);
-    SDL_SubmitGPUCommandBuffer (cmd);
-    SDL_ReleaseGPUTransferBuffer (device, tbuf);
     return tex;
 }
 
@@ -413,8 +393,10 @@ int draw_text (
     SDL_GPUTexture* tex = ui_create_text_texture (device, abgr);
     int w = abgr->w;
     int h = abgr->h;
-    SDL_DestroySurface (abgr);
-    if (!tex) return 0;
+    if (!tex) {
+        SDL_DestroySurface (abgr);
+        return 0;
+    }
 
     ui->rects[ui->rect_count++] = (UIRect) {
         .rect =
@@ -422,6 +404,8 @@ int draw_text (
                          (float) w, (float) h},
         .color = (SDL_FColor) {r, g, b, a},
         .texture = tex,
+        .pixels = abgr,
+        .clip = ui->clip,
     };
     return w;
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include <util/hash_table.h>
+
+#define HASH_PRIME 0x100000001b3ull // FNV-1a
+
+Uint64 PAL_HashBytes (Uint64 hash, const void* data, Uint64 size) {
+    const Uint8* bytes = (const Uint8*) data;
+    for (Uint64 i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * HASH_PRIME;
+    }
+    return hash;
+}
+
+void PAL_InitHashKey (PAL_HashKey* key) {
+    key->bytes = key->inline_bytes;
+    key->size = 0;
+    key->capacity = PAL_HASH_KEY_INLINE;
+    key->failed = false;
+}
+
+void PAL_HashKeyAppend (PAL_HashKey* key, const void* data, Uint64 size) {
+    if (key->failed || size == 0) return;
+    if (key->size + size > key->capacity) {
+        Uint64 capacity = key->capacity * 2;
+        while (capacity < key->size + size) capacity *= 2;
+        Uint8* bytes = malloc (capacity);
+        if (bytes == NULL) {
+            key->failed = true;
+            return;
+        }
+        SDL_memcpy (bytes, key->bytes, key->size);
+        if (key->bytes != key->inline_bytes) free (key->bytes);
+        key->bytes = bytes;
+        key->capacity = capacity;
+    }
+    SDL_memcpy (key->bytes + key->size, data, size);
+    key->size += size;
+}
+
+void PAL_HashKeyAppendString (PAL_HashKey* key, const char* string) {
+    PAL_HashKeyAppend (key, string, SDL_strlen (string) + 1);
+}
+
+void PAL_FreeHashKey (PAL_HashKey* key) {
+    if (key->bytes != key->inline_bytes) free (key->bytes);
+    PAL_InitHashKey (key);
+}
+
+// the entry keyed by key, or the empty slot it would go in
+static PAL_HashSlot* probe (
+    const PAL_HashTable* table,
+    Uint64 hash,
+    const void* key,
+    Uint64 size
+) {
+    Uint32 mask = table->capacity - 1;
+    for (Uint32 i = (Uint32) hash & mask;; i = (i + 1) & mask) {
+        PAL_HashSlot* slot = &table->slots[i];
+        if (slot->value == NULL) return slot;
+        if (slot->hash == hash && slot->key_size == size &&
+            SDL_memcmp (slot->key, key, size) == 0) {
+            return slot;
+        }
+    }
+}
+
+PAL_HashSlot*
+PAL_HashTableFind (const PAL_HashTable* table, const void* key, Uint64 size) {
+    if (table->capacity == 0) return NULL;
+    PAL_HashSlot* slot =
+        probe (table, PAL_HashBytes (PAL_HASH_SEED, key, size), key, size);
+    return slot->value ? slot : NULL;
+}
+
+static bool grow (PAL_HashTable* table) {
+    Uint32 capacity = table->capacity ? table->capacity * 2 : 16;
+    PAL_HashSlot* slots = calloc (capacity, sizeof (PAL_HashSlot));
+    if (slots == NULL) return false;
+
+    PAL_HashSlot* old = table->slots;
+    Uint32 old_capacity = table->capacity;
+    table->slots = slots;
+    table->capacity = capacity;
+    for (Uint32 i = 0; i < old_capacity; i++) {
+        if (old[i].value == NULL) continue;
+        *probe (table, old[i].hash, old[i].key, old[i].key_size) = old[i];
+    }
+    free (old);
+    return true;
+}
+
+PAL_HashSlot* PAL_HashTableInsert (
+    PAL_HashTable* table,
+    const void* key,
+    Uint64 size,
+    void* value
+) {
+    // keep the load factor at or under one half
+    if ((table->count + 1) * 2 > table->capacity && !grow (table)) {
+        return NULL;
+    }
+    Uint8* copy = malloc (size ? size : 1);
+    if (copy == NULL) return NULL;
+    SDL_memcpy (copy, key, size);
+
+    Uint64 hash = PAL_HashBytes (PAL_HASH_SEED, key, size);
+    PAL_HashSlot* slot = probe (table, hash, key, size);
+    *slot = (PAL_HashSlot) {
+        .hash = hash,
+        .key = copy,
+        .key_size = size,
+        .value = value,
+    };
+    table->count++;
+    return slot;
+}
+
+PAL_HashSlot*
+PAL_HashTableFindValue (const PAL_HashTable* table, const void* value) {
+    for (Uint32 i = 0; i < table->capacity; i++) {
+        if (table->slots[i].value == value) return &table->slots[i];
+    }
+    return NULL;
+}
+
+PAL_HashSlot* PAL_HashTableFindValueFrom (
+    const PAL_HashTable* table,
+    Uint64 hash,
+    const void* value
+) {
+    if (table->capacity == 0) return NULL;
+    Uint32 mask = table->capacity - 1;
+    for (Uint32 i = (Uint32) hash & mask; table->slots[i].value;
+         i = (i + 1) & mask) {
+        if (table->slots[i].value == value) return &table->slots[i];
+    }
+    return NULL;
+}
+
+void PAL_HashTableRemove (PAL_HashTable* table, PAL_HashSlot* slot) {
+    free (slot->key);
+
+    // shift later entries of the probe run back into the hole
+    Uint32 mask = table->capacity - 1;
+    Uint32 hole = (Uint32) (slot - table->slots);
+    for (Uint32 i = (hole + 1) & mask; table->slots[i].value;
+         i = (i + 1) & mask) {
+        Uint32 home = (Uint32) table->slots[i].hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            table->slots[hole] = table->slots[i];
+            hole = i;
+        }
+    }
+    table->slots[hole] = (PAL_HashSlot) {0};
+    if (--table->count == 0) PAL_FreeHashTable (table);
+}
+
+void PAL_FreeHashTable (PAL_HashTable* table) {
+    for (Uint32 i = 0; i < table->capacity; i++) {
+        if (table->slots[i].value) free (table->slots[i].key);
+    }
+    free (table->slots);
+    *table = (PAL_HashTable) {0};
+}
\ No newline at end of file
@@ -0,0 +1,674 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+#include <geometry/g_common.h>
+#include <geometry/sphere.h>
+#include <math/bounds.h>
+#include <math/matrix.h>
+#include <scene/bvh.h>
+#include <scene/light_grid.h>
+#include <scene/occlusion.h>
+
+// Headless CPU benchmarks for engine subsystems.
+//   benchmark bvh        frustum query and refit time vs entity count and
+//                        the fraction of entities moving each frame
+//   benchmark occlusion  occluder rasterization and box test time for a
+//                        grid of walled rooms seen from inside one of them
+//   benchmark lod        triangles drawn for a field of 10k spheres with and
+//                        without LOD chains, plus level switches per frame
+//   benchmark normals    vertex throughput of the phong vertex stage on a
+//                        high-segment sphere, with a per-vertex inverse()
+//                        normal matrix vs one precomputed per object
+//   benchmark lights     clustered light assignment time vs point light
+//                        count, and lights each fragment visits compared
+//                        with looping over all of them
+
+#define BVH_FRAMES 60
+#define WORLD_SIZE 2000.0f
+
+#define OCCLUSION_FRAMES 200
+#define ROOM_SIZE 10.0f
+#define ROOMS 16 // per side
+
+#define LOD_FRAMES 300
+#define LOD_GRID 100 // spheres per side
+#define LOD_SPACING 3.0f
+#define LOD_SCREEN_HEIGHT 1080.0f
+
+#define NORMAL_FRAMES 10
+#define NORMAL_OBJECTS 8
+#define NORMAL_SEGMENTS 512 // around; half as many from pole to pole
+
+#define LIGHT_FRAMES 100
+#define LIGHT_DEPTH 150.0f    // lights fill the view out to this distance
+#define LIGHT_SAMPLES 100000 // fragments at random pixels and depths
+#define GRID_LAST_X (PAL_LIGHT_GRID_X - 1)
+#define GRID_LAST_Y (PAL_LIGHT_GRID_Y - 1)
+
+static double ns_to_ms (Uint64 ns) {
+    return (double) ns / 1e6;
+}
+
+static aabb random_box (vec3 center) {
+    float r = random_float_range (0.25f, 2.0f);
+    vec3 ext = {r, r, r};
+    return (aabb) {.min = vec3_sub (center, ext), .max = vec3_add (center, ext)};
+}
+
+static void make_frustum (frustum* f) {
+    mat4 view;
+    mat4_identity (view); // camera at the origin looking down +z
+
+    mat4 proj;
+    mat4_perspective (
+        proj, 70.0f * (float) M_PI / 180.0f, 16.0f / 9.0f, 0.1f, 500.0f
+    );
+
+    mat4 view_proj;
+    mat4_multiply (view_proj, proj, view);
+    frustum_from_matrix (f, view_proj);
+}
+
+static void bench_bvh_case (Uint32 count, float moving) {
+    vec3* centers = malloc (count * sizeof (vec3));
+    aabb* boxes = malloc (count * sizeof (aabb));
+    Uint32* proxies = malloc (count * sizeof (Uint32));
+    Entity* visible = malloc (count * sizeof (Entity));
+    PAL_BVH* bvh = PAL_CreateBVH (0.5f);
+    if (!centers || !boxes || !proxies || !visible || !bvh) {
+        SDL_Log ("Failed to allocate benchmark data");
+        free (centers);
+        free (boxes);
+        free (proxies);
+        free (visible);
+        PAL_DestroyBVH (bvh);
+        return;
+    }
+
+    float half = WORLD_SIZE * 0.5f;
+    for (Uint32 i = 0; i < count; i++) {
+        centers[i] = (vec3) {
+            random_float_range (-half, half),
+            random_float_range (-half * 0.1f, half * 0.1f),
+            random_float_range (-half, half),
+        };
+        boxes[i] = random_box (centers[i]);
+        proxies[i] = PAL_BVHInsert (bvh, i, boxes[i]);
+    }
+    PAL_BVHRebuild (bvh);
+
+    frustum f;
+    make_frustum (&f);
+
+    Uint32 movers = (Uint32) ((float) count * moving);
+    Uint64 refit_ns = 0;
+    Uint64 query_ns = 0;
+    Uint64 linear_ns = 0;
+    Uint32 reinserted = 0;
+    Uint32 visible_count = 0;
+    Uint32 linear_count = 0;
+    for (Uint32 frame = 0; frame < BVH_FRAMES; frame++) {
+        Uint64 start = SDL_GetTicksNS ();
+        for (Uint32 m = 0; m < movers; m++) {
+            Uint32 i = (Uint32) (random_float () * (float) count);
+            if (i >= count) i = count - 1;
+            vec3 step = {
+                random_float_range (-0.3f, 0.3f),
+                0.0f,
+                random_float_range (-0.3f, 0.3f),
+            };
+            boxes[i].min = vec3_add (boxes[i].min, step);
+            boxes[i].max = vec3_add (boxes[i].max, step);
+            reinserted += PAL_BVHMove (bvh, proxies[i], boxes[i]);
+        }
+        PAL_BVHMaintain (bvh);
+        Uint64 mid = SDL_GetTicksNS ();
+        visible_count = PAL_BVHQueryFrustum (bvh, &f, visible);
+        Uint64 end = SDL_GetTicksNS ();
+
+        linear_count = 0;
+        for (Uint32 i = 0; i < count; i++) {
+            if (frustum_test_aabb (&f, boxes[i])) visible[linear_count++] = i;
+        }
+        Uint64 linear_end = SDL_GetTicksNS ();
+
+        refit_ns += mid - start;
+        query_ns += end - mid;
+        linear_ns += linear_end - end;
+    }
+
+    printf (
+        "%8u %7.1f%% %10.3f %10.3f %10.3f %9u %9u %10u\n", count,
+        moving * 100.0f, ns_to_ms (refit_ns) / BVH_FRAMES,
+        ns_to_ms (query_ns) / BVH_FRAMES, ns_to_ms (linear_ns) / BVH_FRAMES,
+        visible_count, linear_count, reinserted / BVH_FRAMES
+    );
+
+    PAL_DestroyBVH (bvh);
+    free (centers);
+    free (boxes);
+    free (proxies);
+    free (visible);
+}
+
+static void bench_bvh (void) {
+    const Uint32 counts[] = {1000, 10000, 100000, 500000};
+    const float moving[] = {0.0f, 0.01f, 0.1f, 0.5f};
+
+    printf ("BVH: %u frames per case, times are ms per frame\n", BVH_FRAMES);
+    printf (
+        "%8s %8s %10s %10s %10s %9s %9s %10s\n", "entities", "moving",
+        "refit", "query", "linear", "visible", "linear", "reinserts"
+    );
+    for (Uint32 c = 0; c < SDL_arraysize (counts); c++) {
+        for (Uint32 m = 0; m < SDL_arraysize (moving); m++) {
+            bench_bvh_case (counts[c], moving[m]);
+        }
+    }
+}
+
+static void bench_occlusion_case (Uint32 width, Uint32 height, Uint32 props) {
+    PAL_OcclusionBuffer* ob = PAL_CreateOcclusionBuffer (width, height);
+    aabb* boxes = malloc (props * sizeof (aabb));
+    if (!ob || !boxes) {
+        SDL_Log ("Failed to allocate benchmark data");
+        PAL_DestroyOcclusionBuffer (ob);
+        free (boxes);
+        return;
+    }
+
+    // props scattered over a ROOMS x ROOMS grid of rooms
+    float extent = ROOMS * ROOM_SIZE;
+    for (Uint32 i = 0; i < props; i++) {
+        vec3 c = {
+            random_float_range (0.0f, extent),
+            random_float_range (0.0f, 2.0f),
+            random_float_range (0.0f, extent),
+        };
+        boxes[i] = random_box (c);
+    }
+
+    // one wall per room edge, with a doorway gap on every other wall
+    aabb walls[2 * (ROOMS + 1) * ROOMS * 2];
+    Uint32 wall_count = 0;
+    for (Uint32 a = 0; a <= ROOMS; a++) {
+        for (Uint32 b = 0; b < ROOMS; b++) {
+            float fixed = (float) a * ROOM_SIZE;
+            float lo = (float) b * ROOM_SIZE;
+            float door = (a + b) % 2 ? 0.0f : 1.5f;
+            float mid = lo + ROOM_SIZE * 0.5f;
+            aabb x_walls[2] = {
+                {{fixed - 0.1f, 0.0f, lo}, {fixed + 0.1f, 4.0f, mid - door}},
+                {{fixed - 0.1f, 0.0f, mid + door},
+                 {fixed + 0.1f, 4.0f, lo + ROOM_SIZE}},
+            };
+            aabb z_walls[2] = {
+                {{lo, 0.0f, fixed - 0.1f}, {mid - door, 4.0f, fixed + 0.1f}},
+                {{mid + door, 0.0f, fixed - 0.1f},
+                 {lo + ROOM_SIZE, 4.0f, fixed + 0.1f}},
+            };
+            for (Uint32 w = 0; w < 2; w++) {
+                walls[wall_count++] = x_walls[w];
+                walls[wall_count++] = z_walls[w];
+            }
+        }
+    }
+
+    mat4 identity;
+    mat4_identity (identity);
+    Uint64 raster_ns = 0;
+    Uint64 test_ns = 0;
+    Uint32 frustum_visible = 0;
+    Uint32 occluded = 0;
+    for (Uint32 frame = 0; frame < OCCLUSION_FRAMES; frame++) {
+        // camera in a room near the middle, turning in place
+        float yaw = (float) frame / OCCLUSION_FRAMES * 2.0f * (float) M_PI;
+        vec3 eye = {extent * 0.5f + 5.0f, 1.7f, extent * 0.5f + 5.0f};
+        vec4 rot = quat_from_axis_angle ((vec3) {0.0f, 1.0f, 0.0f}, yaw);
+        mat4 view;
+        mat4_identity (view);
+        mat4_rotate_quat (view, quat_conjugate (rot));
+        mat4_translate (view, vec3_scale (eye, -1.0f));
+        mat4 proj;
+        mat4_perspective (
+            proj, 70.0f * (float) M_PI / 180.0f, 16.0f / 9.0f, 0.1f, 500.0f
+        );
+        mat4 view_proj;
+        mat4_multiply (view_proj, proj, view);
+        frustum f;
+        frustum_from_matrix (&f, view_proj);
+
+        Uint64 start = SDL_GetTicksNS ();
+        PAL_OcclusionClear (ob, view_proj);
+        for (Uint32 w = 0; w < wall_count; w++) {
+            if (!frustum_test_aabb (&f, walls[w])) continue;
+            PAL_OcclusionRasterizeBox (ob, walls[w], identity);
+        }
+        Uint64 mid = SDL_GetTicksNS ();
+        for (Uint32 i = 0; i < props; i++) {
+            if (!frustum_test_aabb (&f, boxes[i])) continue;
+            frustum_visible++;
+            if (!PAL_OcclusionTestAABB (ob, boxes[i])) occluded++;
+        }
+        Uint64 end = SDL_GetTicksNS ();
+
+        raster_ns += mid - start;
+        test_ns += end - mid;
+    }
+
+    printf (
+        "%5ux%-4u %8u %6u %10.3f %10.3f %10u %9.1f%%\n", width, height, props,
+        wall_count, ns_to_ms (raster_ns) / OCCLUSION_FRAMES,
+        ns_to_ms (test_ns) / OCCLUSION_FRAMES,
+        frustum_visible / OCCLUSION_FRAMES,
+        frustum_visible ? 100.0f * (float) occluded / (float) frustum_visible
+                        : 0.0f
+    );
+
+    PAL_DestroyOcclusionBuffer (ob);
+    free (boxes);
+}
+
+static void bench_occlusion (void) {
+    const Uint32 sizes[][2] = {{128, 64}, {256, 128}, {512, 256}};
+    const Uint32 props[] = {10000, 100000};
+
+    printf (
+        "Occlusion: %u frames per case, times are ms per frame\n",
+        OCCLUSION_FRAMES
+    );
+    printf (
+        "%10s %8s %6s %10s %10s %10s %10s\n", "buffer", "props", "walls",
+        "raster", "test", "in frustum", "occluded"
+    );
+    for (Uint32 s = 0; s < SDL_arraysize (sizes); s++) {
+        for (Uint32 p = 0; p < SDL_arraysize (props); p++) {
+            bench_occlusion_case (sizes[s][0], sizes[s][1], props[p]);
+        }
+    }
+}
+
+static void bench_lod (void) {
+    // CPU-side stand-in for PAL_CreateSphereMeshLODs: same levels and
+    // errors, no GPU buffers
+    PAL_SphereMeshCreateInfo sphere_info = {
+        .radius = 0.5f,
+        .width_segments = 64,
+        .height_segments = 32,
+        .phi_start = 0.0f,
+        .phi_length = 2.0f * (float) M_PI,
+        .theta_start = 0.0f,
+        .theta_length = (float) M_PI,
+    };
+    PAL_MeshComponent mesh = {
+        .bounds = {{-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f}},
+    };
+    PAL_SphereMeshCreateInfo prev = {0};
+    for (Uint32 l = 0; l < PAL_MAX_MESH_LODS; l++) {
+        PAL_SphereMeshCreateInfo level = PAL_SphereMeshLODInfo (&sphere_info, l);
+        if (level.width_segments == prev.width_segments &&
+            level.height_segments == prev.height_segments) {
+            break;
+        }
+        prev = level;
+        mesh.lods[l] = (PAL_MeshLOD) {
+            .num_vertices = (level.width_segments + 1) *
+                            (level.height_segments + 1),
+            .num_indices = level.width_segments * level.height_segments * 6,
+            .error = PAL_SphereMeshError (&level),
+        };
+        mesh.num_lods = l + 1;
+    }
+
+    Uint32 count = LOD_GRID * LOD_GRID;
+    vec3* centers = malloc (count * sizeof (vec3));
+    Uint8* levels = calloc (count, sizeof (Uint8));
+    if (!centers || !levels) {
+        SDL_Log ("Failed to allocate benchmark data");
+        free (centers);
+        free (levels);
+        return;
+    }
+    for (Uint32 i = 0; i < count; i++) {
+        centers[i] = (vec3) {
+            (float) (i % LOD_GRID) * LOD_SPACING, 0.0f,
+            (float) (i / LOD_GRID) * LOD_SPACING,
+        };
+    }
+
+    mat4 proj;
+    mat4_perspective (
+        proj, 70.0f * (float) M_PI / 180.0f, 16.0f / 9.0f, 0.1f, 1000.0f
+    );
+    float pixels_per_radian = proj[MAT4_IDX (1, 1)] * LOD_SCREEN_HEIGHT * 0.5f;
+
+    Uint64 full_triangles = 0;
+    Uint64 lod_triangles = 0;
+    Uint64 switches = 0;
+    Uint64 select_ns = 0;
+    float worst_error = 0.0f;
+    for (Uint32 frame = 0; frame < LOD_FRAMES; frame++) {
+        // walk diagonally across the field at head height
+        float t = (float) frame / LOD_FRAMES;
+        float edge = LOD_GRID * LOD_SPACING;
+        vec3 eye = {edge * 0.5f * t, 1.7f, edge * 0.5f * t - 5.0f};
+        mat4 view;
+        mat4_identity (view);
+        mat4_rotate_quat (
+            view, quat_conjugate (quat_from_axis_angle (
+                      (vec3) {0.0f, 1.0f, 0.0f}, (float) M_PI * 0.25f
+                  ))
+        );
+        mat4_translate (view, vec3_scale (eye, -1.0f));
+        mat4 view_proj;
+        mat4_multiply (view_proj, proj, view);
+        frustum f;
+        frustum_from_matrix (&f, view_proj);
+
+        Uint64 start = SDL_GetTicksNS ();
+        for (Uint32 i = 0; i < count; i++) {
+            aabb box = {
+                vec3_add (centers[i], mesh.bounds.min),
+                vec3_add (centers[i], mesh.bounds.max),
+            };
+            if (!frustum_test_aabb (&f, box)) continue;
+
+            vec3 d = vec3_sub (centers[i], eye);
+            float dist = fmaxf (sqrtf (vec3_dot (d, d)) - 0.87f, 1e-3f);
+            float ppu = pixels_per_radian / dist;
+            Uint32 level = PAL_SelectMeshLOD (&mesh, ppu, levels[i]);
+            switches += level != levels[i];
+            levels[i] = (Uint8) level;
+
+            full_triangles += mesh.lods[0].num_indices / 3;
+            lod_triangles += mesh.lods[level].num_indices / 3;
+            worst_error = fmaxf (worst_error, mesh.lods[level].error * ppu);
+        }
+        select_ns += SDL_GetTicksNS () - start;
+    }
+
+    printf (
+        "LOD: %u spheres, %u frames, %u levels\n", count, LOD_FRAMES,
+        mesh.num_lods
+    );
+    for (Uint32 l = 0; l < mesh.num_lods; l++) {
+        printf (
+            "  level %u: %6u triangles, error %.5f\n", l,
+            mesh.lods[l].num_indices / 3, mesh.lods[l].error
+        );
+    }
+    printf (
+        "triangles/frame: %.0f full, %.0f with LOD (%.1fx fewer)\n",
+        (double) full_triangles / LOD_FRAMES,
+        (double) lod_triangles / LOD_FRAMES,
+        (double) full_triangles / (double) SDL_max (lod_triangles, 1)
+    );
+    printf (
+        "level switches/frame: %.1f, worst error: %.2f px, select: %.3f ms\n",
+        (double) switches / LOD_FRAMES, worst_error,
+        ns_to_ms (select_ns) / LOD_FRAMES
+    );
+
+    free (centers);
+    free (levels);
+}
+
+static vec4 mat4_mul_vec4 (const float* m, vec4 v) {
+    return (vec4) {
+        m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * v.w,
+        m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * v.w,
+        m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * v.w,
+        m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15] * v.w,
+    };
+}
+
+static vec3 mat3_mul_vec3 (const float* m, vec3 v) {
+    return (vec3) {
+        m[0] * v.x + m[3] * v.y + m[6] * v.z,
+        m[1] * v.x + m[4] * v.y + m[7] * v.z,
+        m[2] * v.x + m[5] * v.y + m[8] * v.z,
+    };
+}
+
+static void bench_normals (void) {
+    // unit sphere positions; on a unit sphere the normal is the position
+    Uint32 width = NORMAL_SEGMENTS;
+    Uint32 height = NORMAL_SEGMENTS / 2;
+    Uint32 count = (width + 1) * (height + 1);
+    vec3* positions = malloc (count * sizeof (vec3));
+    if (!positions) {
+        SDL_Log ("Failed to allocate benchmark data");
+        return;
+    }
+    for (Uint32 y = 0; y <= height; y++) {
+        float theta = (float) y / (float) height * (float) M_PI;
+        for (Uint32 x = 0; x <= width; x++) {
+            float phi = (float) x / (float) width * 2.0f * (float) M_PI;
+            positions[y * (width + 1) + x] = (vec3) {
+                -cosf (phi) * sinf (theta), cosf (theta),
+                sinf (phi) * sinf (theta),
+            };
+        }
+    }
+
+    mat4 view;
+    mat4_identity (view);
+    mat4_translate (view, (vec3) {0.0f, 0.0f, 10.0f});
+    mat4 proj;
+    mat4_perspective (
+        proj, 70.0f * (float) M_PI / 180.0f, 16.0f / 9.0f, 0.1f, 500.0f
+    );
+    mat4 view_proj;
+    mat4_multiply (view_proj, proj, view);
+
+    mat4 models[NORMAL_OBJECTS];
+    for (Uint32 i = 0; i < NORMAL_OBJECTS; i++) {
+        mat4_identity (models[i]);
+        mat4_translate (models[i], random_vec3 ());
+        mat4_rotate_quat (
+            models[i], quat_from_euler (vec3_scale (random_vec3 (), 6.0f))
+        );
+        float s = random_float_range (0.5f, 2.0f);
+        // half uniformly scaled, half stretched
+        mat4_scale (
+            models[i], i % 2 ? (vec3) {s, s, s} : (vec3) {s, 1.0f, 0.5f}
+        );
+    }
+
+    // before: (P * V * M) * p as written, FragPos = M * p again and
+    // transpose(inverse(M)) for every vertex
+    double checksum = 0.0;
+    Uint64 start = SDL_GetTicksNS ();
+    for (Uint32 frame = 0; frame < NORMAL_FRAMES; frame++) {
+        for (Uint32 o = 0; o < NORMAL_OBJECTS; o++) {
+            for (Uint32 v = 0; v < count; v++) {
+                vec4 p = {positions[v].x, positions[v].y, positions[v].z, 1.0f};
+                mat4 mvp;
+                mat4_multiply (mvp, proj, view);
+                mat4_multiply (mvp, mvp, models[o]);
+                vec4 clip = mat4_mul_vec4 (mvp, p);
+                vec4 world = mat4_mul_vec4 (models[o], p);
+                mat4 inv;
+                mat4_inverse (inv, models[o]);
+                vec3 n = {
+                    inv[0] * p.x + inv[1] * p.y + inv[2] * p.z,
+                    inv[4] * p.x + inv[5] * p.y + inv[6] * p.z,
+                    inv[8] * p.x + inv[9] * p.y + inv[10] * p.z,
+                };
+                checksum += clip.w + world.x + n.y;
+            }
+        }
+    }
+    Uint64 before_ns = SDL_GetTicksNS () - start;
+
+    // after: normal matrices once per object, one model transform per vertex
+    start = SDL_GetTicksNS ();
+    for (Uint32 frame = 0; frame < NORMAL_FRAMES; frame++) {
+        for (Uint32 o = 0; o < NORMAL_OBJECTS; o++) {
+            mat3 normal;
+            mat3_normal (normal, models[o]);
+            for (Uint32 v = 0; v < count; v++) {
+                vec4 p = {positions[v].x, positions[v].y, positions[v].z, 1.0f};
+                vec4 world = mat4_mul_vec4 (models[o], p);
+                vec4 clip = mat4_mul_vec4 (view_proj, world);
+                vec3 n = mat3_mul_vec3 (normal, positions[v]);
+                checksum += clip.w + world.x + n.y;
+            }
+        }
+    }
+    Uint64 after_ns = SDL_GetTicksNS () - start;
+
+    Uint64 vertices = (Uint64) count * NORMAL_OBJECTS * NORMAL_FRAMES;
+    printf (
+        "normals: %u-vertex sphere x %u objects, %u frames (checksum %.1f)\n",
+        count, NORMAL_OBJECTS, NORMAL_FRAMES, checksum
+    );
+    printf (
+        "  per-vertex inverse: %8.2f ms/frame, %7.1f Mverts/s\n",
+        ns_to_ms (before_ns) / NORMAL_FRAMES,
+        (double) vertices / ((double) before_ns / 1e3)
+    );
+    printf (
+        "  precomputed:        %8.2f ms/frame, %7.1f Mverts/s (%.1fx)\n",
+        ns_to_ms (after_ns) / NORMAL_FRAMES,
+        (double) vertices / ((double) after_ns / 1e3),
+        (double) before_ns / (double) SDL_max (after_ns, 1)
+    );
+
+    free (positions);
+}
+
+static void bench_lights_case (Uint32 count) {
+    vec4* lights = malloc (count * sizeof (vec4));
+    vec3* base = malloc (count * sizeof (vec3));
+    PAL_LightGrid* grid = PAL_CreateLightGrid ();
+    if (!lights || !base || !grid) {
+        SDL_Log ("Failed to allocate benchmark data");
+        free (lights);
+        free (base);
+        PAL_DestroyLightGrid (grid);
+        return;
+    }
+
+    // camera at the origin looking down +z
+    mat4 proj;
+    mat4_perspective (
+        proj, 70.0f * (float) M_PI / 180.0f, 16.0f / 9.0f, 0.1f, 1000.0f
+    );
+    PAL_LightGridView view = {
+        .proj_x = proj[MAT4_IDX (0, 0)],
+        .proj_y = proj[MAT4_IDX (1, 1)],
+        .near_clip = 0.1f,
+        .far_clip = 1000.0f,
+    };
+    mat4_identity (view.view);
+
+    // lights spread through the visible volume, each reaching a few units
+    for (Uint32 i = 0; i < count; i++) {
+        float z = random_float_range (1.0f, LIGHT_DEPTH);
+        base[i] = (vec3) {
+            random_float_range (-1.0f, 1.0f) * z / view.proj_x,
+            random_float_range (-1.0f, 1.0f) * z / view.proj_y,
+            z,
+        };
+        lights[i].w = random_float_range (2.0f, 8.0f);
+    }
+
+    // every light moves every frame
+    Uint64 build_ns = 0;
+    for (Uint32 frame = 0; frame < LIGHT_FRAMES; frame++) {
+        for (Uint32 i = 0; i < count; i++) {
+            float t = (float) frame * 0.1f + (float) i;
+            lights[i].x = base[i].x + sinf (t) * 2.0f;
+            lights[i].y = base[i].y + cosf (t) * 2.0f;
+            lights[i].z = base[i].z;
+        }
+        Uint64 start = SDL_GetTicksNS ();
+        PAL_LightGridBuild (grid, &view, lights, count);
+        build_ns += SDL_GetTicksNS () - start;
+    }
+
+    // fragments at random pixels and depths, looked up like the shader
+    // does; a light missing from a fragment's cluster would be a bug
+    PAL_LightGridOutput out = PAL_LightGridGetOutput (grid);
+    Uint64 visited = 0;
+    Uint64 reaching = 0;
+    Uint32 missed = 0;
+    for (Uint32 s = 0; s < LIGHT_SAMPLES; s++) {
+        float u = random_float_range (0.0f, 1.0f);
+        float v = random_float_range (0.0f, 1.0f);
+        float depth = random_float_range (1.0f, LIGHT_DEPTH);
+        vec3 p = {
+            (u * 2.0f - 1.0f) * depth / view.proj_x,
+            (1.0f - v * 2.0f) * depth / view.proj_y,
+            depth,
+        };
+        Uint32 x = SDL_min ((Uint32) (u * PAL_LIGHT_GRID_X), GRID_LAST_X);
+        Uint32 y = SDL_min ((Uint32) (v * PAL_LIGHT_GRID_Y), GRID_LAST_Y);
+        float slice = logf (depth) * out.slice_scale + out.slice_bias;
+        Uint32 z = (Uint32) SDL_clamp (slice, 0.0f, PAL_LIGHT_GRID_Z - 1.0f);
+        PAL_LightCluster cluster =
+            out.clusters[(z * PAL_LIGHT_GRID_Y + y) * PAL_LIGHT_GRID_X + x];
+        visited += cluster.count;
+
+        for (Uint32 i = 0; i < count; i++) {
+            vec3 d = {p.x - lights[i].x, p.y - lights[i].y, p.z - lights[i].z};
+            if (vec3_dot (d, d) >= lights[i].w * lights[i].w) continue;
+            reaching++;
+            bool listed = false;
+            for (Uint32 k = 0; k < cluster.count && !listed; k++) {
+                listed = out.indices[cluster.offset + k] == i;
+            }
+            if (!listed) missed++;
+        }
+    }
+
+    printf (
+        "  %5u lights: build %6.3f ms/frame, %7u entries, lights per "
+        "fragment %5u -> %6.2f (%.2f reach it), %u missed\n",
+        count, ns_to_ms (build_ns) / LIGHT_FRAMES, out.num_indices, count,
+        (double) visited / LIGHT_SAMPLES, (double) reaching / LIGHT_SAMPLES,
+        missed
+    );
+
+    free (lights);
+    free (base);
+    PAL_DestroyLightGrid (grid);
+}
+
+static void bench_lights (void) {
+    printf (
+        "lights: %ux%ux%u clusters, %u frames, %u fragment samples\n",
+        PAL_LIGHT_GRID_X, PAL_LIGHT_GRID_Y, PAL_LIGHT_GRID_Z, LIGHT_FRAMES,
+        LIGHT_SAMPLES
+    );
+    const Uint32 counts[] = {64, 256, 1024, 4096};
+    for (Uint32 i = 0; i < SDL_arraysize (counts); i++) {
+        bench_lights_case (counts[i]);
+    }
+}
+
+int main (int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "bvh";
+    random_seed (1234);
+
+    if (strcmp (mode, "bvh") == 0) {
+        bench_bvh ();
+    } else if (strcmp (mode, "occlusion") == 0) {
+        bench_occlusion ();
+    } else if (strcmp (mode, "lod") == 0) {
+        bench_lod ();
+    } else if (strcmp (mode, "normals") == 0) {
+        bench_normals ();
+    } else if (strcmp (mode, "lights") == 0) {
+        bench_lights ();
+    } else {
+        printf ("usage: %s [bvh|occlusion|lod|normals|lights]\n", argv[0]);
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
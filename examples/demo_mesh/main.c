@@ -8,6 +8,8 @@
 
 #include <microui.h>
 
+#include <geometry/g_common.h>
+
 #include <geometry/circle.h>
 #include <geometry/plane.h>
 #include <geometry/ring.h>
@@ -67,7 +69,6 @@ typedef struct {
     Uint64 frame_count;
     bool debug;
     bool settings;
-    SDL_GPUTexture* white_texture;
 } AppState;
 
 static Uint32
@@ -105,16 +106,18 @@ SDL_AppResult SDL_AppEvent (void* appstate, SDL_Event* event) {
         if (event->key.key == SDLK_F3) state->debug = !state->debug;
         if (event->key.key == SDLK_UP) {
             if (state->current_mesh < GEO_TORUS) {
-                PAL_MeshComponent* current_mesh =
-                    PAL_GetMeshComponent (state->entity);
-                *current_mesh = *state->meshes[++state->current_mesh];
+                PAL_AddMeshComponent (
+                    state->renderer->device, state->entity,
+                    state->meshes[++state->current_mesh]
+                );
             }
         }
         if (event->key.key == SDLK_DOWN) {
             if (state->current_mesh > GEO_CIRCLE) {
-                PAL_MeshComponent* current_mesh =
-                    PAL_GetMeshComponent (state->entity);
-                *current_mesh = *state->meshes[--state->current_mesh];
+                PAL_AddMeshComponent (
+                    state->renderer->device, state->entity,
+                    state->meshes[--state->current_mesh]
+                );
             }
         }
         break;
@@ -181,17 +184,17 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
         .device = device,
         .window = window,
         .width = STARTING_WIDTH,
-        .height = STARTING_HEIGHT
+        .height = STARTING_HEIGHT,
+        // latency over throughput for mouse look: one frame queued, and
+        // mailbox presents the newest frame without tearing
+        .frames_in_flight = 1,
+        .present_mode = SDL_GPU_PRESENTMODE_MAILBOX
     };
     state->renderer = renderer_init (&renderer_info);
     if (state->renderer == NULL) {
         return SDL_APP_FAILURE;
     }
 
-    // load texture
-    state->white_texture = create_white_texture (state->renderer->device);
-    if (state->white_texture == NULL) return SDL_APP_FAILURE;
-
     // player
     state->player = create_entity ();
     PAL_TransformCreateInfo player_transform_info = {
@@ -346,7 +349,7 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
         .theta_length = (float) M_PI,
         .device = state->renderer->device,
     };
-    state->meshes[GEO_SPHERE] = PAL_CreateSphereMesh (&sphere_info);
+    state->meshes[GEO_SPHERE] = PAL_CreateSphereMeshLODs (&sphere_info, 4);
     if (state->meshes[GEO_SPHERE] == NULL) return SDL_APP_FAILURE;
 
     // torus
@@ -358,32 +361,21 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
         .arc = (float) M_PI * 2.0f,
         .device = state->renderer->device
     };
-    state->meshes[GEO_TORUS] = PAL_CreateTorusMesh (&torus_info);
+    state->meshes[GEO_TORUS] = PAL_CreateTorusMeshLODs (&torus_info, 4);
     if (state->meshes[GEO_TORUS] == NULL) return SDL_APP_FAILURE;
 
-    // add mesh
-    PAL_AddMeshComponent (state->entity, state->meshes[0]);
-
-    // torus material
-    SDL_GPUSamplerCreateInfo torus_sampler_info = {
-        .min_filter = SDL_GPU_FILTER_LINEAR,
-        .mag_filter = SDL_GPU_FILTER_LINEAR,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
-        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .max_anisotropy = 1.0f,
-        .enable_anisotropy = false
-    };
-    SDL_GPUSampler* torus_sampler =
-        SDL_CreateGPUSampler (state->renderer->device, &torus_sampler_info);
+    // keep every mesh alive while it's swapped out, then add the first
+    for (Uint32 i = 0; i <= GEO_TORUS; i++) PAL_RetainMesh (state->meshes[i]);
+    PAL_AddMeshComponent (
+        state->renderer->device, state->entity, state->meshes[0]
+    );
+
+    // torus material; untextured, so it skips the texture fetch
     PAL_PhongMaterialCreateInfo phong_info = {
         .renderer = state->renderer,
         .color = (SDL_FColor) {1.0f, 1.0f, 1.0f, 1.0f},
         .emissive = (SDL_FColor) {0.0f, 0.0f, 0.0f, 0.0f},
         .cullmode = SDL_GPU_CULLMODE_BACK,
-        .texture = state->white_texture,
-        .sampler = torus_sampler
     };
     PAL_MaterialComponent* torus_material =
         PAL_CreatePhongMaterial (&phong_info);
@@ -401,7 +393,6 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     Entity ambient_light = create_entity ();
     PAL_AmbientLightCreateInfo ambient_info = {
         .color = (SDL_FColor) {1.0f, 1.0f, 1.0f, 0.1f},
-        .renderer = state->renderer
     };
     add_ambient_light (ambient_light, &ambient_info);
 
@@ -415,7 +406,7 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     add_transform (point_light, &point_light_transform_info);
     PAL_PointLightCreateInfo point_light_info = {
         .color = (SDL_FColor) {1.0f, 1.0f, 1.0f, 1.0f},
-        .renderer = state->renderer
+        .radius = 20.0f,
     };
     add_point_light (point_light, &point_light_info);
 
@@ -518,19 +509,23 @@ SDL_AppResult SDL_AppIterate (void* appstate) {
 void SDL_AppQuit (void* appstate, SDL_AppResult result) {
     AppState* state = (AppState*) appstate;
 
+    // let queued frames finish before their resources go
+    renderer_quit (state->renderer);
+
     UIComponent ui = *(get_ui (state->player));
 
     if (ui.rects) free (ui.rects);
     if (ui.pipeline)
         SDL_ReleaseGPUGraphicsPipeline (state->renderer->device, ui.pipeline);
     if (ui.fragment)
-        SDL_ReleaseGPUShader (state->renderer->device, ui.fragment);
-    if (ui.vertex) SDL_ReleaseGPUShader (state->renderer->device, ui.vertex);
+        PAL_ReleaseShader (state->renderer->device, ui.fragment);
+    if (ui.vertex) PAL_ReleaseShader (state->renderer->device, ui.vertex);
 
-    free_pools (state->renderer->device);
-    if (state->white_texture) {
-        SDL_ReleaseGPUTexture (state->renderer->device, state->white_texture);
+    // before free_pools, which destroys the mesh arena
+    for (Uint32 i = 0; i <= GEO_TORUS; i++) {
+        PAL_ReleaseMesh (state->renderer->device, state->meshes[i]);
     }
+    free_pools (state->renderer->device);
     // TODO: update free pools lol
     // if (state->renderer->sampler) {
     //     SDL_ReleaseGPUSampler (state->renderer->device,
@@ -541,5 +536,38 @@ void SDL_AppQuit (void* appstate, SDL_AppResult result) {
             state->renderer->device, state->renderer->depth_texture
         );
     }
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->object_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->indirect_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->instance_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->cluster_ssbo
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->color_target
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->gbuffer_albedo
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->gbuffer_normal
+    );
+    PAL_ReleaseSampler (
+        state->renderer->device, state->renderer->gbuffer_sampler
+    );
+    SDL_ReleaseGPUGraphicsPipeline (
+        state->renderer->device, state->renderer->lighting_pipeline
+    );
+    PAL_DestroyUploadRing (state->renderer->upload);
+    PAL_DestroyOcclusionBuffer (state->renderer->occlusion);
+    PAL_DestroyGPUCuller (state->renderer->culler);
+    PAL_DestroyLightGrid (state->renderer->light_grid);
+    free (state->renderer->light_spheres);
+    free (state->renderer->draw_list);
     free (state->renderer);
 }
\ No newline at end of file
@@ -0,0 +1,326 @@
+#define SDL_MAIN_USE_CALLBACKS 1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL_main.h>
+
+#include <ecs/ecs.h>
+#include <geometry/g_common.h>
+#include <geometry/plane.h>
+#include <material/m_common.h>
+#include <material/phong_material.h>
+
+#define STARTING_WIDTH 1280
+#define STARTING_HEIGHT 720
+#define STARTING_FOV 70.0
+#define LAYERS 32         // screen-filling planes stacked in depth
+#define LAYER_SPACING 0.25f
+#define POINT_LIGHTS 512
+#define REPORT_FRAMES 100 // frames averaged per report
+
+// Overdraw benchmark: every pixel is covered by LAYERS lit planes. Draws
+// are ordered by material state rather than depth, so the forward path
+// shades most covered layers against the clustered lights, while the
+// deferred path only writes the G-buffer per layer and lights each pixel
+// once. A depth pre-pass ("prepass") also shades each pixel once, at the
+// cost of drawing the geometry twice. Run with the options to compare:
+//   overdraw [deferred] [prepass] [textured] [ambient]
+// The forward path wins when layers are few and lights are cheap; the
+// others win as overdraw and light counts grow. The planes are untextured
+// unless "textured" has them sample 1x1 white layers of one texture array,
+// and "ambient" leaves out the point lights, so the shader variants without
+// the texture fetch and the cluster lookup can be compared with the full
+// one.
+typedef struct {
+    bool quit;
+    PAL_GPURenderer* renderer;
+    Entity camera_entity;
+    SDL_GPUSampler* sampler;
+    Uint64 report_start;
+    Uint64 frame_count;
+} AppState;
+
+SDL_AppResult SDL_AppEvent (void* appstate, SDL_Event* event) {
+    AppState* state = (AppState*) appstate;
+
+    switch (event->type) {
+    case SDL_EVENT_QUIT:
+        state->quit = true;
+        break;
+    case SDL_EVENT_KEY_DOWN:
+        if (event->key.key == SDLK_ESCAPE) state->quit = true;
+        break;
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+static float randf (void) {
+    return (float) rand () / (float) RAND_MAX;
+}
+
+SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
+    SDL_SetAppMetadata (
+        "Asmadi Engine Overdraw Benchmark", "0.1.0", "xyz.lukeh.Asmadi-Engine"
+    );
+
+    bool deferred = false;
+    bool depth_prepass = false;
+    bool textured = false;
+    Uint32 point_lights = POINT_LIGHTS;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp (argv[i], "deferred") == 0) deferred = true;
+        if (strcmp (argv[i], "prepass") == 0) depth_prepass = true;
+        if (strcmp (argv[i], "textured") == 0) textured = true;
+        if (strcmp (argv[i], "ambient") == 0) point_lights = 0;
+    }
+
+    // create appstate
+    AppState* state = (AppState*) calloc (1, sizeof (AppState));
+    state->camera_entity = (Entity) -1;
+
+    // initialize SDL
+    if (!SDL_Init (SDL_INIT_VIDEO)) {
+        SDL_Log ("Couldn't initialize SDL: %s", SDL_GetError ());
+        return SDL_APP_FAILURE;
+    }
+
+    // Create window
+    SDL_Window* window = SDL_CreateWindow (
+        "Overdraw Benchmark", STARTING_WIDTH, STARTING_HEIGHT,
+        SDL_WINDOW_VULKAN
+    );
+    if (!window) {
+        SDL_Log ("Couldn't create window/renderer: %s", SDL_GetError ());
+        return SDL_APP_FAILURE;
+    }
+
+    // create GPU device
+    SDL_GPUDevice* device =
+        SDL_CreateGPUDevice (SDL_GPU_SHADERFORMAT_SPIRV, false, NULL);
+    if (!device) {
+        SDL_Log ("Couldn't create SDL_GPU_DEVICE");
+        return SDL_APP_FAILURE;
+    }
+    if (!SDL_ClaimWindowForGPUDevice (device, window)) {
+        SDL_Log ("Couldn't claim window for GPU device: %s", SDL_GetError ());
+        return SDL_APP_FAILURE;
+    }
+
+    PAL_RendererCreateInfo renderer_info = {
+        .device = device,
+        .window = window,
+        .width = STARTING_WIDTH,
+        .height = STARTING_HEIGHT,
+        .gpu_culling = true,
+        .deferred = deferred,
+        .depth_prepass = depth_prepass,
+        // throughput over latency: frame times would be capped at the
+        // refresh rate with vsync, and queueing frames keeps the GPU busy
+        .frames_in_flight = 3,
+        .present_mode = SDL_GPU_PRESENTMODE_IMMEDIATE
+    };
+    state->renderer = renderer_init (&renderer_info);
+    if (state->renderer == NULL) {
+        return SDL_APP_FAILURE;
+    }
+    printf (
+        "%s shading%s, %d %s layers, %u point lights\n",
+        state->renderer->deferred ? "deferred" : "forward",
+        depth_prepass ? " with a depth pre-pass" : "", LAYERS,
+        textured ? "textured" : "untextured", point_lights
+    );
+
+    // every startup upload goes out in one copy pass
+    PAL_UploadBatch* batch =
+        PAL_BeginUploadBatch (state->renderer->device, 1 << 20);
+    if (batch == NULL) return SDL_APP_FAILURE;
+
+    if (textured) {
+        // each layer's material takes its own reference
+        state->sampler = PAL_AcquirePresetSampler (
+            state->renderer->device, PAL_SAMPLER_LINEAR_REPEAT
+        );
+        if (!state->sampler) return SDL_APP_FAILURE;
+    }
+
+    // the layers share one template and differ in colour only
+    PAL_MaterialTemplate* phong = PAL_CreatePhongTemplate (
+        state->renderer, SDL_GPU_CULLMODE_NONE, textured
+    );
+    if (phong == NULL) return SDL_APP_FAILURE;
+
+    // planes wide enough to fill the view at any layer
+    for (int i = LAYERS - 1; i >= 0; i--) {
+        Entity layer = create_entity ();
+
+        PAL_PlaneMeshCreateInfo mesh_info = {
+            .width = 64.0f,
+            .height = 36.0f,
+            .width_segments = 1,
+            .height_segments = 1,
+            .device = state->renderer->device,
+            .batch = batch
+        };
+        PAL_MeshComponent* plane_mesh =
+            PAL_CreateSharedMesh (Plane, &mesh_info);
+        if (plane_mesh == NULL) return SDL_APP_FAILURE;
+        PAL_AddMeshComponent (state->renderer->device, layer, plane_mesh);
+
+        // one array layer per plane, so they still draw as one batch
+        PAL_TextureLayer texture = {0};
+        if (textured) {
+            texture =
+                PAL_CreateWhiteTextureLayer (state->renderer->device, batch);
+            if (texture.array == NULL) return SDL_APP_FAILURE;
+        }
+        PAL_PhongMaterialCreateInfo mat_info = {
+            .renderer = state->renderer,
+            .tmpl = phong,
+            .color = (SDL_FColor) {randf (), randf (), randf (), 1.0f},
+            .emissive = (SDL_FColor) {0.0f, 0.0f, 0.0f, 0.0f},
+            .texture = texture,
+            .sampler = state->sampler
+        };
+        PAL_MaterialComponent* plane_material =
+            PAL_CreatePhongMaterial (&mat_info);
+        if (plane_material == NULL) return SDL_APP_FAILURE;
+        PAL_AddMaterialComponent (layer, plane_material);
+
+        PAL_TransformCreateInfo transform_info = {
+            .position = (vec3) {0.0f, 0.0f, 4.0f + LAYER_SPACING * (float) i},
+            .rotation = (vec3) {0.0f, 0.0f, 0.0f},
+            .scale = (vec3) {1.0f, 1.0f, 1.0f}
+        };
+        add_transform (layer, &transform_info);
+    }
+
+    SDL_GPUFence* upload_fence = NULL;
+    if (!PAL_SubmitUploadBatch (batch, &upload_fence)) return SDL_APP_FAILURE;
+    SDL_WaitForGPUFences (state->renderer->device, true, &upload_fence, 1);
+    SDL_ReleaseGPUFence (state->renderer->device, upload_fence);
+
+    // ambient light
+    Entity ambient_light = create_entity ();
+    PAL_AmbientLightCreateInfo ambient_info = {
+        .color = (SDL_FColor) {1.0f, 1.0f, 1.0f, 0.1f},
+    };
+    add_ambient_light (ambient_light, &ambient_info);
+
+    // lights in front of and between the layers, so every layer is lit
+    for (Uint32 i = 0; i < point_lights; i++) {
+        Entity point_light = create_entity ();
+        PAL_PointLightCreateInfo point_light_info = {
+            .color = (SDL_FColor) {randf (), randf (), randf (), 1.0f},
+            .radius = 3.0f,
+        };
+        add_point_light (point_light, &point_light_info);
+
+        PAL_TransformCreateInfo light_transform_info = {
+            .position = (vec3) {(randf () - 0.5f) * 12.0f,
+                                (randf () - 0.5f) * 7.0f,
+                                3.0f + randf () * LAYER_SPACING * LAYERS},
+            .rotation = (vec3) {0.0f, 0.0f, 0.0f},
+            .scale = (vec3) {1.0f, 1.0f, 1.0f}
+        };
+        add_transform (point_light, &light_transform_info);
+    }
+
+    // camera, looking down +z through the layers
+    Entity camera = create_entity ();
+    PAL_TransformCreateInfo camera_transform_info = {
+        .position = (vec3) {0.0f, 0.0f, 0.0f},
+        .rotation = (vec3) {0.0f, 0.0f, 0.0f},
+        .scale = (vec3) {1.0f, 1.0f, 1.0f}
+    };
+    add_transform (camera, &camera_transform_info);
+
+    PAL_CameraCreateInfo camera_info =
+        {.fov = STARTING_FOV, .near_clip = 0.1f, .far_clip = 100.0f};
+    add_camera (camera, &camera_info);
+
+    state->camera_entity = camera;
+    state->report_start = SDL_GetTicksNS ();
+
+    *appstate = state;
+    return SDL_APP_CONTINUE;
+}
+
+SDL_AppResult SDL_AppIterate (void* appstate) {
+    AppState* state = (AppState*) appstate;
+    if (state->quit) return SDL_APP_SUCCESS;
+
+    Uint64 prerender, preui, postrender;
+    SDL_AppResult result = render_system (
+        state->renderer, state->camera_entity, &prerender, &preui, &postrender
+    );
+    if (result != SDL_APP_CONTINUE) return result;
+
+    // wall time per frame; with the camera still it is bound by the GPU
+    if (++state->frame_count % REPORT_FRAMES == 0) {
+        Uint64 now = SDL_GetTicksNS ();
+        double frame_ms =
+            (double) (now - state->report_start) / 1e6 / REPORT_FRAMES;
+        printf (
+            "%.3f ms/frame, %u draw calls, %u pre-pass draw calls\n",
+            frame_ms, state->renderer->stats.draw_calls,
+            state->renderer->stats.prepass_draw_calls
+        );
+        state->report_start = now;
+    }
+
+    return SDL_APP_CONTINUE;
+}
+
+void SDL_AppQuit (void* appstate, SDL_AppResult result) {
+    AppState* state = (AppState*) appstate;
+
+    // let queued frames finish before their resources go
+    renderer_quit (state->renderer);
+
+    free_pools (state->renderer->device);
+    if (state->sampler) {
+        PAL_ReleaseSampler (state->renderer->device, state->sampler);
+    }
+    if (state->renderer->depth_texture) {
+        SDL_ReleaseGPUTexture (
+            state->renderer->device, state->renderer->depth_texture
+        );
+    }
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->object_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->indirect_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->instance_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->cluster_ssbo
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->color_target
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->gbuffer_albedo
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->gbuffer_normal
+    );
+    PAL_ReleaseSampler (
+        state->renderer->device, state->renderer->gbuffer_sampler
+    );
+    SDL_ReleaseGPUGraphicsPipeline (
+        state->renderer->device, state->renderer->lighting_pipeline
+    );
+    PAL_DestroyUploadRing (state->renderer->upload);
+    PAL_DestroyOcclusionBuffer (state->renderer->occlusion);
+    PAL_DestroyGPUCuller (state->renderer->culler);
+    PAL_DestroyLightGrid (state->renderer->light_grid);
+    free (state->renderer->light_spheres);
+    free (state->renderer->draw_list);
+    free (state->renderer);
+}
\ No newline at end of file
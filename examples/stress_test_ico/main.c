@@ -8,6 +8,7 @@
 #include <SDL3/SDL_main.h>
 
 #include <ecs/ecs.h>
+#include <geometry/g_common.h>
 #include <geometry/icosahedron.h>
 #include <material/m_common.h>
 #include <material/phong_material.h>
@@ -17,16 +18,17 @@
 #define STARTING_FOV 70.0
 #define MOUSE_SENSE 1.0f / 100.0f
 #define MOVEMENT_SPEED 3.0f
+#define POINT_LIGHTS 1024
 
 typedef struct {
     bool quit;
     PAL_GPURenderer* renderer;
     Entity camera_entity;
-    SDL_GPUTexture* white_texture;
     Uint64 last_time;
 } AppState;
 
 Entity icosahedrons[8000];
+Entity point_lights[POINT_LIGHTS];
 
 Uint64 frame_start;
 Uint64 rot_time;
@@ -97,34 +99,31 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
         .device = device,
         .window = window,
         .width = STARTING_WIDTH,
-        .height = STARTING_HEIGHT
+        .height = STARTING_HEIGHT,
+        .gpu_culling = true,
+        // drop to half resolution rather than below 60 fps
+        .min_render_scale = 0.5f,
+        .target_frame_ms = 16.7f,
+        // record frames while the next one is simulated
+        .render_thread = true
     };
     state->renderer = renderer_init (&renderer_info);
     if (state->renderer == NULL) {
         return SDL_APP_FAILURE;
     }
 
-    // load texture
-    state->white_texture = create_white_texture (state->renderer->device);
-    if (!state->white_texture) return SDL_APP_FAILURE;
-
-    // create sampler
-    SDL_GPUSamplerCreateInfo sampler_info = {
-        .min_filter = SDL_GPU_FILTER_LINEAR,
-        .mag_filter = SDL_GPU_FILTER_LINEAR,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
-        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .max_anisotropy = 1.0f,
-        .enable_anisotropy = false
-    };
-    SDL_GPUSampler* sampler =
-        SDL_CreateGPUSampler (state->renderer->device, &sampler_info);
-    if (!sampler) {
-        SDL_Log ("Failed to create sampler: %s", SDL_GetError ());
-        return SDL_APP_FAILURE;
-    }
+    // every startup upload goes out in one copy pass
+    PAL_UploadBatch* batch =
+        PAL_BeginUploadBatch (state->renderer->device, 8 << 20);
+    if (batch == NULL) return SDL_APP_FAILURE;
+
+    // every icosahedron is an instance of one untextured template, so only
+    // their parameters differ. It is built on the material loader thread;
+    // the icosahedra appear once it is ready.
+    PAL_MaterialTemplate* phong = PAL_LoadPhongTemplate (
+        state->renderer, SDL_GPU_CULLMODE_BACK, false, NULL
+    );
+    if (phong == NULL) return SDL_APP_FAILURE;
 
     // spawn 8k icosahedrons
     for (int i = -10; i < 10; i++) {
@@ -135,12 +134,16 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
 
                 PAL_IcosahedronMeshCreateInfo mesh_info = {
                     .radius = 0.5f,
-                    .device = state->renderer->device
+                    .device = state->renderer->device,
+                    .batch = batch
                 };
+                // one shared mesh for all 8000 entities
                 PAL_MeshComponent* icosahedron_mesh =
-                    PAL_CreateIcosahedronMesh (&mesh_info);
+                    PAL_CreateSharedMesh (Icosahedron, &mesh_info);
                 if (icosahedron_mesh == NULL) return SDL_APP_FAILURE;
-                PAL_AddMeshComponent (ico, icosahedron_mesh);
+                PAL_AddMeshComponent (
+                    state->renderer->device, ico, icosahedron_mesh
+                );
 
                 float r = (float) rand () / (float) RAND_MAX;
                 float g = (float) rand () / (float) RAND_MAX;
@@ -148,11 +151,9 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
 
                 PAL_PhongMaterialCreateInfo mat_info = {
                     .renderer = state->renderer,
+                    .tmpl = phong,
                     .color = (SDL_FColor) {r, g, b, 1.0f},
                     .emissive = (SDL_FColor) {0.0f, 0.0f, 0.0f, 0.0f},
-                    .cullmode = SDL_GPU_CULLMODE_BACK,
-                    .texture = state->white_texture,
-                    .sampler = sampler
                 };
                 PAL_MaterialComponent* icosahedron_material =
                     PAL_CreatePhongMaterial (&mat_info);
@@ -176,29 +177,37 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
         printf ("spawned %d icos\n", (i + 11) * 400);
     }
 
+    SDL_GPUFence* upload_fence = NULL;
+    if (!PAL_SubmitUploadBatch (batch, &upload_fence)) return SDL_APP_FAILURE;
+    SDL_WaitForGPUFences (state->renderer->device, true, &upload_fence, 1);
+    SDL_ReleaseGPUFence (state->renderer->device, upload_fence);
+
     // ambient light
     Entity ambient_light = create_entity ();
     PAL_AmbientLightCreateInfo ambient_info = {
         .color = (SDL_FColor) {1.0f, 1.0f, 1.0f, 0.1f},
-        .renderer = state->renderer
     };
     add_ambient_light (ambient_light, &ambient_info);
 
-    // four point lights for now
-    for (Uint32 i = 0; i < 4; i++) {
+    // a thousand small coloured point lights through the grid; clustered
+    // shading keeps each fragment to the few that reach it
+    for (Uint32 i = 0; i < POINT_LIGHTS; i++) {
         Entity point_light = create_entity ();
+        point_lights[i] = point_light;
         PAL_PointLightCreateInfo point_light_info = {
-            .color = (SDL_FColor) {1.0f, 1.0f, 1.0f, 1.0f},
-            .renderer = state->renderer
+            .color = (SDL_FColor) {(float) rand () / (float) RAND_MAX,
+                                   (float) rand () / (float) RAND_MAX,
+                                   (float) rand () / (float) RAND_MAX, 1.0f},
+            .radius = 4.0f,
         };
         add_point_light (point_light, &point_light_info);
 
-        int px = (rand () % 101) - 50;
-        int py = (rand () % 101) - 50;
-        int pz = (rand () % 101) - 50;
+        int px = (rand () % 40) - 20;
+        int py = (rand () % 40) - 20;
+        int pz = (rand () % 40) - 20;
         PAL_TransformCreateInfo light_transform_info = {
-            .position = (vec3) {(float) (px * 2 + 1), (float) (py * 2 + 1),
-                                (float) (pz * 2 + 1)},
+            .position = (vec3) {(float) px + 0.5f, (float) py + 0.5f,
+                                (float) pz + 0.5f},
             .rotation = (vec3) {0.0f, 0.0f, 0.0f},
             .scale = (vec3) {1.0f, 1.0f, 1.0f}
         };
@@ -266,6 +275,14 @@ SDL_AppResult SDL_AppIterate (void* appstate) {
         add_transform (icosahedron, &transform_info);
     }
 
+    // the lights bob up and down; only moved lights are restaged
+    float seconds = (float) SDL_GetTicks () / 1000.0f;
+    for (Uint32 i = 0; i < POINT_LIGHTS; i++) {
+        TransformComponent* light_trans = get_transform (point_lights[i]);
+        light_trans->position.y += sinf (seconds + (float) i) * dt;
+        mark_transform_dirty (point_lights[i]);
+    }
+
     rot_time = SDL_GetTicksNS () - frame_start;
     rot_time_ms = rot_time / 1e6;
 
@@ -288,14 +305,47 @@ SDL_AppResult SDL_AppIterate (void* appstate) {
 void SDL_AppQuit (void* appstate, SDL_AppResult result) {
     AppState* state = (AppState*) appstate;
 
+    // let queued frames finish before their resources go
+    renderer_quit (state->renderer);
+
     free_pools (state->renderer->device);
-    if (state->white_texture) {
-        SDL_ReleaseGPUTexture (state->renderer->device, state->white_texture);
-    }
     if (state->renderer->depth_texture) {
         SDL_ReleaseGPUTexture (
             state->renderer->device, state->renderer->depth_texture
         );
     }
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->object_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->indirect_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->instance_buffer
+    );
+    SDL_ReleaseGPUBuffer (
+        state->renderer->device, state->renderer->cluster_ssbo
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->color_target
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->gbuffer_albedo
+    );
+    SDL_ReleaseGPUTexture (
+        state->renderer->device, state->renderer->gbuffer_normal
+    );
+    PAL_ReleaseSampler (
+        state->renderer->device, state->renderer->gbuffer_sampler
+    );
+    SDL_ReleaseGPUGraphicsPipeline (
+        state->renderer->device, state->renderer->lighting_pipeline
+    );
+    PAL_DestroyUploadRing (state->renderer->upload);
+    PAL_DestroyOcclusionBuffer (state->renderer->occlusion);
+    PAL_DestroyGPUCuller (state->renderer->culler);
+    PAL_DestroyLightGrid (state->renderer->light_grid);
+    free (state->renderer->light_spheres);
+    free (state->renderer->draw_list);
     free (state->renderer);
-}
+}
\ No newline at end of file
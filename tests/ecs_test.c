@@ -0,0 +1,51 @@
+#include <stdio.h>
+
+#include <SDL3/SDL.h>
+
+#include <ecs/ecs.h>
+
+// Component pools without a renderer. Billboards are a flag pool with no
+// data, which has to keep growing past its first 64 entries like the rest.
+#define ENTITIES 100
+
+static int failures = 0;
+
+#define CHECK(cond, what)                                                      \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf ("FAIL %s\n", what);                                        \
+            failures++;                                                        \
+        }                                                                      \
+    } while (0)
+
+static Uint32 count_billboards (const Entity* entities) {
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < ENTITIES; i++) {
+        if (has_billboard (entities[i])) count++;
+    }
+    return count;
+}
+
+int main (void) {
+    Entity entities[ENTITIES];
+    for (Uint32 i = 0; i < ENTITIES; i++) {
+        entities[i] = create_entity ();
+        add_billboard (entities[i]);
+    }
+    CHECK (count_billboards (entities) == ENTITIES, "every billboard kept");
+
+    // swap-and-pop removal moves the last entries into the holes
+    for (Uint32 i = 0; i < ENTITIES; i += 3) remove_billboard (entities[i]);
+    bool kept = true;
+    for (Uint32 i = 0; i < ENTITIES; i++) {
+        kept &= has_billboard (entities[i]) == (i % 3 != 0);
+    }
+    CHECK (kept, "only removed billboards gone");
+
+    for (Uint32 i = 0; i < ENTITIES; i += 3) add_billboard (entities[i]);
+    CHECK (count_billboards (entities) == ENTITIES, "billboards added back");
+
+    free_pools (NULL);
+    if (failures == 0) printf ("ecs: ok\n");
+    return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,627 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+
+#include "null_gpu.h"
+
+typedef struct NullObject {
+    struct NullObject* next; // every object made, for NullGPU_Quit
+    NullGPUKind kind;
+    bool released;
+    Uint32 size; // buffers and transfer buffers have host memory
+    Uint8* memory;
+    SDL_GPUTextureCreateInfo info; // textures
+} NullObject;
+
+static SDL_SpinLock lock = 0;
+static NullObject* objects = NULL;
+static Uint32 live[NULL_GPU_KINDS];
+static SDL_AtomicInt errors = {0};
+static SDL_AtomicInt texture_copies = {0};
+
+// handles that are never released; only their addresses matter
+static int device;
+static int window;
+static int command_buffer;
+static int copy_pass;
+static int render_pass;
+static int compute_pass;
+static NullObject swapchain = {
+    .kind = NULL_GPU_TEXTURE,
+    .info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM,
+        .width = NULL_GPU_WIDTH,
+        .height = NULL_GPU_HEIGHT,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+    },
+};
+
+static void fail (const char* what, const char* problem) {
+    SDL_Log ("null GPU: %s: %s", what, problem);
+    SDL_AddAtomicInt (&errors, 1);
+}
+
+static void* create (NullGPUKind kind, Uint32 size) {
+    NullObject* object = calloc (1, sizeof (NullObject));
+    if (object == NULL) return NULL;
+    if (size > 0) {
+        object->memory = calloc (1, size);
+        if (object->memory == NULL) {
+            free (object);
+            return NULL;
+        }
+    }
+    object->kind = kind;
+    object->size = size;
+    SDL_LockSpinlock (&lock);
+    object->next = objects;
+    objects = object;
+    live[kind]++;
+    SDL_UnlockSpinlock (&lock);
+    return object;
+}
+
+// the object behind a handle, or NULL after counting an error if there is
+// none, it was released or it is of another kind
+static NullObject*
+use (const void* handle, NullGPUKind kind, const char* what) {
+    NullObject* object = (NullObject*) handle;
+    if (object == NULL) {
+        fail (what, "NULL handle");
+        return NULL;
+    }
+    SDL_LockSpinlock (&lock);
+    bool released = object->released;
+    SDL_UnlockSpinlock (&lock);
+    if (object->kind != kind) {
+        fail (what, "handle of another kind");
+        return NULL;
+    }
+    if (released) {
+        fail (what, "released handle");
+        return NULL;
+    }
+    return object;
+}
+
+static void release (void* handle, NullGPUKind kind, const char* what) {
+    if (handle == NULL) return;
+    NullObject* object = use (handle, kind, what);
+    if (object == NULL) return;
+    SDL_LockSpinlock (&lock);
+    object->released = true;
+    live[kind]--;
+    SDL_UnlockSpinlock (&lock);
+    free (object->memory);
+    object->memory = NULL;
+}
+
+// a texture subresource the texture has
+static bool
+use_subresource (const NullObject* texture, Uint32 level, Uint32 layer) {
+    return level < SDL_max (texture->info.num_levels, 1u) &&
+           layer < SDL_max (texture->info.layer_count_or_depth, 1u);
+}
+
+SDL_GPUDevice* NullGPU_Device (void) {
+    return (SDL_GPUDevice*) &device;
+}
+
+SDL_Window* NullGPU_Window (void) {
+    return (SDL_Window*) &window;
+}
+
+Uint32 NullGPU_Live (NullGPUKind kind) {
+    SDL_LockSpinlock (&lock);
+    Uint32 count = live[kind];
+    SDL_UnlockSpinlock (&lock);
+    return count;
+}
+
+bool NullGPU_Released (const void* object) {
+    SDL_LockSpinlock (&lock);
+    bool released = ((const NullObject*) object)->released;
+    SDL_UnlockSpinlock (&lock);
+    return released;
+}
+
+Uint32 NullGPU_TextureCopies (void) {
+    return (Uint32) SDL_GetAtomicInt (&texture_copies);
+}
+
+Uint32 NullGPU_Errors (void) {
+    return (Uint32) SDL_GetAtomicInt (&errors);
+}
+
+void NullGPU_Quit (void) {
+    SDL_LockSpinlock (&lock);
+    NullObject* object = objects;
+    objects = NULL;
+    memset (live, 0, sizeof (live));
+    SDL_UnlockSpinlock (&lock);
+    while (object) {
+        NullObject* next = object->next;
+        free (object->memory);
+        free (object);
+        object = next;
+    }
+}
+
+// Device
+bool SDL_GPUTextureSupportsFormat (
+    SDL_GPUDevice* device,
+    SDL_GPUTextureFormat format,
+    SDL_GPUTextureType type,
+    SDL_GPUTextureUsageFlags usage
+) {
+    return true;
+}
+
+bool SDL_SetGPUAllowedFramesInFlight (
+    SDL_GPUDevice* device,
+    Uint32 allowed_frames_in_flight
+) {
+    return allowed_frames_in_flight >= 1 && allowed_frames_in_flight <= 3;
+}
+
+bool SDL_WindowSupportsGPUPresentMode (
+    SDL_GPUDevice* device,
+    SDL_Window* window,
+    SDL_GPUPresentMode present_mode
+) {
+    return true;
+}
+
+bool SDL_SetGPUSwapchainParameters (
+    SDL_GPUDevice* device,
+    SDL_Window* window,
+    SDL_GPUSwapchainComposition swapchain_composition,
+    SDL_GPUPresentMode present_mode
+) {
+    return true;
+}
+
+SDL_GPUTextureFormat
+SDL_GetGPUSwapchainTextureFormat (SDL_GPUDevice* device, SDL_Window* window) {
+    return swapchain.info.format;
+}
+
+bool SDL_WaitForGPUIdle (SDL_GPUDevice* device) {
+    return true;
+}
+
+// Resources
+SDL_GPUBuffer* SDL_CreateGPUBuffer (
+    SDL_GPUDevice* device,
+    const SDL_GPUBufferCreateInfo* createinfo
+) {
+    return create (NULL_GPU_BUFFER, createinfo->size);
+}
+
+void SDL_ReleaseGPUBuffer (SDL_GPUDevice* device, SDL_GPUBuffer* buffer) {
+    release (buffer, NULL_GPU_BUFFER, "release buffer");
+}
+
+SDL_GPUTransferBuffer* SDL_CreateGPUTransferBuffer (
+    SDL_GPUDevice* device,
+    const SDL_GPUTransferBufferCreateInfo* createinfo
+) {
+    return create (NULL_GPU_TRANSFER_BUFFER, createinfo->size);
+}
+
+void SDL_ReleaseGPUTransferBuffer (
+    SDL_GPUDevice* device,
+    SDL_GPUTransferBuffer* transfer_buffer
+) {
+    release (
+        transfer_buffer, NULL_GPU_TRANSFER_BUFFER, "release transfer buffer"
+    );
+}
+
+void* SDL_MapGPUTransferBuffer (
+    SDL_GPUDevice* device,
+    SDL_GPUTransferBuffer* transfer_buffer,
+    bool cycle
+) {
+    NullObject* object =
+        use (transfer_buffer, NULL_GPU_TRANSFER_BUFFER, "map transfer buffer");
+    return object ? object->memory : NULL;
+}
+
+void SDL_UnmapGPUTransferBuffer (
+    SDL_GPUDevice* device,
+    SDL_GPUTransferBuffer* transfer_buffer
+) {
+    use (transfer_buffer, NULL_GPU_TRANSFER_BUFFER, "unmap transfer buffer");
+}
+
+SDL_GPUTexture* SDL_CreateGPUTexture (
+    SDL_GPUDevice* device,
+    const SDL_GPUTextureCreateInfo* createinfo
+) {
+    NullObject* texture = create (NULL_GPU_TEXTURE, 0);
+    if (texture) texture->info = *createinfo;
+    return (SDL_GPUTexture*) texture;
+}
+
+void SDL_ReleaseGPUTexture (SDL_GPUDevice* device, SDL_GPUTexture* texture) {
+    release (texture, NULL_GPU_TEXTURE, "release texture");
+}
+
+SDL_GPUSampler* SDL_CreateGPUSampler (
+    SDL_GPUDevice* device,
+    const SDL_GPUSamplerCreateInfo* createinfo
+) {
+    return create (NULL_GPU_SAMPLER, 0);
+}
+
+void SDL_ReleaseGPUSampler (SDL_GPUDevice* device, SDL_GPUSampler* sampler) {
+    release (sampler, NULL_GPU_SAMPLER, "release sampler");
+}
+
+SDL_GPUShader* SDL_CreateGPUShader (
+    SDL_GPUDevice* device,
+    const SDL_GPUShaderCreateInfo* createinfo
+) {
+    return create (NULL_GPU_SHADER, 0);
+}
+
+void SDL_ReleaseGPUShader (SDL_GPUDevice* device, SDL_GPUShader* shader) {
+    release (shader, NULL_GPU_SHADER, "release shader");
+}
+
+SDL_GPUGraphicsPipeline* SDL_CreateGPUGraphicsPipeline (
+    SDL_GPUDevice* device,
+    const SDL_GPUGraphicsPipelineCreateInfo* createinfo
+) {
+    return create (NULL_GPU_GRAPHICS_PIPELINE, 0);
+}
+
+void SDL_ReleaseGPUGraphicsPipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUGraphicsPipeline* graphics_pipeline
+) {
+    release (
+        graphics_pipeline, NULL_GPU_GRAPHICS_PIPELINE,
+        "release graphics pipeline"
+    );
+}
+
+SDL_GPUComputePipeline* SDL_CreateGPUComputePipeline (
+    SDL_GPUDevice* device,
+    const SDL_GPUComputePipelineCreateInfo* createinfo
+) {
+    return create (NULL_GPU_COMPUTE_PIPELINE, 0);
+}
+
+void SDL_ReleaseGPUComputePipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUComputePipeline* compute_pipeline
+) {
+    release (
+        compute_pipeline, NULL_GPU_COMPUTE_PIPELINE, "release compute pipeline"
+    );
+}
+
+// Command buffers
+SDL_GPUCommandBuffer* SDL_AcquireGPUCommandBuffer (SDL_GPUDevice* device) {
+    return (SDL_GPUCommandBuffer*) &command_buffer;
+}
+
+bool SDL_SubmitGPUCommandBuffer (SDL_GPUCommandBuffer* command_buffer) {
+    return true;
+}
+
+SDL_GPUFence* SDL_SubmitGPUCommandBufferAndAcquireFence (
+    SDL_GPUCommandBuffer* command_buffer
+) {
+    return create (NULL_GPU_FENCE, 0);
+}
+
+bool SDL_CancelGPUCommandBuffer (SDL_GPUCommandBuffer* command_buffer) {
+    return true;
+}
+
+bool SDL_WaitForGPUFences (
+    SDL_GPUDevice* device,
+    bool wait_all,
+    SDL_GPUFence* const* fences,
+    Uint32 num_fences
+) {
+    for (Uint32 i = 0; i < num_fences; i++) {
+        use (fences[i], NULL_GPU_FENCE, "wait for fence");
+    }
+    return true;
+}
+
+void SDL_ReleaseGPUFence (SDL_GPUDevice* device, SDL_GPUFence* fence) {
+    release (fence, NULL_GPU_FENCE, "release fence");
+}
+
+bool SDL_AcquireGPUSwapchainTexture (
+    SDL_GPUCommandBuffer* command_buffer,
+    SDL_Window* window,
+    SDL_GPUTexture** swapchain_texture,
+    Uint32* swapchain_texture_width,
+    Uint32* swapchain_texture_height
+) {
+    *swapchain_texture = (SDL_GPUTexture*) &swapchain;
+    if (swapchain_texture_width) *swapchain_texture_width = NULL_GPU_WIDTH;
+    if (swapchain_texture_height) *swapchain_texture_height = NULL_GPU_HEIGHT;
+    return true;
+}
+
+void SDL_PushGPUVertexUniformData (
+    SDL_GPUCommandBuffer* command_buffer,
+    Uint32 slot_index,
+    const void* data,
+    Uint32 length
+) {}
+
+void SDL_PushGPUFragmentUniformData (
+    SDL_GPUCommandBuffer* command_buffer,
+    Uint32 slot_index,
+    const void* data,
+    Uint32 length
+) {}
+
+void SDL_PushGPUComputeUniformData (
+    SDL_GPUCommandBuffer* command_buffer,
+    Uint32 slot_index,
+    const void* data,
+    Uint32 length
+) {}
+
+void SDL_GenerateMipmapsForGPUTexture (
+    SDL_GPUCommandBuffer* command_buffer,
+    SDL_GPUTexture* texture
+) {
+    use (texture, NULL_GPU_TEXTURE, "generate mipmaps");
+}
+
+void SDL_BlitGPUTexture (
+    SDL_GPUCommandBuffer* command_buffer,
+    const SDL_GPUBlitInfo* info
+) {
+    use (info->source.texture, NULL_GPU_TEXTURE, "blit from texture");
+    use (info->destination.texture, NULL_GPU_TEXTURE, "blit to texture");
+}
+
+// Copy passes
+SDL_GPUCopyPass* SDL_BeginGPUCopyPass (SDL_GPUCommandBuffer* command_buffer) {
+    return (SDL_GPUCopyPass*) &copy_pass;
+}
+
+void SDL_EndGPUCopyPass (SDL_GPUCopyPass* copy_pass) {}
+
+void SDL_UploadToGPUBuffer (
+    SDL_GPUCopyPass* copy_pass,
+    const SDL_GPUTransferBufferLocation* source,
+    const SDL_GPUBufferRegion* destination,
+    bool cycle
+) {
+    const char* what = "upload to buffer";
+    NullObject* from =
+        use (source->transfer_buffer, NULL_GPU_TRANSFER_BUFFER, what);
+    NullObject* to = use (destination->buffer, NULL_GPU_BUFFER, what);
+    if (from == NULL || to == NULL) return;
+    if ((Uint64) source->offset + destination->size > from->size ||
+        (Uint64) destination->offset + destination->size > to->size) {
+        fail (what, "out of bounds");
+        return;
+    }
+    memcpy (
+        to->memory + destination->offset, from->memory + source->offset,
+        destination->size
+    );
+}
+
+void SDL_UploadToGPUTexture (
+    SDL_GPUCopyPass* copy_pass,
+    const SDL_GPUTextureTransferInfo* source,
+    const SDL_GPUTextureRegion* destination,
+    bool cycle
+) {
+    const char* what = "upload to texture";
+    NullObject* from =
+        use (source->transfer_buffer, NULL_GPU_TRANSFER_BUFFER, what);
+    NullObject* to = use (destination->texture, NULL_GPU_TEXTURE, what);
+    if (from == NULL || to == NULL) return;
+    if (source->offset >= from->size ||
+        !use_subresource (to, destination->mip_level, destination->layer)) {
+        fail (what, "out of bounds");
+    }
+}
+
+void SDL_CopyGPUTextureToTexture (
+    SDL_GPUCopyPass* copy_pass,
+    const SDL_GPUTextureLocation* source,
+    const SDL_GPUTextureLocation* destination,
+    Uint32 w,
+    Uint32 h,
+    Uint32 d,
+    bool cycle
+) {
+    const char* what = "copy texture";
+    NullObject* from = use (source->texture, NULL_GPU_TEXTURE, what);
+    NullObject* to = use (destination->texture, NULL_GPU_TEXTURE, what);
+    if (from == NULL || to == NULL) return;
+    if (!use_subresource (from, source->mip_level, source->layer) ||
+        !use_subresource (to, destination->mip_level, destination->layer)) {
+        fail (what, "out of bounds");
+        return;
+    }
+    SDL_AddAtomicInt (&texture_copies, 1);
+}
+
+// Render passes
+SDL_GPURenderPass* SDL_BeginGPURenderPass (
+    SDL_GPUCommandBuffer* command_buffer,
+    const SDL_GPUColorTargetInfo* color_target_infos,
+    Uint32 num_color_targets,
+    const SDL_GPUDepthStencilTargetInfo* depth_stencil_target_info
+) {
+    for (Uint32 i = 0; i < num_color_targets; i++) {
+        use (color_target_infos[i].texture, NULL_GPU_TEXTURE, "color target");
+    }
+    if (depth_stencil_target_info) {
+        use (
+            depth_stencil_target_info->texture, NULL_GPU_TEXTURE,
+            "depth target"
+        );
+    }
+    return (SDL_GPURenderPass*) &render_pass;
+}
+
+void SDL_EndGPURenderPass (SDL_GPURenderPass* render_pass) {}
+
+void SDL_SetGPUViewport (
+    SDL_GPURenderPass* render_pass,
+    const SDL_GPUViewport* viewport
+) {}
+
+void SDL_SetGPUScissor (
+    SDL_GPURenderPass* render_pass,
+    const SDL_Rect* scissor
+) {}
+
+void SDL_BindGPUGraphicsPipeline (
+    SDL_GPURenderPass* render_pass,
+    SDL_GPUGraphicsPipeline* graphics_pipeline
+) {
+    use (graphics_pipeline, NULL_GPU_GRAPHICS_PIPELINE, "bind pipeline");
+}
+
+void SDL_BindGPUVertexBuffers (
+    SDL_GPURenderPass* render_pass,
+    Uint32 first_slot,
+    const SDL_GPUBufferBinding* bindings,
+    Uint32 num_bindings
+) {
+    for (Uint32 i = 0; i < num_bindings; i++) {
+        use (bindings[i].buffer, NULL_GPU_BUFFER, "bind vertex buffer");
+    }
+}
+
+void SDL_BindGPUIndexBuffer (
+    SDL_GPURenderPass* render_pass,
+    const SDL_GPUBufferBinding* binding,
+    SDL_GPUIndexElementSize index_element_size
+) {
+    use (binding->buffer, NULL_GPU_BUFFER, "bind index buffer");
+}
+
+void SDL_BindGPUVertexStorageBuffers (
+    SDL_GPURenderPass* render_pass,
+    Uint32 first_slot,
+    SDL_GPUBuffer* const* storage_buffers,
+    Uint32 num_bindings
+) {
+    for (Uint32 i = 0; i < num_bindings; i++) {
+        use (storage_buffers[i], NULL_GPU_BUFFER, "bind storage buffer");
+    }
+}
+
+void SDL_BindGPUFragmentStorageBuffers (
+    SDL_GPURenderPass* render_pass,
+    Uint32 first_slot,
+    SDL_GPUBuffer* const* storage_buffers,
+    Uint32 num_bindings
+) {
+    for (Uint32 i = 0; i < num_bindings; i++) {
+        use (storage_buffers[i], NULL_GPU_BUFFER, "bind storage buffer");
+    }
+}
+
+void SDL_BindGPUFragmentSamplers (
+    SDL_GPURenderPass* render_pass,
+    Uint32 first_slot,
+    const SDL_GPUTextureSamplerBinding* texture_sampler_bindings,
+    Uint32 num_bindings
+) {
+    for (Uint32 i = 0; i < num_bindings; i++) {
+        const SDL_GPUTextureSamplerBinding* binding =
+            &texture_sampler_bindings[i];
+        use (binding->texture, NULL_GPU_TEXTURE, "bind texture");
+        use (binding->sampler, NULL_GPU_SAMPLER, "bind sampler");
+    }
+}
+
+void SDL_DrawGPUPrimitives (
+    SDL_GPURenderPass* render_pass,
+    Uint32 num_vertices,
+    Uint32 num_instances,
+    Uint32 first_vertex,
+    Uint32 first_instance
+) {}
+
+void SDL_DrawGPUIndexedPrimitives (
+    SDL_GPURenderPass* render_pass,
+    Uint32 num_indices,
+    Uint32 num_instances,
+    Uint32 first_index,
+    Sint32 vertex_offset,
+    Uint32 first_instance
+) {}
+
+void SDL_DrawGPUIndexedPrimitivesIndirect (
+    SDL_GPURenderPass* render_pass,
+    SDL_GPUBuffer* buffer,
+    Uint32 offset,
+    Uint32 draw_count
+) {
+    use (buffer, NULL_GPU_BUFFER, "indirect draw");
+}
+
+// Compute passes
+SDL_GPUComputePass* SDL_BeginGPUComputePass (
+    SDL_GPUCommandBuffer* command_buffer,
+    const SDL_GPUStorageTextureReadWriteBinding* storage_texture_bindings,
+    Uint32 num_storage_texture_bindings,
+    const SDL_GPUStorageBufferReadWriteBinding* storage_buffer_bindings,
+    Uint32 num_storage_buffer_bindings
+) {
+    for (Uint32 i = 0; i < num_storage_texture_bindings; i++) {
+        use (
+            storage_texture_bindings[i].texture, NULL_GPU_TEXTURE,
+            "bind storage texture"
+        );
+    }
+    for (Uint32 i = 0; i < num_storage_buffer_bindings; i++) {
+        use (
+            storage_buffer_bindings[i].buffer, NULL_GPU_BUFFER,
+            "bind storage buffer"
+        );
+    }
+    return (SDL_GPUComputePass*) &compute_pass;
+}
+
+void SDL_EndGPUComputePass (SDL_GPUComputePass* compute_pass) {}
+
+void SDL_BindGPUComputePipeline (
+    SDL_GPUComputePass* compute_pass,
+    SDL_GPUComputePipeline* compute_pipeline
+) {
+    use (compute_pipeline, NULL_GPU_COMPUTE_PIPELINE, "bind compute pipeline");
+}
+
+void SDL_BindGPUComputeStorageBuffers (
+    SDL_GPUComputePass* compute_pass,
+    Uint32 first_slot,
+    SDL_GPUBuffer* const* storage_buffers,
+    Uint32 num_bindings
+) {
+    for (Uint32 i = 0; i < num_bindings; i++) {
+        use (storage_buffers[i], NULL_GPU_BUFFER, "bind storage buffer");
+    }
+}
+
+void SDL_DispatchGPUCompute (
+    SDL_GPUComputePass* compute_pass,
+    Uint32 groupcount_x,
+    Uint32 groupcount_y,
+    Uint32 groupcount_z
+) {}
\ No newline at end of file
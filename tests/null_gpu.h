@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// A stand-in for the SDL GPU API, so engine code that talks to a device can
+// be tested without one. Linked into a test executable, its definitions take
+// the place of a shared SDL3's (see tests/CMakeLists.txt). Buffers and
+// transfer buffers have host memory and copy passes run as they are
+// recorded; textures, pipelines and the rest are placeholders, and draws and
+// dispatches do nothing. Fences are signalled at once.
+//
+// Released objects are kept until NullGPU_Quit, so any later use of one is
+// caught: binding, uploading into or copying from it, or releasing it again
+// counts an error and logs what happened.
+typedef enum {
+    NULL_GPU_BUFFER,
+    NULL_GPU_TRANSFER_BUFFER,
+    NULL_GPU_TEXTURE,
+    NULL_GPU_SAMPLER,
+    NULL_GPU_SHADER,
+    NULL_GPU_GRAPHICS_PIPELINE,
+    NULL_GPU_COMPUTE_PIPELINE,
+    NULL_GPU_FENCE,
+    NULL_GPU_KINDS,
+} NullGPUKind;
+
+// the swapchain size the window reports
+#define NULL_GPU_WIDTH 640
+#define NULL_GPU_HEIGHT 360
+
+SDL_GPUDevice* NullGPU_Device (void);
+SDL_Window* NullGPU_Window (void);
+// objects of a kind created and not yet released
+Uint32 NullGPU_Live (NullGPUKind kind);
+bool NullGPU_Released (const void* object);
+// texture to texture copies recorded so far
+Uint32 NullGPU_TextureCopies (void);
+Uint32 NullGPU_Errors (void);
+// frees every object, released or not
+void NullGPU_Quit (void);
\ No newline at end of file
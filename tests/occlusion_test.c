@@ -0,0 +1,105 @@
+#include <math.h>
+#include <stdio.h>
+
+#include <SDL3/SDL.h>
+
+#include <math/bounds.h>
+#include <math/matrix.h>
+#include <scene/occlusion.h>
+
+// The occlusion buffer on its own: a camera at the origin looking down +Z
+// (mat4_perspective takes view depth as w) and a wall across the view five
+// units out.
+#define WIDTH 320
+#define HEIGHT 192
+
+static int failures = 0;
+
+#define CHECK(cond, what)                                                      \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf ("FAIL %s\n", what);                                        \
+            failures++;                                                        \
+        }                                                                      \
+    } while (0)
+
+static void camera (mat4 view_proj) {
+    mat4 view;
+    mat4_identity (view);
+    mat4 proj;
+    mat4_perspective (
+        proj, 60.0f * (float) M_PI / 180.0f, (float) WIDTH / HEIGHT, 0.1f,
+        100.0f
+    );
+    mat4_multiply (view_proj, proj, view);
+}
+
+static aabb box (vec3 min, vec3 max) {
+    return (aabb) {.min = min, .max = max};
+}
+
+int main (void) {
+    PAL_OcclusionBuffer* ob = PAL_CreateOcclusionBuffer (WIDTH, HEIGHT);
+    if (ob == NULL) return 1;
+    mat4 view_proj;
+    camera (view_proj);
+    mat4 identity;
+    mat4_identity (identity);
+
+    aabb behind =
+        box ((vec3) {-1.0f, -1.0f, 9.0f}, (vec3) {1.0f, 1.0f, 10.0f});
+    aabb in_front =
+        box ((vec3) {-1.0f, -1.0f, 2.0f}, (vec3) {1.0f, 1.0f, 3.0f});
+    aabb through =
+        box ((vec3) {-1.0f, -1.0f, 4.0f}, (vec3) {1.0f, 1.0f, 10.0f});
+    aabb near_plane =
+        box ((vec3) {-1.0f, -1.0f, -1.0f}, (vec3) {1.0f, 1.0f, 10.0f});
+    aabb past_edge =
+        box ((vec3) {1.5f, -1.0f, 9.0f}, (vec3) {3.5f, 1.0f, 10.0f});
+
+    // nothing rasterized yet
+    PAL_OcclusionClear (ob, view_proj);
+    CHECK (PAL_OcclusionTestAABB (ob, behind), "empty buffer culls nothing");
+    CHECK (PAL_OcclusionTestAABB (ob, in_front), "empty buffer, near box");
+
+    // a wall wider than the boxes behind it, but narrower than the view
+    PAL_OcclusionRasterizeBox (
+        ob, box ((vec3) {-2.0f, -2.0f, 4.9f}, (vec3) {2.0f, 2.0f, 5.1f}),
+        identity
+    );
+    CHECK (!PAL_OcclusionTestAABB (ob, behind), "box behind the wall culled");
+    CHECK (PAL_OcclusionTestAABB (ob, in_front), "box in front stays");
+    CHECK (PAL_OcclusionTestAABB (ob, through), "box through the wall stays");
+    CHECK (
+        PAL_OcclusionTestAABB (ob, near_plane),
+        "box across the near plane stays"
+    );
+    CHECK (PAL_OcclusionTestAABB (ob, past_edge), "box past the edge stays");
+
+    // the same wall as an indexed triangle list, behind the camera: it
+    // must not hide anything in front
+    vec3 quad[] = {
+        {-50.0f, -50.0f, -3.0f},
+        {50.0f, -50.0f, -3.0f},
+        {50.0f, 50.0f, -3.0f},
+        {-50.0f, 50.0f, -3.0f},
+    };
+    Uint32 indices[] = {0, 1, 2, 0, 2, 3};
+    PAL_OcclusionClear (ob, view_proj);
+    PAL_OcclusionRasterize (ob, quad, indices, 6, identity);
+    CHECK (
+        PAL_OcclusionTestAABB (ob, behind), "occluder behind the camera ignored"
+    );
+
+    // a full-screen quad in front of everything, either winding
+    for (Uint32 i = 0; i < 4; i++) quad[i].z = 4.0f;
+    Uint32 reversed[] = {0, 2, 1, 0, 3, 2};
+    PAL_OcclusionClear (ob, view_proj);
+    PAL_OcclusionRasterize (ob, quad, reversed, 6, identity);
+    CHECK (!PAL_OcclusionTestAABB (ob, behind), "reversed winding occludes");
+    CHECK (PAL_OcclusionTestAABB (ob, in_front), "reversed winding, near box");
+
+    PAL_DestroyOcclusionBuffer (ob);
+    if (failures == 0) printf ("occlusion: ok\n");
+    return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include <ecs/ecs.h>
+#include <geometry/box.h>
+#include <material/m_common.h>
+#include <scene/gpu_cull.h>
+
+#include "null_gpu.h"
+
+// The renderer on the null GPU, with GPU culling: a box drawn with a
+// template that is built asynchronously and fails.
+static int failures = 0;
+
+#define CHECK(cond, what)                                                      \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf ("FAIL %s\n", what);                                        \
+            failures++;                                                        \
+        }                                                                      \
+    } while (0)
+
+// the null device never reads shader code, but it is loaded and checked;
+// a bare SPIR-V header will do
+static bool write_shaders (void) {
+    Uint32 header[5] = {0x07230203, 0x00010000, 0, 1, 0};
+    return SDL_CreateDirectory ("shaders") &&
+           SDL_SaveFile ("shaders/cull.comp.spv", header, sizeof (header));
+}
+
+static bool build_template (
+    PAL_MaterialTemplate* tmpl,
+    const PAL_GPURenderer* renderer,
+    const void* args
+) {
+    SDL_GPUGraphicsPipelineCreateInfo info = {0};
+    tmpl->pipeline = SDL_CreateGPUGraphicsPipeline (renderer->device, &info);
+    return tmpl->pipeline != NULL;
+}
+
+// fails once the test lets it, so the template is seen pending first
+static bool fail_template (
+    PAL_MaterialTemplate* tmpl,
+    const PAL_GPURenderer* renderer,
+    const void* args
+) {
+    SDL_WaitSemaphore (*(SDL_Semaphore* const*) args);
+    return false;
+}
+
+static void render (PAL_GPURenderer* renderer, Entity cam) {
+    Uint64 prerender, preui, postrender;
+    render_system (renderer, cam, &prerender, &preui, &postrender);
+    renderer_wait (renderer);
+}
+
+int main (void) {
+    SDL_GPUDevice* device = NullGPU_Device ();
+    if (!write_shaders ()) {
+        printf ("FAIL couldn't write shaders: %s\n", SDL_GetError ());
+        return 1;
+    }
+    PAL_RendererCreateInfo renderer_info = {
+        .device = device,
+        .window = NullGPU_Window (),
+        .width = NULL_GPU_WIDTH,
+        .height = NULL_GPU_HEIGHT,
+        .gpu_culling = true,
+    };
+    PAL_GPURenderer* renderer = renderer_init (&renderer_info);
+    if (renderer == NULL || renderer->culler == NULL) {
+        printf ("FAIL renderer with GPU culling\n");
+        return 1;
+    }
+
+    Entity cam = create_entity ();
+    add_transform (
+        cam, &(PAL_TransformCreateInfo) {
+                 .position = {0.0f, 0.0f, -5.0f},
+                 .scale = {1.0f, 1.0f, 1.0f},
+             }
+    );
+    add_camera (
+        cam, &(PAL_CameraCreateInfo) {
+                 .fov = 60.0f,
+                 .near_clip = 0.1f,
+                 .far_clip = 100.0f,
+             }
+    );
+
+    PAL_MaterialTemplate* fallback =
+        PAL_BuildMaterialTemplate (&(PAL_TemplateBuildInfo) {
+            .renderer = renderer,
+            .build = build_template,
+        });
+    SDL_Semaphore* go = SDL_CreateSemaphore (0);
+    PAL_MaterialTemplate* failing =
+        PAL_BuildMaterialTemplate (&(PAL_TemplateBuildInfo) {
+            .renderer = renderer,
+            .build = fail_template,
+            .args = &go,
+            .args_size = sizeof (go),
+            .async = true,
+            .fallback = fallback,
+        });
+    if (fallback == NULL || failing == NULL || go == NULL) {
+        printf ("FAIL templates\n");
+        return 1;
+    }
+
+    Entity box = create_entity ();
+    add_transform (
+        box, &(PAL_TransformCreateInfo) {.scale = {1.0f, 1.0f, 1.0f}}
+    );
+    PAL_AddMeshComponent (
+        device, box,
+        PAL_CreateBoxMesh (&(PAL_BoxMeshCreateInfo) {
+            .l = 1.0f,
+            .w = 1.0f,
+            .h = 1.0f,
+            .device = device,
+        })
+    );
+    PAL_GPUMaterial white = {.color = {1.0f, 1.0f, 1.0f, 1.0f}};
+    PAL_AddMaterialComponent (
+        box, PAL_CreateMaterialInstance (
+                 failing, &white, (PAL_TextureLayer) {0}, NULL
+             )
+    );
+
+    // while pending the box is drawn with the fallback
+    render (renderer, cam);
+    CHECK (
+        PAL_GetMaterialTemplateState (failing) == PAL_TEMPLATE_PENDING,
+        "template pending"
+    );
+    CHECK (
+        PAL_GPUCullerCount (renderer->culler) == 1,
+        "pending template's instance culled with its fallback"
+    );
+
+    SDL_SignalSemaphore (go);
+    while (PAL_GetMaterialTemplateState (failing) == PAL_TEMPLATE_PENDING) {
+        SDL_Delay (1);
+    }
+    CHECK (
+        PAL_GetMaterialTemplateState (failing) == PAL_TEMPLATE_FAILED,
+        "template failed"
+    );
+    CHECK (
+        PAL_ResolveMaterialTemplate (failing) == NULL,
+        "failed template resolves to nothing"
+    );
+    // as on the CPU path, a failed template's instances are no longer drawn
+    render (renderer, cam);
+    CHECK (
+        PAL_GPUCullerCount (renderer->culler) == 0,
+        "failed template's instance removed from the culler"
+    );
+    CHECK (NullGPU_Errors () == 0, "no invalid GPU calls");
+
+    // GPU objects go with the null device
+    renderer_quit (renderer);
+    free_pools (device);
+    PAL_DestroyUploadRing (renderer->upload);
+    PAL_DestroyGPUCuller (renderer->culler);
+    PAL_DestroyLightGrid (renderer->light_grid);
+    free (renderer->light_spheres);
+    free (renderer->draw_list);
+    free (renderer);
+    SDL_DestroySemaphore (go);
+    NullGPU_Quit ();
+    if (failures == 0) printf ("renderer: ok\n");
+    return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <stdio.h>
+
+#include <SDL3/SDL.h>
+
+#include <gpu/texture_array.h>
+#include <gpu/upload.h>
+
+#include "null_gpu.h"
+
+// Texture arrays and upload batches on the null GPU: growth and its copies,
+// layer reuse, when retired textures are released, and discarding copies
+// before a batch is submitted.
+static int failures = 0;
+
+#define CHECK(cond, what)                                                      \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf ("FAIL %s\n", what);                                        \
+            failures++;                                                        \
+        }                                                                      \
+    } while (0)
+
+static const SDL_GPUTextureCreateInfo info = {
+    .type = SDL_GPU_TEXTURETYPE_2D,
+    .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+    .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
+    .width = 4,
+    .height = 4,
+    .layer_count_or_depth = 1,
+    .num_levels = 1,
+};
+
+static SDL_GPUTextureLocation location (SDL_GPUTexture* texture, Uint32 l) {
+    return (SDL_GPUTextureLocation) {.texture = texture, .layer = l};
+}
+
+static SDL_GPUTextureRegion region (SDL_GPUTexture* texture, Uint32 l) {
+    return (SDL_GPUTextureRegion) {
+        .texture = texture,
+        .layer = l,
+        .w = info.width,
+        .h = info.height,
+        .d = 1,
+    };
+}
+
+int main (void) {
+    SDL_GPUDevice* device = NullGPU_Device ();
+    PAL_TextureLayer layers[9];
+
+    // the fifth layer doubles the array inside the batch; the old texture
+    // is kept while the batch copying out of it is unsubmitted
+    PAL_UploadBatch* batch = PAL_BeginUploadBatch (device, 0);
+    for (Uint32 i = 0; i < 5; i++) {
+        layers[i] = PAL_AcquireTextureLayer (device, batch, &info);
+        CHECK (layers[i].array != NULL, "layer acquired");
+        CHECK (layers[i].array == layers[0].array, "layers share an array");
+    }
+    PAL_TextureArray* array = layers[0].array;
+    CHECK (PAL_GetTextureArrayGrowths () == 1, "array grown once");
+    CHECK (
+        PAL_GetTextureArrayInfo (array)->layer_count_or_depth == 8,
+        "array doubled"
+    );
+    CHECK (NullGPU_Live (NULL_GPU_TEXTURE) == 2, "old texture retired");
+    PAL_ReleaseRetiredTextures (SDL_MAX_UINT32);
+    CHECK (
+        NullGPU_Live (NULL_GPU_TEXTURE) == 2,
+        "retired texture kept until its copies are submitted"
+    );
+    CHECK (PAL_SubmitUploadBatch (batch, NULL), "growth batch submitted");
+    CHECK (NullGPU_TextureCopies () == 4, "layers in use copied");
+
+    // a released layer is handed out again before the array grows
+    PAL_ReleaseTextureLayer (layers[2]);
+    layers[2] = PAL_AcquireTextureLayer (device, NULL, &info);
+    CHECK (layers[2].array == array, "layer reused");
+    CHECK (PAL_GetTextureArrayGrowths () == 1, "no growth for a free layer");
+
+    // the ninth layer grows the array again, submitting its own copies
+    SDL_GPUTexture* grown_once = PAL_GetTextureArrayTexture (array);
+    for (Uint32 i = 5; i < 9; i++) {
+        layers[i] = PAL_AcquireTextureLayer (device, NULL, &info);
+    }
+    SDL_GPUTexture* grown_twice = PAL_GetTextureArrayTexture (array);
+    CHECK (PAL_GetTextureArrayGrowths () == 2, "array grown twice");
+    CHECK (NullGPU_TextureCopies () == 12, "second growth copied");
+
+    // retired textures go once the frames that saw their growth are done
+    PAL_ReleaseRetiredTextures (0);
+    CHECK (NullGPU_Live (NULL_GPU_TEXTURE) == 3, "no growth unbound");
+    PAL_ReleaseRetiredTextures (1);
+    CHECK (NullGPU_Live (NULL_GPU_TEXTURE) == 2, "first growth unbound");
+    CHECK (!NullGPU_Released (grown_once), "second growth's texture kept");
+    PAL_ReleaseRetiredTextures (SDL_MAX_UINT32);
+    CHECK (NullGPU_Live (NULL_GPU_TEXTURE) == 1, "every growth unbound");
+    CHECK (NullGPU_Released (grown_once), "retired textures released");
+    CHECK (!NullGPU_Released (grown_twice), "array texture kept");
+
+    // discarded copies are never recorded, so their texture can be
+    // released before the batch is submitted
+    SDL_GPUTexture* texture = PAL_GetTextureArrayTexture (array);
+    SDL_GPUTextureCreateInfo pair_info = info;
+    pair_info.type = SDL_GPU_TEXTURETYPE_2D_ARRAY;
+    pair_info.layer_count_or_depth = 2;
+    SDL_GPUTexture* pair = SDL_CreateGPUTexture (device, &pair_info);
+    SDL_GPUTexture* scratch = SDL_CreateGPUTexture (device, &info);
+    batch = PAL_BeginUploadBatch (device, 0);
+    SDL_GPUTextureLocation from = location (texture, layers[0].layer);
+    SDL_GPUTextureRegion to_first = region (pair, 0);
+    SDL_GPUTextureRegion to_second = region (pair, 1);
+    SDL_GPUTextureRegion to_scratch = region (scratch, 0);
+    CHECK (
+        PAL_UploadBatchCopyTexture (batch, &from, &to_first) &&
+            PAL_UploadBatchCopyTexture (batch, &from, &to_second) &&
+            PAL_UploadBatchCopyTexture (batch, &from, &to_scratch),
+        "copies queued"
+    );
+    CHECK (
+        PAL_UploadBatchTexture (batch, &to_scratch, 0, 64) != NULL,
+        "upload queued"
+    );
+    PAL_UploadBatchDiscard (batch, pair, 1);
+    PAL_UploadBatchDiscard (batch, scratch, PAL_UPLOAD_ALL_LAYERS);
+    SDL_ReleaseGPUTexture (device, scratch);
+    CHECK (PAL_SubmitUploadBatch (batch, NULL), "batch submitted");
+    CHECK (NullGPU_TextureCopies () == 13, "only the kept copy recorded");
+    SDL_ReleaseGPUTexture (device, pair);
+
+    // the last layer takes the array with it
+    for (Uint32 i = 0; i < 9; i++) PAL_ReleaseTextureLayer (layers[i]);
+    CHECK (NullGPU_Live (NULL_GPU_TEXTURE) == 0, "every texture released");
+    CHECK (
+        NullGPU_Live (NULL_GPU_TRANSFER_BUFFER) == 0,
+        "every transfer buffer released"
+    );
+    CHECK (NullGPU_Errors () == 0, "no invalid GPU calls");
+
+    NullGPU_Quit ();
+    if (failures == 0) printf ("texture array: ok\n");
+    return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,377 @@
+// texconv: converts an image to a block-compressed DDS file with a prebuilt
+// mip chain, which PAL_LoadTexture uploads without decoding.
+//
+//   texconv [-f bc1|bc3|bc5] input.png output.dds
+//
+// Input is anything SDL_image reads; sides must be multiples of 4. Without
+// -f, opaque images become BC1 and images with alpha BC3; BC5 keeps red and
+// green, for normal maps. Mips are box filtered and each 4x4 block is fitted
+// along its principal color axis, which is quick and good enough for
+// textures that aren't hand-tuned.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+
+#include <gpu/dds.h>
+
+typedef enum { FORMAT_AUTO, FORMAT_BC1, FORMAT_BC3, FORMAT_BC5 } Format;
+
+typedef struct {
+    Uint8* pixels; // RGBA8, tightly packed
+    Uint32 w;
+    Uint32 h;
+} Level;
+
+// halves a level with a 2x2 box filter; odd edges repeat their last texel
+static bool downsample (const Level* src, Level* dst) {
+    dst->w = SDL_max (src->w / 2, 1u);
+    dst->h = SDL_max (src->h / 2, 1u);
+    dst->pixels = malloc ((size_t) dst->w * dst->h * 4);
+    if (dst->pixels == NULL) return false;
+    for (Uint32 y = 0; y < dst->h; y++) {
+        Uint32 y0 = SDL_min (y * 2, src->h - 1);
+        Uint32 y1 = SDL_min (y * 2 + 1, src->h - 1);
+        for (Uint32 x = 0; x < dst->w; x++) {
+            Uint32 x0 = SDL_min (x * 2, src->w - 1);
+            Uint32 x1 = SDL_min (x * 2 + 1, src->w - 1);
+            const Uint8* a = &src->pixels[(y0 * src->w + x0) * 4];
+            const Uint8* b = &src->pixels[(y0 * src->w + x1) * 4];
+            const Uint8* c = &src->pixels[(y1 * src->w + x0) * 4];
+            const Uint8* d = &src->pixels[(y1 * src->w + x1) * 4];
+            Uint8* out = &dst->pixels[(y * dst->w + x) * 4];
+            for (int i = 0; i < 4; i++) {
+                out[i] = (Uint8) ((a[i] + b[i] + c[i] + d[i] + 2) / 4);
+            }
+        }
+    }
+    return true;
+}
+
+static Uint32 quantize (float v, float max) {
+    return (Uint32) (SDL_clamp (v, 0.0f, 255.0f) * max / 255.0f + 0.5f);
+}
+
+static Uint16 pack_565 (const float c[3]) {
+    Uint32 r = quantize (c[0], 31.0f);
+    Uint32 g = quantize (c[1], 63.0f);
+    Uint32 b = quantize (c[2], 31.0f);
+    return (Uint16) ((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565 (Uint16 v, float c[3]) {
+    Uint32 r = (v >> 11) & 31;
+    Uint32 g = (v >> 5) & 63;
+    Uint32 b = v & 31;
+    c[0] = (float) ((r << 3) | (r >> 2));
+    c[1] = (float) ((g << 2) | (g >> 4));
+    c[2] = (float) ((b << 3) | (b >> 2));
+}
+
+static void write_le16 (Uint8* out, Uint16 v) {
+    out[0] = (Uint8) v;
+    out[1] = (Uint8) (v >> 8);
+}
+
+// BC1 color block in four-color mode, which BC3 also uses. The endpoints are
+// the extremes of the pixels projected on the principal axis of their
+// colors, found by power iteration on the covariance matrix.
+static void encode_color (const Uint8 block[16][4], Uint8* out) {
+    float mean[3] = {0};
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 3; c++) mean[c] += block[i][c] / 16.0f;
+    }
+    float cov[6] = {0}; // xx xy xz yy yz zz
+    for (int i = 0; i < 16; i++) {
+        float d[3] = {
+            block[i][0] - mean[0], block[i][1] - mean[1], block[i][2] - mean[2]
+        };
+        cov[0] += d[0] * d[0];
+        cov[1] += d[0] * d[1];
+        cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1];
+        cov[4] += d[1] * d[2];
+        cov[5] += d[2] * d[2];
+    }
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iter = 0; iter < 8; iter++) {
+        float next[3] = {
+            cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+            cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+            cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2],
+        };
+        float len = sqrtf (
+            next[0] * next[0] + next[1] * next[1] + next[2] * next[2]
+        );
+        if (len < 1e-6f) break; // flat block, keep the gray axis
+        for (int c = 0; c < 3; c++) axis[c] = next[c] / len;
+    }
+    float lo = INFINITY, hi = -INFINITY;
+    for (int i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < 3; c++) t += (block[i][c] - mean[c]) * axis[c];
+        lo = SDL_min (lo, t);
+        hi = SDL_max (hi, t);
+    }
+    float end0[3], end1[3];
+    for (int c = 0; c < 3; c++) {
+        end0[c] = mean[c] + axis[c] * hi;
+        end1[c] = mean[c] + axis[c] * lo;
+    }
+    Uint16 c0 = pack_565 (end0);
+    Uint16 c1 = pack_565 (end1);
+    if (c0 < c1) {
+        Uint16 t = c0;
+        c0 = c1;
+        c1 = t;
+    }
+    write_le16 (out, c0);
+    write_le16 (out + 2, c1);
+
+    Uint32 indices = 0;
+    if (c0 != c1) {
+        float palette[4][3];
+        unpack_565 (c0, palette[0]);
+        unpack_565 (c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+        for (int i = 0; i < 16; i++) {
+            Uint32 best = 0;
+            float best_dist = INFINITY;
+            for (Uint32 p = 0; p < 4; p++) {
+                float dist = 0.0f;
+                for (int c = 0; c < 3; c++) {
+                    float d = block[i][c] - palette[p][c];
+                    dist += d * d;
+                }
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+    for (int i = 0; i < 4; i++) out[4 + i] = (Uint8) (indices >> (i * 8));
+}
+
+// BC4 block (BC3 alpha, each BC5 channel) in eight-value mode between the
+// channel's extremes
+static void
+encode_channel (const Uint8 block[16][4], int channel, Uint8* out) {
+    Uint8 a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; i++) {
+        a0 = SDL_max (a0, block[i][channel]);
+        a1 = SDL_min (a1, block[i][channel]);
+    }
+    out[0] = a0;
+    out[1] = a1;
+    Uint64 indices = 0;
+    if (a0 != a1) {
+        // codes 0 and 1 are the endpoints, 2 to 7 step from a0 to a1
+        float palette[8] = {a0, a1};
+        for (int i = 1; i < 7; i++) {
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7.0f;
+        }
+        for (int i = 0; i < 16; i++) {
+            Uint64 best = 0;
+            float best_dist = INFINITY;
+            for (Uint32 p = 0; p < 8; p++) {
+                float dist = fabsf (block[i][channel] - palette[p]);
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 3);
+        }
+    }
+    for (int i = 0; i < 6; i++) out[2 + i] = (Uint8) (indices >> (i * 8));
+}
+
+static Uint32 block_size_of (Format format) {
+    return format == FORMAT_BC1 ? 8 : 16;
+}
+
+// encodes a level into out, PAL_DDSLevelSize bytes
+static void encode_level (const Level* level, Format format, Uint8* out) {
+    for (Uint32 by = 0; by < level->h; by += 4) {
+        for (Uint32 bx = 0; bx < level->w; bx += 4) {
+            // levels under 4 texels wide repeat their edges
+            Uint8 block[16][4];
+            for (Uint32 i = 0; i < 16; i++) {
+                Uint32 x = SDL_min (bx + i % 4, level->w - 1);
+                Uint32 y = SDL_min (by + i / 4, level->h - 1);
+                memcpy (block[i], &level->pixels[(y * level->w + x) * 4], 4);
+            }
+            switch (format) {
+            case FORMAT_BC1: encode_color (block, out); break;
+            case FORMAT_BC3:
+                encode_channel (block, 3, out);
+                encode_color (block, out + 8);
+                break;
+            default:
+                encode_channel (block, 0, out);
+                encode_channel (block, 1, out + 8);
+                break;
+            }
+            out += block_size_of (format);
+        }
+    }
+}
+
+static bool write_dds (
+    const char* path,
+    Format format,
+    const Level* levels,
+    Uint32 num_levels
+) {
+    static const Uint32 dxgi[] = {
+        [FORMAT_BC1] = PAL_DXGI_BC1_UNORM,
+        [FORMAT_BC3] = PAL_DXGI_BC3_UNORM,
+        [FORMAT_BC5] = PAL_DXGI_BC5_UNORM,
+    };
+    Uint32 block_size = block_size_of (format);
+    Uint32 magic = PAL_DDS_MAGIC;
+    PAL_DDSHeader header = {
+        .size = sizeof (PAL_DDSHeader),
+        .flags = PAL_DDSD_CAPS | PAL_DDSD_HEIGHT | PAL_DDSD_WIDTH |
+                 PAL_DDSD_PIXELFORMAT | PAL_DDSD_MIPMAPCOUNT |
+                 PAL_DDSD_LINEARSIZE,
+        .height = levels[0].h,
+        .width = levels[0].w,
+        .pitch_or_linear_size =
+            PAL_DDSLevelSize (levels[0].w, levels[0].h, block_size),
+        .mip_map_count = num_levels,
+        .format = {
+            .size = sizeof (PAL_DDSPixelFormat),
+            .flags = PAL_DDPF_FOURCC,
+            .fourcc = PAL_DDS_FOURCC ('D', 'X', '1', '0'),
+        },
+        .caps = PAL_DDSCAPS_TEXTURE,
+    };
+    if (num_levels > 1) {
+        header.caps |= PAL_DDSCAPS_COMPLEX | PAL_DDSCAPS_MIPMAP;
+    }
+    PAL_DDSHeaderDX10 dx10 = {
+        .dxgi_format = dxgi[format],
+        .resource_dimension = PAL_DX10_TEXTURE2D,
+        .array_size = 1,
+    };
+
+    SDL_IOStream* io = SDL_IOFromFile (path, "wb");
+    if (io == NULL) {
+        fprintf (stderr, "Couldn't open %s: %s\n", path, SDL_GetError ());
+        return false;
+    }
+    bool ok = SDL_WriteIO (io, &magic, sizeof (magic)) == sizeof (magic) &&
+              SDL_WriteIO (io, &header, sizeof (header)) == sizeof (header) &&
+              SDL_WriteIO (io, &dx10, sizeof (dx10)) == sizeof (dx10);
+    for (Uint32 i = 0; ok && i < num_levels; i++) {
+        Uint32 size = PAL_DDSLevelSize (levels[i].w, levels[i].h, block_size);
+        Uint8* blocks = malloc (size);
+        if (blocks == NULL) {
+            ok = false;
+            break;
+        }
+        encode_level (&levels[i], format, blocks);
+        ok = SDL_WriteIO (io, blocks, size) == size;
+        free (blocks);
+    }
+    if (!SDL_CloseIO (io)) ok = false;
+    if (!ok) fprintf (stderr, "Failed to write %s\n", path);
+    return ok;
+}
+
+static bool has_alpha (const Level* level) {
+    for (size_t i = 0; i < (size_t) level->w * level->h; i++) {
+        if (level->pixels[i * 4 + 3] != 255) return true;
+    }
+    return false;
+}
+
+static int usage (void) {
+    fprintf (stderr, "usage: texconv [-f bc1|bc3|bc5] input output.dds\n");
+    return 1;
+}
+
+int main (int argc, char** argv) {
+    Format format = FORMAT_AUTO;
+    int arg = 1;
+    if (argc > 2 && strcmp (argv[1], "-f") == 0) {
+        if (strcmp (argv[2], "bc1") == 0) format = FORMAT_BC1;
+        else if (strcmp (argv[2], "bc3") == 0) format = FORMAT_BC3;
+        else if (strcmp (argv[2], "bc5") == 0) format = FORMAT_BC5;
+        else return usage ();
+        arg = 3;
+    }
+    if (argc - arg != 2) return usage ();
+
+    SDL_Surface* surface = IMG_Load (argv[arg]);
+    if (surface == NULL) {
+        fprintf (
+            stderr, "Couldn't load %s: %s\n", argv[arg], SDL_GetError ()
+        );
+        return 1;
+    }
+    SDL_Surface* rgba =
+        SDL_ConvertSurface (surface, SDL_PIXELFORMAT_ABGR8888);
+    SDL_DestroySurface (surface);
+    if (rgba == NULL) {
+        fprintf (
+            stderr, "Couldn't convert %s: %s\n", argv[arg], SDL_GetError ()
+        );
+        return 1;
+    }
+    if (rgba->w % 4 != 0 || rgba->h % 4 != 0) {
+        fprintf (
+            stderr, "%s is %dx%d; sides must be multiples of 4\n", argv[arg],
+            rgba->w, rgba->h
+        );
+        SDL_DestroySurface (rgba);
+        return 1;
+    }
+    // the full chain of a side of 2^16 or more needs a 17th level
+    if (SDL_max (rgba->w, rgba->h) >= 1 << PAL_DDS_MAX_LEVELS) {
+        fprintf (
+            stderr, "%s is %dx%d; sides must be under %d\n", argv[arg],
+            rgba->w, rgba->h, 1 << PAL_DDS_MAX_LEVELS
+        );
+        SDL_DestroySurface (rgba);
+        return 1;
+    }
+
+    Level levels[PAL_DDS_MAX_LEVELS] = {0};
+    levels[0].w = (Uint32) rgba->w;
+    levels[0].h = (Uint32) rgba->h;
+    levels[0].pixels = malloc ((size_t) rgba->w * rgba->h * 4);
+    bool ok = levels[0].pixels != NULL;
+    for (int y = 0; ok && y < rgba->h; y++) {
+        memcpy (
+            &levels[0].pixels[(size_t) y * rgba->w * 4],
+            (Uint8*) rgba->pixels + (size_t) y * rgba->pitch,
+            (size_t) rgba->w * 4
+        );
+    }
+    SDL_DestroySurface (rgba);
+
+    Uint32 num_levels = 1;
+    while (ok && num_levels < PAL_DDS_MAX_LEVELS) {
+        const Level* last = &levels[num_levels - 1];
+        if (last->w == 1 && last->h == 1) break;
+        ok = downsample (last, &levels[num_levels++]);
+    }
+    if (format == FORMAT_AUTO && ok) {
+        format = has_alpha (&levels[0]) ? FORMAT_BC3 : FORMAT_BC1;
+    }
+    if (!ok) fprintf (stderr, "Out of memory\n");
+    ok = ok && write_dds (argv[arg + 1], format, levels, num_levels);
+
+    for (Uint32 i = 0; i < num_levels; i++) free (levels[i].pixels);
+    return ok ? 0 : 1;
+}
\ No newline at end of file